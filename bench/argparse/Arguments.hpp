@@ -0,0 +1,82 @@
+///
+///  @file Arguments.hpp
+///  @brief Generated ArgumentParser instantiations of any number of options
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef BENCH_ARGPARSE_ARGUMENTS_HPP_
+#define BENCH_ARGPARSE_ARGUMENTS_HPP_
+
+#include <cstddef>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "lib/ArgumentParser.hpp"
+
+namespace bench {
+
+/// "--", then Prefix, then I in three digits, e.g. "--o007"
+template <std::size_t I, char... Prefix>
+struct Name final {
+    static constexpr char text[]{'-',
+                                 '-',
+                                 Prefix...,
+                                 static_cast<char>('0' + I / 100 % 10),
+                                 static_cast<char>('0' + I / 10 % 10),
+                                 static_cast<char>('0' + I % 10),
+                                 '\0'};
+    static constexpr coreutils::detail::ComptimeString<sizeof(text)> value{
+        text};
+};
+
+inline constexpr auto identity = [](std::string_view arg) { return arg; };
+inline constexpr auto ignore = [](std::string_view) {};
+
+/// BooleanArgument, spelled out: GCC cannot substitute into the lambda that
+/// alias holds when the names are themselves dependent
+template <coreutils::detail::ComptimeString... Names>
+using Switch =
+    coreutils::detail::Argument<void, coreutils::detail::NArgs::None, ignore,
+                                std::vector, Names...>;
+
+/// Every option answers to four names (e.g. --o007, --a007, --b007 and
+/// --c007). Even ones are switches, odd ones take a value.
+template <std::size_t I>
+using Option = std::conditional_t<
+    I % 2 == 0,
+    Switch<Name<I, 'o'>::value, Name<I, 'a'>::value, Name<I, 'b'>::value,
+           Name<I, 'c'>::value>,
+    coreutils::SingleValueArgument<std::string_view, identity,
+                                   Name<I, 'o'>::value, Name<I, 'a'>::value,
+                                   Name<I, 'b'>::value, Name<I, 'c'>::value>>;
+
+using Operands = coreutils::PositionalArguments<std::string_view, identity>;
+
+template <class Program, std::size_t... I>
+coreutils::ArgumentParser<Program, Option<I>..., Operands> MakeParser(
+    std::index_sequence<I...>);
+
+/// A parser of Count options, and operands
+template <class Program, std::size_t Count>
+using Parser =
+    decltype(MakeParser<Program>(std::make_index_sequence<Count>{}));
+
+}  // namespace bench
+
+#endif  // BENCH_ARGPARSE_ARGUMENTS_HPP_
@@ -0,0 +1,40 @@
+///
+///  @file instantiate.cpp
+///  @brief One ArgumentParser instantiation, compiled by the argparse benchmark
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+// Not part of the build. The argparse benchmark compiles this once for each
+// option count it measures, passing that count as COREUTILS_BENCH_ARGUMENTS.
+
+#include "bench/argparse/Arguments.hpp"
+
+#if !defined(COREUTILS_BENCH_ARGUMENTS)
+#define COREUTILS_BENCH_ARGUMENTS 5
+#endif
+
+namespace {
+using Program =
+    coreutils::ProgramInfo<"instantiate", "0.0.1", "instantiate [OPTION]...",
+                           "Parses its command line, and nothing more.">;
+}  // namespace
+
+/// Exported, so that none of the parser can be thrown away
+extern "C" int coreutils_bench_parse(int argc, const char** argv) {
+    bench::Parser<Program, COREUTILS_BENCH_ARGUMENTS> parser{argc, argv};
+    return parser.TryParseArgs() ? 0 : 1;
+}
@@ -0,0 +1,430 @@
+///
+///  @file main.cpp
+///  @brief Benchmark ArgumentParser parse throughput and compile cost as JSON
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <optional>
+#include <print>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "bench/argparse/Arguments.hpp"
+
+namespace {
+std::atomic<std::size_t> allocations{0};
+}  // namespace
+
+// Every allocation in the program goes through here, so that a parse's can
+// be read off as the difference in the count before and after it
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* const memory{std::malloc(std::max<std::size_t>(size, 1))}) {
+        return memory;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Seconds = std::chrono::duration<double>;
+
+/// In the same shape as the suite's results, so that the same tooling reads
+/// both
+struct Result final {
+    std::string name;
+    std::string unit;
+    double value;
+    bool higher_is_better;
+};
+
+using Program = coreutils::ProgramInfo<"argparse", "0.0.1",
+                                       "argparse [OPTION]... [FILE]...",
+                                       "A command line to benchmark.">;
+
+/// Shaped like sort's or ls's: switches that combine, options with a value
+/// given either way, and one that takes a value each time
+using MixedParser = coreutils::ArgumentParser<
+    Program, coreutils::BooleanArgument<"-a", "--all">,
+    coreutils::BooleanArgument<"-l">,
+    coreutils::BooleanArgument<"-r", "--reverse">,
+    coreutils::BooleanArgument<"-n", "--numeric">,
+    coreutils::SingleValueArgument<std::string_view, bench::identity, "-o",
+                                   "--output">,
+    coreutils::SingleValueArgument<std::string_view, bench::identity, "-j",
+                                   "--jobs">,
+    coreutils::RepeatedValueArgument<std::string_view, bench::identity, "-k",
+                                     "--key">,
+    bench::Operands>;
+
+/// argv, with an argv[0] in front of tokens. The parser moves operands to
+/// the front of the argv it is given, so every parse gets a fresh copy.
+class CommandLine final {
+ public:
+    explicit CommandLine(std::vector<std::string> tokens)
+        : tokens_{std::move(tokens)} {
+        pointers_.push_back("argparse");
+        for (const std::string& token : tokens_) {
+            pointers_.push_back(token.c_str());
+        }
+        scratch_ = pointers_;
+    }
+
+    std::span<const char*> Fresh() {
+        std::ranges::copy(pointers_, scratch_.begin());
+        return scratch_;
+    }
+
+    std::size_t size() const { return tokens_.size(); }
+
+ private:
+    std::vector<std::string> tokens_{};
+    std::vector<const char*> pointers_{};
+    std::vector<const char*> scratch_{};
+};
+
+struct Measurement final {
+    /// Median
+    Seconds per_parse;
+    std::size_t allocations;
+};
+
+/// Parses command_line over and over with a fresh Parser, for about
+/// duration (and at least a few times)
+template <class Parser>
+std::optional<Measurement> Measure(CommandLine& command_line,
+                                   Seconds duration) {
+    std::vector<double> samples{};
+    std::size_t allocated{0};
+    const Clock::time_point end{
+        Clock::now() + std::chrono::duration_cast<Clock::duration>(duration)};
+    do {
+        const std::span<const char*> argv{command_line.Fresh()};
+        const std::size_t before{allocations.load()};
+        const Clock::time_point start{Clock::now()};
+        {
+            Parser parser{static_cast<int>(argv.size()), argv.data()};
+            if (!parser.TryParseArgs()) {
+                return std::nullopt;
+            }
+        }
+        const Seconds elapsed{Clock::now() - start};
+        allocated = allocations.load() - before;
+        samples.push_back(elapsed.count());
+    } while (Clock::now() < end || samples.size() < 5);
+
+    std::ranges::sort(samples);
+    return Measurement{
+        .per_parse = Seconds{samples[samples.size() / 2]},
+        .allocations = allocated,
+    };
+}
+
+/// Throughput in arguments per second, and allocations per parse
+template <class Parser>
+void Record(std::vector<Result>& results, std::string_view name,
+            std::vector<std::string> tokens, Seconds duration) {
+    CommandLine command_line{std::move(tokens)};
+    const std::optional<Measurement> measured{
+        Measure<Parser>(command_line, duration)};
+    if (!measured) {
+        std::println(std::cerr, "bench_argparse: {} did not parse", name);
+        return;
+    }
+    results.push_back({
+        .name = std::format("argparse.{}", name),
+        .unit = "args/s",
+        .value = static_cast<double>(command_line.size()) /
+                 measured->per_parse.count(),
+        .higher_is_better = true,
+    });
+    results.push_back({
+        .name = std::format("argparse.{}.allocations", name),
+        .unit = "allocations",
+        .value = static_cast<double>(measured->allocations),
+        .higher_is_better = false,
+    });
+}
+
+/// What xargs hands to e.g. rm -f: one switch and a great many operands
+std::vector<std::string> PositionalTokens(std::size_t count) {
+    std::vector<std::string> tokens{"--o000"};
+    for (std::size_t i{0}; i < count; ++i) {
+        tokens.push_back(std::format("file-{:06}", i));
+    }
+    return tokens;
+}
+
+/// Every one of count options once, each by a different one of its names,
+/// with values given both as --name value and as --name=value
+std::vector<std::string> AliasTokens(std::size_t count) {
+    constexpr std::array<char, 4> prefixes{'o', 'a', 'b', 'c'};
+    std::vector<std::string> tokens{};
+    for (std::size_t i{0}; i < count; ++i) {
+        const std::string name{std::format("--{}{:03}", prefixes[i % 4], i)};
+        if (i % 2 == 0) {
+            tokens.push_back(name);
+        } else if (i % 3 == 0) {
+            tokens.push_back(std::format("{}=value", name));
+        } else {
+            tokens.push_back(name);
+            tokens.push_back("value");
+        }
+    }
+    tokens.push_back("file");
+    return tokens;
+}
+
+/// A sort -k style command line: a few switches up front, then keys and
+/// operands interleaved
+std::vector<std::string> MixedTokens(std::size_t keys) {
+    std::vector<std::string> tokens{"-alr", "-o", "out", "--jobs=4",
+                                    "--numeric"};
+    for (std::size_t i{0}; i < keys; ++i) {
+        tokens.push_back("-k");
+        tokens.push_back(std::format("{},{}n", i, i));
+        tokens.push_back(std::format("file-{:04}", i));
+    }
+    return tokens;
+}
+
+#if defined(__linux__)
+
+/// Runs argv, with its output thrown away (but not its errors, so that a
+/// compiler that cannot build the source says why)
+std::optional<Seconds> RunOnce(const std::vector<std::string>& argv) {
+    std::vector<char*> args{};
+    for (const std::string& arg : argv) {
+        args.push_back(const_cast<char*>(arg.c_str()));
+    }
+    args.push_back(nullptr);
+
+    const Clock::time_point start{Clock::now()};
+    const pid_t pid{::fork()};
+    if (pid == 0) {
+        const int sink{::open("/dev/null", O_WRONLY)};
+        ::dup2(sink, STDOUT_FILENO);
+        ::execvp(args.front(), args.data());
+        ::_exit(127);
+    } else if (pid < 0) {
+        return std::nullopt;
+    }
+
+    int status{0};
+    if (::waitpid(pid, &status, 0) != pid || !WIFEXITED(status) ||
+        WEXITSTATUS(status) != 0) {
+        return std::nullopt;
+    }
+    return Clock::now() - start;
+}
+
+/// Compiles source with an ArgumentParser of options options, runs times.
+/// Records the median time, and the size of the object file.
+bool RecordCompile(std::vector<Result>& results,
+                   std::span<const std::string_view> compiler,
+                   std::string_view source, std::string_view include,
+                   std::size_t options, std::size_t runs) {
+    const std::filesystem::path object{
+        std::filesystem::temp_directory_path() /
+        std::format("coreutilspp-argparse-{}-{}.o", ::getpid(), options)};
+    std::vector<std::string> command{compiler.begin(), compiler.end()};
+    command.insert(command.end(),
+                   {"-std=c++26", "-O2", "-c", "-I", std::string{include},
+                    std::format("-DCOREUTILS_BENCH_ARGUMENTS={}", options),
+                    std::string{source}, "-o", object.string()});
+
+    std::vector<double> samples{};
+    for (std::size_t run{0}; run < runs; ++run) {
+        const std::optional<Seconds> elapsed{RunOnce(command)};
+        if (!elapsed) {
+            return false;
+        }
+        samples.push_back(elapsed->count());
+    }
+    std::ranges::sort(samples);
+
+    std::error_code error{};
+    const std::uintmax_t size{std::filesystem::file_size(object, error)};
+    std::filesystem::remove(object, error);
+    results.push_back({
+        .name = std::format("argparse.compile.{}", options),
+        .unit = "s",
+        .value = samples[samples.size() / 2],
+        .higher_is_better = false,
+    });
+    results.push_back({
+        .name = std::format("argparse.object.{}", options),
+        .unit = "bytes",
+        .value = static_cast<double>(size),
+        .higher_is_better = false,
+    });
+    return true;
+}
+
+#endif
+
+void WriteJson(std::ostream& out, std::span<const Result> results) {
+    std::println(out, "{{\n  \"results\": [");
+    for (std::size_t i{0}; i < results.size(); ++i) {
+        const Result& result{results[i]};
+        std::println(out,
+                     "    {{\"name\": \"{}\", \"implementation\": "
+                     "\"coreutilspp\", \"unit\": \"{}\", \"value\": {:.3f}, "
+                     "\"higher_is_better\": {}}}{}",
+                     result.name, result.unit, result.value,
+                     result.higher_is_better,
+                     i + 1 < results.size() ? "," : "");
+    }
+    std::println(out, "  ]\n}}");
+}
+
+template <class Number>
+std::optional<Number> ParseNumber(std::string_view text) {
+    Number value{};
+    const auto [end, error]{
+        std::from_chars(text.data(), text.data() + text.size(), value)};
+    if (error != std::errc{} || end != text.data() + text.size()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+}  // namespace
+
+int main(int argc, const char** argv) {
+    using Bench = coreutils::ProgramInfo<
+        "bench_argparse", "0.0.1",
+        "bench_argparse [OPTION]... [-- COMPILER...]",
+        "Time ArgumentParser on huge, option heavy and mixed command lines,\n"
+        "count the allocations each parse makes, and print the results as\n"
+        "JSON. Given a COMPILER (e.g. -- zig c++) and --source (this\n"
+        "benchmark's instantiate.cpp), also time compiling parsers of 0, 5,\n"
+        "20 and 50 options, and measure their object files.">;
+    using Compiler =
+        coreutils::PositionalArguments<std::string_view, bench::identity>;
+    using Source = coreutils::SingleValueArgument<std::string_view,
+                                                  bench::identity, "--source">;
+    using Include =
+        coreutils::SingleValueArgument<std::string_view, bench::identity,
+                                       "--include">;
+    using OutputFile =
+        coreutils::SingleValueArgument<std::string_view, bench::identity,
+                                       "-o", "--output">;
+    using Duration =
+        coreutils::SingleValueArgument<std::string_view, bench::identity,
+                                       "--seconds">;
+    using Runs = coreutils::SingleValueArgument<std::string_view,
+                                                bench::identity, "--runs">;
+    coreutils::ArgumentParser<Bench, Compiler, Source, Include, OutputFile,
+                              Duration, Runs>
+        parser{argc, argv};
+    parser.ParseArgsOrExit();
+
+    double seconds{1};
+    std::size_t runs{3};
+    if (const std::string_view text{parser.get<Duration>().value};
+        !text.empty()) {
+        const std::optional<double> parsed{ParseNumber<double>(text)};
+        if (!parsed || *parsed <= 0) {
+            std::println(std::cerr, "bench_argparse: invalid number '{}'",
+                         text);
+            return 2;
+        }
+        seconds = *parsed;
+    }
+    if (const std::string_view text{parser.get<Runs>().value};
+        !text.empty()) {
+        const std::optional<std::size_t> parsed{
+            ParseNumber<std::size_t>(text)};
+        if (!parsed || *parsed == 0) {
+            std::println(std::cerr, "bench_argparse: invalid number '{}'",
+                         text);
+            return 2;
+        }
+        runs = *parsed;
+    }
+    const Seconds duration{seconds};
+
+    std::vector<Result> results{};
+    Record<bench::Parser<Program, 5>>(results, "positionals",
+                                      PositionalTokens(100'000), duration);
+    Record<bench::Parser<Program, 50>>(results, "aliases", AliasTokens(50),
+                                       duration);
+    Record<MixedParser>(results, "mixed", MixedTokens(1'000), duration);
+
+    const std::span<const std::string_view> compiler{
+        parser.get<Compiler>().value};
+    const std::string_view source{parser.get<Source>().value};
+    if (!compiler.empty() && !source.empty()) {
+#if defined(__linux__)
+        const std::string_view include{parser.get<Include>().value};
+        constexpr std::array<std::size_t, 4> counts{0, 5, 20, 50};
+        for (const std::size_t options : counts) {
+            if (!RecordCompile(results, compiler, source,
+                               include.empty() ? "." : include, options,
+                               runs)) {
+                std::println(std::cerr,
+                             "bench_argparse: could not compile {} with {} "
+                             "options",
+                             source, options);
+                return 2;
+            }
+        }
+#else
+        std::println(std::cerr,
+                     "bench_argparse: compile times are only measured on "
+                     "Linux");
+#endif
+    }
+
+    if (const std::string_view output{parser.get<OutputFile>().value};
+        !output.empty()) {
+        std::ofstream file{std::string{output}};
+        WriteJson(file, results);
+    } else {
+        WriteJson(std::cout, results);
+    }
+    return 0;
+}
@@ -0,0 +1,291 @@
+///
+///  @file main.cpp
+///  @brief Benchmark mapping files against reading them, across sizes, as JSON
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <print>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "lib/ArgumentParser.hpp"
+#include "lib/FileCopy.hpp"
+#include "lib/FileInput.hpp"
+#include "lib/Parallel.hpp"
+#include "lib/TextCount.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Seconds = std::chrono::duration<double>;
+
+constexpr auto identity = [](std::string_view arg) { return arg; };
+
+/// In the same shape as the suite's results, so that the same tooling reads
+/// both
+struct Result final {
+    std::string name;
+    std::string unit;
+    double value;
+    bool higher_is_better;
+};
+
+/// How one pass gets through the file
+enum class Way : std::uint8_t {
+    /// Always read, through a CopyBuffer
+    Read,
+    /// Always map, and count on one thread
+    Map,
+    /// Map, then split the text between threads
+    MapParallel,
+    /// Whatever InputSource picks by default
+    Adaptive,
+};
+
+struct WayInfo final {
+    Way way;
+    std::string_view name;
+};
+
+constexpr std::array<WayInfo, 4> ways{{
+    {Way::Read, "read"},
+    {Way::Map, "map"},
+    {Way::MapParallel, "map_parallel"},
+    {Way::Adaptive, "adaptive"},
+}};
+
+/// Keeps the counting from being optimized away
+std::atomic<std::uint64_t> sink{0};
+
+/// Counts the lines of path one way. Counting lines stands in for what the
+/// utilities do with their input: little work per byte, so the cost of
+/// getting at the bytes shows.
+std::error_code Pass(const std::string& path, Way way,
+                     std::span<char> buffer) {
+    const std::expected<coreutils::InputFile, std::error_code> file{
+        coreutils::InputFile::Open(path.c_str())};
+    if (!file) {
+        return file.error();
+    }
+    const std::size_t threshold{
+        way == Way::Read       ? std::numeric_limits<std::size_t>::max()
+        : way == Way::Adaptive ? coreutils::InputSource::default_map_threshold
+                               : 0};
+    coreutils::InputSource source{file->fd(), threshold};
+
+    std::uint64_t lines{0};
+    if (const std::optional<std::span<const char>> text{source.mapped()};
+        text && way == Way::MapParallel) {
+        const std::vector<std::span<const char>> chunks{
+            coreutils::SplitChunks(*text, 1024 * 1024)};
+        std::vector<std::uint64_t> counts(chunks.size());
+        coreutils::ParallelFor(chunks.size(), coreutils::DefaultConcurrency(),
+                               1, [&chunks, &counts](std::size_t i) {
+                                   counts[i] = coreutils::CountLines(chunks[i]);
+                               });
+        for (const std::uint64_t count : counts) {
+            lines += count;
+        }
+        sink.fetch_add(lines, std::memory_order_relaxed);
+        return {};
+    }
+    const std::error_code error{source.ForEachChunk(
+        buffer, [&lines](std::span<const char> text) {
+            lines += coreutils::CountLines(text);
+        })};
+    sink.fetch_add(lines, std::memory_order_relaxed);
+    return error;
+}
+
+/// Median time of a pass, over about duration (and at least a few passes)
+std::expected<Seconds, std::error_code> Measure(const std::string& path,
+                                                Way way, Seconds duration,
+                                                std::span<char> buffer) {
+    // the first pass pulls the file into the page cache, so that every way
+    // is timed against the same warm cache
+    if (const std::error_code error{Pass(path, way, buffer)}) {
+        return std::unexpected{error};
+    }
+    std::vector<double> samples{};
+    const Clock::time_point end{
+        Clock::now() + std::chrono::duration_cast<Clock::duration>(duration)};
+    do {
+        const Clock::time_point start{Clock::now()};
+        if (const std::error_code error{Pass(path, way, buffer)}) {
+            return std::unexpected{error};
+        }
+        samples.push_back(Seconds{Clock::now() - start}.count());
+    } while (Clock::now() < end || samples.size() < 5);
+    std::ranges::sort(samples);
+    return Seconds{samples[samples.size() / 2]};
+}
+
+/// Lines of varying length, like source code or logs
+bool WriteText(const std::string& path, std::size_t size) {
+    std::ofstream file{path, std::ios::binary | std::ios::trunc};
+    std::string line{};
+    auto state{static_cast<std::uint32_t>(size)};
+    for (std::size_t written{0}; written < size;) {
+        state = state * 1664525u + 1013904223u;
+        line.assign((state >> 16) % 120, 'x');
+        line.push_back('\n');
+        const std::size_t length{std::min(line.size(), size - written)};
+        file.write(line.data(), static_cast<std::streamsize>(length));
+        written += length;
+    }
+    return static_cast<bool>(file.flush());
+}
+
+std::string SizeName(std::size_t size) {
+    return size >= 1024 * 1024 ? std::format("{}MiB", size / (1024 * 1024))
+                               : std::format("{}KiB", size / 1024);
+}
+
+void WriteJson(std::ostream& out, std::span<const Result> results) {
+    std::println(out, "{{\n  \"results\": [");
+    for (std::size_t i{0}; i < results.size(); ++i) {
+        const Result& result{results[i]};
+        std::println(out,
+                     "    {{\"name\": \"{}\", \"implementation\": "
+                     "\"coreutilspp\", \"unit\": \"{}\", \"value\": {:.3f}, "
+                     "\"higher_is_better\": {}}}{}",
+                     result.name, result.unit, result.value,
+                     result.higher_is_better,
+                     i + 1 < results.size() ? "," : "");
+    }
+    std::println(out, "  ]\n}}");
+}
+
+template <class Number>
+std::optional<Number> ParseNumber(std::string_view text) {
+    Number value{};
+    const auto [end, error]{
+        std::from_chars(text.data(), text.data() + text.size(), value)};
+    if (error != std::errc{} || end != text.data() + text.size()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+}  // namespace
+
+int main(int argc, const char** argv) {
+    using Bench = coreutils::ProgramInfo<
+        "bench_input", "0.0.1", "bench_input [OPTION]...",
+        "Count the lines of files from 4 KiB up to --max-size MiB (64 by\n"
+        "default), reading them, mapping them, mapping them and splitting\n"
+        "them between threads, and letting InputSource choose. Files are\n"
+        "made in --directory (the temporary directory by default), timed\n"
+        "with a warm page cache, and removed. Prints throughput as JSON.">;
+    using Directory =
+        coreutils::SingleValueArgument<std::string_view, identity,
+                                       "--directory">;
+    using MaxSize = coreutils::SingleValueArgument<std::string_view, identity,
+                                                   "--max-size">;
+    using OutputFile = coreutils::SingleValueArgument<std::string_view,
+                                                      identity, "-o",
+                                                      "--output">;
+    using Duration = coreutils::SingleValueArgument<std::string_view,
+                                                    identity, "--seconds">;
+    coreutils::ArgumentParser<Bench, Directory, MaxSize, OutputFile,
+                              Duration>
+        parser{argc, argv};
+    parser.ParseArgsOrExit();
+
+    double seconds{0.5};
+    std::size_t max_size{64};
+    if (const std::string_view text{parser.get<Duration>().value};
+        !text.empty()) {
+        const std::optional<double> parsed{ParseNumber<double>(text)};
+        if (!parsed || *parsed <= 0) {
+            std::println(std::cerr, "bench_input: invalid number '{}'", text);
+            return 2;
+        }
+        seconds = *parsed;
+    }
+    if (const std::string_view text{parser.get<MaxSize>().value};
+        !text.empty()) {
+        const std::optional<std::size_t> parsed{
+            ParseNumber<std::size_t>(text)};
+        if (!parsed || *parsed == 0) {
+            std::println(std::cerr, "bench_input: invalid number '{}'", text);
+            return 2;
+        }
+        max_size = *parsed;
+    }
+    const Seconds duration{seconds};
+
+    std::error_code error{};
+    const std::string_view directory_text{parser.get<Directory>().value};
+    const std::filesystem::path directory{
+        directory_text.empty() ? std::filesystem::temp_directory_path(error)
+                               : std::filesystem::path{directory_text}};
+    const std::string path{(directory / "bench_input.txt").string()};
+
+    coreutils::CopyBuffer buffer{};
+    std::vector<Result> results{};
+    for (std::size_t size{4 * 1024}; size <= max_size * 1024 * 1024;
+         size *= 4) {
+        if (!WriteText(path, size)) {
+            std::println(std::cerr, "bench_input: could not write {}", path);
+            std::filesystem::remove(path, error);
+            return 2;
+        }
+        for (const WayInfo& way : ways) {
+            const std::expected<Seconds, std::error_code> pass{
+                Measure(path, way.way, duration, buffer.span())};
+            if (!pass) {
+                std::println(std::cerr, "bench_input: {}: {}", path,
+                             pass.error().message());
+                std::filesystem::remove(path, error);
+                return 2;
+            }
+            results.push_back({
+                .name = std::format("input.{}.{}", way.name, SizeName(size)),
+                .unit = "MB/s",
+                .value = static_cast<double>(size) / 1e6 / pass->count(),
+                .higher_is_better = true,
+            });
+        }
+    }
+    std::filesystem::remove(path, error);
+
+    if (const std::string_view output{parser.get<OutputFile>().value};
+        !output.empty()) {
+        std::ofstream file{std::string{output}};
+        WriteJson(file, results);
+    } else {
+        WriteJson(std::cout, results);
+    }
+    return 0;
+}
@@ -0,0 +1,645 @@
+///
+///  @file main.cpp
+///  @brief Benchmark the built utilities (and GNU's, if installed) as JSON
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <print>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <array>
+#include <cstdlib>
+#endif
+
+#include "lib/ArgumentParser.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Seconds = std::chrono::duration<double>;
+
+/// One measurement of one implementation. Results are written one per line,
+/// so that a previous run's output can be read back as a baseline without a
+/// JSON library.
+struct Result final {
+    std::string name;
+    /// "coreutilspp" or "gnu"
+    std::string implementation;
+    std::string unit;
+    double value;
+    bool higher_is_better;
+    /// Only for latencies
+    std::optional<std::array<double, 3>> percentiles{};
+    long max_rss_kib{0};
+};
+
+struct Settings final {
+    std::size_t latency_runs;
+    std::size_t repeats;
+    std::size_t entries;
+    std::size_t paths;
+    Seconds duration;
+};
+
+#if defined(__linux__)
+
+struct Run final {
+    Seconds elapsed;
+    long max_rss_kib;
+    bool succeeded;
+};
+
+/// Runs argv to completion with its output thrown away
+std::optional<Run> RunOnce(const std::vector<std::string>& argv) {
+    std::vector<char*> args{};
+    for (const std::string& arg : argv) {
+        args.push_back(const_cast<char*>(arg.c_str()));
+    }
+    args.push_back(nullptr);
+
+    const Clock::time_point start{Clock::now()};
+    const pid_t pid{::fork()};
+    if (pid == 0) {
+        const int sink{::open("/dev/null", O_WRONLY)};
+        ::dup2(sink, STDOUT_FILENO);
+        ::dup2(sink, STDERR_FILENO);
+        ::execv(args.front(), args.data());
+        ::_exit(127);
+    } else if (pid < 0) {
+        return std::nullopt;
+    }
+
+    int status{0};
+    rusage usage{};
+    if (::wait4(pid, &status, 0, &usage) != pid) {
+        return std::nullopt;
+    }
+    return Run{
+        .elapsed = Clock::now() - start,
+        .max_rss_kib = usage.ru_maxrss,
+        .succeeded = WIFEXITED(status) && WEXITSTATUS(status) == 0,
+    };
+}
+
+/// p in [0, 1] of sorted samples, by nearest rank
+double Percentile(std::span<const double> sorted, double p) {
+    const auto rank{static_cast<std::size_t>(
+        p * static_cast<double>(sorted.size() - 1) + 0.5)};
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+double Median(std::vector<double> samples) {
+    std::ranges::sort(samples);
+    return Percentile(samples, 0.5);
+}
+
+/// Exec-to-exit time of a command that does next to nothing, i.e. what
+/// starting the utility costs
+std::optional<Result> Latency(std::string_view name,
+                              std::string_view implementation,
+                              const std::vector<std::string>& argv,
+                              const Settings& settings) {
+    // the first few runs pay for faulting the binary into the page cache
+    for (std::size_t i{0}; i < 5; ++i) {
+        if (!RunOnce(argv)) {
+            return std::nullopt;
+        }
+    }
+
+    std::vector<double> micros{};
+    long max_rss_kib{0};
+    for (std::size_t i{0}; i < settings.latency_runs; ++i) {
+        const std::optional<Run> run{RunOnce(argv)};
+        if (!run || !run->succeeded) {
+            return std::nullopt;
+        }
+        micros.push_back(run->elapsed.count() * 1e6);
+        max_rss_kib = std::max(max_rss_kib, run->max_rss_kib);
+    }
+    std::ranges::sort(micros);
+    const double p50{Percentile(micros, 0.5)};
+    return Result{
+        .name = std::string{name} + ".latency",
+        .implementation = std::string{implementation},
+        .unit = "us",
+        .value = p50,
+        .higher_is_better = false,
+        .percentiles = std::array{p50, Percentile(micros, 0.9),
+                                  Percentile(micros, 0.99)},
+        .max_rss_kib = max_rss_kib,
+    };
+}
+
+/// Median wall time of running every command in commands, in order,
+/// settings.repeats times. make_commands(i) gives the commands of the i-th
+/// repeat, so that repeats that create things can each start from scratch.
+template <class MakeCommands>
+std::optional<Result> Workload(std::string_view name,
+                               std::string_view implementation,
+                               MakeCommands&& make_commands,
+                               const Settings& settings) {
+    std::vector<double> millis{};
+    long max_rss_kib{0};
+    for (std::size_t i{0}; i < settings.repeats; ++i) {
+        Seconds total{0};
+        for (const std::vector<std::string>& argv : make_commands(i)) {
+            const std::optional<Run> run{RunOnce(argv)};
+            if (!run || !run->succeeded) {
+                return std::nullopt;
+            }
+            total += run->elapsed;
+            max_rss_kib = std::max(max_rss_kib, run->max_rss_kib);
+        }
+        millis.push_back(total.count() * 1e3);
+    }
+    return Result{
+        .name = std::string{name},
+        .implementation = std::string{implementation},
+        .unit = "ms",
+        .value = Median(std::move(millis)),
+        .higher_is_better = false,
+        .max_rss_kib = max_rss_kib,
+    };
+}
+
+/// Bytes per second yes gets through a pipe that is drained as fast as
+/// possible
+std::optional<Result> YesPipe(std::string_view implementation,
+                              const std::string& yes,
+                              const Settings& settings) {
+    std::array<int, 2> fds{};
+    if (::pipe2(fds.data(), O_CLOEXEC) != 0) {
+        return std::nullopt;
+    }
+    const auto [read_end, write_end]{fds};
+    const pid_t pid{::fork()};
+    if (pid == 0) {
+        ::dup2(write_end, STDOUT_FILENO);
+        ::execl(yes.c_str(), yes.c_str(), nullptr);
+        ::_exit(127);
+    }
+    ::close(write_end);
+    if (pid < 0) {
+        ::close(read_end);
+        return std::nullopt;
+    }
+
+    std::vector<char> scratch(128 * 1024);
+    std::uint64_t total{0};
+    const Clock::time_point start{Clock::now()};
+    for (const auto end{start + settings.duration}; Clock::now() < end;) {
+        const ssize_t moved{::read(read_end, scratch.data(), scratch.size())};
+        if (moved <= 0) {
+            break;
+        }
+        total += static_cast<std::uint64_t>(moved);
+    }
+    const Seconds elapsed{Clock::now() - start};
+
+    ::kill(pid, SIGKILL);
+    rusage usage{};
+    ::wait4(pid, nullptr, 0, &usage);
+    ::close(read_end);
+    return Result{
+        .name = "yes.pipe",
+        .implementation = std::string{implementation},
+        .unit = "B/s",
+        .value = static_cast<double>(total) / elapsed.count(),
+        .higher_is_better = true,
+        .max_rss_kib = usage.ru_maxrss,
+    };
+}
+
+/// The workloads' inputs, in a temporary directory that is removed again
+/// afterwards
+class Fixtures final {
+ public:
+    explicit Fixtures(const Settings& settings) {
+        const std::filesystem::path base{
+            std::filesystem::temp_directory_path() / "coreutilspp-bench-"};
+        std::string pattern{base.string() + "XXXXXX"};
+        if (!::mkdtemp(pattern.data())) {
+            return;
+        }
+        root_ = pattern;
+        std::filesystem::create_directory(empty());
+        ok_ = MakeFlat(settings.entries);
+    }
+
+    Fixtures(const Fixtures&) = delete;
+    Fixtures& operator=(const Fixtures&) = delete;
+
+    ~Fixtures() {
+        if (!root_.empty()) {
+            std::error_code ignored{};
+            std::filesystem::remove_all(root_, ignored);
+        }
+    }
+
+    bool ok() const { return ok_; }
+    std::string empty() const { return (root_ / "empty").string(); }
+    /// Holds settings.entries empty files
+    std::string flat() const { return (root_ / "flat").string(); }
+    /// A fresh directory for the run-th repeat of implementation
+    std::string nested(std::string_view implementation,
+                       std::size_t run) const {
+        return (root_ / std::format("nested-{}-{}", implementation, run))
+            .string();
+    }
+
+ private:
+    bool MakeFlat(std::size_t entries) {
+        std::filesystem::create_directory(flat());
+        const int dir{::open(flat().c_str(), O_RDONLY | O_DIRECTORY)};
+        if (dir < 0) {
+            return false;
+        }
+        bool ok{true};
+        for (std::size_t i{0}; ok && i < entries; ++i) {
+            const std::string name{std::format("entry-{:07}", i)};
+            const int fd{::openat(dir, name.c_str(),
+                                  O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC,
+                                  0644)};
+            ok = fd >= 0;
+            ::close(fd);
+        }
+        ::close(dir);
+        return ok;
+    }
+
+    std::filesystem::path root_{};
+    bool ok_{false};
+};
+
+/// Leaves come in groups of ten under one parent, and parents in groups of
+/// ten under one grandparent, so most of the work is on shared prefixes.
+/// Split into as few commands as fit in ARG_MAX.
+std::vector<std::vector<std::string>> NestedCommands(const std::string& mkdir,
+                                                     const std::string& root,
+                                                     std::size_t paths) {
+    const long arg_max{::sysconf(_SC_ARG_MAX)};
+    // leave room for the environment
+    const std::size_t budget{
+        arg_max > 0 ? static_cast<std::size_t>(arg_max) / 2 : 64 * 1024};
+
+    std::vector<std::vector<std::string>> commands{};
+    std::size_t used{budget};
+    for (std::size_t i{0}; i < paths; ++i) {
+        std::string path{
+            std::format("{}/{}/{}/{}", root, i / 100, i / 10 % 10, i % 10)};
+        if (used + path.size() + sizeof(char*) + 1 > budget) {
+            commands.push_back({mkdir, "-p"});
+            used = 0;
+        }
+        used += path.size() + sizeof(char*) + 1;
+        commands.back().push_back(std::move(path));
+    }
+    return commands;
+}
+
+/// The first executable called name on PATH that is not one of ours
+std::optional<std::string> FindOnPath(std::string_view name,
+                                      std::span<const std::string> ours) {
+    const char* const path{std::getenv("PATH")};
+    if (!path) {
+        return std::nullopt;
+    }
+    for (const auto part : std::string_view{path} | std::views::split(':')) {
+        const std::filesystem::path candidate{
+            std::filesystem::path{std::string_view{part}} / name};
+        std::error_code error{};
+        const std::filesystem::path real{
+            std::filesystem::canonical(candidate, error)};
+        if (error || ::access(candidate.c_str(), X_OK) != 0) {
+            continue;
+        }
+        const bool is_ours{std::ranges::any_of(ours, [&](const auto& ours_path) {
+            std::error_code ignored{};
+            return std::filesystem::equivalent(real, ours_path, ignored);
+        })};
+        if (!is_ours) {
+            return candidate.string();
+        }
+    }
+    return std::nullopt;
+}
+
+#endif
+
+void WriteJson(std::ostream& out, std::span<const Result> results) {
+    std::println(out, "{{\n  \"results\": [");
+    for (std::size_t i{0}; i < results.size(); ++i) {
+        const Result& result{results[i]};
+        std::print(out,
+                   "    {{\"name\": \"{}\", \"implementation\": \"{}\", "
+                   "\"unit\": \"{}\", \"value\": {:.3f}, "
+                   "\"higher_is_better\": {}",
+                   result.name, result.implementation, result.unit,
+                   result.value, result.higher_is_better);
+        if (result.percentiles) {
+            const auto [p50, p90, p99]{*result.percentiles};
+            std::print(out, ", \"p50\": {:.3f}, \"p90\": {:.3f}, \"p99\": {:.3f}",
+                       p50, p90, p99);
+        }
+        std::println(out, ", \"max_rss_kib\": {}}}{}", result.max_rss_kib,
+                     i + 1 < results.size() ? "," : "");
+    }
+    std::println(out, "  ]\n}}");
+}
+
+/// The raw text of "key": value on line, without quotes
+std::optional<std::string_view> Field(std::string_view line,
+                                      std::string_view key) {
+    const std::string quoted{std::format("\"{}\": ", key)};
+    const std::size_t start{line.find(quoted)};
+    if (start == std::string_view::npos) {
+        return std::nullopt;
+    }
+    line.remove_prefix(start + quoted.size());
+    if (line.starts_with('"')) {
+        line.remove_prefix(1);
+        return line.substr(0, line.find('"'));
+    }
+    return line.substr(0, line.find_first_of(",}"));
+}
+
+template <class Number>
+std::optional<Number> ParseNumber(std::string_view text) {
+    Number value{};
+    const auto [end, error]{
+        std::from_chars(text.data(), text.data() + text.size(), value)};
+    if (error != std::errc{} || end != text.data() + text.size()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+/// Reads back our own results from a previous run's output
+std::optional<std::vector<Result>> ReadBaseline(const std::string& path) {
+    std::ifstream in{path};
+    if (!in) {
+        return std::nullopt;
+    }
+    std::vector<Result> results{};
+    for (std::string line{}; std::getline(in, line);) {
+        const auto name{Field(line, "name")};
+        const auto value{Field(line, "value")};
+        if (!name || !value || Field(line, "implementation") != "coreutilspp") {
+            continue;
+        }
+        results.push_back({
+            .name = std::string{*name},
+            .implementation = "coreutilspp",
+            .unit = std::string{Field(line, "unit").value_or("")},
+            .value = ParseNumber<double>(*value).value_or(0),
+            .higher_is_better = Field(line, "higher_is_better") == "true",
+            .max_rss_kib = ParseNumber<long>(
+                               Field(line, "max_rss_kib").value_or("0"))
+                               .value_or(0),
+        });
+    }
+    return results;
+}
+
+/// Prints every result that is more than threshold (a fraction) worse than
+/// the baseline, and returns how many there were
+std::size_t ReportRegressions(std::span<const Result> results,
+                              std::span<const Result> baseline,
+                              double threshold) {
+    std::size_t regressions{0};
+    for (const Result& before : baseline) {
+        const auto after{std::ranges::find_if(results, [&](const Result& r) {
+            return r.name == before.name && r.implementation == "coreutilspp";
+        })};
+        if (after == results.end()) {
+            continue;
+        }
+
+        const bool slower{
+            before.higher_is_better
+                ? after->value < before.value * (1 - threshold)
+                : after->value > before.value * (1 + threshold)};
+        if (slower) {
+            std::println(std::cerr, "regression: {} {:.3f} -> {:.3f} {}",
+                         before.name, before.value, after->value, after->unit);
+            ++regressions;
+        }
+        if (before.max_rss_kib > 0 &&
+            static_cast<double>(after->max_rss_kib) >
+                static_cast<double>(before.max_rss_kib) * (1 + threshold)) {
+            std::println(std::cerr, "regression: {} max RSS {} -> {} KiB",
+                         before.name, before.max_rss_kib, after->max_rss_kib);
+            ++regressions;
+        }
+    }
+    return regressions;
+}
+
+}  // namespace
+
+int main(int argc, const char** argv) {
+    using Bench = coreutils::ProgramInfo<
+        "bench", "0.0.1", "bench [OPTION]... UTILITY...",
+        "Benchmark each built UTILITY (ls, yes, echo, mkdir, given by path),\n"
+        "and GNU's when it is on PATH, and print the results as JSON.\n"
+        "Exits with 1 if any result is worse than --baseline (a previous run's\n"
+        "output) by more than --threshold percent.">;
+    constexpr auto identity = [](std::string_view arg) { return arg; };
+    using Utilities = coreutils::PositionalArguments<std::string_view, identity>;
+    using Baseline =
+        coreutils::SingleValueArgument<std::string_view, identity, "--baseline">;
+    using Threshold =
+        coreutils::SingleValueArgument<std::string_view, identity,
+                                       "--threshold">;
+    using OutputFile =
+        coreutils::SingleValueArgument<std::string_view, identity, "-o",
+                                       "--output">;
+    using Runs =
+        coreutils::SingleValueArgument<std::string_view, identity, "--runs">;
+    using Entries =
+        coreutils::SingleValueArgument<std::string_view, identity,
+                                       "--entries">;
+    using Paths =
+        coreutils::SingleValueArgument<std::string_view, identity, "--paths">;
+    using Duration =
+        coreutils::SingleValueArgument<std::string_view, identity,
+                                       "--seconds">;
+    coreutils::ArgumentParser<Bench, Utilities, Baseline, Threshold,
+                              OutputFile, Runs, Entries, Paths, Duration>
+        parser{argc, argv};
+    parser.ParseArgsOrExit();
+
+    Settings settings{
+        .latency_runs = 200,
+        .repeats = 5,
+        .entries = 1'000'000,
+        .paths = 100'000,
+        .duration = Seconds{2},
+    };
+    double threshold{10};
+    bool valid{true};
+    const auto number = [&valid](auto& setting, std::string_view text) {
+        if (text.empty()) {
+            return;
+        }
+        const auto parsed{
+            ParseNumber<std::remove_reference_t<decltype(setting)>>(text)};
+        if (!parsed || *parsed <= 0) {
+            std::println(std::cerr, "bench: invalid number '{}'", text);
+            valid = false;
+            return;
+        }
+        setting = *parsed;
+    };
+    number(settings.latency_runs, parser.get<Runs>().value);
+    number(settings.entries, parser.get<Entries>().value);
+    number(settings.paths, parser.get<Paths>().value);
+    number(threshold, parser.get<Threshold>().value);
+    double seconds{settings.duration.count()};
+    number(seconds, parser.get<Duration>().value);
+    settings.duration = Seconds{seconds};
+    if (!valid) {
+        return 2;
+    }
+
+#if defined(__linux__)
+    std::vector<std::string> ours{};
+    for (const std::string_view utility : parser.get<Utilities>().value) {
+        std::error_code error{};
+        ours.push_back(std::filesystem::absolute(utility, error).string());
+    }
+    const auto find = [&ours](std::string_view name) {
+        return std::ranges::find_if(ours, [name](const std::string& path) {
+            return std::filesystem::path{path}.stem() == name;
+        });
+    };
+
+    Fixtures fixtures{settings};
+    if (!fixtures.ok()) {
+        std::println(std::cerr, "bench: could not create the fixtures");
+        return 2;
+    }
+
+    std::vector<Result> results{};
+    const auto record = [&results](std::optional<Result> result,
+                                   std::string_view what) {
+        if (result) {
+            results.push_back(std::move(*result));
+        } else {
+            std::println(std::cerr, "bench: {} failed", what);
+        }
+    };
+    for (const std::string_view name : {"ls", "yes", "echo", "mkdir"}) {
+        const auto mine{find(name)};
+        std::vector<std::pair<std::string_view, std::string>> implementations{};
+        if (mine != ours.end()) {
+            implementations.emplace_back("coreutilspp", *mine);
+        }
+        if (const auto gnu{FindOnPath(name, ours)}) {
+            implementations.emplace_back("gnu", *gnu);
+        }
+
+        for (const auto& [implementation, path] : implementations) {
+            std::vector<std::string> trivial{path};
+            if (name == "ls") {
+                trivial.push_back(fixtures.empty());
+            } else if (name == "yes") {
+                trivial.push_back("--version");
+            } else if (name == "echo") {
+                trivial.push_back("x");
+            } else {
+                trivial = {path, "-p", fixtures.empty()};
+            }
+            record(Latency(name, implementation, trivial, settings),
+                   std::format("{} {} latency", implementation, name));
+
+            if (name == "ls") {
+                record(Workload(
+                           "ls.flat", implementation,
+                           [&](std::size_t) {
+                               return std::vector<std::vector<std::string>>{
+                                   {path, fixtures.flat()}};
+                           },
+                           settings),
+                       std::format("{} ls.flat", implementation));
+            } else if (name == "yes") {
+                record(YesPipe(implementation, path, settings),
+                       std::format("{} yes.pipe", implementation));
+            } else if (name == "mkdir") {
+                record(Workload(
+                           "mkdir.nested", implementation,
+                           [&](std::size_t run) {
+                               return NestedCommands(
+                                   path, fixtures.nested(implementation, run),
+                                   settings.paths);
+                           },
+                           settings),
+                       std::format("{} mkdir.nested", implementation));
+            }
+        }
+    }
+
+    if (const std::string_view output{parser.get<OutputFile>().value};
+        !output.empty()) {
+        std::ofstream file{std::string{output}};
+        WriteJson(file, results);
+    } else {
+        WriteJson(std::cout, results);
+    }
+
+    if (const std::string_view path{parser.get<Baseline>().value};
+        !path.empty()) {
+        const std::optional<std::vector<Result>> baseline{
+            ReadBaseline(std::string{path})};
+        if (!baseline) {
+            std::println(std::cerr, "bench: cannot read baseline '{}'", path);
+            return 2;
+        }
+        if (ReportRegressions(results, *baseline, threshold / 100) > 0) {
+            return 1;
+        }
+    }
+    return 0;
+#else
+    std::println(std::cerr, "Benchmarks are only supported on Linux");
+    return 1;
+#endif
+}
@@ -0,0 +1,201 @@
+///
+///  @file main.cpp
+///  @brief Measure how fast yes can fill /dev/null and a pipe
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <print>
+#include <string_view>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <array>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <thread>
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Seconds = std::chrono::duration<double>;
+
+/// Time given to yes to start up before anything is measured
+constexpr std::chrono::milliseconds warmup{200};
+
+#if defined(__linux__)
+
+/// Starts yes with its standard output redirected to out_fd
+std::optional<pid_t> Spawn(const char* yes_path, int out_fd) {
+    const pid_t pid{::fork()};
+    if (pid == 0) {
+        ::dup2(out_fd, STDOUT_FILENO);
+        ::execl(yes_path, yes_path, nullptr);
+        ::_exit(127);
+    }
+    return pid > 0 ? std::optional{pid} : std::nullopt;
+}
+
+void Reap(pid_t pid) {
+    ::kill(pid, SIGKILL);
+    ::waitpid(pid, nullptr, 0);
+}
+
+/// Bytes a process has handed to write(2) and friends so far. This is the
+/// only way to see how much was written to /dev/null, as it keeps no tally.
+std::optional<std::uint64_t> WrittenBytes(pid_t pid) {
+    std::ifstream io{"/proc/" + std::to_string(pid) + "/io"};
+    for (std::string key{}; io >> key;) {
+        std::uint64_t value{};
+        io >> value;
+        if (key == "wchar:") {
+            return value;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<double> DevNullThroughput(const char* yes_path,
+                                        Seconds duration) {
+    const int sink{::open("/dev/null", O_WRONLY | O_CLOEXEC)};
+    if (sink < 0) {
+        return std::nullopt;
+    }
+    const std::optional<pid_t> pid{Spawn(yes_path, sink)};
+    ::close(sink);
+    if (!pid) {
+        return std::nullopt;
+    }
+
+    std::this_thread::sleep_for(warmup);
+    const std::optional<std::uint64_t> before{WrittenBytes(*pid)};
+    const Clock::time_point start{Clock::now()};
+    std::this_thread::sleep_for(duration);
+    const std::optional<std::uint64_t> after{WrittenBytes(*pid)};
+    const Seconds elapsed{Clock::now() - start};
+    Reap(*pid);
+
+    if (!before || !after) {
+        return std::nullopt;
+    }
+    return static_cast<double>(*after - *before) / elapsed.count();
+}
+
+std::optional<double> PipeThroughput(const char* yes_path, Seconds duration) {
+    std::array<int, 2> fds{};
+    if (::pipe2(fds.data(), O_CLOEXEC) != 0) {
+        return std::nullopt;
+    }
+    const auto [read_end, write_end]{fds};
+    const std::optional<pid_t> pid{Spawn(yes_path, write_end)};
+    ::close(write_end);
+    if (!pid) {
+        ::close(read_end);
+        return std::nullopt;
+    }
+
+    // drain through splice so the reading side costs as little as possible,
+    // falling back to read(2) if this kernel cannot splice into /dev/null
+    const int sink{::open("/dev/null", O_WRONLY | O_CLOEXEC)};
+    std::array<char, 128 * 1024> scratch{};
+    bool use_splice{sink >= 0};
+    const auto drain{[&]() -> ssize_t {
+        if (use_splice) {
+            const ssize_t moved{::splice(read_end, nullptr, sink, nullptr,
+                                         scratch.size(), SPLICE_F_MOVE)};
+            if (moved >= 0 || errno != EINVAL) {
+                return moved;
+            }
+            use_splice = false;
+        }
+        return ::read(read_end, scratch.data(), scratch.size());
+    }};
+
+    for (const Clock::time_point end{Clock::now() + warmup};
+         Clock::now() < end && drain() > 0;) {
+    }
+
+    std::uint64_t total{0};
+    const Clock::time_point start{Clock::now()};
+    for (const auto end{start + duration}; Clock::now() < end;) {
+        const ssize_t moved{drain()};
+        if (moved <= 0) {
+            break;
+        }
+        total += static_cast<std::uint64_t>(moved);
+    }
+    const Seconds elapsed{Clock::now() - start};
+
+    Reap(*pid);
+    ::close(read_end);
+    if (sink >= 0) {
+        ::close(sink);
+    }
+    return static_cast<double>(total) / elapsed.count();
+}
+
+#endif
+
+void Report(std::string_view sink, auto throughput) {
+    if (throughput) {
+        std::println("yes -> {:<10} {:>8.3f} GB/s", sink, *throughput / 1e9);
+    } else {
+        std::println("yes -> {:<10} {:>8}", sink, "failed");
+    }
+}
+
+}  // namespace
+
+int main(int argc, const char** argv) {
+    if (argc < 2) {
+        std::println(std::cerr, "Usage: {} PATH_TO_YES [SECONDS]", argv[0]);
+        return 1;
+    }
+
+    double seconds{2.0};
+    if (argc > 2) {
+        const std::string_view arg{argv[2]};
+        if (std::from_chars(arg.data(), arg.data() + arg.size(), seconds).ec !=
+                std::errc{} ||
+            seconds <= 0) {
+            std::println(std::cerr, "Invalid duration: {}", arg);
+            return 1;
+        }
+    }
+
+#if defined(__linux__)
+    const Seconds duration{seconds};
+    Report("/dev/null", DevNullThroughput(argv[1], duration));
+    Report("pipe", PipeThroughput(argv[1], duration));
+    return 0;
+#else
+    std::println(std::cerr, "Throughput measurement is only supported on "
+                            "Linux");
+    return 1;
+#endif
+}
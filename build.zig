@@ -25,6 +25,9 @@ const Config = struct {
     target: std.Build.ResolvedTarget,
     optimize: std.builtin.OptimizeMode,
     compiledb: bool,
+    no_exceptions: bool = false,
+    stats: bool = false,
+    io_uring: bool = false,
 };
 
 const common_cpp_flags = [_][]const u8{
@@ -37,6 +40,49 @@ const common_cpp_flags = [_][]const u8{
     "-Werror",
 };
 
+/// Links `coreutilspp` as a symlink to the multicall binary under every
+/// utility's name, so that running e.g. `ls` dispatches to ls
+const InstallSymlinks = struct {
+    step: std.Build.Step,
+    dir: []const u8,
+    target: []const u8,
+    names: []const []const u8,
+
+    pub fn create(
+        b: *std.Build,
+        dir: []const u8,
+        target: []const u8,
+        names: []const []const u8,
+    ) std.mem.Allocator.Error!*InstallSymlinks {
+        const self = try b.allocator.create(InstallSymlinks);
+        self.* = .{
+            .step = .init(.{
+                .id = .custom,
+                .name = "install multicall symlinks",
+                .owner = b,
+                .makeFn = make,
+            }),
+            .dir = dir,
+            .target = target,
+            .names = names,
+        };
+        return self;
+    }
+
+    fn make(step: *std.Build.Step, _: std.Build.Step.MakeOptions) anyerror!void {
+        const self: *InstallSymlinks = @fieldParentPtr("step", step);
+        var dir = try std.fs.cwd().makeOpenPath(self.dir, .{});
+        defer dir.close();
+        for (self.names) |name| {
+            dir.deleteFile(name) catch |err| switch (err) {
+                error.FileNotFound => {},
+                else => return err,
+            };
+            try dir.symLink(self.target, name, .{});
+        }
+    }
+};
+
 fn tmpJsonPath(
     buf: *std.ArrayList([]const u8),
     allocator: std.mem.Allocator,
@@ -59,6 +105,7 @@ fn tmpJsonPath(
 const CommonModule = struct {
     name: []const u8,
     module: *std.Build.Module,
+    root_source_file: []const u8,
 
     pub fn create(config: Config) std.mem.Allocator.Error!CommonModule {
         const module = config.b.createModule(.{
@@ -73,6 +120,15 @@ const CommonModule = struct {
         for (common_cpp_flags) |flag| {
             try flags.append(allocator, flag);
         }
+        if (config.no_exceptions) {
+            try flags.append(allocator, "-fno-exceptions");
+        }
+        if (config.stats) {
+            try flags.append(allocator, "-DCOREUTILS_STATS");
+        }
+        if (config.io_uring) {
+            try flags.append(allocator, "-DCOREUTILS_IO_URING");
+        }
         if (config.compiledb) {
             try tmpJsonPath(&flags, config.b.allocator, config.root_source_file);
         }
@@ -87,6 +143,7 @@ const CommonModule = struct {
         return .{
             .name = config.name,
             .module = module,
+            .root_source_file = config.root_source_file,
         };
     }
 };
@@ -120,6 +177,27 @@ pub fn build(b: *std.Build) std.mem.Allocator.Error!void {
         "Generate compile_commands.json for this project",
     ) orelse false;
 
+    const no_exceptions: bool = b.option(
+        bool,
+        "no_exceptions",
+        "Build the utilities with -fno-exceptions",
+    ) orelse false;
+
+    // off by default, so that release builds carry none of the counting
+    const stats: bool = b.option(
+        bool,
+        "stats",
+        "Build the utilities with --stats (and COREUTILSPP_STATS=path)",
+    ) orelse false;
+
+    // off by default: some sandboxes and container runtimes forbid io_uring
+    // (falling back costs a failed syscall), and some kernels lack it
+    const io_uring: bool = b.option(
+        bool,
+        "io_uring",
+        "Batch the utilities' I/O through io_uring where the kernel allows",
+    ) orelse false;
+
     // compiledb
     const compile_db_step = b.step(
         "compiledb",
@@ -148,6 +226,18 @@ pub fn build(b: *std.Build) std.mem.Allocator.Error!void {
         yes: CommonModule,
         echo: CommonModule,
         mkdir: CommonModule,
+        cat: CommonModule,
+        wc: CommonModule,
+        sort: CommonModule,
+        cp: CommonModule,
+        du: CommonModule,
+        md5sum: CommonModule,
+        sha256sum: CommonModule,
+        b2sum: CommonModule,
+        tail: CommonModule,
+        head: CommonModule,
+        tr: CommonModule,
+        printf: CommonModule,
     };
 
     const modules: CoreUtils = .{
@@ -158,6 +248,9 @@ pub fn build(b: *std.Build) std.mem.Allocator.Error!void {
             .target = target,
             .optimize = optimize,
             .compiledb = create_compiledb,
+            .no_exceptions = no_exceptions,
+            .stats = stats,
+            .io_uring = io_uring,
         }),
         .yes = try .create(.{
             .b = b,
@@ -166,6 +259,9 @@ pub fn build(b: *std.Build) std.mem.Allocator.Error!void {
             .target = target,
             .optimize = optimize,
             .compiledb = create_compiledb,
+            .no_exceptions = no_exceptions,
+            .stats = stats,
+            .io_uring = io_uring,
         }),
         .echo = try .create(.{
             .b = b,
@@ -174,6 +270,9 @@ pub fn build(b: *std.Build) std.mem.Allocator.Error!void {
             .target = target,
             .optimize = optimize,
             .compiledb = create_compiledb,
+            .no_exceptions = no_exceptions,
+            .stats = stats,
+            .io_uring = io_uring,
         }),
         .mkdir = try .create(.{
             .b = b,
@@ -182,9 +281,244 @@ pub fn build(b: *std.Build) std.mem.Allocator.Error!void {
             .target = target,
             .optimize = optimize,
             .compiledb = create_compiledb,
+            .no_exceptions = no_exceptions,
+            .stats = stats,
+            .io_uring = io_uring,
+        }),
+        .cat = try .create(.{
+            .b = b,
+            .name = "cat",
+            .root_source_file = "coreutils/cat/main.cpp",
+            .target = target,
+            .optimize = optimize,
+            .compiledb = create_compiledb,
+            .no_exceptions = no_exceptions,
+            .stats = stats,
+            .io_uring = io_uring,
+        }),
+        .wc = try .create(.{
+            .b = b,
+            .name = "wc",
+            .root_source_file = "coreutils/wc/main.cpp",
+            .target = target,
+            .optimize = optimize,
+            .compiledb = create_compiledb,
+            .no_exceptions = no_exceptions,
+            .stats = stats,
+            .io_uring = io_uring,
+        }),
+        .sort = try .create(.{
+            .b = b,
+            .name = "sort",
+            .root_source_file = "coreutils/sort/main.cpp",
+            .target = target,
+            .optimize = optimize,
+            .compiledb = create_compiledb,
+            .no_exceptions = no_exceptions,
+            .stats = stats,
+            .io_uring = io_uring,
+        }),
+        .cp = try .create(.{
+            .b = b,
+            .name = "cp",
+            .root_source_file = "coreutils/cp/main.cpp",
+            .target = target,
+            .optimize = optimize,
+            .compiledb = create_compiledb,
+            .no_exceptions = no_exceptions,
+            .stats = stats,
+            .io_uring = io_uring,
+        }),
+        .du = try .create(.{
+            .b = b,
+            .name = "du",
+            .root_source_file = "coreutils/du/main.cpp",
+            .target = target,
+            .optimize = optimize,
+            .compiledb = create_compiledb,
+            .no_exceptions = no_exceptions,
+            .stats = stats,
+            .io_uring = io_uring,
+        }),
+        .md5sum = try .create(.{
+            .b = b,
+            .name = "md5sum",
+            .root_source_file = "coreutils/md5sum/main.cpp",
+            .target = target,
+            .optimize = optimize,
+            .compiledb = create_compiledb,
+            .no_exceptions = no_exceptions,
+            .stats = stats,
+            .io_uring = io_uring,
+        }),
+        .sha256sum = try .create(.{
+            .b = b,
+            .name = "sha256sum",
+            .root_source_file = "coreutils/sha256sum/main.cpp",
+            .target = target,
+            .optimize = optimize,
+            .compiledb = create_compiledb,
+            .no_exceptions = no_exceptions,
+            .stats = stats,
+            .io_uring = io_uring,
+        }),
+        .b2sum = try .create(.{
+            .b = b,
+            .name = "b2sum",
+            .root_source_file = "coreutils/b2sum/main.cpp",
+            .target = target,
+            .optimize = optimize,
+            .compiledb = create_compiledb,
+            .no_exceptions = no_exceptions,
+            .stats = stats,
+            .io_uring = io_uring,
+        }),
+        .tail = try .create(.{
+            .b = b,
+            .name = "tail",
+            .root_source_file = "coreutils/tail/main.cpp",
+            .target = target,
+            .optimize = optimize,
+            .compiledb = create_compiledb,
+            .no_exceptions = no_exceptions,
+            .stats = stats,
+            .io_uring = io_uring,
+        }),
+        .head = try .create(.{
+            .b = b,
+            .name = "head",
+            .root_source_file = "coreutils/head/main.cpp",
+            .target = target,
+            .optimize = optimize,
+            .compiledb = create_compiledb,
+            .no_exceptions = no_exceptions,
+            .stats = stats,
+            .io_uring = io_uring,
+        }),
+        .tr = try .create(.{
+            .b = b,
+            .name = "tr",
+            .root_source_file = "coreutils/tr/main.cpp",
+            .target = target,
+            .optimize = optimize,
+            .compiledb = create_compiledb,
+            .no_exceptions = no_exceptions,
+            .stats = stats,
+            .io_uring = io_uring,
+        }),
+        .printf = try .create(.{
+            .b = b,
+            .name = "printf",
+            .root_source_file = "coreutils/printf/main.cpp",
+            .target = target,
+            .optimize = optimize,
+            .compiledb = create_compiledb,
+            .no_exceptions = no_exceptions,
+            .stats = stats,
+            .io_uring = io_uring,
         }),
     };
 
+    // Throughput
+    const throughput_yes = b.step(
+        "throughput_yes",
+        "Report yes throughput (GB/s) into /dev/null and a pipe",
+    );
+    const throughput_yes_module: CommonModule = try .create(.{
+        .b = b,
+        .name = "yes_throughput",
+        .root_source_file = "bench/yes/main.cpp",
+        .target = target,
+        .optimize = optimize,
+        .compiledb = create_compiledb,
+    });
+
+    // Benchmarks
+    const bench = b.step(
+        "bench",
+        "Benchmark every utility (and GNU's, if on PATH) and print JSON",
+    );
+    const bench_module: CommonModule = try .create(.{
+        .b = b,
+        .name = "bench",
+        .root_source_file = "bench/suite/main.cpp",
+        .target = target,
+        .optimize = optimize,
+        .compiledb = create_compiledb,
+    });
+    const bench_exe = b.addExecutable(.{
+        .name = bench_module.name,
+        .root_module = bench_module.module,
+    });
+    const run_bench = b.addRunArtifact(bench_exe);
+    // e.g. zig build bench -- --baseline bench.json --threshold 5
+    if (b.args) |args| {
+        run_bench.addArgs(args);
+    }
+    bench.dependOn(&run_bench.step);
+    if (create_compiledb) {
+        runcompiledb.step.dependOn(&bench_exe.step);
+    }
+
+    const bench_argparse = b.step(
+        "bench_argparse",
+        "Benchmark ArgumentParser's parse throughput and compile cost as JSON",
+    );
+    const bench_argparse_module: CommonModule = try .create(.{
+        .b = b,
+        .name = "bench_argparse",
+        .root_source_file = "bench/argparse/main.cpp",
+        .target = target,
+        .optimize = optimize,
+        .compiledb = create_compiledb,
+    });
+    const bench_argparse_exe = b.addExecutable(.{
+        .name = bench_argparse_module.name,
+        .root_module = bench_argparse_module.module,
+    });
+    const run_bench_argparse = b.addRunArtifact(bench_argparse_exe);
+    // e.g. zig build bench_argparse -- --seconds 5 --runs 5
+    if (b.args) |args| {
+        run_bench_argparse.addArgs(args);
+    }
+    run_bench_argparse.addArg("--source");
+    run_bench_argparse.addFileArg(b.path("bench/argparse/instantiate.cpp"));
+    run_bench_argparse.addArg("--include");
+    run_bench_argparse.addDirectoryArg(b.path(""));
+    // compile times are measured with the compiler the utilities are built
+    // with
+    run_bench_argparse.addArgs(&.{ "--", b.graph.zig_exe, "c++" });
+    bench_argparse.dependOn(&run_bench_argparse.step);
+    if (create_compiledb) {
+        runcompiledb.step.dependOn(&bench_argparse_exe.step);
+    }
+
+    const bench_input = b.step(
+        "bench_input",
+        "Benchmark mapping files against reading them, by size, as JSON",
+    );
+    const bench_input_module: CommonModule = try .create(.{
+        .b = b,
+        .name = "bench_input",
+        .root_source_file = "bench/input/main.cpp",
+        .target = target,
+        .optimize = optimize,
+        .compiledb = create_compiledb,
+    });
+    const bench_input_exe = b.addExecutable(.{
+        .name = bench_input_module.name,
+        .root_module = bench_input_module.module,
+    });
+    const run_bench_input = b.addRunArtifact(bench_input_exe);
+    // e.g. zig build bench_input -- --max-size 1024 --directory /mnt/disk
+    if (b.args) |args| {
+        run_bench_input.addArgs(args);
+    }
+    bench_input.dependOn(&run_bench_input.step);
+    if (create_compiledb) {
+        runcompiledb.step.dependOn(&bench_input_exe.step);
+    }
+
     inline for (comptime std.meta.fieldNames(CoreUtils)) |field| {
         const coreutil: CommonModule = @field(modules, field);
         const exe = b.addExecutable(.{
@@ -215,14 +549,124 @@ pub fn build(b: *std.Build) std.mem.Allocator.Error!void {
         if (create_compiledb) {
             runcompiledb.step.dependOn(&exe.step);
         }
+
+        run_bench.addArtifactArg(exe);
+
+        if (comptime std.mem.eql(u8, field, "yes")) {
+            const throughput_exe = b.addExecutable(.{
+                .name = throughput_yes_module.name,
+                .root_module = throughput_yes_module.module,
+            });
+            const run_throughput = b.addRunArtifact(throughput_exe);
+            run_throughput.addArtifactArg(exe);
+            if (b.args) |args| {
+                run_throughput.addArgs(args);
+            }
+            throughput_yes.dependOn(&run_throughput.step);
+
+            if (create_compiledb) {
+                runcompiledb.step.dependOn(&throughput_exe.step);
+            }
+        }
     }
 
+    // Multicall: every utility linked into one binary, which picks the
+    // utility to run from argv[0] (or from its first argument)
+    const multicall_step = b.step(
+        "multicall",
+        "Build every utility into one binary, symlinked under each name",
+    );
+    const registry = b.addWriteFiles();
+    _ = registry.add("utilities.inc", comptime registry: {
+        var lines: []const u8 = "";
+        for (std.meta.fieldNames(CoreUtils)) |field| {
+            lines = lines ++ "COREUTILS_UTILITY(" ++ field ++ ")\n";
+        }
+        break :registry lines;
+    });
+
+    const multicall_module = b.createModule(.{
+        .target = target,
+        .optimize = optimize,
+        .link_libcpp = true,
+        .strip = optimize != .Debug,
+    });
+    var multicall_flags: std.ArrayList([]const u8) = .empty;
+    for (common_cpp_flags) |flag| {
+        try multicall_flags.append(b.allocator, flag);
+    }
+    try multicall_flags.append(b.allocator, "-DCOREUTILS_MULTICALL");
+    if (no_exceptions) {
+        try multicall_flags.append(b.allocator, "-fno-exceptions");
+    }
+    if (stats) {
+        try multicall_flags.append(b.allocator, "-DCOREUTILS_STATS");
+    }
+    if (io_uring) {
+        try multicall_flags.append(b.allocator, "-DCOREUTILS_IO_URING");
+    }
+    multicall_module.addCSourceFile(.{
+        .file = b.path("multicall/main.cpp"),
+        .flags = multicall_flags.items,
+        .language = .cpp,
+    });
+    inline for (comptime std.meta.fieldNames(CoreUtils)) |field| {
+        multicall_module.addCSourceFile(.{
+            .file = b.path(@field(modules, field).root_source_file),
+            .flags = multicall_flags.items,
+            .language = .cpp,
+        });
+    }
+    multicall_module.addIncludePath(b.path(""));
+    multicall_module.addIncludePath(registry.getDirectory());
+
+    const multicall_exe = b.addExecutable(.{
+        .name = "coreutilspp",
+        .root_module = multicall_module,
+    });
+    multicall_exe.lto = switch (optimize) {
+        .Debug => .none,
+        else => .full,
+    };
+    // a directory of its own, so the symlinks do not clobber the standalone
+    // utilities
+    const multicall_dir = b.pathJoin(&.{ target_str, "multicall" });
+    const install_multicall = b.addInstallArtifact(multicall_exe, .{
+        .dest_dir = .{
+            .override = .{ .custom = multicall_dir },
+        },
+    });
+    var link_names: std.ArrayList([]const u8) = .empty;
+    inline for (comptime std.meta.fieldNames(CoreUtils)) |field| {
+        try link_names.append(
+            b.allocator,
+            b.fmt("{s}{s}", .{ field, target.result.exeFileExt() }),
+        );
+    }
+    const install_symlinks: *InstallSymlinks = try .create(
+        b,
+        b.getInstallPath(.{ .custom = multicall_dir }, ""),
+        multicall_exe.out_filename,
+        link_names.items,
+    );
+    install_symlinks.step.dependOn(&install_multicall.step);
+    multicall_step.dependOn(&install_symlinks.step);
+
     // Tests
 
     const test_step = b.step("test", "Run unit tests");
 
     const cpp_test_files = [_][]const u8{
         "tests/ArgumentParser/tests.cpp",
+        "tests/StringSort/tests.cpp",
+        "tests/TextCount/tests.cpp",
+        "tests/InodeSet/tests.cpp",
+        "tests/Checksum/tests.cpp",
+        "tests/Translate/tests.cpp",
+        "tests/Escapes/tests.cpp",
+        "tests/FileInput/tests.cpp",
+        "tests/AsyncIo/tests.cpp",
+        "tests/SortKey/tests.cpp",
     };
 
     const test_mod = b.createModule(.{
@@ -241,6 +685,10 @@ pub fn build(b: *std.Build) std.mem.Allocator.Error!void {
         for (common_cpp_flags) |common_flag| {
             try flags.append(b.allocator, common_flag);
         }
+        // so that zig build test -Dio_uring tests the ring
+        if (io_uring) {
+            try flags.append(b.allocator, "-DCOREUTILS_IO_URING");
+        }
         if (create_compiledb) {
             try tmpJsonPath(&flags, b.allocator, file);
         }
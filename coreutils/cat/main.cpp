@@ -0,0 +1,405 @@
+///
+///  @file main.cpp
+///  @brief Concatenate files to standard output
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <iostream>
+#include <print>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "lib/ArgumentParser.hpp"
+#include "lib/FileCopy.hpp"
+#include "lib/FileInput.hpp"
+#include "lib/Main.hpp"
+#include "lib/Output.hpp"
+
+namespace {
+
+constexpr int standard_output{1};
+
+/// What to do to the text on its way through. With none of these the bytes
+/// are copied as is, and can stay in the kernel.
+struct Transforms final {
+    bool number;
+    bool number_nonblank;
+    bool squeeze_blank;
+    bool show_ends;
+    bool show_tabs;
+    bool show_nonprinting;
+
+    bool any() const {
+        return number || number_nonblank || squeeze_blank || show_ends ||
+               show_tabs || show_nonprinting;
+    }
+};
+
+/// Whether reading in would mean reading what is being written, e.g.
+/// cat log >> log, which would never end
+bool IsOutput(int in) {
+#if defined(_WIN32)
+    (void)in;
+    return false;
+#else
+    struct stat input {};
+    struct stat output {};
+    if (::fstat(in, &input) != 0 || ::fstat(standard_output, &output) != 0) {
+        return false;
+    }
+    return S_ISREG(input.st_mode) && input.st_dev == output.st_dev &&
+           input.st_ino == output.st_ino &&
+           ::lseek(in, 0, SEEK_CUR) < input.st_size;
+#endif
+}
+
+/// Repeats b in every byte of a word
+constexpr std::uint64_t Bytes(std::uint8_t b) {
+    return 0x0101010101010101u * b;
+}
+
+/// Whether any byte of word is below n (n <= 128)
+constexpr bool HasLess(std::uint64_t word, std::uint8_t n) {
+    return ((word - Bytes(n)) & ~word & Bytes(0x80)) != 0;
+}
+
+constexpr bool HasZero(std::uint64_t word) { return HasLess(word, 1); }
+
+/// The text filter behind -nbsETv. Lines can span reads (and files, as with
+/// GNU cat, numbering carries on from one file into the next), so where it
+/// is in a line is kept between calls.
+class LineFilter final {
+ public:
+    explicit LineFilter(const Transforms& transforms)
+        : transforms_{transforms} {
+        for (std::size_t c{0}; c < spellings_.size(); ++c) {
+            spellings_[c] = Spell(static_cast<unsigned char>(c));
+        }
+    }
+
+    void Feed(std::string_view data, coreutils::Output& out) {
+        while (!data.empty()) {
+            if (at_line_start_) {
+                const bool blank{data.front() == '\n'};
+                if (blank && transforms_.squeeze_blank && previous_blank_) {
+                    data.remove_prefix(1);
+                    continue;
+                }
+                previous_blank_ = blank;
+                at_line_start_ = false;
+                if (transforms_.number_nonblank ? !blank
+                                                : transforms_.number) {
+                    ++line_number_;
+                    const std::size_t digits{Digits(line_number_)};
+                    out.Fill(' ', digits < 6 ? 6 - digits : 0)
+                        .Write(line_number_)
+                        .Put('\t');
+                }
+            }
+
+            // memchr is vectorized by every libc worth using
+            const void* const newline{
+                std::memchr(data.data(), '\n', data.size())};
+            const std::size_t length{
+                newline ? static_cast<std::size_t>(
+                              static_cast<const char*>(newline) - data.data())
+                        : data.size()};
+            std::string_view line{data.substr(0, length)};
+            if (pending_return_) {
+                pending_return_ = false;
+                out.Write(newline && line.empty() ? "^M" : "\r");
+            }
+            // like GNU cat, -E shows a carriage return ending a line, so that
+            // CRLF line endings can be told apart
+            if (transforms_.show_ends && !transforms_.show_nonprinting &&
+                line.ends_with('\r')) {
+                line.remove_suffix(1);
+                WriteVisible(line, out);
+                if (newline) {
+                    out.Write("^M");
+                } else {
+                    // the newline may be in the next read
+                    pending_return_ = true;
+                }
+            } else {
+                WriteVisible(line, out);
+            }
+            if (!newline) {
+                return;
+            }
+            if (transforms_.show_ends) {
+                out.Put('$');
+            }
+            out.Put('\n');
+            at_line_start_ = true;
+            data.remove_prefix(length + 1);
+        }
+    }
+
+    /// Called after the last input
+    void Finish(coreutils::Output& out) {
+        if (pending_return_) {
+            pending_return_ = false;
+            out.Put('\r');
+        }
+    }
+
+ private:
+    static std::size_t Digits(std::uint64_t n) {
+        std::size_t digits{1};
+        for (; n >= 10; n /= 10) {
+            ++digits;
+        }
+        return digits;
+    }
+
+    /// How a byte is written out: as itself, or in ^ and M- notation (as in
+    /// GNU cat -v)
+    struct Spelling final {
+        std::array<char, 4> text;
+        std::uint8_t length;
+        bool plain;
+    };
+
+    Spelling Spell(unsigned char c) const {
+        const bool escaped{c == '\t' ? transforms_.show_tabs
+                                     : transforms_.show_nonprinting &&
+                                           (c < 0x20 || c >= 0x7f)};
+        if (!escaped) {
+            return {.text{static_cast<char>(c)}, .length = 1, .plain = true};
+        }
+
+        Spelling spelling{.text{}, .length = 0, .plain = false};
+        if (c >= 0x80) {
+            spelling.text[spelling.length++] = 'M';
+            spelling.text[spelling.length++] = '-';
+            c = static_cast<unsigned char>(c - 0x80);
+        }
+        if (c < 0x20) {
+            spelling.text[spelling.length++] = '^';
+            spelling.text[spelling.length++] = static_cast<char>(c + 0x40);
+        } else if (c == 0x7f) {
+            spelling.text[spelling.length++] = '^';
+            spelling.text[spelling.length++] = '?';
+        } else {
+            spelling.text[spelling.length++] = static_cast<char>(c);
+        }
+        return spelling;
+    }
+
+    /// Length of the longest prefix of line that can be written as is. Eight
+    /// bytes are checked at a time, and only words that might hold something
+    /// to escape are looked at byte by byte.
+    std::size_t PlainPrefix(std::string_view line) const {
+        if (!transforms_.show_nonprinting) {
+            const void* const tab{std::memchr(line.data(), '\t', line.size())};
+            return tab ? static_cast<std::size_t>(
+                             static_cast<const char*>(tab) - line.data())
+                       : line.size();
+        }
+
+        std::size_t i{0};
+        for (; i + sizeof(std::uint64_t) <= line.size();
+             i += sizeof(std::uint64_t)) {
+            std::uint64_t word{};
+            std::memcpy(&word, line.data() + i, sizeof(word));
+            // control characters, DEL, and anything with the high bit set
+            if (HasLess(word, 0x20) || (word & Bytes(0x80)) != 0 ||
+                HasZero(word ^ Bytes(0x7f))) {
+                break;
+            }
+        }
+        for (; i < line.size(); ++i) {
+            if (!spellings_[static_cast<unsigned char>(line[i])].plain) {
+                return i;
+            }
+        }
+        return line.size();
+    }
+
+    void WriteVisible(std::string_view line, coreutils::Output& out) const {
+        if (!transforms_.show_tabs && !transforms_.show_nonprinting) {
+            out.Write(line);
+            return;
+        }
+
+        // plain runs go straight out. Once something needs escaping, bytes
+        // are spelled out one at a time (through a table, into a staging
+        // buffer) until a run of plain bytes makes the word at a time scan
+        // worth going back to, as binary data is escapes all the way through.
+        constexpr std::size_t worthwhile_run{16};
+        // left uninitialized: lines are often far shorter than the buffer
+        std::array<char, 4096> staged;
+        while (!line.empty()) {
+            const std::size_t plain{PlainPrefix(line)};
+            out.Write(line.substr(0, plain));
+            line.remove_prefix(plain);
+
+            std::size_t used{0};
+            for (std::size_t run{0}; !line.empty() && run < worthwhile_run &&
+                                     used + 4 <= staged.size();
+                 line.remove_prefix(1)) {
+                const Spelling& spelling{
+                    spellings_[static_cast<unsigned char>(line.front())]};
+                std::memcpy(staged.data() + used, spelling.text.data(), 4);
+                used += spelling.length;
+                run = (run + 1) * spelling.plain;
+            }
+            out.Write({staged.data(), used});
+        }
+    }
+
+    Transforms transforms_;
+    std::array<Spelling, 256> spellings_{};
+    std::uint64_t line_number_{0};
+    bool at_line_start_{true};
+    bool previous_blank_{false};
+    /// A carriage return held back to see if a newline follows
+    bool pending_return_{false};
+};
+
+}  // namespace
+
+COREUTILS_MAIN(cat) {
+    using Cat = coreutils::ProgramInfo<
+        "cat", "0.0.1", "Usage: cat [OPTION]... [FILE]...",
+        "Concatenate FILE(s) to standard output.\n\n"
+        "With no FILE, or when FILE is -, read standard input.">;
+    using PosArgs = coreutils::PositionalArguments<
+        std::string_view, [](std::string_view arg) { return arg; },
+        coreutils::ArgvView>;
+    using ShowAll = coreutils::BooleanArgument<"-A", "--show-all">;
+    using NumberNonblank =
+        coreutils::BooleanArgument<"-b", "--number-nonblank">;
+    using ShowNonprintingEnds = coreutils::BooleanArgument<"-e">;
+    using ShowEnds = coreutils::BooleanArgument<"-E", "--show-ends">;
+    using Number = coreutils::BooleanArgument<"-n", "--number">;
+    using SqueezeBlank = coreutils::BooleanArgument<"-s", "--squeeze-blank">;
+    using ShowNonprintingTabs = coreutils::BooleanArgument<"-t">;
+    using ShowTabs = coreutils::BooleanArgument<"-T", "--show-tabs">;
+    using Unbuffered = coreutils::BooleanArgument<"-u">;
+    using ShowNonprinting =
+        coreutils::BooleanArgument<"-v", "--show-nonprinting">;
+    coreutils::ArgumentParser<Cat, PosArgs, ShowAll, NumberNonblank,
+                              ShowNonprintingEnds, ShowEnds, Number,
+                              SqueezeBlank, ShowNonprintingTabs, ShowTabs,
+                              Unbuffered, ShowNonprinting>
+        parser{argc, argv};
+    parser.ParseArgsOrExit();
+
+    const bool all{parser.get<ShowAll>().value};
+    const bool e{parser.get<ShowNonprintingEnds>().value};
+    const bool t{parser.get<ShowNonprintingTabs>().value};
+    const Transforms transforms{
+        .number = parser.get<Number>().value,
+        .number_nonblank = parser.get<NumberNonblank>().value,
+        .squeeze_blank = parser.get<SqueezeBlank>().value,
+        .show_ends = all || e || parser.get<ShowEnds>().value,
+        .show_tabs = all || t || parser.get<ShowTabs>().value,
+        .show_nonprinting =
+            all || e || t || parser.get<ShowNonprinting>().value,
+    };
+
+    coreutils::CopyBuffer buffer{};
+    coreutils::Output out{};
+    LineFilter filter{transforms};
+    int status{0};
+    // false once writing has failed, after which there is no point going on
+    const auto cat = [&](std::string_view target) {
+        // targets are views into argv, so they are null terminated
+        const std::expected<coreutils::InputFile, std::error_code> input{
+            coreutils::InputFile::Open(target.data())};
+        if (!input) {
+            std::println(std::cerr, "cat: {}: {}", target,
+                         input.error().message());
+            status = 1;
+            return true;
+        } else if (IsOutput(input->fd())) {
+            std::println(std::cerr, "cat: {}: input file is output file",
+                         target);
+            status = 1;
+            return true;
+        }
+
+        if (transforms.any()) {
+            while (true) {
+                const std::expected<std::size_t, std::error_code> got{
+                    coreutils::ReadSome(input->fd(), buffer.span())};
+                if (!got) {
+                    std::println(std::cerr, "cat: {}: {}", target,
+                                 got.error().message());
+                    status = 1;
+                    return true;
+                } else if (*got == 0) {
+                    return !out.error();
+                }
+                filter.Feed({buffer.span().data(), *got}, out);
+                if (out.error()) {
+                    return false;
+                }
+            }
+        }
+
+        const coreutils::CopyResult copied{
+            coreutils::CopyAll(input->fd(), standard_output, buffer.span())};
+        if (!copied && copied.error().writing) {
+            std::println(std::cerr, "cat: write error: {}",
+                         copied.error().error.message());
+            status = 1;
+            return false;
+        } else if (!copied) {
+            std::println(std::cerr, "cat: {}: {}", target,
+                         copied.error().error.message());
+            status = 1;
+        }
+        return true;
+    };
+
+    const auto& targets{parser.get<PosArgs>().value};
+    if (targets.empty()) {
+        cat("-");
+    }
+    for (const std::string_view target : targets) {
+        if (!cat(target)) {
+            break;
+        }
+    }
+
+    filter.Finish(out);
+    if (const std::error_code error{out.Flush()}; error) {
+        std::println(std::cerr, "cat: write error: {}", error.message());
+        return 1;
+    }
+    return status;
+}
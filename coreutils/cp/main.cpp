@@ -0,0 +1,654 @@
+///
+///  @file main.cpp
+///  @brief Copy files and directories
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <expected>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <print>
+#include <semaphore>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "lib/Arena.hpp"
+#include "lib/ArgumentParser.hpp"
+#include "lib/DirectoryReader.hpp"
+#include "lib/FileCopy.hpp"
+#include "lib/Main.hpp"
+#include "lib/MakeDirectory.hpp"
+#include "lib/Parallel.hpp"
+#include "lib/WorkStealingPool.hpp"
+
+namespace {
+
+struct Options final {
+    bool recursive;
+    /// -p: permissions, ownership and timestamps
+    bool preserve;
+    /// Copy symlinks as symlinks, rather than what they point to
+    bool no_dereference;
+};
+
+/// Errors can come from any worker, so they are written out one at a time
+class Errors final {
+ public:
+    void Report(std::string_view message) {
+        std::lock_guard lock{mutex_};
+        std::println(std::cerr, "cp: {}", message);
+        failed_ = true;
+    }
+
+    void Report(std::string_view what, std::string_view path,
+                std::error_code error) {
+        Report(std::format("{} '{}': {}", what, path, error.message()));
+    }
+
+    bool failed() const { return failed_.load(); }
+
+ private:
+    std::mutex mutex_{};
+    std::atomic<bool> failed_{false};
+};
+
+/// The last component of path, ignoring trailing slashes
+std::string_view BaseName(std::string_view path) {
+    while (path.size() > 1 && path.ends_with('/')) {
+        path.remove_suffix(1);
+    }
+    const std::size_t slash{path.rfind('/')};
+    return slash == std::string_view::npos || path.size() == 1
+               ? path
+               : path.substr(slash + 1);
+}
+
+#if !defined(_WIN32)
+
+std::error_code LastError() { return {errno, std::system_category()}; }
+
+/// A file descriptor, closed when it goes out of scope
+class File final {
+ public:
+    explicit File(int fd) : fd_{fd} {}
+    File(const File&) = delete;
+    File& operator=(const File&) = delete;
+    ~File() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    int fd() const { return fd_; }
+    explicit operator bool() const { return fd_ >= 0; }
+
+    /// Closes early, to find out whether it worked: on NFS, for one, that
+    /// is when delayed write errors turn up
+    std::error_code Close() {
+        const int result{::close(std::exchange(fd_, -1))};
+        return result != 0 ? LastError() : std::error_code{};
+    }
+
+ private:
+    int fd_;
+};
+
+/// A file, named by way of an open directory when inside a tree being
+/// copied (so that every lookup is a single component), or by its path
+/// otherwise. Whole paths are only put together for messages.
+struct Place final {
+    /// Null for a path relative to the working directory
+    const coreutils::DirectoryReader* parent;
+    /// Null terminated
+    const char* name;
+    /// The path of parent
+    std::string_view parent_path;
+
+    int dir() const { return parent ? parent->fd() : AT_FDCWD; }
+
+    std::string path() const {
+        return parent ? std::format("{}/{}", parent_path, name)
+                      : std::string{name};
+    }
+};
+
+/// Whether path would be inside of the directory, i.e. whether copying the
+/// directory to path would go on forever
+bool Inside(std::string_view directory, std::string_view path) {
+    // path itself need not exist yet, but the directory it goes in must
+    const std::string_view parent{
+        path.substr(0, path.size() - BaseName(path).size())};
+    const std::unique_ptr<char, decltype(&std::free)> resolved_directory{
+        ::realpath(std::string{directory}.c_str(), nullptr), &std::free};
+    const std::unique_ptr<char, decltype(&std::free)> resolved_parent{
+        ::realpath(parent.empty() ? "." : std::string{parent}.c_str(),
+                   nullptr),
+        &std::free};
+    if (!resolved_directory || !resolved_parent) {
+        return false;
+    }
+    const std::string_view inner{resolved_parent.get()};
+    const std::string_view outer{resolved_directory.get()};
+    return inner.starts_with(outer) &&
+           (inner.size() == outer.size() || outer == "/" ||
+            inner[outer.size()] == '/');
+}
+
+/// What -p carries over: ownership, then permissions (as changing the owner
+/// may clear set-user-ID), then timestamps. Not being allowed to give a file
+/// away is not an error, as with GNU cp, unless running as root.
+std::error_code PreserveAt(const Place& place, const struct stat& status,
+                           bool follow) {
+    const int flags{follow ? 0 : AT_SYMLINK_NOFOLLOW};
+    if (::fchownat(place.dir(), place.name, status.st_uid, status.st_gid,
+                   flags) != 0 &&
+        (errno != EPERM || ::geteuid() == 0)) {
+        return LastError();
+    }
+    // symlinks have no permissions of their own on Linux
+    if ((follow || !S_ISLNK(status.st_mode)) &&
+        ::fchmodat(place.dir(), place.name, status.st_mode & 07777, 0) != 0) {
+        return LastError();
+    }
+#if defined(__APPLE__)
+    const std::array<timespec, 2> times{status.st_atimespec,
+                                        status.st_mtimespec};
+#else
+    const std::array<timespec, 2> times{status.st_atim, status.st_mtim};
+#endif
+    if (::utimensat(place.dir(), place.name, times.data(), flags) != 0) {
+        return LastError();
+    }
+    return {};
+}
+
+/// The same for a file that is open
+std::error_code Preserve(int fd, const struct stat& status) {
+    if (::fchown(fd, status.st_uid, status.st_gid) != 0 &&
+        (errno != EPERM || ::geteuid() == 0)) {
+        return LastError();
+    }
+    if (::fchmod(fd, status.st_mode & 07777) != 0) {
+        return LastError();
+    }
+#if defined(__APPLE__)
+    const std::array<timespec, 2> times{status.st_atimespec,
+                                        status.st_mtimespec};
+#else
+    const std::array<timespec, 2> times{status.st_atim, status.st_mtim};
+#endif
+    if (::futimens(fd, times.data()) != 0) {
+        return LastError();
+    }
+    return {};
+}
+
+/// Copies the data read from the source into a regular file at to. The
+/// source is usually a regular file too, but need not be: without -r,
+/// cp /dev/stdin out or cp fifo out copies whatever comes out of it.
+void CopyRegular(const Place& from, const Place& to, const Options& options,
+                 Errors& errors) {
+    // one per worker, for the copies the kernel cannot do by itself
+    thread_local coreutils::CopyBuffer buffer{};
+
+    File in{::openat(from.dir(), from.name, O_RDONLY | O_CLOEXEC)};
+    struct stat status {};
+    if (!in || ::fstat(in.fd(), &status) != 0) {
+        errors.Report(std::format("cannot open '{}' for reading: {}",
+                                  from.path(), LastError().message()));
+        return;
+    }
+    File out{::openat(to.dir(), to.name,
+                      O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                      status.st_mode & 0777)};
+    if (!out) {
+        errors.Report("cannot create regular file", to.path(), LastError());
+        return;
+    }
+
+    if (const coreutils::CopyResult copied{
+            S_ISREG(status.st_mode)
+                ? coreutils::CopyRegularFile(in.fd(), out.fd(), buffer.span())
+                : coreutils::CopyAll(in.fd(), out.fd(), buffer.span())};
+        !copied) {
+        const bool writing{copied.error().writing};
+        errors.Report(writing ? "error writing" : "error reading",
+                      writing ? to.path() : from.path(),
+                      copied.error().error);
+        return;
+    }
+    if (options.preserve) {
+        if (const std::error_code error{Preserve(out.fd(), status)}; error) {
+            errors.Report("failed to preserve attributes for", to.path(),
+                          error);
+        }
+    }
+    if (const std::error_code error{out.Close()}; error) {
+        errors.Report("error writing", to.path(), error);
+    }
+}
+
+/// Makes to again (replacing whatever is there), as a copy of from: a
+/// symlink, fifo, device or socket
+void CopySpecial(const Place& from, const struct stat& status,
+                 const Place& to, const Options& options, Errors& errors) {
+    std::string target{};
+    if (S_ISLNK(status.st_mode)) {
+        target.resize(static_cast<std::size_t>(status.st_size) + 1);
+        const ssize_t length{::readlinkat(from.dir(), from.name, target.data(),
+                                          target.size())};
+        if (length < 0) {
+            errors.Report("cannot read symbolic link", from.path(),
+                          LastError());
+            return;
+        }
+        target.resize(static_cast<std::size_t>(length));
+    }
+
+    const auto make = [&]() {
+        return S_ISLNK(status.st_mode)
+                   ? ::symlinkat(target.c_str(), to.dir(), to.name)
+                   : ::mknodat(to.dir(), to.name, status.st_mode & ~07000,
+                               status.st_rdev);
+    };
+    if (make() != 0 && (errno != EEXIST ||
+                        ::unlinkat(to.dir(), to.name, 0) != 0 ||
+                        make() != 0)) {
+        errors.Report(S_ISLNK(status.st_mode) ? "cannot create symbolic link"
+                                              : "cannot create special file",
+                      to.path(), LastError());
+        return;
+    }
+    if (options.preserve) {
+        if (const std::error_code error{PreserveAt(to, status, false)};
+            error) {
+            errors.Report("failed to preserve attributes for", to.path(),
+                          error);
+        }
+    }
+}
+
+/// Copies one file that is not a directory. Like GNU cp, only recursive
+/// copies make fifos, devices and sockets again; otherwise their contents
+/// are copied, as from any other file.
+void CopyFile(const Place& from, const struct stat& status, const Place& to,
+              const Options& options, Errors& errors) {
+    if (S_ISREG(status.st_mode) || !options.recursive) {
+        CopyRegular(from, to, options, errors);
+    } else {
+        CopySpecial(from, status, to, options, errors);
+    }
+}
+
+/// Copies directory trees. The walk runs on the calling thread, creating
+/// each directory before it lists what is in it, and hands the files it
+/// finds to a pool of workers. Directories therefore always exist by the
+/// time any worker needs one, while the (many, small, latency bound) file
+/// copies overlap with each other and with the walk.
+///
+/// Directories are made writable for the duration, and only get their final
+/// permissions and timestamps once everything inside of them is done.
+class TreeCopy final {
+ public:
+    TreeCopy(const Options& options, Errors& errors, std::size_t threads)
+        : options_{&options},
+          errors_{&errors},
+          umask_{coreutils::CurrentUmask()},
+          pool_{threads} {}
+
+    /// from is a directory, whose status is status
+    void Copy(const Place& from, const struct stat& status, const Place& to) {
+        std::expected<coreutils::DirectoryReader, std::error_code> source{
+            from.parent ? coreutils::DirectoryReader::Open(*from.parent,
+                                                           from.name)
+                        : coreutils::DirectoryReader::Open(from.name)};
+        if (!source) {
+            errors_->Report("cannot access", from.path(), source.error());
+            return;
+        }
+
+        // writable until the end, whatever its final permissions
+        bool created{true};
+        if (const std::error_code error{
+                ::mkdirat(to.dir(), to.name,
+                          (status.st_mode & 0777) | S_IRWXU) != 0
+                    ? LastError()
+                    : std::error_code{}};
+            error == std::errc::file_exists) {
+            struct stat existing {};
+            if (::fstatat(to.dir(), to.name, &existing, 0) != 0 ||
+                !S_ISDIR(existing.st_mode)) {
+                errors_->Report(std::format(
+                    "cannot overwrite non-directory '{}' with directory '{}'",
+                    to.path(), from.path()));
+                return;
+            }
+            created = false;
+        } else if (error) {
+            errors_->Report("cannot create directory", to.path(), error);
+            return;
+        }
+
+        std::expected<coreutils::DirectoryReader, std::error_code> target{
+            to.parent ? coreutils::DirectoryReader::Open(*to.parent, to.name)
+                      : coreutils::DirectoryReader::Open(to.name)};
+        if (!target) {
+            errors_->Report("cannot access", to.path(), target.error());
+            return;
+        }
+        if (created || options_->preserve) {
+            finishing_.push_back({to.path(), status, created});
+        }
+
+        const std::shared_ptr<Directory> directory{
+            std::make_shared<Directory>(std::move(*source),
+                                        std::move(*target), from.path(),
+                                        to.path())};
+        Walk(directory);
+    }
+
+    /// Waits for the last copies, then gives directories their final
+    /// permissions and timestamps, deepest first
+    void Finish() {
+        pool_.Wait();
+        for (auto it{finishing_.rbegin()}; it != finishing_.rend(); ++it) {
+            const Place place{
+                .parent = nullptr, .name = it->path.c_str(), .parent_path{}};
+            const std::error_code error{
+                options_->preserve
+                    ? PreserveAt(place, it->status, true)
+                    : (::chmod(place.name, it->status.st_mode & 0777 &
+                                               ~umask_) != 0
+                           ? LastError()
+                           : std::error_code{})};
+            if (error) {
+                errors_->Report("failed to preserve attributes for",
+                                it->path, error);
+            }
+        }
+        finishing_.clear();
+    }
+
+ private:
+    /// A directory being copied. Shared by the copies of the files in it,
+    /// which reach both sides through it.
+    struct Directory final {
+        coreutils::DirectoryReader source;
+        coreutils::DirectoryReader target;
+        std::string source_path;
+        std::string target_path;
+        coreutils::Arena names{4096};
+        std::vector<coreutils::DirectoryEntry> entries{};
+    };
+
+    /// A directory whose permissions (and with -p, owner and timestamps)
+    /// still need setting
+    struct Unfinished final {
+        std::string path;
+        struct stat status;
+        bool created;
+    };
+
+    /// Copies queued up but not yet done, at most. Each holds its
+    /// directories open, so this bounds open file descriptors too.
+    static constexpr std::ptrdiff_t max_queued{256};
+
+    void Walk(const std::shared_ptr<Directory>& directory) {
+        if (const std::error_code error{directory->source.ReadAll(
+                directory->names, directory->entries)};
+            error) {
+            errors_->Report("cannot read directory", directory->source_path,
+                            error);
+        }
+
+        // files first, so the workers have something to do while the walk
+        // goes on into the subdirectories
+        std::vector<std::size_t> subdirectories{};
+        for (std::size_t i{0}; i < directory->entries.size(); ++i) {
+            const coreutils::DirectoryEntry& entry{directory->entries[i]};
+            if (entry.name == "." || entry.name == "..") {
+                continue;
+            } else if (entry.type == coreutils::FileType::Directory ||
+                       entry.type == coreutils::FileType::Unknown) {
+                subdirectories.push_back(i);
+                continue;
+            }
+            Submit(directory, i);
+        }
+
+        for (const std::size_t i : subdirectories) {
+            const Place from{Source(*directory, i)};
+            struct stat status {};
+            if (::fstatat(from.dir(), from.name, &status,
+                          AT_SYMLINK_NOFOLLOW) != 0) {
+                errors_->Report("cannot stat", from.path(), LastError());
+            } else if (S_ISDIR(status.st_mode)) {
+                Copy(from, status, Target(*directory, i));
+            } else {
+                Submit(directory, i);
+            }
+        }
+    }
+
+    void Submit(const std::shared_ptr<Directory>& directory, std::size_t i) {
+        queued_.acquire();
+        pool_.Submit([this, directory, i]() {
+            const Place from{Source(*directory, i)};
+            struct stat status {};
+            if (::fstatat(from.dir(), from.name, &status,
+                          AT_SYMLINK_NOFOLLOW) != 0) {
+                errors_->Report("cannot stat", from.path(), LastError());
+            } else {
+                CopyFile(from, status, Target(*directory, i), *options_,
+                         *errors_);
+            }
+            queued_.release();
+        });
+    }
+
+    static Place Source(const Directory& directory, std::size_t i) {
+        return {.parent = &directory.source,
+                .name = directory.entries[i].name.data(),
+                .parent_path = directory.source_path};
+    }
+
+    static Place Target(const Directory& directory, std::size_t i) {
+        return {.parent = &directory.target,
+                .name = directory.entries[i].name.data(),
+                .parent_path = directory.target_path};
+    }
+
+    const Options* options_;
+    Errors* errors_;
+    unsigned umask_;
+    std::vector<Unfinished> finishing_{};
+    std::counting_semaphore<max_queued> queued_{max_queued};
+    // declared last, so that the workers are done before anything they
+    // use goes away
+    coreutils::WorkStealingPool pool_;
+};
+
+#endif
+
+}  // namespace
+
+COREUTILS_MAIN(cp) {
+    using Cp = coreutils::ProgramInfo<
+        "cp", "0.0.1",
+        "Usage: cp [OPTION]... SOURCE DEST\n"
+        "  or:  cp [OPTION]... SOURCE... DIRECTORY",
+        "Copy SOURCE to DEST, or multiple SOURCE(s) to DIRECTORY.\n\n"
+        "Regular files are cloned where the filesystem supports it, and "
+        "holes in sparse\nfiles are kept. Recursive copies copy many files "
+        "at once.">;
+    using PosArgs = coreutils::PositionalArguments<
+        std::string_view, [](std::string_view arg) { return arg; },
+        coreutils::ArgvView>;
+    using Archive = coreutils::BooleanArgument<"-a", "--archive">;
+    using Preserve = coreutils::BooleanArgument<"-p">;
+    using Recursive = coreutils::BooleanArgument<"-r", "-R", "--recursive">;
+    coreutils::ArgumentParser<Cp, PosArgs, Archive, Preserve, Recursive>
+        parser{argc, argv};
+    parser.ParseArgsOrExit();
+
+    const bool archive{parser.get<Archive>().value};
+    const bool recursive{archive || parser.get<Recursive>().value};
+    const Options options{
+        .recursive = recursive,
+        .preserve = archive || parser.get<Preserve>().value,
+        // as with GNU cp, copying recursively copies symlinks as symlinks,
+        // even those named on the command line
+        .no_dereference = recursive,
+    };
+
+    const auto& names{parser.get<PosArgs>().value};
+    const std::vector<std::string_view> operands(names.begin(), names.end());
+    if (operands.empty()) {
+        std::println(std::cerr, "cp: missing file operand\nTry 'cp --help' "
+                     "for more information.");
+        return 1;
+    } else if (operands.size() == 1) {
+        std::println(std::cerr,
+                     "cp: missing destination file operand after '{}'\nTry "
+                     "'cp --help' for more information.",
+                     operands.front());
+        return 1;
+    }
+    const std::string_view destination{operands.back()};
+    const std::span<const std::string_view> sources{
+        std::span{operands}.first(operands.size() - 1)};
+
+#if defined(_WIN32)
+    namespace fs = std::filesystem;
+    std::error_code error{};
+    const bool into{fs::is_directory(destination, error)};
+    if (sources.size() > 1 && !into) {
+        std::println(std::cerr, "cp: target '{}' is not a directory",
+                     destination);
+        return 1;
+    }
+    fs::copy_options copy_options{fs::copy_options::overwrite_existing};
+    if (options.recursive) {
+        copy_options |= fs::copy_options::recursive |
+                        fs::copy_options::copy_symlinks;
+    }
+    int status{0};
+    for (const std::string_view source : sources) {
+        if (!options.recursive && fs::is_directory(source, error)) {
+            std::println(std::cerr,
+                         "cp: -r not specified; omitting directory '{}'",
+                         source);
+            status = 1;
+            continue;
+        }
+        const fs::path target{into ? fs::path{destination} / BaseName(source)
+                                   : fs::path{destination}};
+        fs::copy(source, target, copy_options, error);
+        if (error) {
+            std::println(std::cerr, "cp: cannot copy '{}': {}", source,
+                         error.message());
+            status = 1;
+        }
+    }
+    return status;
+#else
+    struct stat destination_status {};
+    const bool exists{::stat(std::string{destination}.c_str(),
+                             &destination_status) == 0};
+    const bool into{exists && S_ISDIR(destination_status.st_mode)};
+    if (sources.size() > 1 && !into) {
+        std::println(
+            std::cerr, "cp: target '{}': {}", destination,
+            (exists ? std::make_error_code(std::errc::not_a_directory)
+                    : LastError())
+                .message());
+        return 1;
+    }
+
+    Errors errors{};
+    // only started for the first directory, so cp a b runs no workers
+    std::optional<TreeCopy> tree{};
+    for (const std::string_view source : sources) {
+        // operands are views into argv, so they are null terminated
+        struct stat status {};
+        if ((options.no_dereference ? ::lstat(source.data(), &status)
+                                    : ::stat(source.data(), &status)) != 0) {
+            errors.Report("cannot stat", source, LastError());
+            continue;
+        }
+
+        const std::string target{
+            into ? std::format("{}{}{}", destination,
+                               destination.ends_with('/') ? "" : "/",
+                               BaseName(source))
+                 : std::string{destination}};
+        const Place from{
+            .parent = nullptr, .name = source.data(), .parent_path{}};
+        const Place to{
+            .parent = nullptr, .name = target.c_str(), .parent_path{}};
+        if (S_ISDIR(status.st_mode) && !options.recursive) {
+            errors.Report(std::format(
+                "-r not specified; omitting directory '{}'", source));
+            continue;
+        }
+
+        struct stat existing {};
+        if (::stat(target.c_str(), &existing) == 0 &&
+            existing.st_dev == status.st_dev &&
+            existing.st_ino == status.st_ino) {
+            errors.Report(std::format("'{}' and '{}' are the same file",
+                                      source, target));
+        } else if (S_ISDIR(status.st_mode) && Inside(source, target)) {
+            errors.Report(std::format(
+                "cannot copy a directory, '{}', into itself, '{}'", source,
+                target));
+        } else if (S_ISDIR(status.st_mode)) {
+            if (!tree) {
+                tree.emplace(options, errors, coreutils::DefaultConcurrency());
+            }
+            tree->Copy(from, status, to);
+        } else {
+            CopyFile(from, status, to, options, errors);
+        }
+    }
+    if (tree) {
+        tree->Finish();
+    }
+    return errors.failed() ? 1 : 0;
+#endif
+}
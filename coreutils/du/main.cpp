@@ -0,0 +1,524 @@
+///
+///  @file main.cpp
+///  @brief Estimate file space usage
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <print>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+#include "lib/ArgumentParser.hpp"
+#include "lib/DirectoryReader.hpp"
+#include "lib/InodeSet.hpp"
+#include "lib/Main.hpp"
+#include "lib/Output.hpp"
+#include "lib/Parallel.hpp"
+#include "lib/WorkStealingPool.hpp"
+
+namespace {
+
+using coreutils::DirectoryReader;
+
+struct Options final {
+    bool all;
+    bool human_readable;
+    bool apparent_size;
+    bool one_file_system;
+    /// Deepest level that is printed, the operands being level 0
+    std::size_t max_depth;
+    /// Whether to count every file only once, rather than only those with
+    /// several hard links (which is what happens when there are several
+    /// operands, which may overlap)
+    bool deduplicate_all;
+};
+
+/// Writes size, in 1024 byte blocks (rounded up) or, for -h, as GNU du -h
+/// does: rounded up to one decimal place below 10 of a unit, and to a whole
+/// number of units above
+void WriteSize(coreutils::Output& out, std::uint64_t bytes, bool human) {
+    constexpr std::uint64_t kibibyte{1024};
+    if (!human) {
+        out.Write(bytes / kibibyte + (bytes % kibibyte != 0 ? 1 : 0));
+        return;
+    } else if (bytes < kibibyte) {
+        out.Write(bytes);
+        return;
+    }
+
+    constexpr std::string_view suffixes{"KMGTPE"};
+    std::uint64_t unit{kibibyte};
+    for (std::size_t i{0}; i < suffixes.size(); ++i, unit *= kibibyte) {
+        // the remainder is below 2^60, so ten of it still fits
+        const std::uint64_t remainder{bytes % unit};
+        const std::uint64_t tenths{bytes / unit * 10 +
+                                   (remainder * 10 + unit - 1) / unit};
+        if (tenths < 100) {
+            out.Write(tenths / 10).Put('.').Write(tenths % 10).Put(
+                suffixes[i]);
+            return;
+        }
+        const std::uint64_t whole{bytes / unit + (remainder != 0 ? 1 : 0)};
+        if (whole < kibibyte || i + 1 == suffixes.size()) {
+            out.Write(whole).Put(suffixes[i]);
+            return;
+        }
+    }
+}
+
+std::string Join(std::string_view parent, std::string_view name) {
+    std::string path{parent};
+    if (!path.ends_with('/')) {
+        path.push_back('/');
+    }
+    path.append(name);
+    return path;
+}
+
+/// A directory of the walk. Its contents are listed (and stat'ed) by
+/// whichever worker gets to it, and its total is put together bottom up
+/// with atomics alone: each subdirectory adds its total in when it
+/// finishes, and the last one to finish finishes its parent.
+struct Node final {
+    Node(Node* parent_node, std::string node_name, std::size_t node_depth,
+         std::uint64_t own_size)
+        : parent{parent_node},
+          name{std::move(node_name)},
+          depth{node_depth},
+          size{own_size} {}
+
+    /// Something to print inside of the directory, in the order the
+    /// directory lists it: a subdirectory, or with -a a file
+    struct Item final {
+        std::unique_ptr<Node> directory;
+        std::string name;
+        std::uint64_t size;
+    };
+
+    Node* parent;
+    /// Relative to the parent, or the whole operand at the top
+    std::string name;
+    std::size_t depth;
+    /// This directory and everything under it, in bytes
+    std::atomic<std::uint64_t> size;
+    /// Unfinished subdirectories, plus one until the listing is done
+    std::atomic<std::size_t> pending{1};
+    /// Filled in by the listing, and untouched afterwards
+    std::vector<Item> items{};
+    std::string errors{};
+    /// Guarded by the walk's mutex
+    bool listed{false};
+    /// Guarded by the walk's mutex. Once set, workers never touch the
+    /// node again.
+    bool finished{false};
+};
+
+#if defined(_WIN32)
+/// Without dirfds (or block counts) there is nothing for the walk below to
+/// gain, so Windows gets a serial total of the apparent sizes
+bool Summarize(std::string_view operand, coreutils::Output& out) {
+    namespace fs = std::filesystem;
+    std::error_code error{};
+    std::uint64_t total{0};
+    if (!fs::is_directory(operand, error)) {
+        total = fs::is_regular_file(operand, error)
+                    ? fs::file_size(operand, error)
+                    : 0;
+    }
+    for (fs::recursive_directory_iterator it{operand, error}, end{};
+         !error && it != end; it.increment(error)) {
+        if (it->is_regular_file(error)) {
+            total += it->file_size(error);
+        }
+    }
+    if (error) {
+        out.Flush();
+        std::println(std::cerr, "du: cannot access '{}': {}", operand,
+                     error.message());
+        return true;
+    }
+    out.Write((total + 1023) / 1024).Put('\t').Write(operand).Put('\n');
+    return false;
+}
+#else
+std::uint64_t Size(const struct stat& status, bool apparent) {
+    return apparent ? static_cast<std::uint64_t>(status.st_size)
+                    : static_cast<std::uint64_t>(status.st_blocks) * 512;
+}
+
+/// Walks the trees under the operands, every directory being a task for
+/// the pool, and prints them depth first, each directory after everything
+/// in it, exactly as a serial walk would. Subtrees are freed as soon as
+/// they are printed.
+class Walk final {
+ public:
+    Walk(const Options& options, std::size_t threads, coreutils::Output& out)
+        : options_{&options}, out_{&out}, pool_{threads} {}
+
+    /// Returns whether there were errors
+    bool Run(std::string_view operand) {
+        // operands are views into argv, so they are null terminated
+        struct stat status {};
+        if (::lstat(operand.data(), &status) != 0) {
+            Report(std::format("cannot access '{}': {}", operand,
+                               LastError().message()));
+            return true;
+        } else if (!Count(status)) {
+            return false;
+        }
+        if (!S_ISDIR(status.st_mode)) {
+            Print(operand, Size(status, options_->apparent_size));
+            return false;
+        }
+
+        root_device_ = status.st_dev;
+        Node root{nullptr, std::string{operand}, 0,
+                  Size(status, options_->apparent_size)};
+        pool_.Submit([this, &root]() { List(root, nullptr); });
+        const bool failed{PrintTree(root, root.name)};
+        // root is done, but its task may still be on its way out
+        pool_.Wait();
+        return failed;
+    }
+
+ private:
+    static std::error_code LastError() {
+        return {errno, std::system_category()};
+    }
+
+    /// Whether the file should count, i.e. has not been counted already
+    bool Count(const struct stat& status) {
+        return !(options_->deduplicate_all ||
+                 (!S_ISDIR(status.st_mode) && status.st_nlink > 1)) ||
+               seen_.Insert(static_cast<std::uint64_t>(status.st_dev),
+                            static_cast<std::uint64_t>(status.st_ino));
+    }
+
+    /// Lists node, on a worker, opening it relative to its parent
+    void List(Node& node, std::shared_ptr<DirectoryReader> parent) {
+        std::expected<DirectoryReader, std::error_code> opened{
+            parent ? DirectoryReader::Open(*parent, node.name.c_str())
+                   : DirectoryReader::Open(node.name.c_str())};
+        std::vector<Node*> subdirectories{};
+        if (!opened) {
+            node.errors = std::format("cannot read directory '{}': {}",
+                                      Path(node), opened.error().message());
+        } else {
+            const std::shared_ptr<DirectoryReader> dir{
+                std::make_shared<DirectoryReader>(std::move(*opened))};
+            std::uint64_t files{0};
+            const std::error_code error{dir->ForEach(
+                [&](const coreutils::DirectoryEntry& entry) {
+                    if (entry.name == "." || entry.name == "..") {
+                        return;
+                    }
+                    struct stat status {};
+                    if (::fstatat(dir->fd(), entry.name.data(), &status,
+                                  AT_SYMLINK_NOFOLLOW) != 0) {
+                        node.errors += std::format(
+                            "{}cannot access '{}': {}",
+                            node.errors.empty() ? "" : "\n",
+                            Join(Path(node), entry.name),
+                            LastError().message());
+                        return;
+                    } else if ((options_->one_file_system &&
+                                status.st_dev != root_device_) ||
+                               !Count(status)) {
+                        return;
+                    }
+
+                    const std::uint64_t size{
+                        Size(status, options_->apparent_size)};
+                    if (S_ISDIR(status.st_mode)) {
+                        node.items.push_back({
+                            .directory = std::make_unique<Node>(
+                                &node, std::string{entry.name},
+                                node.depth + 1, size),
+                        });
+                        subdirectories.push_back(
+                            node.items.back().directory.get());
+                        return;
+                    }
+                    files += size;
+                    if (options_->all &&
+                        node.depth + 1 <= options_->max_depth) {
+                        node.items.push_back(
+                            {.name = std::string{entry.name}, .size = size});
+                    }
+                })};
+            if (error) {
+                node.errors += std::format(
+                    "{}cannot read directory '{}': {}",
+                    node.errors.empty() ? "" : "\n", Path(node),
+                    error.message());
+            }
+            node.size.fetch_add(files);
+            node.pending.fetch_add(subdirectories.size());
+
+            // the owning worker pops its newest task first, so submit in
+            // reverse to have it carry on with the first subdirectory
+            for (auto it{subdirectories.rbegin()};
+                 it != subdirectories.rend(); ++it) {
+                pool_.Submit([this, child = *it, dir]() { List(*child, dir); });
+            }
+        }
+
+        {
+            std::lock_guard lock{mutex_};
+            node.listed = true;
+        }
+        changed_.notify_one();
+        Finish(node);
+    }
+
+    /// Called once for the listing and once for every subdirectory. The
+    /// last call adds the node's total into its parent, and so on up.
+    void Finish(Node& node) {
+        for (Node* current{&node};
+             current && current->pending.fetch_sub(1) == 1;) {
+            Node* const parent{current->parent};
+            if (parent) {
+                parent->size.fetch_add(current->size.load());
+            }
+            {
+                std::lock_guard lock{mutex_};
+                current->finished = true;
+            }
+            changed_.notify_one();
+            current = parent;
+        }
+    }
+
+    /// Only the path of the operand is kept whole, so paths below it are
+    /// put together on the way down from there
+    static std::string Path(const Node& node) {
+        return node.parent ? Join(Path(*node.parent), node.name) : node.name;
+    }
+
+    /// Prints node's subtree (waiting for it as needed) and frees it as it
+    /// goes. Returns whether there were errors.
+    bool PrintTree(Node& node, const std::string& path) {
+        {
+            std::unique_lock lock{mutex_};
+            changed_.wait(lock, [&node]() { return node.listed; });
+        }
+        bool failed{false};
+        for (Node::Item& item : node.items) {
+            if (item.directory) {
+                failed = PrintTree(*item.directory,
+                                   Join(path, item.directory->name)) ||
+                         failed;
+                item.directory.reset();
+            } else {
+                Print(Join(path, item.name), item.size);
+            }
+        }
+
+        {
+            std::unique_lock lock{mutex_};
+            changed_.wait(lock, [&node]() { return node.finished; });
+        }
+        if (!node.errors.empty()) {
+            Report(node.errors);
+            failed = true;
+        }
+        if (node.depth <= options_->max_depth) {
+            Print(path, node.size.load());
+        }
+        return failed;
+    }
+
+    void Print(std::string_view path, std::uint64_t size) {
+        WriteSize(*out_, size, options_->human_readable);
+        out_->Put('\t').Write(path).Put('\n');
+    }
+
+    /// Errors go to (unbuffered) stderr, so what is before them on stdout
+    /// is flushed first to keep the two in order on a terminal
+    void Report(std::string_view errors) {
+        out_->Flush();
+        std::string_view rest{errors};
+        while (!rest.empty()) {
+            const std::size_t end{std::min(rest.find('\n'), rest.size())};
+            std::println(std::cerr, "du: {}", rest.substr(0, end));
+            rest.remove_prefix(std::min(end + 1, rest.size()));
+        }
+    }
+
+    const Options* options_;
+    coreutils::Output* out_;
+    coreutils::InodeSet seen_{};
+    std::uint64_t root_device_{0};
+    /// For the main thread to wait on nodes being listed and finished. One
+    /// for the whole walk, as the main thread frees a node once it has
+    /// printed it (see ls -R).
+    std::mutex mutex_{};
+    std::condition_variable changed_{};
+    // declared last, so that the workers are done before anything they use
+    // goes away
+    coreutils::WorkStealingPool pool_;
+};
+#endif
+
+std::optional<std::size_t> ParseCount(std::string_view arg) {
+    std::size_t count{};
+    const std::from_chars_result result{
+        std::from_chars(arg.data(), arg.data() + arg.size(), count)};
+    if (result.ec != std::errc{} || result.ptr != arg.data() + arg.size()) {
+        return std::nullopt;
+    }
+    return count;
+}
+
+}  // namespace
+
+COREUTILS_MAIN(du) {
+    using Du = coreutils::ProgramInfo<
+        "du", "0.0.1", "Usage: du [OPTION]... [FILE]...",
+        "Summarize device usage of the set of FILEs, recursively for "
+        "directories.\n\nDirectories are walked by many threads at once; "
+        "see -j.">;
+    constexpr auto identity = [](std::string_view arg) { return arg; };
+    using PosArgs = coreutils::PositionalArguments<std::string_view, identity,
+                                                   coreutils::ArgvView>;
+    using All = coreutils::BooleanArgument<"-a", "--all">;
+    using ApparentSize = coreutils::BooleanArgument<"--apparent-size">;
+    using HumanReadable =
+        coreutils::BooleanArgument<"-h", "--human-readable">;
+    using Summarize = coreutils::BooleanArgument<"-s", "--summarize">;
+    using OneFileSystem =
+        coreutils::BooleanArgument<"-x", "--one-file-system">;
+    using MaxDepth =
+        coreutils::SingleValueArgument<std::string_view, identity, "-d",
+                                       "--max-depth">;
+    using Jobs = coreutils::SingleValueArgument<std::string_view, identity,
+                                                "-j", "--jobs">;
+    coreutils::ArgumentParser<Du, PosArgs, All, ApparentSize, HumanReadable,
+                              Summarize, OneFileSystem, MaxDepth, Jobs>
+        parser{argc, argv};
+    parser.ParseArgsOrExit();
+
+    const auto& names{parser.get<PosArgs>().value};
+    std::vector<std::string_view> operands(names.begin(), names.end());
+    if (operands.empty()) {
+        operands.emplace_back(".");
+    }
+
+    Options options{
+        .all = parser.get<All>().value,
+        .human_readable = parser.get<HumanReadable>().value,
+        .apparent_size = parser.get<ApparentSize>().value,
+        .one_file_system = parser.get<OneFileSystem>().value,
+        .max_depth = std::numeric_limits<std::size_t>::max(),
+        .deduplicate_all = operands.size() > 1,
+    };
+    const bool summarize{parser.get<Summarize>().value};
+    if (const std::string_view depth{parser.get<MaxDepth>().value};
+        !depth.empty()) {
+        const std::optional<std::size_t> parsed{ParseCount(depth)};
+        if (!parsed) {
+            std::println(std::cerr,
+                         "du: invalid maximum depth '{}'\nTry 'du --help' "
+                         "for more information.",
+                         depth);
+            return 1;
+        } else if (summarize && *parsed == 0) {
+            std::println(std::cerr, "du: warning: summarizing is the same "
+                                    "as using --max-depth=0");
+        } else if (summarize) {
+            std::println(std::cerr,
+                         "du: warning: summarizing conflicts with "
+                         "--max-depth={}\nTry 'du --help' for more "
+                         "information.",
+                         *parsed);
+            return 1;
+        }
+        options.max_depth = *parsed;
+    }
+    if (summarize) {
+        if (options.all) {
+            std::println(std::cerr,
+                         "du: cannot both summarize and show all entries\n"
+                         "Try 'du --help' for more information.");
+            return 1;
+        }
+        options.max_depth = 0;
+    }
+
+    // walking is mostly waiting on the filesystem (more so on network
+    // filesystems), so threads help even past the number of cores
+    std::size_t threads{std::max<std::size_t>(
+        coreutils::DefaultConcurrency(), 8)};
+    if (const std::string_view jobs{parser.get<Jobs>().value}; !jobs.empty()) {
+        const std::optional<std::size_t> parsed{ParseCount(jobs)};
+        if (!parsed || *parsed == 0) {
+            std::println(std::cerr, "du: invalid number of jobs: '{}'", jobs);
+            return 1;
+        }
+        threads = *parsed;
+    }
+
+    coreutils::Output out{};
+    int status{0};
+#if defined(_WIN32)
+    (void)threads;
+    for (const std::string_view operand : operands) {
+        if (Summarize(operand, out)) {
+            status = 1;
+        }
+    }
+#else
+    {
+        Walk walk{options, threads, out};
+        for (const std::string_view operand : operands) {
+            if (walk.Run(operand)) {
+                status = 1;
+            }
+        }
+    }
+#endif
+    if (const std::error_code error{out.Flush()}; error) {
+        std::println(std::cerr, "du: write error: {}", error.message());
+        return 1;
+    }
+    return status;
+}
@@ -18,24 +18,91 @@
 ///  with this program. If not, see <https://www.gnu.org/licenses/>
 ///
 
+#include <cstddef>
+#include <iostream>
 #include <print>
 #include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
 
-int main(int argc, const char** argv) {
+#include "lib/ArgumentParser.hpp"
+#include "lib/Escapes.hpp"
+#include "lib/Main.hpp"
+#include "lib/Output.hpp"
+#include "lib/Stats.hpp"
+
+namespace {
+
+/// As with GNU echo, an argument is an option only if it is made of n, e
+/// and E alone, and only if every argument before it was one too. Anything
+/// else, "--" and "-x" included, is text.
+bool IsOption(std::string_view arg) {
+    return arg.size() > 1 && arg.starts_with('-') &&
+           arg.find_first_not_of("neE", 1) == std::string_view::npos;
+}
+
+}  // namespace
+
+COREUTILS_MAIN(echo) {
+    using Echo = coreutils::ProgramInfo<
+        "echo", "0.0.1", "Usage: echo [SHORT-OPTION]... [STRING]...",
+        "Echo the STRING(s) to standard output.">;
+    using NoNewline = coreutils::BooleanArgument<"-n">;
+    using Escapes = coreutils::BooleanArgument<"-e">;
+    using NoEscapes = coreutils::BooleanArgument<"-E">;
+
+    // options may repeat, -e and -E cancel each other out, and unknown ones
+    // are text, so they are read in order here, and the parser is only there
+    // for --help and --version
     std::span<const char*> args{argv + 1, argv + argc};
+    // in a stats build, a leading --stats is taken before all of that
+    args = args.subspan(coreutils::EnableStatsFromCommandLine(
+        Echo::name.PrintableView(), args));
+    bool newline{true};
+    bool escapes{false};
+    std::size_t options{0};
+    for (; options < args.size() && IsOption(args[options]); ++options) {
+        for (const char c : std::string_view{args[options]}.substr(1)) {
+            newline = newline && c != 'n';
+            escapes = c == 'e' || (escapes && c != 'E');
+        }
+    }
+    // --help and --version only count on their own
+    if (args.size() == 1 && (std::string_view{args[0]} == "--help" ||
+                             std::string_view{args[0]} == "--version")) {
+        coreutils::ArgumentParser<Echo, NoNewline, Escapes, NoEscapes> parser{
+            argc, argv};
+        parser.ParseArgsOrExit();
+    }
 
-    if (args.size()) {
-        const auto last{args.back()};
-        for (const char* arg : args) {
-            if (arg != last) {
-                std::print("{} ", arg);
-            } else {
-                std::println("{}", arg);
-            }
+    // everything is put together first, and goes out in a single write
+    coreutils::Output out{};
+    std::string unescaped{};
+    for (std::size_t i{options}; i < args.size(); ++i) {
+        if (i > options) {
+            out.Put(' ');
+        }
+        if (!escapes) {
+            out.Write(args[i]);
+            continue;
         }
-    } else {
-        std::println();
+        unescaped.clear();
+        const coreutils::EscapeResult result{coreutils::AppendUnescaped(
+            args[i], coreutils::EscapeStyle::Echo, unescaped)};
+        out.Write(unescaped);
+        if (result == coreutils::EscapeEnd::Stopped) {
+            newline = false;
+            break;
+        }
+    }
+    if (newline) {
+        out.Put('\n');
     }
 
+    if (const std::error_code error{out.Flush()}; error) {
+        std::println(std::cerr, "echo: write error: {}", error.message());
+        return 1;
+    }
     return 0;
 }
@@ -0,0 +1,268 @@
+///
+///  @file main.cpp
+///  @brief Output the first part of files
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <iostream>
+#include <optional>
+#include <print>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "lib/ArgumentParser.hpp"
+#include "lib/FileCopy.hpp"
+#include "lib/FileInput.hpp"
+#include "lib/LineSeek.hpp"
+#include "lib/Main.hpp"
+#include "lib/Output.hpp"
+#include "lib/TextCount.hpp"
+
+namespace {
+
+using coreutils::CopyResult;
+using coreutils::ReadError;
+using coreutils::Seek;
+using coreutils::Seekable;
+
+/// How much of every file to print
+struct Amount final {
+    std::uint64_t count;
+    bool bytes;
+    /// -N, i.e. all but the last N lines (or bytes), rather than the first N
+    bool all_but;
+};
+
+std::optional<Amount> ParseAmount(std::string_view arg, bool bytes) {
+    Amount amount{.count = 0, .bytes = bytes, .all_but = false};
+    if (arg.starts_with('-')) {
+        amount.all_but = true;
+        arg.remove_prefix(1);
+    } else if (arg.starts_with('+')) {
+        arg.remove_prefix(1);
+    }
+    const std::optional<std::uint64_t> count{coreutils::ParseCount(arg)};
+    if (!count) {
+        return std::nullopt;
+    }
+    amount.count = *count;
+    return amount;
+}
+
+/// The first count lines (or bytes). Reading stops at the block the last of
+/// them is in, and whatever was read past them is seeked back over, so that
+/// e.g. "(head -n 1; cat) < file" leaves the rest for cat.
+CopyResult PrintFirst(int fd, const Amount& amount, coreutils::Output& out,
+                      std::span<char> buffer) {
+    std::uint64_t remaining{amount.count};
+    while (remaining > 0) {
+        // counted bytes are never read past, even on pipes
+        const std::size_t wanted{
+            amount.bytes ? static_cast<std::size_t>(std::min<std::uint64_t>(
+                               remaining, buffer.size()))
+                         : buffer.size()};
+        const std::expected<std::size_t, std::error_code> got{
+            coreutils::ReadSome(fd, buffer.first(wanted))};
+        if (!got) {
+            return ReadError(got.error());
+        } else if (*got == 0) {
+            break;
+        }
+        const std::span<const char> text{buffer.first(*got)};
+        std::size_t used{text.size()};
+        if (amount.bytes) {
+            remaining -= used;
+        } else {
+            const coreutils::NewlineSearch search{
+                coreutils::FindNewline(text, remaining)};
+            remaining -= search.found;
+            used = remaining == 0 ? search.position + 1 : text.size();
+        }
+        out.Write({text.data(), used});
+        if (used < text.size()) {
+            // fails harmlessly on pipes, where it cannot be helped
+            Seek(fd, -static_cast<std::int64_t>(text.size() - used),
+                 SEEK_CUR);
+        }
+    }
+    return {};
+}
+
+/// All but the last count lines (or bytes) of a stream that can only be
+/// read front to back. Chunks are held back only until enough has come in
+/// after them that they cannot be part of the end.
+CopyResult PrintAllButStream(int fd, const Amount& amount,
+                             coreutils::Output& out, std::span<char> buffer) {
+    const std::expected<coreutils::StreamEnd, std::error_code> end{
+        coreutils::ReadStreamEnd(
+            fd, amount.count, amount.bytes, buffer,
+            [&out](std::string_view chunk) { out.Write(chunk); })};
+    if (!end) {
+        return ReadError(end.error());
+    }
+    out.Write(std::string_view{end->text}.substr(0, end->start));
+    return {};
+}
+
+/// All but the last count lines (or bytes). Regular files are searched
+/// from their end for where to stop, and only what is printed is read.
+CopyResult PrintAllBut(int fd, const Amount& amount, coreutils::Output& out,
+                       std::span<char> buffer) {
+    const std::optional<Seekable> seekable{coreutils::InspectSeekable(fd)};
+    if (!seekable) {
+        return PrintAllButStream(fd, amount, out, buffer);
+    }
+
+    std::uint64_t end{seekable->size -
+                      std::min(amount.count,
+                               seekable->size - seekable->offset)};
+    if (!amount.bytes) {
+        const std::expected<std::uint64_t, std::error_code> found{
+            coreutils::FindLastLines(fd, seekable->offset, seekable->size,
+                                     amount.count, buffer)};
+        if (!found) {
+            return ReadError(found.error());
+        }
+        end = *found;
+    }
+    for (std::uint64_t position{seekable->offset}; position < end;) {
+        const std::size_t wanted{static_cast<std::size_t>(
+            std::min<std::uint64_t>(buffer.size(), end - position))};
+        const std::expected<std::size_t, std::error_code> got{
+            coreutils::ReadSome(fd, buffer.first(wanted))};
+        if (!got) {
+            return ReadError(got.error());
+        } else if (*got == 0) {
+            break;
+        }
+        out.Write({buffer.data(), *got});
+        position += *got;
+    }
+    return {};
+}
+
+}  // namespace
+
+COREUTILS_MAIN(head) {
+    using Head = coreutils::ProgramInfo<
+        "head", "0.0.1", "Usage: head [OPTION]... [FILE]...",
+        "Print the first 10 lines of each FILE to standard output.\nWith more "
+        "than one FILE, precede each with a header giving the file "
+        "name.\n\nWith no FILE, or when FILE is -, read standard input.">;
+    constexpr auto view = [](std::string_view arg) { return arg; };
+    using PosArgs = coreutils::PositionalArguments<std::string_view, view,
+                                                   coreutils::ArgvView>;
+    using Bytes = coreutils::SingleValueArgument<std::string_view, view,
+                                                 "-c", "--bytes">;
+    using Lines = coreutils::SingleValueArgument<std::string_view, view,
+                                                 "-n", "--lines">;
+    using Quiet = coreutils::BooleanArgument<"-q", "--quiet", "--silent">;
+    using Verbose = coreutils::BooleanArgument<"-v", "--verbose">;
+
+    std::string obsolete_count{};
+    std::vector<const char*> args{
+        coreutils::RewriteObsolete(argc, argv, obsolete_count)};
+    coreutils::ArgumentParser<Head, PosArgs, Bytes, Lines, Quiet, Verbose>
+        parser{static_cast<int>(args.size()), args.data()};
+    parser.ParseArgsOrExit();
+
+    Amount amount{.count = 10, .bytes = false, .all_but = false};
+    for (const auto& [arg, bytes] :
+         {std::pair{parser.get<Lines>().value, false},
+          std::pair{parser.get<Bytes>().value, true}}) {
+        if (arg.empty()) {
+            continue;
+        }
+        const std::optional<Amount> parsed{ParseAmount(arg, bytes)};
+        if (!parsed) {
+            std::println(std::cerr, "head: invalid number of {}: '{}'",
+                         bytes ? "bytes" : "lines", arg);
+            return 1;
+        }
+        amount = *parsed;
+    }
+
+    const auto& names{parser.get<PosArgs>().value};
+    std::vector<std::string_view> targets(names.begin(), names.end());
+    if (targets.empty()) {
+        targets.emplace_back("-");
+    }
+    const bool headers{parser.get<Verbose>().value ||
+                       (targets.size() > 1 && !parser.get<Quiet>().value)};
+
+    coreutils::CopyBuffer buffer{};
+    coreutils::Output out{};
+    bool first{true};
+    int status{0};
+    for (const std::string_view target : targets) {
+        // targets are views into argv, so they are null terminated
+        std::expected<coreutils::InputFile, std::error_code> input{
+            coreutils::InputFile::Open(target.data())};
+        if (!input) {
+            out.Flush();
+            std::println(std::cerr, "head: cannot open '{}' for reading: {}",
+                         target, input.error().message());
+            status = 1;
+            continue;
+        }
+
+        if (headers) {
+            out.Write(first ? "==> " : "\n==> ")
+                .Write(target == "-" ? "standard input" : target)
+                .Write(" <==\n");
+        }
+        first = false;
+        const CopyResult printed{
+            amount.all_but
+                ? PrintAllBut(input->fd(), amount, out, buffer.span())
+                : PrintFirst(input->fd(), amount, out, buffer.span())};
+        if (!printed) {
+            out.Flush();
+            std::println(std::cerr, "head: error reading '{}': {}", target,
+                         printed.error().error.message());
+            status = 1;
+        }
+        if (out.error()) {
+            break;
+        }
+    }
+    if (const std::error_code error{out.Flush()}; error) {
+        std::println(std::cerr, "head: error writing 'standard output': {}",
+                     error.message());
+        return 1;
+    }
+    return status;
+}
@@ -19,73 +19,754 @@
 ///
 
 #include <algorithm>
-#include <filesystem>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <expected>
+#include <format>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <print>
+#include <span>
 #include <string>
 #include <string_view>
+#include <system_error>
+#include <utility>
 #include <vector>
 
+#include "lib/Arena.hpp"
 #include "lib/ArgumentParser.hpp"
+#include "lib/AsyncIo.hpp"
+#include "lib/DirectoryReader.hpp"
+#include "lib/FileStatus.hpp"
+#include "lib/Main.hpp"
+#include "lib/Output.hpp"
+#include "lib/OwnerNameCache.hpp"
+#include "lib/Parallel.hpp"
+#include "lib/StringSort.hpp"
+#include "lib/WorkStealingPool.hpp"
 
-int main(int argc, const char** argv) {
+namespace {
+
+using coreutils::DirectoryEntry;
+using coreutils::DirectoryReader;
+using coreutils::FileStatus;
+using coreutils::FileType;
+using coreutils::SortRecord;
+using coreutils::StatField;
+using coreutils::StatResult;
+
+enum class SortMode : std::uint8_t {
+    Name,
+    None,
+    Size,
+    Time,
+    Extension,
+};
+
+std::optional<SortMode> SortModeFromWord(std::string_view word) {
+    if (word == "name") {
+        return SortMode::Name;
+    } else if (word == "none") {
+        return SortMode::None;
+    } else if (word == "size") {
+        return SortMode::Size;
+    } else if (word == "time") {
+        return SortMode::Time;
+    } else if (word == "extension") {
+        return SortMode::Extension;
+    }
+    return std::nullopt;
+}
+
+/// Everything from the last '.' on, or nothing if there is no '.'
+constexpr std::string_view Extension(std::string_view name) {
+    const std::size_t dot{name.rfind('.')};
+    return dot == std::string_view::npos ? std::string_view{}
+                                         : name.substr(dot);
+}
+
+/// Returns entries in the order they should be printed. Names are always
+/// sorted first, so that they break ties between equal sizes, times, or
+/// extensions. statuses must hold sizes or times when sorting by them.
+std::vector<SortRecord> Sort(std::span<const DirectoryEntry> entries,
+                             std::span<const StatResult> statuses,
+                             SortMode mode, bool reverse) {
+    std::vector<SortRecord> order{};
+    order.reserve(entries.size());
+    for (std::size_t i{0}; i < entries.size(); ++i) {
+        order.push_back(
+            SortRecord::Make(entries[i].name, static_cast<std::uint32_t>(i)));
+    }
+    if (mode == SortMode::None) {
+        return order;
+    }
+    coreutils::SortStrings(order);
+
+    if (mode == SortMode::Size || mode == SortMode::Time) {
+        // largest or newest first
+        const auto key = [statuses, mode](const SortRecord& record) {
+            const StatResult& status{statuses[record.index]};
+            if (!status) {
+                return std::int64_t{0};
+            }
+            return mode == SortMode::Size
+                       ? static_cast<std::int64_t>(status->size)
+                       : status->mtime;
+        };
+        std::ranges::stable_sort(order, std::ranges::greater{}, key);
+    } else if (mode == SortMode::Extension) {
+        std::ranges::stable_sort(order, std::ranges::less{},
+                                 [](const SortRecord& record) {
+                                     return Extension(record.view());
+                                 });
+    }
+
+    if (reverse) {
+        std::ranges::reverse(order);
+    }
+    return order;
+}
+
+/// The first letter of the mode string
+char TypeChar(FileType type) {
+    switch (type) {
+        case FileType::Regular:
+            return '-';
+        case FileType::Directory:
+            return 'd';
+        case FileType::Symlink:
+            return 'l';
+        case FileType::Fifo:
+            return 'p';
+        case FileType::Socket:
+            return 's';
+        case FileType::CharDevice:
+            return 'c';
+        case FileType::BlockDevice:
+            return 'b';
+        case FileType::Unknown:
+            break;
+    }
+    return '?';
+}
+
+/// e.g. drwxr-xr-x
+std::array<char, 10> ModeString(const FileStatus& status) {
+    const auto bit = [&status](unsigned mask, char set) {
+        return (status.permissions & mask) ? set : '-';
+    };
+    // an execute bit that doubles as setuid, setgid, or sticky
+    const auto special = [&status](unsigned exec, unsigned flag, char both,
+                                   char flag_only) {
+        const bool has_exec{(status.permissions & exec) != 0};
+        if (status.permissions & flag) {
+            return has_exec ? both : flag_only;
+        }
+        return has_exec ? 'x' : '-';
+    };
+
+    return {
+        TypeChar(status.type),
+        bit(0400, 'r'),
+        bit(0200, 'w'),
+        special(0100, 04000, 's', 'S'),
+        bit(040, 'r'),
+        bit(020, 'w'),
+        special(010, 02000, 's', 'S'),
+        bit(04, 'r'),
+        bit(02, 'w'),
+        special(01, 01000, 't', 'T'),
+    };
+}
+
+constexpr std::size_t Digits(std::uint64_t value) {
+    std::size_t digits{1};
+    for (; value >= 10; value /= 10) {
+        ++digits;
+    }
+    return digits;
+}
+
+/// Appends text right aligned to width
+void AppendRight(std::string& out, std::string_view text, std::size_t width) {
+    out.append(width - std::min(width, text.size()), ' ');
+    out.append(text);
+}
+
+/// Appends value right aligned to width
+void AppendNumber(std::string& out, std::uint64_t value, std::size_t width) {
+    std::array<char, 20> digits{};
+    const std::to_chars_result result{
+        std::to_chars(digits.data(), digits.data() + digits.size(), value)};
+    AppendRight(out, {digits.data(), result.ptr}, width);
+}
+
+/// Appends text left aligned to width
+void AppendPadded(std::string& out, std::string_view text, std::size_t width) {
+    out.append(text);
+    out.append(width - std::min(width, text.size()), ' ');
+}
+
+/// Renders ls -l rows. Columns are as wide as their widest cell, so every row
+/// is measured before any is printed.
+class LongFormat final {
+ public:
+    static constexpr StatField fields{
+        StatField::Permissions | StatField::Links | StatField::Owner |
+        StatField::Size | StatField::Blocks | StatField::ModifyTime};
+
+    LongFormat(coreutils::OwnerNameCache& owners, std::int64_t now)
+        : owners_{owners}, now_{now} {}
+
+    void Measure(const FileStatus& status) {
+        links_width_ = std::max(links_width_, Digits(status.links));
+        user_width_ = std::max(user_width_, owners_.User(status.uid).size());
+        group_width_ =
+            std::max(group_width_, owners_.Group(status.gid).size());
+        size_width_ = std::max(size_width_, Digits(status.size));
+    }
+
+    void Render(std::string& out, const FileStatus& status,
+                std::string_view name, std::string_view link_target = {}) {
+        const std::array<char, 10> mode{ModeString(status)};
+        out.append(mode.data(), mode.size());
+        out.push_back(' ');
+        AppendNumber(out, status.links, links_width_);
+        out.push_back(' ');
+        AppendPadded(out, owners_.User(status.uid), user_width_);
+        out.push_back(' ');
+        AppendPadded(out, owners_.Group(status.gid), group_width_);
+        out.push_back(' ');
+        AppendNumber(out, status.size, size_width_);
+        out.push_back(' ');
+        out.append(Time(status.mtime));
+        out.push_back(' ');
+        out.append(name);
+        if (!link_target.empty()) {
+            out.append(" -> ");
+            out.append(link_target);
+        }
+        out.push_back('\n');
+    }
+
+    /// A row for a file that could not be stat'ed (e.g. in a directory that
+    /// can be read but not searched), with a ? for everything but its name
+    /// and, when the directory gave it, its type
+    void RenderUnknown(std::string& out, FileType type, std::string_view name) {
+        out.push_back(TypeChar(type));
+        out.append("????????? ");
+        AppendRight(out, "?", links_width_);
+        out.push_back(' ');
+        AppendPadded(out, "?", user_width_);
+        out.push_back(' ');
+        AppendPadded(out, "?", group_width_);
+        out.push_back(' ');
+        AppendRight(out, "?", size_width_);
+        out.push_back(' ');
+        AppendRight(out, "?", time_width);
+        out.push_back(' ');
+        out.append(name);
+        out.push_back('\n');
+    }
+
+ private:
+    /// Like GNU, files older than six months (or from the future) show their
+    /// year instead of the time of day
+    std::string_view Time(std::int64_t mtime) {
+        constexpr std::int64_t six_months{
+            1'000'000'000LL * 60 * 60 * 24 * 365 / 2};
+        const std::time_t seconds{
+            static_cast<std::time_t>(mtime / 1'000'000'000)};
+        std::tm local{};
+#if defined(_WIN32)
+        ::localtime_s(&local, &seconds);
+#else
+        ::localtime_r(&seconds, &local);
+#endif
+        const bool recent{mtime <= now_ && now_ - mtime < six_months};
+        const std::size_t length{std::strftime(
+            time_buffer_.data(), time_buffer_.size(),
+            recent ? "%b %e %H:%M" : "%b %e  %Y", &local)};
+        return {time_buffer_.data(), length};
+    }
+
+    /// Of either time format, with month names in the C locale
+    static constexpr std::size_t time_width{12};
+
+    coreutils::OwnerNameCache& owners_;
+    std::int64_t now_;
+    std::size_t links_width_{0};
+    std::size_t user_width_{0};
+    std::size_t group_width_{0};
+    std::size_t size_width_{0};
+    std::array<char, 64> time_buffer_{};
+};
+
+struct Options final {
+    SortMode sort_mode;
+    bool reverse;
+    bool long_format;
+    bool recursive;
+    /// What needs to be stat'ed for the above
+    StatField fields;
+    std::int64_t now;
+};
+
+/// Everything listing one directory produces. Nothing is printed straight
+/// away, so that directories listed in parallel can still be printed in
+/// order.
+struct Listing final {
+    std::string out{};
+    std::string errors{};
+    int status{0};
+    /// Names of subdirectories, in the order they were listed
+    std::vector<std::string> subdirectories{};
+
+    void CannotAccess(std::string_view name, std::error_code error,
+                      int severity) {
+        std::format_to(std::back_inserter(errors),
+                       "ls: cannot access '{}': {}\n", name, error.message());
+        status = std::max(status, severity);
+    }
+};
+
+/// Each thread keeps its own cache, so lookups never need a lock
+coreutils::OwnerNameCache& ThreadOwnerNames() {
+    thread_local coreutils::OwnerNameCache owners{};
+    return owners;
+}
+
+/// For recursive listings, where every directory is listed on one of the
+/// pool's threads and the pool already keeps them all busy: one thread per
+/// directory's lookups, but still many lookups in flight when there is a
+/// ring to put them on. An engine belongs to one thread, hence one each.
+coreutils::IoEngine& ThreadIoEngine() {
+    thread_local coreutils::IoEngine engine{
+        coreutils::IoEngine::default_queue_depth, 1};
+    return engine;
+}
+
+std::string Subdirectory(std::string_view parent, std::string_view name) {
+    std::string path{parent};
+    if (!path.ends_with('/')) {
+        path.push_back('/');
+    }
+    path.append(name);
+    return path;
+}
+
+/// A single file operand, rather than a directory
+Listing ListFile(std::string_view path, const Options& options) {
+    Listing listing{};
+    if (!options.long_format) {
+        listing.out.append(path);
+        listing.out.push_back('\n');
+    } else if (const StatResult file{
+                   coreutils::Stat(path.data(), options.fields)};
+               file) {
+        LongFormat rows{ThreadOwnerNames(), options.now};
+        rows.Measure(*file);
+        rows.Render(listing.out, *file, path);
+    } else {
+        listing.CannotAccess(path, file.error(), 2);
+    }
+    return listing;
+}
+
+Listing ListDirectory(DirectoryReader& dir, std::string_view path,
+                      const Options& options, coreutils::IoEngine& io) {
+    Listing listing{};
+    coreutils::Arena arena{};
+    std::vector<DirectoryEntry> entries{};
+    if (const std::error_code error{
+            dir.ForEach([&](const DirectoryEntry& entry) {
+                if (!entry.name.starts_with('.')) {
+                    entries.push_back({
+                        .name = arena.Store(entry.name),
+                        .type = entry.type,
+                    });
+                }
+            })};
+        error) {
+        std::format_to(std::back_inserter(listing.errors),
+                       "ls: reading directory '{}': {}\n", path,
+                       error.message());
+        listing.status = 2;
+    }
+
+    std::vector<StatResult> statuses{};
+    if (options.fields != StatField::None) {
+        statuses.resize(entries.size());
+        coreutils::StatAll(io, dir, entries, options.fields, statuses);
+        for (std::size_t i{0}; i < entries.size(); ++i) {
+            if (!statuses[i]) {
+                // named the way GNU names them, from the current directory
+                listing.CannotAccess(path == "."
+                                         ? std::string{entries[i].name}
+                                         : Subdirectory(path, entries[i].name),
+                                     statuses[i].error(), 1);
+            }
+        }
+    }
+
+    const std::vector<SortRecord> order{
+        Sort(entries, statuses, options.sort_mode, options.reverse)};
+
+    if (options.recursive) {
+        for (const SortRecord& record : order) {
+            const DirectoryEntry& entry{entries[record.index]};
+            FileType type{entry.type};
+            if (!statuses.empty() && statuses[record.index]) {
+                type = statuses[record.index]->type;
+            } else if (type == FileType::Unknown) {
+                // the filesystem does not fill in d_type
+                const StatResult status{coreutils::StatAt(
+                    dir, entry.name.data(), StatField::None)};
+                type = status ? status->type : FileType::Unknown;
+            }
+            if (type == FileType::Directory) {
+                listing.subdirectories.emplace_back(entry.name);
+            }
+        }
+    }
+
+    if (!options.long_format) {
+        for (const SortRecord& record : order) {
+            listing.out.append(entries[record.index].name);
+            listing.out.push_back(' ');
+        }
+        listing.out.push_back('\n');
+        return listing;
+    }
+
+    std::uint64_t blocks{0};
+    LongFormat rows{ThreadOwnerNames(), options.now};
+    for (const StatResult& status : statuses) {
+        if (status) {
+            blocks += status->blocks;
+            rows.Measure(*status);
+        }
+    }
+    // GNU reports the total in 1K blocks
+    listing.out.append("total ");
+    AppendNumber(listing.out, (blocks + 1) / 2, 0);
+    listing.out.push_back('\n');
+    for (const SortRecord& record : order) {
+        const StatResult& status{statuses[record.index]};
+        const std::string_view name{entries[record.index].name};
+        if (!status) {
+            rows.RenderUnknown(listing.out, entries[record.index].type, name);
+            continue;
+        }
+        std::string link_target{};
+        if (status->type == FileType::Symlink) {
+            link_target =
+                coreutils::ReadLinkAt(dir, name.data()).value_or(std::string{});
+        }
+        rows.Render(listing.out, *status, name, link_target);
+    }
+    return listing;
+}
+
+/// Lists path, whether it is a directory or a single file
+Listing List(std::string_view path, const Options& options,
+             coreutils::IoEngine& io) {
+    // path is either an argument or built by Subdirectory, so it is null
+    // terminated
+    std::expected<DirectoryReader, std::error_code> dir{
+        DirectoryReader::Open(path.data())};
+    if (dir) {
+        return ListDirectory(*dir, path, options, io);
+    } else if (dir.error() == std::errc::not_a_directory) {
+        return ListFile(path, options);
+    }
+
+    Listing listing{};
+    listing.CannotAccess(path, dir.error(), 2);
+    return listing;
+}
+
+/// One directory of an ls -R walk. Its listing may be produced on any thread,
+/// but is only ever printed by the main thread, once ready is set.
+struct Node final {
+    explicit Node(std::string directory) : path{std::move(directory)} {}
+
+    std::string path;
+    Listing listing{};
+    std::vector<std::unique_ptr<Node>> children{};
+    /// Guarded by the walk's mutex
+    bool ready{false};
+};
+
+/// Errors go to (unbuffered) stderr, so anything before them on stdout is
+/// flushed first to keep the two in order on a terminal. Like GNU, they come
+/// before the listing they were found making.
+void Print(coreutils::Output& out, const Listing& listing) {
+    if (!listing.errors.empty()) {
+        out.Flush();
+        std::print(std::cerr, "{}", listing.errors);
+    }
+    out.Write(listing.out);
+}
+
+/// Lists node and creates (but does not list) its children
+void Expand(Node& node, const Options& options) {
+    node.listing = List(node.path, options, ThreadIoEngine());
+    node.children.reserve(node.listing.subdirectories.size());
+    for (const std::string& name : node.listing.subdirectories) {
+        node.children.push_back(
+            std::make_unique<Node>(Subdirectory(node.path, name)));
+    }
+    node.listing.subdirectories = {};
+}
+
+/// Walks the tree under root, with every directory being a task for pool
+/// (or listed right here, when there is no pool). Output is always printed
+/// depth first in listing order, exactly as a serial walk would, no matter
+/// which directories finish first.
+int ListRecursively(std::unique_ptr<Node> root, const Options& options,
+                    coreutils::WorkStealingPool* pool, coreutils::Output& out,
+                    bool& first) {
+    // the main thread frees a node as soon as it is printed, so a task must
+    // not touch its node after marking it ready. Hence one mutex and
+    // condition variable for the whole walk, rather than one per node.
+    std::mutex mutex{};
+    std::condition_variable ready{};
+    const std::function<void(Node&)> expand = [&](Node& node) {
+        Expand(node, options);
+        // the owning worker pops its newest task first, so submit in reverse
+        // to have it continue with the first child
+        for (auto it{node.children.rbegin()}; it != node.children.rend();
+             ++it) {
+            pool->Submit([child = it->get(), &expand]() { expand(*child); });
+        }
+        std::lock_guard lock{mutex};
+        node.ready = true;
+        ready.notify_one();
+    };
+    if (pool) {
+        pool->Submit([node = root.get(), &expand]() { expand(*node); });
+    }
+
+    int status{0};
+    std::vector<std::unique_ptr<Node>> stack{};
+    stack.push_back(std::move(root));
+    while (!stack.empty()) {
+        std::unique_ptr<Node> node{std::move(stack.back())};
+        stack.pop_back();
+        if (pool) {
+            std::unique_lock lock{mutex};
+            ready.wait(lock, [&node]() { return node->ready; });
+        } else {
+            Expand(*node, options);
+        }
+
+        if (!first) {
+            out.Put('\n');
+        }
+        first = false;
+        out.Write(node->path).Write(":\n");
+        Print(out, node->listing);
+        status = std::max(status, node->listing.status);
+
+        for (auto it{node->children.rbegin()}; it != node->children.rend();
+             ++it) {
+            stack.push_back(std::move(*it));
+        }
+    }
+    if (pool) {
+        // every node has been printed, but tasks may still be returning from
+        // expand, which must outlive them
+        pool->Wait();
+    }
+    return status;
+}
+
+/// Lists every target without descending into subdirectories
+template <class Targets>
+void ListEach(const Targets& targets, const Options& options,
+              coreutils::IoEngine& io, coreutils::Output& out, int& status) {
+    // lists target, straight to stdout when there is nothing to buffer for
+    const auto list = [&](std::string_view target) {
+        if (options.sort_mode == SortMode::None &&
+            options.fields == StatField::None) {
+            if (std::expected<DirectoryReader, std::error_code> dir{
+                    DirectoryReader::Open(target.data())};
+                dir) {
+                const std::error_code error{
+                    dir->ForEach([&out](const DirectoryEntry& entry) {
+                        if (!entry.name.starts_with('.')) {
+                            out.Write(entry.name).Put(' ');
+                        }
+                    })};
+                out.Put('\n');
+                if (error) {
+                    out.Flush();
+                    std::println(std::cerr, "ls: reading directory '{}': {}",
+                                 target, error.message());
+                    status = 2;
+                }
+                return;
+            }
+        }
+
+        const Listing listing{List(target, options, io)};
+        Print(out, listing);
+        status = std::max(status, listing.status);
+    };
+
+    if (targets.size() == 1) {
+        list(targets.front());
+    } else {
+        for (const std::string_view target : targets) {
+            out.Write(target).Write(":\n");
+            list(target);
+            out.Put('\n');
+        }
+    }
+}
+
+std::optional<std::size_t> ParseThreads(std::string_view arg) {
+    std::size_t threads{};
+    const std::from_chars_result result{
+        std::from_chars(arg.data(), arg.data() + arg.size(), threads)};
+    if (result.ec != std::errc{} || result.ptr != arg.data() + arg.size() ||
+        threads == 0) {
+        return std::nullopt;
+    }
+    return threads;
+}
+
+}  // namespace
+
+COREUTILS_MAIN(ls) {
     using Ls = coreutils::ProgramInfo<
         "ls", "0.0.1", "ls [OPTION]... [FILE]...",
         "List information about the FILEs (the current directory by default).\n"
         "Sort entries alphabetically if none of -cftuvSUX nor --sort is "
         "specified.">;
-    using PosArgs =
-        coreutils::PositionalArguments<std::filesystem::path,
-                                       [](std::string_view arg) {
-                                           return std::filesystem::path{arg};
-                                       }>;
-    coreutils::ArgumentParser<Ls, PosArgs> parser{argc, argv};
-    try {
-        parser.ParseArgsOrExit();
-    } catch (const std::exception& ex) {
-        std::println(std::cerr, "Error occured while parsing arguments: {}",
-                     ex.what());
-        return 1;
-    } catch (...) {
-        std::println(std::cerr, "Unrecognized error occurred.");
-        return 1;
-    }
-
-    namespace fs = std::filesystem;
-    using Path = fs::path;
-    const std::vector<Path>& dirs{parser.get<PosArgs>().value};
-    const auto display = [](const Path& entry) {
-        if (auto name{entry.filename().string()}; !name.starts_with('.')) {
-            std::print("{} ", entry.filename().string());
+    using PosArgs = coreutils::PositionalArguments<
+        std::string_view, [](std::string_view arg) { return arg; },
+        coreutils::ArgvView>;
+    using Long = coreutils::BooleanArgument<"-l">;
+    using Recursive = coreutils::BooleanArgument<"-R", "--recursive">;
+    using Reverse = coreutils::BooleanArgument<"-r", "--reverse">;
+    using SortBySize = coreutils::BooleanArgument<"-S">;
+    using SortByTime = coreutils::BooleanArgument<"-t">;
+    using Unsorted = coreutils::BooleanArgument<"-U">;
+    using SortByExtension = coreutils::BooleanArgument<"-X">;
+    using SortWord =
+        coreutils::SingleValueArgument<std::string_view,
+                                       [](std::string_view word) {
+                                           return word;
+                                       },
+                                       "--sort">;
+    using Jobs =
+        coreutils::SingleValueArgument<std::string_view,
+                                       [](std::string_view jobs) {
+                                           return jobs;
+                                       },
+                                       "-j", "--jobs">;
+    coreutils::ArgumentParser<Ls, PosArgs, Long, Recursive, Reverse,
+                              SortBySize, SortByTime, Unsorted,
+                              SortByExtension, SortWord, Jobs>
+        parser{argc, argv};
+    parser.ParseArgsOrExit();
+
+    SortMode sort_mode{SortMode::Name};
+    if (const std::string_view word{parser.get<SortWord>().value};
+        !word.empty()) {
+        if (const std::optional<SortMode> mode{SortModeFromWord(word)}; mode) {
+            sort_mode = *mode;
+        } else {
+            std::println(std::cerr,
+                         "ls: invalid argument '{}' for '--sort'\nValid "
+                         "arguments are: none, name, size, time, extension",
+                         word);
+            return 2;
+        }
+    } else if (parser.get<Unsorted>().value) {
+        sort_mode = SortMode::None;
+    } else if (parser.get<SortBySize>().value) {
+        sort_mode = SortMode::Size;
+    } else if (parser.get<SortByTime>().value) {
+        sort_mode = SortMode::Time;
+    } else if (parser.get<SortByExtension>().value) {
+        sort_mode = SortMode::Extension;
+    }
+
+    std::size_t threads{coreutils::DefaultConcurrency()};
+    if (const std::string_view jobs{parser.get<Jobs>().value}; !jobs.empty()) {
+        if (const std::optional<std::size_t> parsed{ParseThreads(jobs)};
+            parsed) {
+            threads = *parsed;
+        } else {
+            std::println(std::cerr, "ls: invalid number of jobs: '{}'", jobs);
+            return 2;
         }
+    }
+
+    const bool long_format{parser.get<Long>().value};
+    Options options{
+        .sort_mode = sort_mode,
+        .reverse = parser.get<Reverse>().value,
+        .long_format = long_format,
+        .recursive = parser.get<Recursive>().value,
+        // only ask the filesystem for what will actually be shown or sorted
+        .fields = long_format ? LongFormat::fields : StatField::None,
+        .now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+                   .count(),
     };
+    if (sort_mode == SortMode::Size) {
+        options.fields |= StatField::Size;
+    } else if (sort_mode == SortMode::Time) {
+        options.fields |= StatField::ModifyTime;
+    }
 
-    switch (dirs.size()) {
-        case 0:
-            std::ranges::for_each(fs::directory_iterator{fs::current_path()},
-                                  display);
-            std::println();
-            break;
-        case 1:
-            if (Path target{dirs.front()}; fs::is_directory(target)) {
-                std::ranges::for_each(fs::directory_iterator{target}, display);
-                std::println();
-            } else {
-                std::println("{}", target.string());
-            }
-            break;
-        default:
-            for (auto it{dirs.cbegin()}; it < dirs.cend(); ++it) {
-                std::println("{}:", it->string());
-                if (fs::is_directory(*it)) {
-                    std::ranges::for_each(fs::directory_iterator{*it}, display);
-                    std::println();
-                } else {
-                    std::println("{}", it->string());
-                }
-                std::println();
-            }
-            break;
+    coreutils::Output out{};
+    int status{0};
+    // targets are views into argv, so they are null terminated
+    const auto list = [&](const auto& targets) {
+        if (!options.recursive) {
+            // lookups spread over every thread, or queued on one ring
+            coreutils::IoEngine io{coreutils::IoEngine::default_queue_depth,
+                                   threads};
+            ListEach(targets, options, io, out, status);
+            return;
+        }
+
+        std::optional<coreutils::WorkStealingPool> pool{};
+        if (threads > 1) {
+            pool.emplace(threads);
+        }
+        bool first{true};
+        for (const std::string_view target : targets) {
+            status = std::max(
+                status,
+                ListRecursively(std::make_unique<Node>(std::string{target}),
+                                options, pool ? &*pool : nullptr, out,
+                                first));
+        }
+    };
+    if (const auto& targets{parser.get<PosArgs>().value}; !targets.empty()) {
+        list(targets);
+    } else {
+        list(std::array<std::string_view, 1>{"."});
+    }
+
+    if (const std::error_code error{out.Flush()}; error) {
+        std::println(std::cerr, "ls: write error: {}", error.message());
+        return 2;
     }
-    return 0;
+    return status;
 }
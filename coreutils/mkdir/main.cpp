@@ -18,44 +18,347 @@
 ///  with this program. If not, see <https://www.gnu.org/licenses/>
 ///
 
+#include <algorithm>
+#include <charconv>
 #include <cstddef>
-#include <cstdlib>
-#include <exception>
+#include <cstdint>
+#include <deque>
+#include <expected>
 #include <filesystem>
+#include <functional>
 #include <iostream>
+#include <optional>
 #include <print>
 #include <string>
 #include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
 
+#include "lib/Arena.hpp"
 #include "lib/ArgumentParser.hpp"
+#include "lib/DirectoryReader.hpp"
+#include "lib/Main.hpp"
+#include "lib/MakeDirectory.hpp"
+#include "lib/Output.hpp"
 
-int main(int argc, const char** argv) {
+namespace {
+
+using coreutils::DirectoryReader;
+
+#if defined(_WIN32)
+constexpr std::string_view separators{"/\\"};
+#else
+constexpr std::string_view separators{"/"};
+#endif
+
+/// One path component. Arguments that share a prefix share its nodes, so the
+/// prefix is created (or found to exist) once, however many arguments it has.
+struct Node final {
+    /// Null terminated
+    std::string_view name{};
+    /// How the user spelled this path, when an argument names this node
+    /// itself rather than only passing through it
+    std::optional<std::string_view> argument{};
+    /// In the order they were first seen on the command line
+    std::vector<Node*> children{};
+};
+
+/// The arguments, merged into one tree per starting point (e.g. "/" and the
+/// working directory)
+class PathTrie final {
+ public:
+    struct Root final {
+        std::string path;
+        Node* node;
+    };
+
+    void Insert(std::string_view argument) {
+        const std::filesystem::path as_path{argument};
+        const std::string root_path{as_path.has_root_path()
+                                        ? as_path.root_path().string()
+                                        : std::string{"."}};
+        Node* node{RootNode(root_path)};
+
+        std::string_view rest{argument};
+        rest.remove_prefix(as_path.has_root_path()
+                               ? std::min(rest.size(), root_path.size())
+                               : 0);
+        while (!rest.empty()) {
+            const std::size_t end{
+                std::min(rest.find_first_of(separators), rest.size())};
+            const std::string_view name{rest.substr(0, end)};
+            rest.remove_prefix(std::min(end + 1, rest.size()));
+            if (!name.empty() && name != ".") {
+                node = Child(*node, name);
+            }
+        }
+        if (node->argument) {
+            return;
+        }
+        node->argument = argument;
+    }
+
+    const std::vector<Root>& roots() const { return roots_; }
+
+ private:
+    struct Key final {
+        const Node* parent;
+        std::string_view name;
+
+        bool operator==(const Key&) const = default;
+    };
+
+    struct KeyHash final {
+        std::size_t operator()(const Key& key) const {
+            return std::hash<std::string_view>{}(key.name) ^
+                   (std::hash<const Node*>{}(key.parent) * 31);
+        }
+    };
+
+    Node* RootNode(const std::string& path) {
+        for (const Root& root : roots_) {
+            if (root.path == path) {
+                return root.node;
+            }
+        }
+        roots_.push_back({.path = path, .node = &nodes_.emplace_back()});
+        return roots_.back().node;
+    }
+
+    Node* Child(Node& parent, std::string_view name) {
+        // one map for the whole tree rather than one per node, as most nodes
+        // only have a child or two
+        const auto [it, inserted]{children_.try_emplace({&parent, name})};
+        if (inserted) {
+            Node& child{nodes_.emplace_back(Node{.name = names_.Store(name)})};
+            parent.children.push_back(&child);
+            it->second = &child;
+        }
+        return it->second;
+    }
+
+    /// A deque, so that nodes never move
+    std::deque<Node> nodes_{};
+    std::unordered_map<Key, Node*, KeyHash> children_{};
+    std::vector<Root> roots_{};
+    coreutils::Arena names_{};
+};
+
+/// Creates every node of a PathTrie, holding each level's directory open so
+/// that its children are made with mkdirat, instead of every argument having
+/// its whole path walked again from the start.
+class TreeMaker final {
+ public:
+    TreeMaker(std::optional<unsigned> mode, bool verbose,
+              coreutils::Output& out)
+        : mode_{mode}, verbose_{verbose}, out_{out} {
+        // like GNU, parents are always writable and searchable by their owner,
+        // whatever the umask says
+        const unsigned umask{coreutils::CurrentUmask()};
+        parent_mode_ = (coreutils::default_directory_mode & ~umask) | 0300;
+        parent_needs_chmod_ = (umask & 0300) != 0;
+        needs_chmod_ = mode && ((*mode & ~0777u) != 0 || (*mode & umask) != 0);
+    }
+
+    int status() const { return status_; }
+
+    /// Makes target itself (for when there is no -p), which must not exist
+    void MakeExactly(std::string_view target) {
+        if (!working_directory_) {
+            working_directory_.emplace(DirectoryReader::Open("."));
+        }
+        if (!*working_directory_) {
+            Fail(target, working_directory_->error());
+            return;
+        }
+        // target is a view into argv, so it is null terminated. An absolute
+        // target ignores the directory it is made relative to.
+        if (const std::error_code error{
+                Create(**working_directory_, target.data(), target, true)};
+            error) {
+            Fail(target, error);
+        }
+    }
+
+    /// Makes every node under root
+    void Make(const PathTrie::Root& root) {
+        std::expected<DirectoryReader, std::error_code> dir{
+            DirectoryReader::Open(root.path.c_str())};
+        if (!dir) {
+            Fail(root.path, dir.error());
+            return;
+        }
+        std::string path{root.path == "." ? std::string{} : root.path};
+        MakeChildren(*dir, *root.node, path);
+    }
+
+ private:
+    void MakeChildren(const DirectoryReader& parent, const Node& node,
+                      std::string& path) {
+        for (const Node* child : node.children) {
+            const std::size_t parent_length{path.size()};
+            if (!path.empty() && separators.find(path.back()) ==
+                                     std::string_view::npos) {
+                path.push_back('/');
+            }
+            path.append(child->name);
+            MakeOne(parent, *child, path);
+            path.resize(parent_length);
+        }
+    }
+
+    void MakeOne(const DirectoryReader& parent, const Node& node,
+                 std::string& path) {
+        const std::string_view shown{node.argument.value_or(path)};
+        if (const std::error_code error{Create(parent, node.name.data(), shown,
+                                               node.argument.has_value())};
+            error && error != std::errc::file_exists) {
+            Fail(shown, error);
+            return;
+        } else if (error && node.children.empty()) {
+            // another process (or an earlier argument) may well have made it
+            // first, which is fine as long as it is a directory
+            if (!DirectoryReader::Open(parent, node.name.data())) {
+                Fail(shown, error);
+            }
+            return;
+        }
+
+        if (node.children.empty()) {
+            return;
+        }
+        std::expected<DirectoryReader, std::error_code> dir{
+            DirectoryReader::Open(parent, node.name.data())};
+        if (!dir) {
+            Fail(shown, dir.error());
+            return;
+        }
+        MakeChildren(*dir, node, path);
+    }
+
+    /// Makes the single directory name inside of parent. requested is whether
+    /// an argument names it, rather than it being a parent made for -p.
+    std::error_code Create(const DirectoryReader& parent, const char* name,
+                           std::string_view shown, bool requested) {
+        const unsigned mode{
+            requested ? mode_.value_or(coreutils::default_directory_mode)
+                      : parent_mode_};
+        if (const std::error_code error{
+                coreutils::MakeDirectoryAt(parent, name, mode)};
+            error) {
+            return error;
+        }
+
+        // mkdirat only ever clears bits, so put back whatever the umask took
+        // from an explicit mode
+        if (requested ? needs_chmod_ : parent_needs_chmod_) {
+            if (const std::error_code error{
+                    coreutils::ChangeModeAt(parent, name, mode)};
+                error) {
+                Fail(shown, error, "cannot set permissions of");
+            }
+        }
+        if (verbose_) {
+            out_.Write("mkdir: created directory '").Write(shown).Write("'\n");
+        }
+        return {};
+    }
+
+    void Fail(std::string_view path, std::error_code error,
+              std::string_view action = "cannot create directory") {
+        out_.Flush();
+        std::println(std::cerr, "mkdir: {} '{}': {}", action, path,
+                     error.message());
+        status_ = 1;
+    }
+
+    std::optional<unsigned> mode_;
+    bool verbose_;
+    coreutils::Output& out_;
+    unsigned parent_mode_{coreutils::default_directory_mode};
+    bool parent_needs_chmod_{false};
+    bool needs_chmod_{false};
+    int status_{0};
+    std::optional<std::expected<DirectoryReader, std::error_code>>
+        working_directory_{};
+};
+
+/// Octal modes only, e.g. 755 or 1777
+std::optional<unsigned> ParseMode(std::string_view text) {
+    unsigned mode{};
+    const std::from_chars_result result{
+        std::from_chars(text.data(), text.data() + text.size(), mode, 8)};
+    if (text.empty() || result.ec != std::errc{} ||
+        result.ptr != text.data() + text.size() || mode > 07777) {
+        return std::nullopt;
+    }
+    return mode;
+}
+
+}  // namespace
+
+COREUTILS_MAIN(mkdir) {
     using Mkdir = coreutils::ProgramInfo<
         "mkdir", "0.0.1", "Usage: mkdir [OPTION]... DIRECTORY...",
         "Create the DIRECTORY(ies), if they do not already exist.">;
     using PosArgs =
-        coreutils::PositionalArguments<std::filesystem::path,
+        coreutils::PositionalArguments<std::string_view,
                                        [](std::string_view arg) {
-                                           return std::filesystem::path{arg};
+                                           return arg;
                                        }>;
     using Parents = coreutils::BooleanArgument<"-p", "--parents">;
+    using Verbose = coreutils::BooleanArgument<"-v", "--verbose">;
+    using Mode =
+        coreutils::SingleValueArgument<std::string_view,
+                                       [](std::string_view mode) {
+                                           return mode;
+                                       },
+                                       "-m", "--mode">;
 
-    coreutils::ArgumentParser<Mkdir, PosArgs, Parents> parser{argc, argv};
-    try {
-        parser.ParseArgsOrExit();
-    } catch (const std::exception& ex) {
-        std::println(std::cerr, "Error occured while parsing arguments: {}",
-                     ex.what());
-        return 1;
-    } catch (...) {
-        std::println(std::cerr, "Unrecognized error occurred.");
+    coreutils::ArgumentParser<Mkdir, PosArgs, Parents, Verbose, Mode> parser{
+        argc, argv};
+    parser.ParseArgsOrExit();
+
+    std::optional<unsigned> mode{};
+    if (const std::string_view text{parser.get<Mode>().value}; !text.empty()) {
+        mode = ParseMode(text);
+        if (!mode) {
+            std::println(std::cerr, "mkdir: invalid mode '{}'", text);
+            return 1;
+        }
+    }
+
+    const std::vector<std::string_view>& targets{parser.get<PosArgs>().value};
+    if (targets.empty()) {
+        std::println(std::cerr, "mkdir: missing operand");
         return 1;
     }
-    std::println("Positional arguments were:");
-    std::size_t count{0};
-    for (const std::filesystem::path& name : parser.get<PosArgs>().value) {
-        ++count;
-        const std::string& str{name.string()};
-        std::println("\targ {}: {}", count, str);
+
+    PathTrie trie{};
+    if (parser.get<Parents>().value) {
+        for (const std::string_view target : targets) {
+            trie.Insert(target);
+        }
+    }
+
+    coreutils::Output out{};
+    TreeMaker maker{mode, parser.get<Verbose>().value, out};
+    if (parser.get<Parents>().value) {
+        for (const PathTrie::Root& root : trie.roots()) {
+            maker.Make(root);
+        }
+    } else {
+        // without -p every argument is created as given, in order, and it is
+        // an error for any of them to exist already
+        for (const std::string_view target : targets) {
+            maker.MakeExactly(target);
+        }
+    }
+
+    if (const std::error_code error{out.Flush()}; error) {
+        std::println(std::cerr, "mkdir: write error: {}", error.message());
+        return 1;
     }
+    return maker.status();
 }
@@ -0,0 +1,425 @@
+///
+///  @file main.cpp
+///  @brief Format and print data
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <print>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "lib/ArgumentParser.hpp"
+#include "lib/Escapes.hpp"
+#include "lib/Main.hpp"
+#include "lib/Output.hpp"
+#include "lib/Stats.hpp"
+
+namespace {
+
+/// One piece of FORMAT: some text, and then (usually) a conversion
+struct Directive final {
+    /// With FORMAT's escapes already decoded
+    std::string text;
+    /// Set when the text ends at a \c, or at an error (which is then in
+    /// error), after which nothing more is printed
+    bool stop;
+    std::string error;
+    /// e.g. 'd', or 0 for text alone
+    char conversion;
+    /// e.g. "-0"
+    std::string flags;
+    /// Either of these can instead come from an argument, for a *
+    int width;
+    bool width_from_argument;
+    /// -1 for none
+    int precision;
+    bool precision_from_argument;
+};
+
+/// The digits at the front of text, if any, which it is moved past
+int ReadDigits(std::string_view& text) {
+    int value{0};
+    while (!text.empty() && text.front() >= '0' && text.front() <= '9') {
+        value = value > (INT_MAX - 9) / 10 ? INT_MAX
+                                           : value * 10 + (text.front() - '0');
+        text.remove_prefix(1);
+    }
+    return value;
+}
+
+/// Splits FORMAT into directives, once, so that cycling through it for a
+/// long list of arguments does not mean parsing it again every time
+std::vector<Directive> ParseFormat(std::string_view format) {
+    std::vector<Directive> directives{};
+    Directive current{};
+    while (!format.empty()) {
+        const std::size_t special{format.find_first_of("%\\")};
+        current.text.append(format.substr(0, special));
+        if (special == std::string_view::npos) {
+            break;
+        }
+        format.remove_prefix(special);
+
+        if (format.front() == '\\') {
+            // one escape at a time, since a % may follow it
+            const coreutils::EscapeResult result{coreutils::AppendEscape(
+                format, coreutils::EscapeStyle::PrintfFormat, current.text)};
+            if (!result || *result == coreutils::EscapeEnd::Stopped) {
+                current.stop = true;
+                current.error = result ? "" : result.error();
+                directives.push_back(std::move(current));
+                return directives;
+            }
+            continue;
+        }
+
+        if (format.starts_with("%%")) {
+            current.text.push_back('%');
+            format.remove_prefix(2);
+            continue;
+        }
+        std::string_view spec{format.substr(1)};
+        while (!spec.empty() && std::string_view{"-+ #0'"}.contains(spec[0])) {
+            // ' groups digits, which the C locale does not
+            if (spec[0] != '\'') {
+                current.flags.push_back(spec[0]);
+            }
+            spec.remove_prefix(1);
+        }
+        if (spec.starts_with('*')) {
+            current.width_from_argument = true;
+            spec.remove_prefix(1);
+        } else {
+            current.width = ReadDigits(spec);
+        }
+        current.precision = -1;
+        if (spec.starts_with('.')) {
+            spec.remove_prefix(1);
+            if (spec.starts_with('*')) {
+                current.precision_from_argument = true;
+                spec.remove_prefix(1);
+            } else {
+                current.precision = ReadDigits(spec);
+            }
+        }
+        // length modifiers mean nothing here: every integer is intmax_t
+        while (!spec.empty() && std::string_view{"hlLjzt"}.contains(spec[0])) {
+            spec.remove_prefix(1);
+        }
+        const std::size_t end{format.size() - spec.size()};
+
+        const char conversion{end < format.size() ? format[end] : '\0'};
+        if (conversion == '\0' ||
+            !std::string_view{"diouxXfFeEgGaAcsb"}.contains(conversion) ||
+            (conversion == 'b' && end != 1)) {
+            current.stop = true;
+            current.error = std::format(
+                "{}: invalid conversion specification",
+                format.substr(0, std::min(end + 1, format.size())));
+            directives.push_back(std::move(current));
+            return directives;
+        }
+        current.conversion = conversion;
+        format.remove_prefix(end + 1);
+        directives.push_back(std::move(current));
+        current = Directive{};
+    }
+    if (!current.text.empty() || directives.empty()) {
+        directives.push_back(std::move(current));
+    }
+    return directives;
+}
+
+/// Runs FORMAT over the arguments, as many times as it takes to use them
+/// all up
+class Printer final {
+ public:
+    Printer(std::span<const char* const> arguments, coreutils::Output& out)
+        : arguments_{arguments}, out_{&out} {}
+
+    /// Returns the exit status
+    int Run(const std::vector<Directive>& directives) {
+        bool converts{false};
+        do {
+            for (const Directive& directive : directives) {
+                out_->Write(directive.text);
+                if (directive.stop) {
+                    return Stop(directive.error);
+                } else if (directive.conversion != '\0') {
+                    converts = true;
+                    if (!Convert(directive)) {
+                        return Stop(error_);
+                    }
+                }
+            }
+        } while (converts && next_ < arguments_.size());
+
+        if (!converts && next_ < arguments_.size()) {
+            Report(std::format(
+                "warning: ignoring excess arguments, starting with '{}'",
+                arguments_[next_]));
+        }
+        return status_;
+    }
+
+ private:
+    /// Returns the exit status after a \c (with no error) or a fatal error
+    int Stop(std::string_view error) {
+        if (error.empty()) {
+            return status_;
+        }
+        Report(error);
+        return 1;
+    }
+
+    void Report(std::string_view message) {
+        out_->Flush();
+        std::println(std::cerr, "printf: {}", message);
+    }
+
+    std::string_view Next() {
+        return next_ < arguments_.size() ? arguments_[next_++] : "";
+    }
+
+    /// Reports arguments that are not (entirely) numbers, and carries on
+    /// with what could be made of them, as GNU does
+    template <class Number, class Parse>
+    Number ParseNumber(std::string_view arg, Parse parse) {
+        if (arg.empty()) {
+            return 0;
+        } else if (arg.size() > 1 && (arg[0] == '\'' || arg[0] == '"')) {
+            if (arg.size() > 2) {
+                Report(std::format("warning: {}: character(s) following "
+                                   "character constant have been ignored",
+                                   arg.substr(2)));
+            }
+            return static_cast<Number>(static_cast<unsigned char>(arg[1]));
+        }
+
+        // arguments come from argv, so they are null terminated
+        char* end{nullptr};
+        errno = 0;
+        const Number value{parse(arg.data(), &end)};
+        if (end == arg.data()) {
+            Report(std::format("'{}': expected a numeric value", arg));
+            status_ = 1;
+        } else if (errno != 0) {
+            Report(std::format("'{}': {}", arg,
+                               std::error_code{errno, std::system_category()}
+                                   .message()));
+            status_ = 1;
+        } else if (*end != '\0') {
+            Report(std::format("'{}': value not completely converted", arg));
+            status_ = 1;
+        }
+        return value;
+    }
+
+    /// For a *, which has to fit in an int
+    bool TakeInt(std::string_view what, int& value) {
+        const std::string_view arg{Next()};
+        const std::intmax_t parsed{ParseNumber<std::intmax_t>(
+            arg, [](const char* text, char** end) {
+                return std::strtoimax(text, end, 0);
+            })};
+        if (parsed < INT_MIN || parsed > INT_MAX) {
+            error_ = std::format("invalid {}: '{}'", what, arg);
+            return false;
+        }
+        value = static_cast<int>(parsed);
+        return true;
+    }
+
+    /// Formats value with snprintf, as printf(1) is defined in its terms
+    template <class Value>
+    void Print(const std::string& format, int width, int precision,
+               Value value) {
+        const int length{
+            std::snprintf(scratch_.data(), scratch_.size(), format.c_str(),
+                          width, precision, value)};
+        if (length < 0) {
+            return;
+        } else if (static_cast<std::size_t>(length) >= scratch_.size()) {
+            scratch_.resize(static_cast<std::size_t>(length) + 1);
+            std::snprintf(scratch_.data(), scratch_.size(), format.c_str(),
+                          width, precision, value);
+        }
+        out_->Write({scratch_.data(), static_cast<std::size_t>(length)});
+    }
+
+    /// %s, %b and %c, which pad by hand so that NULs come through
+    void PrintText(std::string_view text, bool left, int width,
+                   int precision) {
+        if (precision >= 0) {
+            text = text.substr(
+                0, std::min(text.size(), static_cast<std::size_t>(precision)));
+        }
+        const std::size_t wanted{static_cast<std::size_t>(width)};
+        const std::size_t padding{wanted > text.size() ? wanted - text.size()
+                                                       : 0};
+        if (!left) {
+            out_->Fill(' ', padding);
+        }
+        out_->Write(text);
+        if (left) {
+            out_->Fill(' ', padding);
+        }
+    }
+
+    /// Returns false on errors that end everything
+    bool Convert(const Directive& directive) {
+        int width{directive.width};
+        int precision{directive.precision};
+        if (directive.width_from_argument && !TakeInt("field width", width)) {
+            return false;
+        } else if (directive.precision_from_argument &&
+                   !TakeInt("precision", precision)) {
+            return false;
+        }
+        // as in C, a negative width from an argument left justifies
+        bool left{directive.flags.contains('-')};
+        if (width < 0) {
+            left = true;
+            width = width == INT_MIN ? INT_MAX : -width;
+        }
+        // and a negative precision is no precision
+        precision = std::max(precision, -1);
+
+        // width and precision always go in through *
+        std::string format{"%"};
+        format.append(directive.flags).append(left ? "-*.*" : "*.*");
+
+        const char conversion{directive.conversion};
+        const std::string_view arg{Next()};
+        switch (conversion) {
+            case 'd':
+            case 'i':
+                format.append("j").push_back(conversion);
+                Print(format, width, precision,
+                      ParseNumber<std::intmax_t>(
+                          arg, [](const char* text, char** end) {
+                              return std::strtoimax(text, end, 0);
+                          }));
+                break;
+            case 'o':
+            case 'u':
+            case 'x':
+            case 'X':
+                format.append("j").push_back(conversion);
+                Print(format, width, precision,
+                      ParseNumber<std::uintmax_t>(
+                          arg, [](const char* text, char** end) {
+                              return std::strtoumax(text, end, 0);
+                          }));
+                break;
+            case 'c':
+                PrintText(arg.empty() ? std::string_view{"", 1}
+                                      : arg.substr(0, 1),
+                          left, width, -1);
+                break;
+            case 's':
+                PrintText(arg, left, width, precision);
+                break;
+            case 'b': {
+                std::string unescaped{};
+                const coreutils::EscapeResult result{
+                    coreutils::AppendUnescaped(
+                        arg, coreutils::EscapeStyle::PrintfArgument,
+                        unescaped)};
+                out_->Write(unescaped);
+                if (!result) {
+                    error_ = result.error();
+                    return false;
+                } else if (*result == coreutils::EscapeEnd::Stopped) {
+                    // nothing at all after a \c, as with echo
+                    next_ = arguments_.size();
+                    error_.clear();
+                    return false;
+                }
+                break;
+            }
+            default:
+                format.append("L").push_back(conversion);
+                Print(format, width, precision,
+                      ParseNumber<long double>(
+                          arg, [](const char* text, char** end) {
+                              return std::strtold(text, end);
+                          }));
+                break;
+        }
+        return true;
+    }
+
+    std::span<const char* const> arguments_;
+    std::size_t next_{0};
+    coreutils::Output* out_;
+    std::vector<char> scratch_{std::vector<char>(256)};
+    std::string error_{};
+    int status_{0};
+};
+
+}  // namespace
+
+COREUTILS_MAIN(printf) {
+    using Printf = coreutils::ProgramInfo<
+        "printf", "0.0.1", "Usage: printf FORMAT [ARGUMENT]...",
+        "Print ARGUMENT(s) according to FORMAT, reusing FORMAT for as long as "
+        "there are ARGUMENT(s) left.">;
+
+    // FORMAT and the arguments may look like options (e.g. a negative
+    // number), so only a lone --help or --version is handed to the parser
+    std::span<const char*> args{argv + 1, argv + argc};
+    // in a stats build, a leading --stats is taken before all of that
+    args = args.subspan(coreutils::EnableStatsFromCommandLine(
+        Printf::name.PrintableView(), args));
+    if (args.size() == 1 && (std::string_view{args[0]} == "--help" ||
+                             std::string_view{args[0]} == "--version")) {
+        coreutils::ArgumentParser<Printf> parser{argc, argv};
+        parser.ParseArgsOrExit();
+    }
+    if (!args.empty() && std::string_view{args[0]} == "--") {
+        args = args.subspan(1);
+    }
+    if (args.empty()) {
+        std::println(std::cerr, "printf: missing operand\nTry 'printf --help' "
+                                "for more information.");
+        return 1;
+    }
+
+    const std::vector<Directive> directives{ParseFormat(args[0])};
+    coreutils::Output out{};
+    Printer printer{args.subspan(1), out};
+    const int status{printer.Run(directives)};
+    if (const std::error_code error{out.Flush()}; error) {
+        std::println(std::cerr, "printf: write error: {}", error.message());
+        return 1;
+    }
+    return status;
+}
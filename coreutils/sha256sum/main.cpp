@@ -0,0 +1,33 @@
+///
+///  @file main.cpp
+///  @brief Compute and check SHA256 (256-bit) checksums
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#include "lib/ArgumentParser.hpp"
+#include "lib/Checksum.hpp"
+#include "lib/ChecksumUtility.hpp"
+#include "lib/Main.hpp"
+
+COREUTILS_MAIN(sha256sum) {
+    using Info = coreutils::ProgramInfo<
+        "sha256sum", "0.0.1", "Usage: sha256sum [OPTION]... [FILE]...",
+        "Print or check SHA256 (256-bit) checksums.\n\nWith no FILE, or when "
+        "FILE is -, read standard input. Files are hashed several at a "
+        "time; see -j.">;
+    return coreutils::ChecksumMain<coreutils::Sha256, Info>(argc, argv);
+}
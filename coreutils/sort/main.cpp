@@ -0,0 +1,963 @@
+///
+///  @file main.cpp
+///  @brief Sort lines of text files
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <expected>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <print>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "lib/ArgumentParser.hpp"
+#include "lib/FileCopy.hpp"
+#include "lib/FileInput.hpp"
+#include "lib/Main.hpp"
+#include "lib/Output.hpp"
+#include "lib/Parallel.hpp"
+#include "lib/SortKey.hpp"
+
+namespace {
+
+using coreutils::LineOrder;
+using coreutils::SortLine;
+
+constexpr int standard_output{1};
+/// GNU sort's status for every kind of trouble
+constexpr int failure{2};
+
+/// A file holding one sorted run that did not fit in memory. It is deleted
+/// as soon as it is made (or, on Windows, when it is closed), so nothing is
+/// left behind however sort exits.
+class TempFile final {
+ public:
+    static std::expected<TempFile, std::error_code> Create(
+        const std::string& directory) {
+#if defined(_WIN32)
+        std::unique_ptr<char, decltype(&std::free)> name{
+            ::_tempnam(directory.c_str(), "sort"), &std::free};
+        const int fd{name ? ::_open(name.get(),
+                                    _O_CREAT | _O_EXCL | _O_RDWR |
+                                        _O_BINARY | _O_TEMPORARY,
+                                    _S_IREAD | _S_IWRITE)
+                          : -1};
+#else
+        std::string name{directory + "/sortXXXXXX"};
+        const int fd{::mkostemp(name.data(), O_CLOEXEC)};
+        if (fd >= 0) {
+            ::unlink(name.c_str());
+        }
+#endif
+        if (fd < 0) {
+            return std::unexpected{
+                std::error_code{errno, std::system_category()}};
+        }
+        return TempFile{fd};
+    }
+
+    TempFile(const TempFile&) = delete;
+    TempFile& operator=(const TempFile&) = delete;
+    TempFile(TempFile&& other) noexcept : fd_{std::exchange(other.fd_, -1)} {}
+    TempFile& operator=(TempFile&& other) noexcept {
+        std::swap(fd_, other.fd_);
+        return *this;
+    }
+
+    ~TempFile() {
+        if (fd_ >= 0) {
+#if defined(_WIN32)
+            ::_close(fd_);
+#else
+            ::close(fd_);
+#endif
+        }
+    }
+
+    int fd() const { return fd_; }
+
+    /// Goes back to the start, to read back what was written
+    std::error_code Rewind() const {
+#if defined(_WIN32)
+        const bool failed{::_lseeki64(fd_, 0, SEEK_SET) < 0};
+#else
+        const bool failed{::lseek(fd_, 0, SEEK_SET) < 0};
+#endif
+        return failed ? std::error_code{errno, std::system_category()}
+                      : std::error_code{};
+    }
+
+ private:
+    explicit TempFile(int fd) : fd_{fd} {}
+
+    int fd_;
+};
+
+/// What sort was doing when it failed, which decides how it is reported
+enum class Stage : std::uint8_t {
+    Reading,
+    CreatingTemporary,
+    WritingTemporary,
+    ReadingTemporary,
+    Writing,
+};
+
+struct SortError final {
+    Stage stage;
+    std::error_code error;
+};
+
+using SortResult = std::expected<void, SortError>;
+
+struct Settings final {
+    /// -S, in bytes
+    std::size_t memory;
+    std::size_t threads;
+    bool unique;
+    std::string temporary_directory;
+};
+
+/// The lines of one sorted slice of a batch
+class SliceSource final {
+ public:
+    explicit SliceSource(std::span<const SortLine> lines) : lines_{lines} {}
+
+    const SortLine* Peek() const {
+        return lines_.empty() ? nullptr : lines_.data();
+    }
+    void Pop() { lines_ = lines_.subspan(1); }
+
+ private:
+    std::span<const SortLine> lines_;
+};
+
+/// Reads a sorted run back from its temporary file, a buffer at a time
+class RunReader final {
+ public:
+    RunReader(int fd, const LineOrder& order, std::size_t buffer_size)
+        : fd_{fd}, order_{&order}, buffer_(buffer_size) {
+        Next();
+    }
+
+    const SortLine* Peek() const { return has_line_ ? &line_ : nullptr; }
+    void Pop() {
+        begin_ += line_.size + 1;
+        scanned_ = begin_;
+        Next();
+    }
+
+    std::error_code error() const { return error_; }
+
+ private:
+    void Next() {
+        while (true) {
+            const void* const newline{std::memchr(
+                buffer_.data() + scanned_, '\n', end_ - scanned_)};
+            if (newline) {
+                const char* const data{buffer_.data() + begin_};
+                line_ = order_->Make(
+                    data, static_cast<std::size_t>(
+                              static_cast<const char*>(newline) - data));
+                has_line_ = true;
+                return;
+            }
+            // every line of a run ends in a newline, so anything left over
+            // can only be a run cut short
+            has_line_ = false;
+            if (done_) {
+                return;
+            }
+
+            // keep the partial line, and make room for the rest of it
+            std::memmove(buffer_.data(), buffer_.data() + begin_,
+                         end_ - begin_);
+            end_ -= begin_;
+            scanned_ = end_;
+            begin_ = 0;
+            if (end_ == buffer_.size()) {
+                buffer_.resize(buffer_.size() * 2);
+            }
+            const std::expected<std::size_t, std::error_code> got{
+                coreutils::ReadSome(fd_,
+                                    std::span{buffer_}.subspan(end_))};
+            if (!got) {
+                error_ = got.error();
+                done_ = true;
+            } else if (*got == 0) {
+                done_ = true;
+            } else {
+                end_ += *got;
+            }
+        }
+    }
+
+    int fd_;
+    const LineOrder* order_;
+    std::vector<char> buffer_;
+    std::size_t begin_{0};
+    /// Where the search for the end of the current line picks up
+    std::size_t scanned_{0};
+    std::size_t end_{0};
+    SortLine line_{};
+    bool has_line_{false};
+    bool done_{false};
+    std::error_code error_{};
+};
+
+/// Merges sorted sources into out. Sources play a tournament (a tree of
+/// losers), so taking each line costs one comparison per level of the tree,
+/// about log2 of the number of sources. Equal lines are taken from the
+/// earlier source first, which keeps the merge stable, so with unique the
+/// line kept is the first one that was read.
+template <class Source>
+void Merge(std::span<Source> sources, const LineOrder& order, bool unique,
+           coreutils::Output& out) {
+    const std::size_t count{sources.size()};
+    const std::size_t leaves{std::bit_ceil(std::max<std::size_t>(count, 1))};
+    // padding leaves, and sources that have run dry, never win
+    const auto beats = [sources, count, &order](std::size_t lhs,
+                                                std::size_t rhs) {
+        const SortLine* const left{lhs < count ? sources[lhs].Peek()
+                                               : nullptr};
+        const SortLine* const right{rhs < count ? sources[rhs].Peek()
+                                                : nullptr};
+        if (!left || !right) {
+            return left != nullptr;
+        }
+        const int diff{order.Compare(*left, *right)};
+        return diff < 0 || (diff == 0 && lhs < rhs);
+    };
+
+    // node 0 holds the overall winner, nodes 1 through leaves - 1 the loser
+    // of the match played there
+    std::vector<std::size_t> losers(leaves);
+    std::vector<std::size_t> winners(2 * leaves);
+    for (std::size_t i{0}; i < leaves; ++i) {
+        winners[leaves + i] = i;
+    }
+    for (std::size_t node{leaves - 1}; node > 0; --node) {
+        const std::size_t left{winners[2 * node]};
+        const std::size_t right{winners[2 * node + 1]};
+        const bool left_wins{beats(left, right)};
+        winners[node] = left_wins ? left : right;
+        losers[node] = left_wins ? right : left;
+    }
+    losers[0] = leaves > 1 ? winners[1] : 0;
+
+    std::string previous_text{};
+    std::optional<SortLine> previous{};
+    while (losers[0] < count && sources[losers[0]].Peek()) {
+        std::size_t winner{losers[0]};
+        Source& source{sources[winner]};
+        const SortLine& line{*source.Peek()};
+        if (!unique || !previous || order.Compare(*previous, line) != 0) {
+            out.Write(line.view()).Put('\n');
+            if (unique) {
+                // the source may reuse the memory the line is in
+                previous_text.assign(line.view());
+                previous = order.Make(previous_text.data(),
+                                      previous_text.size());
+            }
+        }
+        source.Pop();
+
+        // replay the winner's matches on the way up from its leaf
+        for (std::size_t node{(leaves + winner) / 2}; node > 0; node /= 2) {
+            if (beats(losers[node], winner)) {
+                std::swap(losers[node], winner);
+            }
+        }
+        losers[0] = winner;
+    }
+}
+
+/// Reads input into batches of lines, sorts each batch in parallel, and
+/// when the input does not fit in memory, writes the sorted batches out to
+/// temporary files to be merged at the end.
+///
+/// A batch lives in one block of memory, of up to -S bytes. Text is read
+/// into the front, and the lines found in it are recorded from the back (as
+/// GNU sort does), as offsets into the text rather than strings of their
+/// own. The two meeting in the middle is what ends a batch, so the size of
+/// the lines is accounted for as well as the size of the text. The block
+/// starts small and doubles until it reaches -S, so small inputs never ask
+/// for the whole of it.
+class Sorter final {
+ public:
+    Sorter(const LineOrder& order, const Settings& settings)
+        : order_{&order},
+          settings_{&settings},
+          limit_{Capacity(settings.memory)},
+          capacity_{std::min(limit_, Capacity(initial_capacity))},
+          block_{std::make_unique_for_overwrite<std::byte[]>(capacity_)} {}
+
+    /// Reads everything left in fd. A last line without a newline is still
+    /// a line, as if it had one.
+    SortResult Read(int fd) {
+        while (true) {
+            const std::size_t free{capacity_ - used_ -
+                                   lines_ * sizeof(SortLine)};
+            if (free < min_read) {
+                if (const SortResult made{MakeRoom()}; !made) {
+                    return made;
+                }
+                continue;
+            }
+
+            // leave room for the lines the text will turn out to hold
+            const std::size_t wanted{std::min(read_size, free / 2)};
+            const std::expected<std::size_t, std::error_code> got{
+                coreutils::ReadSome(fd, {text() + used_, wanted})};
+            if (!got) {
+                return std::unexpected{SortError{Stage::Reading, got.error()}};
+            } else if (*got == 0) {
+                break;
+            }
+            used_ += *got;
+            if (const SortResult scanned{Scan()}; !scanned) {
+                return scanned;
+            }
+        }
+
+        if (line_start_ < used_) {
+            while (!Record(line_start_, used_)) {
+                if (const SortResult made{MakeRoom()}; !made) {
+                    return made;
+                }
+            }
+            line_start_ = scanned_ = used_;
+        }
+        return {};
+    }
+
+    /// Writes every line read, in order
+    SortResult Write(coreutils::Output& out) {
+        if (runs_.empty()) {
+            std::vector<SliceSource> sources{SortBatch()};
+            Merge(std::span{sources}, *order_, settings_->unique, out);
+        } else {
+            if (lines_ > 0) {
+                if (const SortResult spilled{Spill()}; !spilled) {
+                    return spilled;
+                }
+            }
+            block_.reset();
+            if (const SortResult merged{MergeRuns()}; !merged) {
+                return merged;
+            }
+            if (const SortResult merged{MergeInto(runs_, out)}; !merged) {
+                return merged;
+            }
+        }
+        if (const std::error_code error{out.Flush()}; error) {
+            return std::unexpected{SortError{Stage::Writing, error}};
+        }
+        return {};
+    }
+
+ private:
+    /// Reads smaller than this are not worth a system call
+    static constexpr std::size_t min_read{4096};
+    static constexpr std::size_t read_size{1024 * 1024};
+    static constexpr std::size_t initial_capacity{4 * read_size};
+    /// How many runs are merged at once. Each needs a read buffer of its
+    /// own, and more of them means a deeper tournament.
+    static constexpr std::size_t fan_in{16};
+    /// Batches smaller than this are sorted on one thread
+    static constexpr std::size_t min_slice{16 * 1024};
+
+    static std::size_t Capacity(std::size_t memory) {
+        return std::max(memory, 2 * min_read) / sizeof(SortLine) *
+               sizeof(SortLine);
+    }
+
+    char* text() { return reinterpret_cast<char*>(block_.get()); }
+
+    /// Lines are recorded from the back, so the first line read is last
+    std::span<SortLine> lines() {
+        return {reinterpret_cast<SortLine*>(block_.get() + capacity_) -
+                    lines_,
+                lines_};
+    }
+
+    /// Records the line text()[begin, end) if there is room for it
+    bool Record(std::size_t begin, std::size_t end) {
+        if (used_ + (lines_ + 1) * sizeof(SortLine) > capacity_) {
+            return false;
+        }
+        ++lines_;
+        SortLine& line{lines().front()};
+        line.data = text() + begin;
+        line.size = static_cast<std::uint32_t>(end - begin);
+        return true;
+    }
+
+    /// Records the lines that reading has completed
+    SortResult Scan() {
+        while (scanned_ < used_) {
+            const void* const newline{
+                std::memchr(text() + scanned_, '\n', used_ - scanned_)};
+            if (!newline) {
+                scanned_ = used_;
+                break;
+            }
+            const std::size_t end{static_cast<std::size_t>(
+                static_cast<const char*>(newline) - text())};
+            if (end - line_start_ > LineOrder::max_line) {
+                return std::unexpected{SortError{
+                    Stage::Reading,
+                    std::make_error_code(std::errc::value_too_large)}};
+            }
+            if (!Record(line_start_, end)) {
+                if (const SortResult made{MakeRoom()}; !made) {
+                    return made;
+                }
+                continue;
+            }
+            line_start_ = scanned_ = end + 1;
+        }
+        return {};
+    }
+
+    /// Frees up space for reading: by growing the block while it is under
+    /// -S, then by writing the batch out if it has any lines, and otherwise
+    /// (when one line is bigger than the whole block) by growing it past -S
+    SortResult MakeRoom() {
+        if (capacity_ < limit_) {
+            Grow(std::min(limit_, Capacity(capacity_ * 2)));
+            return {};
+        } else if (lines_ > 0) {
+            return Spill();
+        } else if (used_ > LineOrder::max_line) {
+            return std::unexpected{SortError{
+                Stage::Reading,
+                std::make_error_code(std::errc::value_too_large)}};
+        }
+        Grow(Capacity(capacity_ * 2));
+        return {};
+    }
+
+    /// Moves the batch into a new block of capacity bytes, with the text at
+    /// its front and the lines (pointed at the moved text) at its back
+    void Grow(std::size_t capacity) {
+        std::unique_ptr<std::byte[]> block{
+            std::make_unique_for_overwrite<std::byte[]>(capacity)};
+        char* const text_now{reinterpret_cast<char*>(block.get())};
+        std::memcpy(text_now, text(), used_);
+        SortLine* const lines_now{
+            reinterpret_cast<SortLine*>(block.get() + capacity) - lines_};
+        const std::span<const SortLine> recorded{lines()};
+        for (std::size_t i{0}; i < lines_; ++i) {
+            lines_now[i] = recorded[i];
+            lines_now[i].data = text_now + (recorded[i].data - text());
+        }
+        block_ = std::move(block);
+        capacity_ = capacity;
+    }
+
+    /// Sorts the batch in settings_->threads slices at once. Returns the
+    /// sorted slices, still to be merged.
+    std::vector<SliceSource> SortBatch() {
+        const std::span<SortLine> batch{lines()};
+        std::reverse(batch.begin(), batch.end());
+        const LineOrder& order{*order_};
+        coreutils::ParallelFor(batch.size(), settings_->threads, min_slice,
+                               [batch, &order](std::size_t i) {
+                                   batch[i] =
+                                       order.Make(batch[i].data, batch[i].size);
+                               });
+
+        const std::size_t slices{std::clamp<std::size_t>(
+            batch.size() / min_slice, 1, settings_->threads)};
+        const auto slice = [batch, slices](std::size_t i) {
+            return batch.subspan(i * batch.size() / slices,
+                                 (i + 1) * batch.size() / slices -
+                                     i * batch.size() / slices);
+        };
+        const bool unique{settings_->unique};
+        coreutils::ParallelFor(
+            slices, slices, 1, [&order, &slice, unique](std::size_t i) {
+                const std::span<SortLine> lines{slice(i)};
+                if (order.bytewise()) {
+                    coreutils::detail::MultikeyQuicksort(lines.data(),
+                                                         lines.size(), 0);
+                    // the sort leaves prefixes from whatever depth it
+                    // got to
+                    for (SortLine& line : lines) {
+                        line.prefix = coreutils::detail::LoadChunk(
+                            line.data, line.size, 0);
+                    }
+                    return;
+                }
+                const auto less = [&order](const SortLine& lhs,
+                                           const SortLine& rhs) {
+                    return order.Compare(lhs, rhs) < 0;
+                };
+                // lines that compare equal but differ only exist with
+                // unique, where which one comes first is which one is kept
+                if (unique) {
+                    std::stable_sort(lines.begin(), lines.end(), less);
+                } else {
+                    std::sort(lines.begin(), lines.end(), less);
+                }
+            });
+
+        std::vector<SliceSource> sources{};
+        sources.reserve(slices);
+        for (std::size_t i{0}; i < slices; ++i) {
+            sources.emplace_back(slice(i));
+        }
+        return sources;
+    }
+
+    /// Sorts the batch into a run of its own, and moves the line that was
+    /// being read (if any) to the front of the block
+    SortResult Spill() {
+        std::expected<TempFile, std::error_code> run{
+            TempFile::Create(settings_->temporary_directory)};
+        if (!run) {
+            return std::unexpected{
+                SortError{Stage::CreatingTemporary, run.error()}};
+        }
+        std::vector<SliceSource> sources{SortBatch()};
+        coreutils::Output out{run->fd(), read_size};
+        Merge(std::span{sources}, *order_, settings_->unique, out);
+        if (const std::error_code error{out.Flush()}; error) {
+            return std::unexpected{SortError{Stage::WritingTemporary, error}};
+        }
+        runs_.push_back(std::move(*run));
+
+        std::memmove(text(), text() + line_start_, used_ - line_start_);
+        used_ -= line_start_;
+        scanned_ -= line_start_;
+        line_start_ = 0;
+        lines_ = 0;
+        return {};
+    }
+
+    /// Read buffer for each run being merged, so that merging stays within
+    /// -S however many merges run at once
+    std::size_t ReaderBuffer() const {
+        return std::clamp(
+            settings_->memory / (fan_in * settings_->threads * 2),
+            std::size_t{64 * 1024}, read_size);
+    }
+
+    SortResult MergeInto(std::span<TempFile> runs, coreutils::Output& out) {
+        std::vector<RunReader> readers{};
+        readers.reserve(runs.size());
+        for (const TempFile& run : runs) {
+            if (const std::error_code error{run.Rewind()}; error) {
+                return std::unexpected{
+                    SortError{Stage::ReadingTemporary, error}};
+            }
+            readers.emplace_back(run.fd(), *order_, ReaderBuffer());
+        }
+        Merge(std::span{readers}, *order_, settings_->unique, out);
+        for (const RunReader& reader : readers) {
+            if (reader.error()) {
+                return std::unexpected{
+                    SortError{Stage::ReadingTemporary, reader.error()}};
+            }
+        }
+        return {};
+    }
+
+    /// Merges runs fan_in at a time until there are few enough left to
+    /// merge in one go. The groups of a pass are merged in parallel, and
+    /// each merged run takes the place of its group, so runs stay in the
+    /// order they were read.
+    SortResult MergeRuns() {
+        while (runs_.size() > fan_in) {
+            const std::size_t groups{(runs_.size() + fan_in - 1) / fan_in};
+            std::vector<std::optional<TempFile>> merged(groups);
+            std::vector<SortResult> results(groups);
+            coreutils::ParallelFor(
+                groups, settings_->threads, 1, [&](std::size_t group) {
+                    const std::span<TempFile> runs{std::span{runs_}.subspan(
+                        group * fan_in,
+                        std::min(fan_in, runs_.size() - group * fan_in))};
+                    std::expected<TempFile, std::error_code> run{
+                        TempFile::Create(settings_->temporary_directory)};
+                    if (!run) {
+                        results[group] = std::unexpected{
+                            SortError{Stage::CreatingTemporary, run.error()}};
+                        return;
+                    }
+                    coreutils::Output out{run->fd(), read_size};
+                    results[group] = MergeInto(runs, out);
+                    if (const std::error_code error{out.Flush()};
+                        results[group] && error) {
+                        results[group] = std::unexpected{
+                            SortError{Stage::WritingTemporary, error}};
+                    }
+                    merged[group] = std::move(*run);
+                });
+
+            for (const SortResult& result : results) {
+                if (!result) {
+                    return result;
+                }
+            }
+            runs_.clear();
+            for (std::optional<TempFile>& run : merged) {
+                runs_.push_back(std::move(*run));
+            }
+        }
+        return {};
+    }
+
+    const LineOrder* order_;
+    const Settings* settings_;
+    /// -S, as a block size
+    std::size_t limit_;
+    std::size_t capacity_;
+    std::unique_ptr<std::byte[]> block_;
+    /// Bytes of text in the block
+    std::size_t used_{0};
+    /// Lines recorded at the back of the block
+    std::size_t lines_{0};
+    /// Where the line being read starts
+    std::size_t line_start_{0};
+    /// How far the text has been searched for newlines
+    std::size_t scanned_{0};
+    std::vector<TempFile> runs_{};
+};
+
+enum class SizeError : std::uint8_t {
+    Invalid,
+    Suffix,
+};
+
+/// Bytes of physical memory, or 0 if that cannot be found out
+std::uint64_t PhysicalMemory() {
+#if defined(_SC_PHYS_PAGES) && defined(_SC_PAGESIZE)
+    const long pages{::sysconf(_SC_PHYS_PAGES)};
+    const long page_size{::sysconf(_SC_PAGESIZE)};
+    if (pages > 0 && page_size > 0) {
+        return static_cast<std::uint64_t>(pages) *
+               static_cast<std::uint64_t>(page_size);
+    }
+#endif
+    return 0;
+}
+
+/// The argument of -S: a number of KiB, or of the unit given by a suffix (b
+/// for bytes, K M G T P E for powers of 1024, % for a share of physical
+/// memory). Sizes too big to represent are taken as the biggest there is.
+std::expected<std::size_t, SizeError> ParseSize(std::string_view arg) {
+    std::uint64_t value{};
+    const std::from_chars_result result{
+        std::from_chars(arg.data(), arg.data() + arg.size(), value)};
+    if (result.ptr == arg.data()) {
+        return std::unexpected{SizeError::Invalid};
+    } else if (result.ec == std::errc::result_out_of_range) {
+        value = std::numeric_limits<std::uint64_t>::max();
+    }
+    const std::string_view suffix{
+        arg.substr(static_cast<std::size_t>(result.ptr - arg.data()))};
+    if (suffix.size() > 1) {
+        return std::unexpected{SizeError::Suffix};
+    }
+
+    if (suffix == "%") {
+        return static_cast<std::size_t>(
+            std::min<std::uint64_t>(value, 100) * (PhysicalMemory() / 100));
+    }
+    constexpr std::string_view units{"bkmgtpe"};
+    const std::size_t unit{
+        suffix.empty()
+            ? 1
+            : units.find(static_cast<char>(suffix.front() | 0x20))};
+    // only K has no upper case spelling in GNU's, and b no lower case one
+    if (unit == std::string_view::npos || suffix == "B") {
+        return std::unexpected{SizeError::Suffix};
+    }
+    const unsigned shift{static_cast<unsigned>(10 * unit)};
+    if (value > (std::numeric_limits<std::uint64_t>::max() >> shift)) {
+        value = std::numeric_limits<std::uint64_t>::max();
+    } else {
+        value <<= shift;
+    }
+    return static_cast<std::size_t>(std::min<std::uint64_t>(
+        value, std::numeric_limits<std::size_t>::max()));
+}
+
+/// A quarter of physical memory, which leaves room for everything else
+/// running alongside
+std::size_t DefaultMemory() {
+    constexpr std::size_t fallback{256 * 1024 * 1024};
+    const std::uint64_t physical{PhysicalMemory()};
+    return physical == 0 ? fallback
+                         : static_cast<std::size_t>(physical / 4);
+}
+
+std::optional<std::size_t> ParseThreads(std::string_view arg) {
+    std::size_t threads{};
+    const std::from_chars_result result{
+        std::from_chars(arg.data(), arg.data() + arg.size(), threads)};
+    if (result.ec != std::errc{} || result.ptr != arg.data() + arg.size()) {
+        return std::nullopt;
+    }
+    return threads;
+}
+
+bool Readable(const char* path) {
+#if defined(_WIN32)
+    return ::_access(path, 4) == 0;
+#else
+    return ::access(path, R_OK) == 0;
+#endif
+}
+
+}  // namespace
+
+COREUTILS_MAIN(sort) {
+    using Sort = coreutils::ProgramInfo<
+        "sort", "0.0.1", "Usage: sort [OPTION]... [FILE]...",
+        "Write sorted concatenation of all FILE(s) to standard output.\n\n"
+        "With no FILE, or when FILE is -, read standard input.\n\n"
+        "KEYDEF is F[.C][OPTS][,F[.C][OPTS]] for start and stop position, "
+        "where F is a\nfield number and C a character position in the "
+        "field; both are origin 1, and\nthe stop position defaults to the "
+        "line's end.  OPTS is one or more of b, n\nand r, which override "
+        "global ordering options for that key.\n\nSIZE may be followed by "
+        "one of %, b, K, M, G, T, P or E.  Lines are compared\nbyte by "
+        "byte, as in the C locale.">;
+    constexpr auto identity = [](std::string_view arg) { return arg; };
+    using PosArgs = coreutils::PositionalArguments<std::string_view, identity,
+                                                   coreutils::ArgvView>;
+    using IgnoreLeadingBlanks =
+        coreutils::BooleanArgument<"-b", "--ignore-leading-blanks">;
+    using NumericSort = coreutils::BooleanArgument<"-n", "--numeric-sort">;
+    using Reverse = coreutils::BooleanArgument<"-r", "--reverse">;
+    using Unique = coreutils::BooleanArgument<"-u", "--unique">;
+    using Key = coreutils::RepeatedValueArgument<std::string_view, identity,
+                                                 "-k", "--key">;
+    // optional, so that an empty -t '' can be told from no -t at all
+    constexpr auto given = [](std::string_view arg) {
+        return std::optional{arg};
+    };
+    using FieldSeparator =
+        coreutils::SingleValueArgument<std::optional<std::string_view>,
+                                       given, "-t", "--field-separator">;
+    using BufferSize =
+        coreutils::SingleValueArgument<std::string_view, identity, "-S",
+                                       "--buffer-size">;
+    using Parallel = coreutils::SingleValueArgument<std::string_view,
+                                                    identity, "--parallel">;
+    using OutputFile =
+        coreutils::SingleValueArgument<std::string_view, identity, "-o",
+                                       "--output">;
+    using TemporaryDirectory =
+        coreutils::SingleValueArgument<std::string_view, identity, "-T",
+                                       "--temporary-directory">;
+    coreutils::ArgumentParser<Sort, PosArgs, IgnoreLeadingBlanks, NumericSort,
+                              Reverse, Unique, Key, FieldSeparator,
+                              BufferSize, Parallel, OutputFile,
+                              TemporaryDirectory>
+        parser{argc, argv};
+    parser.ParseArgsOrExit();
+
+    const coreutils::SortFlags defaults{
+        .skip_blanks = parser.get<IgnoreLeadingBlanks>().value,
+        .numeric = parser.get<NumericSort>().value,
+        .reverse = parser.get<Reverse>().value,
+    };
+    std::vector<coreutils::SortKey> keys{};
+    for (const std::string_view spec : parser.get<Key>().value) {
+        const std::expected<coreutils::SortKey, coreutils::SortKeyError> key{
+            coreutils::ParseSortKey(spec, defaults)};
+        if (!key) {
+            std::println(std::cerr,
+                         "sort: {}: invalid field specification '{}'",
+                         coreutils::Describe(key.error()), spec);
+            return failure;
+        }
+        keys.push_back(*key);
+    }
+
+    const std::optional<std::string_view> separator{
+        parser.get<FieldSeparator>().value};
+    std::optional<char> tab{};
+    if (separator && separator->empty()) {
+        std::println(std::cerr, "sort: empty tab");
+        return failure;
+    } else if (separator == "\\0") {
+        tab = '\0';
+    } else if (separator && separator->size() == 1) {
+        tab = separator->front();
+    } else if (separator) {
+        std::println(std::cerr, "sort: multi-character tab '{}'", *separator);
+        return failure;
+    }
+
+    Settings settings{
+        .memory = DefaultMemory(),
+        .threads = std::min<std::size_t>(coreutils::DefaultConcurrency(), 8),
+        .unique = parser.get<Unique>().value,
+        .temporary_directory = "/tmp",
+    };
+    if (const std::string_view size{parser.get<BufferSize>().value};
+        !size.empty()) {
+        const std::expected<std::size_t, SizeError> parsed{ParseSize(size)};
+        if (!parsed) {
+            std::println(std::cerr, "sort: {} -S argument '{}'",
+                         parsed.error() == SizeError::Suffix
+                             ? "invalid suffix in"
+                             : "invalid",
+                         size);
+            return failure;
+        }
+        settings.memory = *parsed;
+    }
+    if (const std::string_view parallel{parser.get<Parallel>().value};
+        !parallel.empty()) {
+        const std::optional<std::size_t> threads{ParseThreads(parallel)};
+        if (!threads) {
+            std::println(std::cerr, "sort: invalid --parallel argument '{}'",
+                         parallel);
+            return failure;
+        } else if (*threads == 0) {
+            std::println(std::cerr, "sort: number in parallel must be nonzero");
+            return failure;
+        }
+        settings.threads = *threads;
+    }
+    if (const std::string_view directory{
+            parser.get<TemporaryDirectory>().value};
+        !directory.empty()) {
+        settings.temporary_directory = directory;
+    } else if (const char* const tmpdir{std::getenv("TMPDIR")};
+               tmpdir && *tmpdir != '\0') {
+        settings.temporary_directory = tmpdir;
+    }
+
+    const auto& names{parser.get<PosArgs>().value};
+    std::vector<std::string_view> targets(names.begin(), names.end());
+    if (targets.empty()) {
+        targets.emplace_back("-");
+    }
+    // like GNU sort, give up before doing anything if any input is missing
+    // (targets are views into argv, so they are null terminated)
+    for (const std::string_view target : targets) {
+        if (target != "-" && !Readable(target.data())) {
+            std::println(std::cerr, "sort: cannot read: {}: {}", target,
+                         std::error_code{errno, std::system_category()}
+                             .message());
+            return failure;
+        }
+    }
+
+    const LineOrder order{std::move(keys), defaults, tab, settings.unique};
+    Sorter sorter{order, settings};
+    const auto report = [&settings](const SortError& error,
+                                    std::string_view name) {
+        switch (error.stage) {
+            case Stage::Reading:
+                std::println(std::cerr, "sort: read failed: {}: {}", name,
+                             error.error.message());
+                break;
+            case Stage::CreatingTemporary:
+                std::println(std::cerr,
+                             "sort: cannot create temporary file in '{}': {}",
+                             settings.temporary_directory,
+                             error.error.message());
+                break;
+            case Stage::WritingTemporary:
+            case Stage::ReadingTemporary:
+                std::println(std::cerr,
+                             "sort: {} failed: temporary file in '{}': {}",
+                             error.stage == Stage::WritingTemporary
+                                 ? "write"
+                                 : "read",
+                             settings.temporary_directory,
+                             error.error.message());
+                break;
+            case Stage::Writing:
+                std::println(std::cerr, "sort: write failed: {}: {}", name,
+                             error.error.message());
+                break;
+        }
+        return failure;
+    };
+
+    for (const std::string_view target : targets) {
+        const std::expected<coreutils::InputFile, std::error_code> input{
+            coreutils::InputFile::Open(target.data())};
+        if (!input) {
+            std::println(std::cerr, "sort: open failed: {}: {}", target,
+                         input.error().message());
+            return failure;
+        }
+        if (const SortResult read{sorter.Read(input->fd())}; !read) {
+            return report(read.error(), target);
+        }
+    }
+
+    // only opened now that every input has been read, so that the output
+    // can be one of them (sort -o file file)
+    const std::string_view output_name{parser.get<OutputFile>().value};
+    int output{standard_output};
+    if (!output_name.empty()) {
+#if defined(_WIN32)
+        output = ::_open(output_name.data(),
+                         _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY,
+                         _S_IREAD | _S_IWRITE);
+#else
+        output = ::open(output_name.data(),
+                        O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+#endif
+        if (output < 0) {
+            std::println(std::cerr, "sort: open failed: {}: {}", output_name,
+                         std::error_code{errno, std::system_category()}
+                             .message());
+            return failure;
+        }
+    }
+    coreutils::Output out{output, 1024 * 1024};
+    if (const SortResult written{sorter.Write(out)}; !written) {
+        return report(written.error(), output_name.empty()
+                                           ? "'standard output'"
+                                           : output_name);
+    }
+    return 0;
+}
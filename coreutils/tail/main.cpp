@@ -0,0 +1,674 @@
+///
+///  @file main.cpp
+///  @brief Output the last part of files
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <format>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <print>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
+#include "lib/ArgumentParser.hpp"
+#include "lib/FileCopy.hpp"
+#include "lib/FileInput.hpp"
+#include "lib/LineSeek.hpp"
+#include "lib/Main.hpp"
+#include "lib/Output.hpp"
+#include "lib/TextCount.hpp"
+
+namespace {
+
+using coreutils::CopyError;
+using coreutils::CopyResult;
+using coreutils::ReadError;
+using coreutils::Seek;
+using coreutils::Seekable;
+
+constexpr int standard_output{1};
+
+/// How much of every file to print
+struct Amount final {
+    std::uint64_t count;
+    bool bytes;
+    /// +N, i.e. from the Nth line (or byte) on, rather than the last N
+    bool from_start;
+};
+
+std::optional<Amount> ParseAmount(std::string_view arg, bool bytes) {
+    Amount amount{.count = 0, .bytes = bytes, .from_start = false};
+    if (arg.starts_with('+')) {
+        amount.from_start = true;
+        arg.remove_prefix(1);
+    } else if (arg.starts_with('-')) {
+        arg.remove_prefix(1);
+    }
+    const std::optional<std::uint64_t> count{coreutils::ParseCount(arg)};
+    if (!count) {
+        return std::nullopt;
+    }
+    amount.count = *count;
+    return amount;
+}
+
+/// What is known of fd, if it is a regular file
+struct RegularFile final {
+    std::uint64_t device;
+    std::uint64_t inode;
+    std::uint64_t size;
+};
+
+std::optional<RegularFile> StatRegular(int fd) {
+#if defined(_WIN32)
+    struct _stat64 status {};
+    if (::_fstat64(fd, &status) != 0 || (status.st_mode & _S_IFREG) == 0) {
+        return std::nullopt;
+    }
+#else
+    struct stat status {};
+    if (::fstat(fd, &status) != 0 || !S_ISREG(status.st_mode)) {
+        return std::nullopt;
+    }
+#endif
+    return RegularFile{.device = static_cast<std::uint64_t>(status.st_dev),
+                       .inode = static_cast<std::uint64_t>(status.st_ino),
+                       .size = static_cast<std::uint64_t>(status.st_size)};
+}
+
+/// Copies the rest of fd to standard output, in the kernel where it can
+CopyResult CopyRest(int fd, coreutils::Output& out, std::span<char> buffer) {
+    if (const std::error_code error{out.Flush()}; error) {
+        return std::unexpected{CopyError{error, true}};
+    }
+    return coreutils::CopyAll(fd, standard_output, buffer);
+}
+
+/// The last amount of a stream that can only be read front to back. Only
+/// the chunks that the end could still be in are kept along the way.
+CopyResult PrintStreamEnd(int fd, const Amount& amount,
+                          coreutils::Output& out, std::span<char> buffer) {
+    const std::expected<coreutils::StreamEnd, std::error_code> end{
+        coreutils::ReadStreamEnd(fd, amount.count, amount.bytes, buffer,
+                                 [](std::string_view) {})};
+    if (!end) {
+        return ReadError(end.error());
+    }
+    out.Write(std::string_view{end->text}.substr(end->start));
+    return {};
+}
+
+/// Skips count - 1 lines (or bytes) of fd, and copies the rest
+CopyResult PrintFrom(int fd, const std::optional<Seekable>& seekable,
+                     const Amount& amount, coreutils::Output& out,
+                     std::span<char> buffer) {
+    std::uint64_t skip{amount.count > 0 ? amount.count - 1 : 0};
+    if (amount.bytes && seekable) {
+        Seek(fd, static_cast<std::int64_t>(
+                     std::min(seekable->size, seekable->offset + skip)),
+             SEEK_SET);
+        return CopyRest(fd, out, buffer);
+    }
+    while (skip > 0) {
+        const std::expected<std::size_t, std::error_code> got{
+            coreutils::ReadSome(fd, buffer)};
+        if (!got) {
+            return ReadError(got.error());
+        } else if (*got == 0) {
+            return {};
+        }
+        const std::span<const char> text{buffer.first(*got)};
+        std::size_t start{text.size()};
+        if (amount.bytes) {
+            start = static_cast<std::size_t>(
+                std::min<std::uint64_t>(skip, text.size()));
+            skip -= start;
+        } else {
+            const coreutils::NewlineSearch search{
+                coreutils::FindNewline(text, skip)};
+            skip -= search.found;
+            start = std::min(search.position + 1, text.size());
+        }
+        if (skip == 0) {
+            out.Write(std::string_view{text.data(), text.size()}.substr(start));
+        }
+    }
+    return CopyRest(fd, out, buffer);
+}
+
+CopyResult PrintEnd(int fd, const Amount& amount, coreutils::Output& out,
+                    std::span<char> buffer) {
+    const std::optional<Seekable> seekable{coreutils::InspectSeekable(fd)};
+    if (amount.from_start) {
+        return PrintFrom(fd, seekable, amount, out, buffer);
+    } else if (!seekable) {
+        return PrintStreamEnd(fd, amount, out, buffer);
+    }
+
+    std::uint64_t start{seekable->size -
+                        std::min(amount.count,
+                                 seekable->size - seekable->offset)};
+    if (!amount.bytes) {
+        const std::expected<std::uint64_t, std::error_code> found{
+            coreutils::FindLastLines(fd, seekable->offset, seekable->size,
+                                     amount.count, buffer)};
+        if (!found) {
+            return ReadError(found.error());
+        }
+        start = *found;
+    }
+    Seek(fd, static_cast<std::int64_t>(start), SEEK_SET);
+    return CopyRest(fd, out, buffer);
+}
+
+/// Prints "==> name <==" headers when output switches between files
+class Headers final {
+ public:
+    explicit Headers(bool enabled) : enabled_{enabled} {}
+
+    void Switch(coreutils::Output& out, std::size_t file,
+                std::string_view name) {
+        if (!enabled_ || current_ == file) {
+            return;
+        }
+        if (current_) {
+            out.Put('\n');
+        }
+        out.Write("==> ").Write(name == "-" ? "standard input" : name);
+        out.Write(" <==\n");
+        current_ = file;
+    }
+
+ private:
+    bool enabled_;
+    std::optional<std::size_t> current_{};
+};
+
+/// A file being followed once its end has been printed
+struct Followed final {
+    std::string_view name;
+    std::optional<coreutils::InputFile> input;
+    /// How far it has been printed
+    std::uint64_t position;
+    std::uint64_t device;
+    std::uint64_t inode;
+    int watch;
+    /// With -f --retry, not opened yet, and to be opened once it can be
+    bool awaited;
+};
+
+/// Follows files as they grow: with -f the files that were opened (and with
+/// --retry, the ones that could not be, once they turn up), with -F
+/// whatever has their names, reopening them when they are replaced (e.g.
+/// by log rotation) and waiting for them when they go missing. On Linux
+/// this sleeps in inotify until something changes, and files that cannot be
+/// watched (standard input, or once the kernel runs out of watches) are
+/// still looked at every interval. Everything that is appended is printed
+/// in as few writes as it was read in, so a busy log does not mean a write
+/// per line.
+class Follower final {
+ public:
+    Follower(std::vector<Followed> files, bool by_name, double interval,
+             Headers& headers, coreutils::Output& out)
+        : files_{std::move(files)},
+          by_name_{by_name},
+          interval_{interval},
+          headers_{&headers},
+          out_{&out} {}
+
+    /// Only returns on errors, or when there is nothing left to follow
+    int Run() {
+#if defined(__linux__)
+        notify_ = ::inotify_init1(IN_CLOEXEC);
+        if (notify_ >= 0) {
+            return RunNotified();
+        }
+#endif
+        return RunPolling();
+    }
+
+ private:
+    static constexpr std::size_t read_size{256 * 1024};
+
+    bool Remaining() const {
+        return by_name_ || std::ranges::any_of(files_, [](const Followed& f) {
+                   return f.input.has_value() || f.awaited;
+               });
+    }
+
+    void Report(std::string_view message) {
+        out_->Flush();
+        std::println(std::cerr, "tail: {}", message);
+    }
+
+    /// Standard output is gone, so there is no point following anything
+    int WriteError() const {
+        std::println(std::cerr, "tail: error writing 'standard output': {}",
+                     out_->error().message());
+        return 1;
+    }
+
+    /// Prints whatever was appended to file since it was last looked at.
+    /// Returns false once standard output cannot be written to.
+    bool Drain(std::size_t index) {
+        Followed& file{files_[index]};
+        if (!file.input) {
+            return true;
+        }
+        const int fd{file.input->fd()};
+        if (const std::optional<RegularFile> status{StatRegular(fd)};
+            status && status->size < file.position) {
+            Report(std::format("{}: file truncated", file.name));
+            Seek(fd, 0, SEEK_SET);
+            file.position = 0;
+        }
+        while (true) {
+            const std::expected<std::size_t, std::error_code> got{
+                coreutils::ReadSome(fd, buffer_.span().first(read_size))};
+            if (!got) {
+                Report(std::format("error reading '{}': {}", file.name,
+                                   got.error().message()));
+                return true;
+            } else if (*got == 0) {
+                break;
+            }
+            headers_->Switch(*out_, index, file.name);
+            out_->Write({buffer_.span().data(), *got});
+            file.position += *got;
+        }
+        return !out_->Flush();
+    }
+
+    /// With -F, looks at what has the name of file now. With -f --retry,
+    /// only does that until it first turns up.
+    void Recheck(std::size_t index) {
+        Followed& file{files_[index]};
+        if (by_name_) {
+            Reopen(index);
+        } else if (file.awaited) {
+            Reopen(index);
+            file.awaited = !file.input;
+        }
+    }
+
+    /// Looks at what has the name of file now, and switches to it if that
+    /// is a different file from the one being followed
+    void Reopen(std::size_t index) {
+        Followed& file{files_[index]};
+        // names are views into argv, so they are null terminated
+        std::expected<coreutils::InputFile, std::error_code> opened{
+            coreutils::InputFile::Open(file.name.data())};
+        if (!opened) {
+            if (file.input) {
+                Drain(index);
+                file.input.reset();
+                Unwatch(index);
+                Report(std::format("'{}' has become inaccessible: {}",
+                                   file.name, opened.error().message()));
+            }
+            return;
+        }
+        const std::optional<RegularFile> identity{StatRegular(opened->fd())};
+        if (!identity || (file.input && identity->device == file.device &&
+                          identity->inode == file.inode)) {
+            return;
+        }
+        if (file.input) {
+            // whatever was written to the old file before it was replaced
+            Drain(index);
+        }
+        Report(std::format("'{}' has {};  following new file", file.name,
+                           file.input ? "been replaced" : "appeared"));
+        Unwatch(index);
+        file.input.emplace(std::move(*opened));
+        file.position = 0;
+        file.device = identity->device;
+        file.inode = identity->inode;
+        Watch(index);
+    }
+
+    void Watch(std::size_t index) {
+#if defined(__linux__)
+        Followed& file{files_[index]};
+        // standard input has no name to watch it by, and a missing file
+        // is watched for through its directory (or every interval)
+        if (notify_ < 0 || file.name == "-" || !file.input) {
+            return;
+        }
+        file.watch = ::inotify_add_watch(
+            notify_, file.name.data(),
+            IN_MODIFY | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF);
+        if (file.watch < 0 && (errno == ENOSPC || errno == ENOMEM)) {
+            Report("inotify resources exhausted");
+        } else if (file.watch < 0) {
+            Report(std::format(
+                "cannot watch '{}': {}", file.name,
+                std::error_code{errno, std::system_category()}.message()));
+        }
+#else
+        (void)index;
+#endif
+    }
+
+    /// Stops watching the file that file used to be
+    void Unwatch(std::size_t index) {
+#if defined(__linux__)
+        Followed& file{files_[index]};
+        if (notify_ >= 0 && file.watch >= 0) {
+            ::inotify_rm_watch(notify_, file.watch);
+        }
+        file.watch = -1;
+#else
+        (void)index;
+#endif
+    }
+
+    int RunPolling() {
+        while (Remaining()) {
+            for (std::size_t i{0}; i < files_.size(); ++i) {
+                Recheck(i);
+                if (!Drain(i)) {
+                    return WriteError();
+                }
+            }
+            std::this_thread::sleep_for(
+                std::chrono::duration<double>{interval_});
+        }
+        Report("no files remaining");
+        return 1;
+    }
+
+#if defined(__linux__)
+    int RunNotified() {
+        // with -F, the directories are watched too, for files that are
+        // created (or moved into place) under a followed name
+        std::vector<int> directories(files_.size(), -1);
+        for (std::size_t i{0}; i < files_.size(); ++i) {
+            Watch(i);
+            if (by_name_) {
+                const std::size_t slash{files_[i].name.rfind('/')};
+                const std::string directory{
+                    slash == std::string_view::npos
+                        ? std::string{"."}
+                        : std::string{files_[i].name.substr(
+                              0, std::max<std::size_t>(slash, 1))}};
+                directories[i] = ::inotify_add_watch(
+                    notify_, directory.c_str(),
+                    IN_CREATE | IN_MOVED_TO | IN_ATTRIB);
+            }
+        }
+
+        // files nothing would say had changed are looked at every interval,
+        // as they would be without inotify
+        const auto unwatched{[this, &directories](std::size_t i) {
+            return files_[i].watch < 0 &&
+                   (files_[i].input || files_[i].awaited ||
+                    (by_name_ && directories[i] < 0));
+        }};
+        const int timeout{static_cast<int>(std::min(
+            interval_ * 1000, double{std::numeric_limits<int>::max()}))};
+
+        alignas(inotify_event) std::array<char, 64 * 1024> events{};
+        while (Remaining()) {
+            bool polling{false};
+            for (std::size_t i{0}; i < files_.size(); ++i) {
+                polling = polling || unwatched(i);
+            }
+            pollfd ready{.fd = notify_, .events = POLLIN, .revents = 0};
+            const int waited{::poll(&ready, 1, polling ? timeout : -1)};
+            if (waited < 0 && errno == EINTR) {
+                continue;
+            }
+
+            // a burst of events is handled once per file it touched
+            std::vector<bool> touched(files_.size(), false);
+            for (std::size_t i{0}; i < files_.size(); ++i) {
+                touched[i] = unwatched(i);
+            }
+            const ssize_t got{
+                waited > 0 ? ::read(notify_, events.data(), events.size())
+                           : 0};
+            if ((waited < 0 || got < 0) && errno != EINTR) {
+                Report(std::format(
+                    "error reading inotify event: {}",
+                    std::error_code{errno, std::system_category()}.message()));
+                return 1;
+            }
+            const std::size_t length{got > 0 ? static_cast<std::size_t>(got)
+                                             : 0};
+            for (std::size_t offset{0}; offset < length;) {
+                const auto* event{reinterpret_cast<const inotify_event*>(
+                    events.data() + offset)};
+                offset += sizeof(inotify_event) + event->len;
+                for (std::size_t i{0}; i < files_.size(); ++i) {
+                    if (event->wd == files_[i].watch ||
+                        event->wd == directories[i]) {
+                        touched[i] = true;
+                    }
+                    if (!by_name_ && event->wd == files_[i].watch &&
+                        (event->mask & (IN_DELETE_SELF | IN_IGNORED))) {
+                        // with -f, a file that is gone for good is done
+                        Drain(i);
+                        files_[i].input.reset();
+                        files_[i].watch = -1;
+                    }
+                }
+            }
+            for (std::size_t i{0}; i < files_.size(); ++i) {
+                if (!touched[i]) {
+                    continue;
+                }
+                Recheck(i);
+                if (!Drain(i)) {
+                    return WriteError();
+                }
+            }
+        }
+        Report("no files remaining");
+        return 1;
+    }
+
+    int notify_{-1};
+#endif
+
+    std::vector<Followed> files_;
+    bool by_name_;
+    double interval_;
+    Headers* headers_;
+    coreutils::Output* out_;
+    coreutils::CopyBuffer buffer_{read_size};
+};
+
+}  // namespace
+
+COREUTILS_MAIN(tail) {
+    using Tail = coreutils::ProgramInfo<
+        "tail", "0.0.1", "Usage: tail [OPTION]... [FILE]...",
+        "Print the last 10 lines of each FILE to standard output.\nWith more "
+        "than one FILE, precede each with a header giving the file "
+        "name.\n\nWith no FILE, or when FILE is -, read standard input.">;
+    constexpr auto view = [](std::string_view arg) { return arg; };
+    using PosArgs = coreutils::PositionalArguments<std::string_view, view,
+                                                   coreutils::ArgvView>;
+    using Bytes = coreutils::SingleValueArgument<std::string_view, view,
+                                                 "-c", "--bytes">;
+    using Lines = coreutils::SingleValueArgument<std::string_view, view,
+                                                 "-n", "--lines">;
+    using Follow = coreutils::BooleanArgument<"-f", "--follow">;
+    using FollowName = coreutils::BooleanArgument<"-F">;
+    using Retry = coreutils::BooleanArgument<"--retry">;
+    using Quiet = coreutils::BooleanArgument<"-q", "--quiet", "--silent">;
+    using Verbose = coreutils::BooleanArgument<"-v", "--verbose">;
+    using SleepInterval =
+        coreutils::SingleValueArgument<std::string_view, view, "-s",
+                                       "--sleep-interval">;
+
+    std::string obsolete_count{};
+    std::vector<const char*> args{
+        coreutils::RewriteObsolete(argc, argv, obsolete_count)};
+    coreutils::ArgumentParser<Tail, PosArgs, Bytes, Lines, Follow, FollowName,
+                              Retry, Quiet, Verbose, SleepInterval>
+        parser{static_cast<int>(args.size()), args.data()};
+    parser.ParseArgsOrExit();
+
+    Amount amount{.count = 10, .bytes = false, .from_start = false};
+    for (const auto& [arg, bytes] :
+         {std::pair{parser.get<Lines>().value, false},
+          std::pair{parser.get<Bytes>().value, true}}) {
+        if (arg.empty()) {
+            continue;
+        }
+        const std::optional<Amount> parsed{ParseAmount(arg, bytes)};
+        if (!parsed) {
+            std::println(std::cerr, "tail: invalid number of {}: '{}'",
+                         bytes ? "bytes" : "lines", arg);
+            return 1;
+        }
+        amount = *parsed;
+    }
+
+    double interval{1.0};
+    if (const std::string_view arg{parser.get<SleepInterval>().value};
+        !arg.empty()) {
+        const std::from_chars_result result{
+            std::from_chars(arg.data(), arg.data() + arg.size(), interval)};
+        if (result.ec != std::errc{} || result.ptr != arg.data() + arg.size() ||
+            interval < 0) {
+            std::println(std::cerr, "tail: invalid number of seconds: '{}'",
+                         arg);
+            return 1;
+        }
+    }
+    const bool by_name{parser.get<FollowName>().value};
+    const bool follow{by_name || parser.get<Follow>().value};
+    const bool retry{by_name || parser.get<Retry>().value};
+    if (parser.get<Retry>().value && !follow) {
+        std::println(std::cerr, "tail: warning: --retry ignored; --retry is "
+                                "useful only when following");
+    } else if (parser.get<Retry>().value && !by_name) {
+        std::println(std::cerr, "tail: warning: --retry only effective for "
+                                "the initial open");
+    }
+
+    const auto& names{parser.get<PosArgs>().value};
+    std::vector<std::string_view> targets(names.begin(), names.end());
+    if (targets.empty()) {
+        targets.emplace_back("-");
+    }
+
+    coreutils::CopyBuffer buffer{};
+    coreutils::Output out{};
+    Headers headers{parser.get<Verbose>().value ||
+                    (targets.size() > 1 && !parser.get<Quiet>().value)};
+    std::vector<Followed> followed{};
+    int status{0};
+    for (std::size_t i{0}; i < targets.size(); ++i) {
+        const std::string_view target{targets[i]};
+        // targets are views into argv, so they are null terminated
+        std::expected<coreutils::InputFile, std::error_code> input{
+            coreutils::InputFile::Open(target.data())};
+        if (!input) {
+            out.Flush();
+            std::println(std::cerr, "tail: cannot open '{}' for reading: {}",
+                         target, input.error().message());
+            status = 1;
+            if (follow && retry && target != "-") {
+                followed.push_back({.name = target, .input = std::nullopt,
+                                    .position = 0, .device = 0, .inode = 0,
+                                    .watch = -1, .awaited = !by_name});
+            }
+            continue;
+        }
+
+        headers.Switch(out, i, target);
+        const CopyResult printed{
+            PrintEnd(input->fd(), amount, out, buffer.span())};
+        if (!printed && printed.error().writing) {
+            out.Flush();
+            std::println(std::cerr, "tail: error writing 'standard output': "
+                                    "{}",
+                         printed.error().error.message());
+            return 1;
+        } else if (!printed) {
+            out.Flush();
+            std::println(std::cerr, "tail: error reading '{}': {}", target,
+                         printed.error().error.message());
+            status = 1;
+        }
+
+        // following a pipe (or a terminal) ends where reading it did
+        if (const std::optional<RegularFile> identity{
+                StatRegular(input->fd())};
+            follow && identity) {
+            const std::int64_t position{Seek(input->fd(), 0, SEEK_CUR)};
+            followed.push_back({
+                .name = target,
+                .input = std::move(*input),
+                .position = static_cast<std::uint64_t>(
+                    std::max<std::int64_t>(position, 0)),
+                .device = identity->device,
+                .inode = identity->inode,
+                .watch = -1,
+                .awaited = false,
+            });
+        }
+    }
+    if (const std::error_code error{out.Flush()}; error) {
+        std::println(std::cerr, "tail: error writing 'standard output': {}",
+                     error.message());
+        return 1;
+    }
+
+    if (follow && !followed.empty()) {
+        Follower follower{std::move(followed), by_name, interval, headers,
+                          out};
+        return follower.Run();
+    } else if (follow && status != 0) {
+        std::println(std::cerr, "tail: no files remaining");
+    }
+    return status;
+}
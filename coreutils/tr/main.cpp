@@ -0,0 +1,449 @@
+///
+///  @file main.cpp
+///  @brief Translate, squeeze, and/or delete characters
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <format>
+#include <iostream>
+#include <optional>
+#include <print>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "lib/ArgumentParser.hpp"
+#include "lib/FileCopy.hpp"
+#include "lib/Main.hpp"
+#include "lib/Output.hpp"
+#include "lib/Translate.hpp"
+
+namespace {
+
+constexpr int standard_input{0};
+
+/// A SET operand, spelled out
+struct Set final {
+    std::string bytes;
+    /// Where each [:upper:] ([:lower:] when false) starts in bytes, which is
+    /// what case conversion lines up
+    std::vector<std::pair<std::size_t, bool>> cases;
+    /// Any other class, or an [=c=]
+    bool other_classes;
+    bool equivalences;
+    bool ends_in_class;
+    /// Where a [c*] goes, to be filled out to the length of SET1
+    std::optional<std::size_t> fill_at;
+    unsigned char fill_byte;
+    bool repeats;
+};
+
+using ParseResult = std::expected<Set, std::string>;
+
+constexpr std::array<std::pair<std::string_view, int (*)(int)>, 12> classes{{
+    {"alnum", [](int c) { return std::isalnum(c); }},
+    {"alpha", [](int c) { return std::isalpha(c); }},
+    {"blank", [](int c) { return std::isblank(c); }},
+    {"cntrl", [](int c) { return std::iscntrl(c); }},
+    {"digit", [](int c) { return std::isdigit(c); }},
+    {"graph", [](int c) { return std::isgraph(c); }},
+    {"lower", [](int c) { return std::islower(c); }},
+    {"print", [](int c) { return std::isprint(c); }},
+    {"punct", [](int c) { return std::ispunct(c); }},
+    {"space", [](int c) { return std::isspace(c); }},
+    {"upper", [](int c) { return std::isupper(c); }},
+    {"xdigit", [](int c) { return std::isxdigit(c); }},
+}};
+
+/// Reads one character of a SET at position, backslash escapes included,
+/// and moves position past it
+unsigned char ReadCharacter(std::string_view text, std::size_t& position) {
+    const char c{text[position++]};
+    if (c != '\\') {
+        return static_cast<unsigned char>(c);
+    } else if (position == text.size()) {
+        std::println(std::cerr, "tr: warning: an unescaped backslash at end "
+                                "of string is not portable");
+        return '\\';
+    }
+
+    const char escaped{text[position++]};
+    if (escaped >= '0' && escaped <= '7') {
+        const std::size_t start{position - 1};
+        unsigned value{static_cast<unsigned>(escaped - '0')};
+        for (std::size_t digits{1}; digits < 3 && position < text.size() &&
+                                    text[position] >= '0' &&
+                                    text[position] <= '7';
+             ++digits) {
+            const unsigned next{value * 8 +
+                                static_cast<unsigned>(text[position] - '0')};
+            if (next > 0xff) {
+                std::println(std::cerr,
+                             "tr: warning: the ambiguous octal escape \\{} "
+                             "is being\n\tinterpreted as the 2-byte "
+                             "sequence \\0{}, {}",
+                             text.substr(start, 3), text.substr(start, 2),
+                             text[position]);
+                break;
+            }
+            value = next;
+            ++position;
+        }
+        return static_cast<unsigned char>(value);
+    }
+    constexpr std::string_view letters{"abfnrtv"};
+    constexpr std::string_view controls{"\a\b\f\n\r\t\v"};
+    const std::size_t letter{letters.find(escaped)};
+    return static_cast<unsigned char>(
+        letter == std::string_view::npos ? escaped : controls[letter]);
+}
+
+/// The constructs that start with [: [:class:], [=c=] and [c*n]. Returns
+/// false, leaving set alone, when what starts at position is none of them,
+/// in which case the [ is just a [.
+std::expected<bool, std::string> ReadBracket(std::string_view text,
+                                             std::size_t& position,
+                                             Set& set) {
+    const std::string_view rest{text.substr(position)};
+    if (rest.starts_with("[:")) {
+        const std::size_t end{rest.find(":]", 2)};
+        if (end == std::string_view::npos || end == 2) {
+            return false;
+        }
+        const std::string_view name{rest.substr(2, end - 2)};
+        const auto* const found{std::ranges::find(
+            classes, name, &std::pair<std::string_view, int (*)(int)>::first)};
+        if (found == classes.end()) {
+            return std::unexpected{
+                std::format("invalid character class '{}'", name)};
+        }
+        if (name == "upper" || name == "lower") {
+            set.cases.emplace_back(set.bytes.size(), name == "upper");
+        } else {
+            set.other_classes = true;
+        }
+        for (int c{0}; c < 256; ++c) {
+            if (found->second(c)) {
+                set.bytes.push_back(static_cast<char>(c));
+            }
+        }
+        position += end + 2;
+        return true;
+    }
+
+    std::size_t after{position + 1};
+    if (rest.starts_with("[=") && rest.size() > 2) {
+        ++after;
+        const unsigned char c{ReadCharacter(text, after)};
+        if (!text.substr(after).starts_with("=]")) {
+            return false;
+        }
+        set.bytes.push_back(static_cast<char>(c));
+        set.equivalences = true;
+        position = after + 2;
+        return true;
+    }
+
+    if (rest.size() < 3) {
+        return false;
+    }
+    const unsigned char c{ReadCharacter(text, after)};
+    if (after >= text.size() || text[after] != '*') {
+        return false;
+    }
+    const std::size_t close{text.find(']', after)};
+    if (close == std::string_view::npos) {
+        return false;
+    }
+    const std::string_view digits{text.substr(after + 1, close - after - 1)};
+    // a leading zero means octal, as in C
+    const int base{digits.starts_with('0') ? 8 : 10};
+    std::uint64_t count{0};
+    for (const char digit : digits) {
+        if (digit < '0' || digit >= '0' + base) {
+            return std::unexpected{std::format(
+                "invalid repeat count '{}' in [c*n] construct", digits)};
+        }
+        count = count * static_cast<std::uint64_t>(base) +
+                static_cast<std::uint64_t>(digit - '0');
+    }
+    set.repeats = true;
+    if (count == 0) {
+        if (set.fill_at) {
+            return std::unexpected{std::string{
+                "only one [c*] repeat construct may appear in string2"}};
+        }
+        set.fill_at = set.bytes.size();
+        set.fill_byte = c;
+    } else {
+        set.bytes.append(count, static_cast<char>(c));
+    }
+    position = close + 1;
+    return true;
+}
+
+/// Spells out a SET operand: characters, escapes, ranges (a-z), classes
+/// ([:alpha:]), equivalence classes ([=c=], which in the C locale are just
+/// c) and repeats ([c*n])
+ParseResult ParseSet(std::string_view text) {
+    Set set{};
+    for (std::size_t position{0}; position < text.size();) {
+        set.ends_in_class = false;
+        if (text[position] == '[') {
+            const std::size_t classes_before{set.cases.size()};
+            const bool other_before{set.other_classes};
+            const std::expected<bool, std::string> bracket{
+                ReadBracket(text, position, set)};
+            if (!bracket) {
+                return std::unexpected{bracket.error()};
+            } else if (*bracket) {
+                set.ends_in_class = set.cases.size() != classes_before ||
+                                    set.other_classes != other_before;
+                continue;
+            }
+        }
+
+        const std::size_t start{position};
+        const unsigned char first{ReadCharacter(text, position)};
+        if (position + 1 < text.size() && text[position] == '-') {
+            ++position;
+            const unsigned char last{ReadCharacter(text, position)};
+            if (last < first) {
+                return std::unexpected{std::format(
+                    "range-endpoints of '{}' are in reverse collating "
+                    "sequence order",
+                    text.substr(start, position - start))};
+            }
+            for (unsigned c{first}; c <= last; ++c) {
+                set.bytes.push_back(static_cast<char>(c));
+            }
+        } else {
+            set.bytes.push_back(static_cast<char>(first));
+        }
+    }
+    return set;
+}
+
+/// Every byte not in bytes, in order
+std::string ComplementOf(std::string_view bytes) {
+    std::array<bool, 256> present{};
+    for (const char c : bytes) {
+        present[static_cast<unsigned char>(c)] = true;
+    }
+    std::string complement{};
+    for (std::size_t c{0}; c < present.size(); ++c) {
+        if (!present[c]) {
+            complement.push_back(static_cast<char>(c));
+        }
+    }
+    return complement;
+}
+
+coreutils::ByteSet ToByteSet(std::string_view bytes) {
+    coreutils::ByteSet set{};
+    for (const char c : bytes) {
+        set.Add(static_cast<unsigned char>(c));
+    }
+    return set;
+}
+
+/// Lines SET2 up with SET1 (already complemented, if it is going to be),
+/// as GNU does: a [c*] takes up the slack, a short SET2 is padded with its
+/// last byte (or SET1 is cut short, with -t), and [:upper:] and [:lower:]
+/// may only be translated into each other
+std::expected<coreutils::ByteMap, std::string> BuildMap(
+    std::string from, const Set& set1, Set to, bool complement,
+    bool truncate) {
+    if (to.other_classes) {
+        return std::unexpected{std::string{
+            "when translating, the only character classes that may appear "
+            "in\nstring2 are 'upper' and 'lower'"}};
+    } else if (to.equivalences) {
+        return std::unexpected{std::string{
+            "[=c=] expressions may not appear in string2 when translating"}};
+    }
+    if (to.fill_at && to.bytes.size() < from.size()) {
+        to.bytes.insert(*to.fill_at, from.size() - to.bytes.size(),
+                        static_cast<char>(to.fill_byte));
+    }
+    if (to.bytes.size() < from.size()) {
+        if (truncate) {
+            from.resize(to.bytes.size());
+        } else if (to.bytes.empty()) {
+            return std::unexpected{std::string{
+                "when not truncating set1, string2 must be non-empty"}};
+        } else if (to.ends_in_class) {
+            return std::unexpected{std::string{
+                "when translating with string1 longer than string2,\nthe "
+                "latter string must not end with a character class"}};
+        } else {
+            to.bytes.resize(from.size(), to.bytes.back());
+        }
+    }
+
+    for (const auto& [position, _] : to.cases) {
+        if (complement ||
+            std::ranges::find(set1.cases, position,
+                              &std::pair<std::size_t, bool>::first) ==
+                set1.cases.end()) {
+            return std::unexpected{std::string{
+                "misaligned [:upper:] and/or [:lower:] construct"}};
+        }
+    }
+
+    coreutils::ByteMap map{};
+    for (std::size_t i{0}; i < from.size(); ++i) {
+        map.Set(static_cast<unsigned char>(from[i]),
+                static_cast<unsigned char>(to.bytes[i]));
+    }
+    return map;
+}
+
+int UsageError(std::string_view message) {
+    std::println(std::cerr,
+                 "tr: {}\nTry 'tr --help' for more information.", message);
+    return 1;
+}
+
+}  // namespace
+
+COREUTILS_MAIN(tr) {
+    using Tr = coreutils::ProgramInfo<
+        "tr", "0.0.1", "Usage: tr [OPTION]... STRING1 [STRING2]",
+        "Translate, squeeze, and/or delete characters from standard input, "
+        "writing to standard output. STRING1 and STRING2 specify arrays of "
+        "characters ARRAY1 and ARRAY2 that control the action.">;
+    using PosArgs = coreutils::PositionalArguments<
+        std::string_view, [](std::string_view arg) { return arg; },
+        coreutils::ArgvView>;
+    using Complement =
+        coreutils::BooleanArgument<"-c", "-C", "--complement">;
+    using Delete = coreutils::BooleanArgument<"-d", "--delete">;
+    using Squeeze = coreutils::BooleanArgument<"-s", "--squeeze-repeats">;
+    using Truncate = coreutils::BooleanArgument<"-t", "--truncate-set1">;
+
+    coreutils::ArgumentParser<Tr, PosArgs, Complement, Delete, Squeeze,
+                              Truncate>
+        parser{argc, argv};
+    parser.ParseArgsOrExit();
+
+    const bool complement{parser.get<Complement>().value};
+    const bool deleting{parser.get<Delete>().value};
+    const bool squeezing{parser.get<Squeeze>().value};
+    const auto& names{parser.get<PosArgs>().value};
+    const std::vector<std::string_view> operands(names.begin(), names.end());
+
+    const std::size_t needed{deleting == squeezing ? 2u : 1u};
+    const std::size_t allowed{deleting && !squeezing ? 1u : 2u};
+    if (operands.empty()) {
+        return UsageError("missing operand");
+    } else if (operands.size() < needed) {
+        return UsageError(std::format(
+            "missing operand after '{}'\nTwo strings must be given when {}.",
+            operands.back(),
+            deleting ? "both deleting and squeezing repeats" : "translating"));
+    } else if (operands.size() > allowed) {
+        return UsageError(std::format(
+            "extra operand '{}'{}", operands[allowed],
+            deleting && !squeezing
+                ? "\nOnly one string may be given when deleting without "
+                  "squeezing repeats."
+                : ""));
+    }
+
+    std::vector<Set> sets{};
+    for (const std::string_view operand : operands) {
+        ParseResult set{ParseSet(operand)};
+        if (!set) {
+            std::println(std::cerr, "tr: {}", set.error());
+            return 1;
+        }
+        sets.push_back(std::move(*set));
+    }
+    if (sets.front().repeats) {
+        std::println(std::cerr,
+                     "tr: the [c*] repeat construct may not appear in "
+                     "string1");
+        return 1;
+    }
+    const std::string set1{complement ? ComplementOf(sets.front().bytes)
+                                      : sets.front().bytes};
+
+    // deleting happens first, then translating, then squeezing
+    std::optional<coreutils::ByteSet> deletions{};
+    std::optional<coreutils::ByteMap> map{};
+    std::optional<coreutils::ByteSet> squeezes{};
+    if (deleting) {
+        deletions = ToByteSet(set1);
+    } else if (sets.size() == 2) {
+        std::expected<coreutils::ByteMap, std::string> built{
+            BuildMap(set1, sets.front(), sets.back(), complement,
+                     parser.get<Truncate>().value)};
+        if (!built) {
+            std::println(std::cerr, "tr: {}", built.error());
+            return 1;
+        }
+        map = *built;
+    }
+    if (squeezing) {
+        squeezes = ToByteSet(sets.size() == 2 ? sets.back().bytes : set1);
+    }
+
+    coreutils::CopyBuffer buffer{};
+    coreutils::Output out{};
+    int last{-1};
+    while (true) {
+        const std::expected<std::size_t, std::error_code> got{
+            coreutils::ReadSome(standard_input, buffer.span())};
+        if (!got) {
+            out.Flush();
+            std::println(std::cerr, "tr: read error: {}",
+                         got.error().message());
+            return 1;
+        } else if (*got == 0) {
+            break;
+        }
+
+        std::span<char> data{buffer.span().first(*got)};
+        if (deletions) {
+            data = data.first(deletions->Delete(data));
+        }
+        if (map) {
+            map->Apply(data);
+        }
+        if (squeezes) {
+            data = data.first(squeezes->Squeeze(data, last));
+        }
+        out.Write({data.data(), data.size()});
+        if (out.error()) {
+            break;
+        }
+    }
+    if (const std::error_code error{out.Flush()}; error) {
+        std::println(std::cerr, "tr: write error: {}", error.message());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,404 @@
+///
+///  @file main.cpp
+///  @brief print newline, word, and byte counts for each file
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#include <algorithm>
+#include <array>
+#include <clocale>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cwchar>
+#include <expected>
+#include <iostream>
+#include <optional>
+#include <print>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "lib/ArgumentParser.hpp"
+#include "lib/FileCopy.hpp"
+#include "lib/FileInput.hpp"
+#include "lib/Main.hpp"
+#include "lib/Output.hpp"
+#include "lib/Parallel.hpp"
+#include "lib/TextCount.hpp"
+
+namespace {
+
+/// Which counts were asked for, in the order they are printed
+struct Selection final {
+    bool lines;
+    bool words;
+    bool characters;
+    bool bytes;
+    bool max_line_length;
+
+    std::size_t size() const {
+        return std::size_t{lines} + words + characters + bytes +
+               max_line_length;
+    }
+};
+
+struct Counts final {
+    coreutils::TextCounts text;
+    std::uint64_t max_line_length;
+};
+
+/// Like GNU: wide enough for the total size of the regular files given, and
+/// at least 7 when any input is something else (whose size is not known up
+/// front). Inputs that cannot be looked at are left out.
+int NumberWidth(std::span<const std::string_view> targets) {
+    std::uint64_t total{0};
+    int minimum{1};
+    for (const std::string_view target : targets) {
+        // targets are views into argv, so they are null terminated
+        const std::expected<coreutils::InputShape, std::error_code> shape{
+            target == "-"
+                ? coreutils::InspectInput(coreutils::InputFile::standard_input)
+                : coreutils::InspectInput(target.data())};
+        if (!shape) {
+            continue;
+        } else if (shape->regular) {
+            total += shape->remaining;
+        } else {
+            minimum = 7;
+        }
+    }
+    int width{1};
+    for (; total >= 10; total /= 10) {
+        ++width;
+    }
+    return std::max(width, minimum);
+}
+
+/// Display width of each line, where tabs go to the next multiple of eight
+/// and characters that cannot be printed take no room. In multibyte locales
+/// characters are as wide as wcwidth says.
+class LineWidth final {
+ public:
+    explicit LineWidth(bool multibyte) {
+        for (std::size_t byte{0}; byte < kinds_.size(); ++byte) {
+            if (byte == '\t') {
+                kinds_[byte] = Kind::Tab;
+            } else if (byte == '\n' || byte == '\r' || byte == '\f') {
+                kinds_[byte] = Kind::Break;
+            } else if (byte >= ' ' && byte < 0x7f) {
+                kinds_[byte] = Kind::Narrow;
+            } else if (multibyte && byte >= 0x80) {
+                kinds_[byte] = Kind::Multibyte;
+            }
+        }
+    }
+
+    void Feed(std::span<const char> text) {
+        for (std::size_t i{0}; i < text.size();) {
+            switch (kinds_[static_cast<unsigned char>(text[i])]) {
+                case Kind::None:
+                    break;
+                case Kind::Narrow:
+                    ++position_;
+                    break;
+                case Kind::Tab:
+                    position_ += 8 - position_ % 8;
+                    break;
+                case Kind::Break:
+                    longest_ = std::max(longest_, position_);
+                    position_ = 0;
+                    break;
+                case Kind::Multibyte:
+                    i += Decode(text.subspan(i));
+                    continue;
+            }
+            ++i;
+        }
+    }
+
+    /// The widest line so far, counting one that has not ended yet
+    std::uint64_t longest() const { return std::max(longest_, position_); }
+
+ private:
+    enum class Kind : std::uint8_t { None, Narrow, Tab, Break, Multibyte };
+
+    /// Adds the width of the character text starts with, returning its length
+    std::size_t Decode(std::span<const char> text) {
+        wchar_t c{};
+        const std::size_t length{
+            std::mbrtowc(&c, text.data(), text.size(), &state_)};
+        if (length == static_cast<std::size_t>(-2)) {
+            // cut short by the end of the text
+            state_ = {};
+            return text.size();
+        } else if (length == static_cast<std::size_t>(-1)) {
+            state_ = {};
+            return 1;
+        }
+        position_ += static_cast<std::uint64_t>(std::max(::wcwidth(c), 0));
+        return std::max<std::size_t>(length, 1);
+    }
+
+    std::array<Kind, 256> kinds_{};
+    std::mbstate_t state_{};
+    std::uint64_t position_{0};
+    std::uint64_t longest_{0};
+};
+
+/// Regular files at least this big are mapped rather than read, and split
+/// into pieces of about this size that are counted in parallel
+constexpr std::size_t chunk_size{8 * 1024 * 1024};
+
+/// Counts one piece of text, doing no more work than was asked for. In
+/// multibyte locales, pieces must not cut characters in two.
+coreutils::TextCounts CountPiece(std::span<const char> text,
+                                 const Selection& selection,
+                                 bool multibyte) {
+    if (selection.words || selection.characters) {
+        const coreutils::TextCounts counts{coreutils::CountText(text)};
+        return multibyte && !counts.ascii
+                   ? coreutils::CountMultibyteText(text)
+                   : counts;
+    }
+    return {.bytes = text.size(),
+            .lines = selection.lines ? coreutils::CountLines(text) : 0};
+}
+
+Counts CountMapped(std::span<const char> text, const Selection& selection,
+                   bool multibyte) {
+    // pieces start at multiples of chunk_size, or in multibyte locales at the
+    // first character that starts at or after one
+    const std::size_t chunks{(text.size() + chunk_size - 1) / chunk_size};
+    std::vector<std::size_t> starts(chunks + 1, text.size());
+    for (std::size_t i{0}; i < chunks; ++i) {
+        std::size_t start{i * chunk_size};
+        // a character is at most 4 bytes, so at most 3 continue it
+        for (const std::size_t limit{std::min(start + 3, text.size())};
+             multibyte && start < limit &&
+             (static_cast<unsigned char>(text[start]) & 0xc0) == 0x80;) {
+            ++start;
+        }
+        starts[i] = start;
+    }
+
+    std::vector<coreutils::TextCounts> pieces(chunks);
+    coreutils::ParallelFor(
+        chunks, coreutils::DefaultConcurrency(), 1,
+        [text, &selection, multibyte, &starts, &pieces](std::size_t i) {
+            pieces[i] = CountPiece(
+                text.subspan(starts[i], starts[i + 1] - starts[i]), selection,
+                multibyte);
+        });
+
+    // in order, so that words straddling two pieces are counted once
+    Counts counts{};
+    for (const coreutils::TextCounts& piece : pieces) {
+        counts.text = coreutils::Join(counts.text, piece);
+    }
+    if (selection.max_line_length) {
+        LineWidth width{multibyte};
+        width.Feed(text);
+        counts.max_line_length = width.longest();
+    }
+    return counts;
+}
+
+/// Counts everything left in fd. On a read error, also returns what was
+/// counted up to it.
+std::pair<Counts, std::error_code> CountStream(int fd,
+                                               const Selection& selection,
+                                               bool multibyte,
+                                               std::span<char> buffer) {
+    Counts counts{};
+    LineWidth width{multibyte};
+    const auto count = [&counts, &width, &selection,
+                        multibyte](std::span<const char> text) {
+        counts.text = coreutils::Join(counts.text,
+                                      CountPiece(text, selection, multibyte));
+        if (selection.max_line_length) {
+            width.Feed(text);
+        }
+    };
+
+    std::error_code error{};
+    // the start of a character that did not fit in the last read, held back
+    // for the next one
+    std::size_t carried{0};
+    while (true) {
+        const std::expected<std::size_t, std::error_code> got{
+            coreutils::ReadSome(fd, buffer.subspan(carried))};
+        if (!got || *got == 0) {
+            count(buffer.first(carried));
+            error = got ? std::error_code{} : got.error();
+            break;
+        }
+        const std::span<const char> text{buffer.first(carried + *got)};
+        const std::size_t whole{multibyte ? coreutils::Utf8Boundary(text)
+                                          : text.size()};
+        count(text.first(whole));
+        carried = text.size() - whole;
+        std::memmove(buffer.data(), text.data() + whole, carried);
+    }
+    counts.max_line_length = width.longest();
+    return {counts, error};
+}
+
+std::pair<Counts, std::error_code> Count(int fd,
+                                         const coreutils::InputShape& shape,
+                                         const Selection& selection,
+                                         bool multibyte,
+                                         std::span<char> buffer) {
+    const std::size_t size{static_cast<std::size_t>(shape.remaining)};
+    if (selection.size() == 1 && selection.bytes && size != 0) {
+        // nothing to read. Empty regular files might be e.g. /proc files,
+        // whose size only reading will tell.
+        return {Counts{.text = {.bytes = size}}, {}};
+    }
+
+    const coreutils::InputSource source{fd, chunk_size};
+    if (const std::optional<std::span<const char>> text{source.mapped()}) {
+        return {CountMapped(*text, selection, multibyte), {}};
+    }
+    return CountStream(fd, selection, multibyte, buffer);
+}
+
+void Print(coreutils::Output& out, const Counts& counts,
+           const Selection& selection, int width, std::string_view name) {
+    const std::array<std::pair<bool, std::uint64_t>, 5> columns{{
+        {selection.lines, counts.text.lines},
+        {selection.words, counts.text.words},
+        {selection.characters, counts.text.characters},
+        {selection.bytes, counts.text.bytes},
+        {selection.max_line_length, counts.max_line_length},
+    }};
+    std::string_view separator{""};
+    for (const auto& [shown, value] : columns) {
+        if (shown) {
+            out.Format("{}{:>{}}", separator, value, width);
+            separator = " ";
+        }
+    }
+    if (!name.empty()) {
+        out.Put(' ').Write(name);
+    }
+    out.Put('\n');
+}
+
+}  // namespace
+
+COREUTILS_MAIN(wc) {
+    using Wc = coreutils::ProgramInfo<
+        "wc", "0.0.1", "Usage: wc [OPTION]... [FILE]...",
+        "Print newline, word, and byte counts for each FILE, and a total "
+        "line if\nmore than one FILE is specified.  A word is a "
+        "non-zero-length sequence of\ncharacters delimited by white "
+        "space.\n\nWith no FILE, or when FILE is -, read standard input.">;
+    using PosArgs = coreutils::PositionalArguments<
+        std::string_view, [](std::string_view arg) { return arg; },
+        coreutils::ArgvView>;
+    using Bytes = coreutils::BooleanArgument<"-c", "--bytes">;
+    using Chars = coreutils::BooleanArgument<"-m", "--chars">;
+    using Lines = coreutils::BooleanArgument<"-l", "--lines">;
+    using MaxLineLength =
+        coreutils::BooleanArgument<"-L", "--max-line-length">;
+    using Words = coreutils::BooleanArgument<"-w", "--words">;
+    coreutils::ArgumentParser<Wc, PosArgs, Bytes, Chars, Lines, MaxLineLength,
+                              Words>
+        parser{argc, argv};
+    parser.ParseArgsOrExit();
+
+    Selection selection{
+        .lines = parser.get<Lines>().value,
+        .words = parser.get<Words>().value,
+        .characters = parser.get<Chars>().value,
+        .bytes = parser.get<Bytes>().value,
+        .max_line_length = parser.get<MaxLineLength>().value,
+    };
+    if (selection.size() == 0) {
+        selection.lines = selection.words = selection.bytes = true;
+    }
+
+    // lines and bytes are the same in every locale. Multibyte locales are
+    // taken to be UTF-8, as practically all of them are.
+    bool multibyte{false};
+    if (selection.words || selection.characters ||
+        selection.max_line_length) {
+        std::setlocale(LC_CTYPE, "");
+        multibyte = MB_CUR_MAX > 1;
+    }
+
+    const auto& names{parser.get<PosArgs>().value};
+    std::vector<std::string_view> targets(names.begin(), names.end());
+    const bool named{!targets.empty()};
+    if (!named) {
+        targets.emplace_back("-");
+    }
+    // one number on its own needs no lining up
+    const int width{targets.size() == 1 && selection.size() == 1
+                        ? 1
+                        : NumberWidth(targets)};
+
+    coreutils::CopyBuffer buffer{};
+    coreutils::Output out{};
+    Counts total{};
+    int status{0};
+    for (const std::string_view target : targets) {
+        // targets are views into argv, so they are null terminated
+        const std::expected<coreutils::InputFile, std::error_code> input{
+            coreutils::InputFile::Open(target.data())};
+        const std::expected<coreutils::InputShape, std::error_code> shape{
+            input ? coreutils::InspectInput(input->fd())
+                  : std::unexpected{input.error()}};
+        if (!shape) {
+            out.Flush();
+            std::println(std::cerr, "wc: {}: {}", target,
+                         shape.error().message());
+            status = 1;
+            continue;
+        }
+
+        const auto [counts, error]{
+            Count(input->fd(), *shape, selection, multibyte, buffer.span())};
+        if (error) {
+            out.Flush();
+            std::println(std::cerr, "wc: {}: {}", target, error.message());
+            status = 1;
+        }
+        Print(out, counts, selection, width, named ? target : "");
+
+        // whole files, so no word straddles two of them
+        total.text.lines += counts.text.lines;
+        total.text.words += counts.text.words;
+        total.text.characters += counts.text.characters;
+        total.text.bytes += counts.text.bytes;
+        total.max_line_length =
+            std::max(total.max_line_length, counts.max_line_length);
+    }
+    if (targets.size() > 1) {
+        Print(out, total, selection, width, "total");
+    }
+
+    if (const std::error_code error{out.Flush()}) {
+        std::println(std::cerr, "wc: write error: {}", error.message());
+        return 1;
+    }
+    return status;
+}
@@ -18,43 +18,163 @@
 ///  with this program. If not, see <https://www.gnu.org/licenses/>
 ///
 
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <expected>
+#include <iostream>
+#include <memory>
+#include <new>
 #include <print>
 #include <span>
 #include <string>
 #include <string_view>
-#include <vector>
+#include <system_error>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#endif
 
 #include "lib/ArgumentParser.hpp"
+#include "lib/Main.hpp"
+#include "lib/Output.hpp"
+
+namespace {
+
+/// Roughly how many bytes one syscall should hand to the kernel. Large enough
+/// to amortize the syscall, small enough to fit a (resized) pipe buffer.
+constexpr std::size_t target_buffer_size{128 * 1024};
+
+std::size_t PageSize() {
+#if defined(_WIN32)
+    return 4096;
+#else
+    const long size{::sysconf(_SC_PAGESIZE)};
+    return size > 0 ? static_cast<std::size_t>(size) : 4096;
+#endif
+}
+
+/// A page aligned buffer filled with as many whole copies of a line as fit in
+/// target_buffer_size (but always at least one). Since it only ever holds
+/// whole lines, emitting it back to back produces the correct stream, and
+/// since it is never modified after construction it is safe to vmsplice.
+class LineBuffer final {
+ public:
+    explicit LineBuffer(std::string_view line)
+        : alignment_{PageSize()},
+          size_{line.size() *
+                std::max<std::size_t>(target_buffer_size / line.size(), 1)},
+          data_{static_cast<char*>(
+                    ::operator new(size_, std::align_val_t{alignment_})),
+                Deleter{alignment_}} {
+        std::memcpy(data_.get(), line.data(), line.size());
+        // double the filled region until the whole buffer is populated
+        for (std::size_t filled{line.size()}; filled < size_;) {
+            const std::size_t chunk{std::min(filled, size_ - filled)};
+            std::memcpy(data_.get() + filled, data_.get(), chunk);
+            filled += chunk;
+        }
+    }
+
+    std::span<const char> view() const { return {data_.get(), size_}; }
+
+ private:
+    struct Deleter {
+        std::size_t alignment;
+        void operator()(char* ptr) const {
+            ::operator delete(ptr, std::align_val_t{alignment});
+        }
+    };
+
+    std::size_t alignment_;
+    std::size_t size_;
+    std::unique_ptr<char[], Deleter> data_;
+};
 
-int main(int argc, const char** argv) {
+/// Emits the buffer forever. Partial writes are handled by continuing from
+/// the offset the kernel stopped at, wrapping around, so the stream stays
+/// contiguous no matter how the kernel splits it up. Only returns on error.
+int WriteForever(std::span<const char> buffer) {
+    std::size_t offset{0};
+#if defined(__linux__)
+    struct stat info {};
+    bool use_vmsplice{::fstat(STDOUT_FILENO, &info) == 0 &&
+                      S_ISFIFO(info.st_mode)};
+    if (use_vmsplice) {
+        // best effort: a pipe the size of our buffer takes it in one call
+        ::fcntl(STDOUT_FILENO, F_SETPIPE_SZ, static_cast<int>(buffer.size()));
+    }
+
+    while (use_vmsplice) {
+        iovec iov{const_cast<char*>(buffer.data() + offset),
+                  buffer.size() - offset};
+        const ssize_t written{::vmsplice(STDOUT_FILENO, &iov, 1, 0)};
+        if (written > 0) {
+            offset = (offset + static_cast<std::size_t>(written)) %
+                     buffer.size();
+        } else if (written < 0 && errno == EINTR) {
+            continue;
+        } else if (written < 0 && errno == EPIPE) {
+            return errno;
+        } else {
+            // e.g. the kernel refuses to splice this pipe; plain write it is
+            use_vmsplice = false;
+        }
+    }
+#endif
+
+    while (true) {
+        const std::expected<std::size_t, std::error_code> written{
+            coreutils::WriteSome(coreutils::Output::standard_output,
+                                 {buffer.data() + offset,
+                                  buffer.size() - offset})};
+        if (!written) {
+            return written.error().value();
+        }
+        offset = (offset + *written) % buffer.size();
+    }
+}
+
+}  // namespace
+
+COREUTILS_MAIN(yes) {
     using Yes = coreutils::ProgramInfo<
         "yes", "0.0.1", "Usage: yes [STRING]...",
         "Repeatedly output a line with all specified STRING(s), or 'y'.">;
-    using PositionalArgs =
-        coreutils::PositionalArguments<std::string_view,
-                                       [](std::string_view v) { return v; }>;
+    using PositionalArgs = coreutils::PositionalArguments<
+        std::string_view, [](std::string_view v) { return v; },
+        coreutils::ArgvView>;
     coreutils::ArgumentParser<Yes, PositionalArgs> parser{argc, argv};
     parser.ParseArgsOrExit();
 
-    const std::vector<std::string_view>& pos_args{
+    const coreutils::ArgvView<std::string_view>& pos_args{
         parser.get<PositionalArgs>().value};
 
     std::string to_print{};
 
-    if (std::vector<std::string_view>::size_type size{pos_args.size()}; size) {
-        for (const std::string_view& v :
-             std::span{pos_args.begin(), size - 1}) {
+    if (!pos_args.empty()) {
+        for (const std::string_view v : pos_args) {
             to_print.append_range(v);
             to_print.push_back(' ');
         }
-        to_print.append_range(pos_args.back());
+        // the last one is followed by the newline instead
+        to_print.back() = '\n';
     } else {
-        to_print.push_back('y');
+        to_print.append_range(std::string_view{"y\n"});
     }
 
-    while (true) {
-        std::println("{}", to_print);
+    const LineBuffer buffer{to_print};
+    if (const int error{WriteForever(buffer.view())}; error != EPIPE) {
+        std::println(std::cerr, "yes: standard output: {}",
+                     std::strerror(error));
     }
 
-    return 0;
+    return 1;
 }
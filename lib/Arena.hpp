@@ -0,0 +1,110 @@
+///
+///  @file Arena.hpp
+///  @brief bump allocator for large numbers of small, same-lifetime objects
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_ARENA_HPP_
+#define LIB_ARENA_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace coreutils {
+
+/// Hands out memory by bumping a pointer through large blocks, and frees all
+/// of it at once when destroyed. Meant for things like file names, where
+/// millions of tiny allocations would otherwise each hit the heap.
+class Arena final {
+ public:
+    static constexpr std::size_t default_block_size{64 * 1024};
+
+    constexpr explicit Arena(std::size_t block_size = default_block_size)
+        : block_size_{block_size} {}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    Arena(Arena&& other) noexcept
+        : block_size_{other.block_size_},
+          blocks_{std::move(other.blocks_)},
+          cursor_{std::exchange(other.cursor_, nullptr)},
+          end_{std::exchange(other.end_, nullptr)} {}
+    Arena& operator=(Arena&& other) noexcept {
+        block_size_ = other.block_size_;
+        blocks_ = std::move(other.blocks_);
+        cursor_ = std::exchange(other.cursor_, nullptr);
+        end_ = std::exchange(other.end_, nullptr);
+        return *this;
+    }
+
+    /// Returns size bytes aligned to align (a power of two). The memory is
+    /// valid until the arena is destroyed.
+    char* Allocate(std::size_t size, std::size_t align = 1) {
+        const std::uintptr_t current{reinterpret_cast<std::uintptr_t>(cursor_)};
+        const std::size_t padding{(align - current % align) % align};
+        if (static_cast<std::size_t>(end_ - cursor_) < size + padding) {
+            return NewBlock(size, align);
+        }
+        char* result{cursor_ + padding};
+        cursor_ = result + size;
+        return result;
+    }
+
+    /// Copies str into the arena. The returned view is followed by a '\0' so
+    /// that its data() may be handed straight to C APIs.
+    std::string_view Store(std::string_view str) {
+        char* copy{Allocate(str.size() + 1)};
+        std::memcpy(copy, str.data(), str.size());
+        copy[str.size()] = '\0';
+        return {copy, str.size()};
+    }
+
+ private:
+    char* NewBlock(std::size_t size, std::size_t align) {
+        // oversized requests get a dedicated block so the current block can
+        // keep being filled
+        const std::size_t needed{size + align - 1};
+        const bool dedicated{needed > block_size_ / 4};
+        const std::size_t length{dedicated ? needed
+                                           : std::max(needed, block_size_)};
+
+        blocks_.emplace_back(std::make_unique_for_overwrite<char[]>(length));
+        char* start{blocks_.back().get()};
+        const std::uintptr_t address{reinterpret_cast<std::uintptr_t>(start)};
+        char* result{start + (align - address % align) % align};
+        if (!dedicated) {
+            cursor_ = result + size;
+            end_ = start + length;
+        }
+        return result;
+    }
+
+    std::size_t block_size_;
+    std::vector<std::unique_ptr<char[]>> blocks_{};
+    char* cursor_{nullptr};
+    char* end_{nullptr};
+};
+
+}  // namespace coreutils
+
+#endif  // LIB_ARENA_HPP_
@@ -21,35 +21,57 @@
 #ifndef LIB_ARGUMENTPARSER_HPP_
 #define LIB_ARGUMENTPARSER_HPP_
 
+#include <algorithm>
 #include <array>
 #include <concepts>
 #include <cstddef>
+#include <cstdint>
+#include <cstdio>
 #include <cstdlib>
+#include <expected>
 #include <print>
 #include <span>
 #include <string_view>
 #include <tuple>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
+#include "ArgumentStorage.hpp"
+#include "Stats.hpp"
 #include "detail/ArgumentParser.hpp"
 
 namespace coreutils {
 
 template <class T, auto Converter, detail::ComptimeString... Names>
 using MultiValueArgument =
-    detail::Argument<T, detail::NArgs::Many, Converter, Names...>;
+    detail::Argument<T, detail::NArgs::Many, Converter, std::vector, Names...>;
 
-template <class T, auto Converter>
+/// MultiValueArgument, keeping its values in Container (see
+/// ArgumentStorage.hpp) instead of a std::vector
+template <template <class> class Container, class T, auto Converter,
+          detail::ComptimeString... Names>
+using MultiValueArgumentIn =
+    detail::Argument<T, detail::NArgs::Many, Converter, Container, Names...>;
+
+template <class T, auto Converter,
+          template <class> class Container = std::vector>
 using PositionalArguments =
-    detail::Argument<T, detail::NArgs::Many, Converter, "">;
+    detail::Argument<T, detail::NArgs::Many, Converter, Container, "">;
 
 template <detail::ComptimeString... Names>
-using BooleanArgument = detail::Argument<void, detail::NArgs::None,
-                                         [](std::string_view) {}, Names...>;
+using BooleanArgument =
+    detail::Argument<void, detail::NArgs::None, [](std::string_view) {},
+                     std::vector, Names...>;
 
 template <class T, auto Converter, detail::ComptimeString... Names>
 using SingleValueArgument =
-    detail::Argument<T, detail::NArgs::One, Converter, Names...>;
+    detail::Argument<T, detail::NArgs::One, Converter, std::vector, Names...>;
+
+/// Takes one value each time it is given, e.g. -k 2,2 -k 1,1
+template <class T, auto Converter, detail::ComptimeString... Names>
+using RepeatedValueArgument =
+    detail::Argument<T, detail::NArgs::Each, Converter, std::vector, Names...>;
 
 template <detail::ComptimeString HelpText, detail::ComptimeString... Names>
 struct ArgumentInfo final {
@@ -133,6 +155,35 @@ struct Flag {};
 template <IsArgumentInfo Info_t, IsValueConverter Converter_t>
 struct Option {};
 
+using detail::ParseErrorKind;
+
+/// Why parsing stopped, and where. Nothing is formatted unless it is printed.
+struct ParseError final {
+    ParseErrorKind kind;
+    /// Index into argv of the offending token. Positional arguments are moved
+    /// to the front of argv as they are parsed, so this is an index into argv
+    /// as the parser left it.
+    std::uint32_t index;
+};
+
+constexpr std::string_view Describe(ParseErrorKind kind) {
+    switch (kind) {
+        case ParseErrorKind::DuplicateOption:
+            return "option given more than once";
+        case ParseErrorKind::MissingValues:
+            return "option requires at least one argument";
+        case ParseErrorKind::MissingValue:
+            return "option requires an argument";
+        case ParseErrorKind::TooManyValues:
+            return "too many arguments, starting at";
+        case ParseErrorKind::UnexpectedValue:
+            return "option doesn't allow an argument";
+        case ParseErrorKind::UnknownOption:
+            return "unrecognized option";
+    }
+    return "invalid argument";
+}
+
 template <class T>
 concept Arg = requires(T arg) {
     std::same_as<std::string_view, decltype(T::help_view_)>;
@@ -142,27 +193,72 @@ concept Arg = requires(T arg) {
 template <IsProgramInfo Program, Arg... Args>
 class ArgumentParser final {
  public:
+    using Result = std::expected<void, ParseError>;
+
     constexpr explicit ArgumentParser(int argc, const char** argv)
         : args_{argv + 1, argv + argc} {}
 
-    constexpr auto ParseArgsOrExit() {
-        for (std::string_view arg : args_) {
-            if (arg == "--version") {
+    /// Parses the whole command line, stopping at the first error. --help and
+    /// --version still print and exit. In a build with COREUTILS_STATS,
+    /// --stats (or COREUTILSPP_STATS=path) reports on the run at exit.
+    constexpr Result TryParseArgs() {
+        const detail::StatsTimer timer{detail::StatsPhase::Parse};
+        EnableStatsFromEnvironment(Program::name.PrintableView());
+        bool options_ended{false};
+        for (current_ = 0; current_ < args_.size(); ++current_) {
+            const std::string_view arg{args_[current_]};
+            Result result{};
+            if (options_ended || TakesNextToken()) {
+                // e.g. -m -5, where -5 is a value rather than a flag
+                result = ParseValue(arg);
+            } else if (arg == "--") {
+                // also ends the values of an option that takes many
+                result = ParseFlag(arg);
+                options_ended = true;
+            } else if (arg == "--version") {
                 PrintVersion();
             } else if (arg == "--help") {
                 PrintHelp();
+#if defined(COREUTILS_STATS)
+            } else if (arg == "--stats") {
+                EnableStats(Program::name.PrintableView());
+#endif
+            } else if (arg.starts_with("--") &&
+                       arg.find('=') != std::string_view::npos) {
+                result = ParseInlineValue(arg);
+            } else if (arg.size() > 2 && !arg.starts_with("--") &&
+                       arg.starts_with('-') && !flag_table_.Find(arg)) {
+                result = ParseShortFlags(arg);
+            } else if (arg.size() > 1 && arg.starts_with('-')) {
+                result = ParseFlag(arg);
             } else {
-                if (arg.starts_with('-')) {
-                    std::apply(
-                        [arg](auto&... a) { (a.TryParseFlag(arg), ...); },
-                        arg_values_);
-                } else {
-                    std::apply(
-                        [arg](auto&... a) { (a.TryParseValue(arg), ...); },
-                        arg_values_);
-                }
+                // including a lone -, which conventionally means stdin
+                result = ParseValue(arg);
+            }
+
+            if (!result) {
+                return result;
             }
         }
+
+        if (TakesNextToken()) {
+            return Fail(ParseErrorKind::MissingValue, seeking_token_);
+        }
+        std::apply([this](auto&... a) { (BindArgv(a), ...); }, arg_values_);
+        return {};
+    }
+
+    constexpr void ParseArgsOrExit() {
+        if (const Result result{TryParseArgs()}; !result) {
+            PrintError(result.error());
+            std::exit(1);
+        }
+    }
+
+    /// e.g. "ls: option requires an argument '--jobs'"
+    void PrintError(const ParseError& error) const {
+        std::println(stderr, "{}: {} '{}'", Program::name.PrintableView(),
+                     Describe(error.kind), args_[error.index - 1]);
     }
 
     [[noreturn]]
@@ -180,6 +276,10 @@ class ArgumentParser final {
         std::println("\t{:<15}{:<}", "--help", "display this help and exit");
         std::println("\t{:<15}{:<}", "--version",
                      "output version information and exit");
+#if defined(COREUTILS_STATS)
+        std::println("\t{:<15}{:<}", "--stats",
+                     "report where the time went, as JSON, at exit");
+#endif
         (std::println("\t{}", Args::help_view_), ...);
         std::exit(0);
     }
@@ -190,11 +290,202 @@ class ArgumentParser final {
     }
 
  private:
+    using Handler = detail::ParseResult (*)(ArgumentParser&, std::string_view);
+    using ValueHandler = detail::ValueResult (*)(ArgumentParser&,
+                                                 std::string_view);
+
+    static constexpr std::array flag_names_{
+        detail::CollectFlagNames<Args...>()};
+    static_assert(detail::HasDistinctNames(flag_names_),
+                  "Two arguments share an option name");
+    static constexpr detail::FlagTable<flag_names_.size()> flag_table_{
+        flag_names_};
+
+    template <std::size_t I>
+    static constexpr detail::ParseResult Flag(ArgumentParser& parser,
+                                              std::string_view arg) {
+        return std::get<I>(parser.arg_values_).ParseFlag(arg);
+    }
+    template <std::size_t I>
+    static constexpr detail::ParseResult OtherFlag(ArgumentParser& parser,
+                                                   std::string_view arg) {
+        return std::get<I>(parser.arg_values_).ParseOtherFlag(arg);
+    }
+    template <std::size_t I>
+    static constexpr detail::ValueResult Value(ArgumentParser& parser,
+                                               std::string_view arg) {
+        return std::get<I>(parser.arg_values_).TryParseValue(arg);
+    }
+    template <std::size_t I>
+    static constexpr bool Seeking(const ArgumentParser& parser) {
+        return std::get<I>(parser.arg_values_).seeking();
+    }
+
+    /// Jump tables from an argument's index (in Args) to its member functions
+    struct Handlers final {
+        std::array<Handler, sizeof...(Args)> flag;
+        std::array<Handler, sizeof...(Args)> other_flag;
+        std::array<ValueHandler, sizeof...(Args)> value;
+        std::array<bool (*)(const ArgumentParser&), sizeof...(Args)> seeking;
+        std::array<bool, sizeof...(Args)> takes_one;
+    };
+
+    template <std::size_t... I>
+    static consteval Handlers MakeHandlers(std::index_sequence<I...>) {
+        return {
+            .flag{&Flag<I>...},
+            .other_flag{&OtherFlag<I>...},
+            .value{&Value<I>...},
+            .seeking{&Seeking<I>...},
+            .takes_one{(Args::nargs_ == detail::NArgs::One ||
+                        Args::nargs_ == detail::NArgs::Each)...},
+        };
+    }
+    static constexpr Handlers handlers_{
+        MakeHandlers(std::index_sequence_for<Args...>{})};
+
+    /// token is an index into args_
+    static constexpr std::unexpected<ParseError> Fail(ParseErrorKind kind,
+                                                      std::size_t token) {
+        return std::unexpected{ParseError{
+            .kind = kind, .index = static_cast<std::uint32_t>(token + 1)}};
+    }
+
+    /// Whether the next token is the value of the last option, whatever it
+    /// looks like
+    constexpr bool TakesNextToken() const {
+        return seeking_ && handlers_.takes_one[seeking_->index];
+    }
+
+    /// Looks arg up in the compile time table and hands it straight to the
+    /// one argument it names. Unknown flags are ignored.
+    constexpr Result ParseFlag(std::string_view arg) {
+        const detail::FlagName* const flag{flag_table_.Find(arg)};
+        if (seeking_ && seeking_ != flag) {
+            // the option that was waiting on values is the one at fault
+            if (const detail::ParseResult ended{
+                    handlers_.other_flag[seeking_->index](*this, arg)};
+                !ended) {
+                return Fail(ended.error(), seeking_token_);
+            }
+        }
+        seeking_ = nullptr;
+        if (!flag) {
+            return {};
+        }
+
+        if (const detail::ParseResult parsed{
+                handlers_.flag[flag->index](*this, arg)};
+            !parsed) {
+            return Fail(parsed.error(), current_);
+        }
+        if (handlers_.seeking[flag->index](*this)) {
+            seeking_ = flag;
+            seeking_token_ = current_;
+        }
+        return {};
+    }
+
+    /// --name=value is shorthand for --name value, so it is only valid when
+    /// --name is an option that takes a value. Unlike a bare unknown flag,
+    /// the value would otherwise have nowhere to go.
+    constexpr Result ParseInlineValue(std::string_view arg) {
+        const std::size_t split{arg.find('=')};
+        const std::string_view name{arg.substr(0, split)};
+        if (const Result result{ParseFlag(name)}; !result) {
+            return result;
+        }
+        if (!flag_table_.Find(name)) {
+            return Fail(ParseErrorKind::UnknownOption, current_);
+        }
+        if (!seeking_) {
+            return Fail(ParseErrorKind::UnexpectedValue, current_);
+        }
+        return ParseValue(arg.substr(split + 1));
+    }
+
+    /// Bundled short flags, e.g. -lS for -l -S. Like getopt, once a flag
+    /// that takes a value turns up, the rest of the token is that value
+    /// (e.g. -j4).
+    constexpr Result ParseShortFlags(std::string_view arg) {
+        for (std::size_t i{1}; i < arg.size(); ++i) {
+            const std::array<char, 2> name{'-', arg[i]};
+            if (const Result result{ParseFlag({name.data(), name.size()})};
+                !result) {
+                return result;
+            }
+            if (seeking_ && i + 1 < arg.size()) {
+                return ParseValue(arg.substr(i + 1));
+            }
+        }
+        return {};
+    }
+
+    /// A value belongs to whichever option is waiting on one, and only goes
+    /// to the positional arguments when no option claims it.
+    constexpr Result ParseValue(std::string_view arg) {
+        if (seeking_) {
+            if (const detail::ValueResult taken{
+                    handlers_.value[seeking_->index](*this, arg)};
+                !taken) {
+                return Fail(taken.error(), current_);
+            }
+            if (handlers_.takes_one[seeking_->index]) {
+                seeking_ = nullptr;
+            }
+            return {};
+        }
+
+        // the first positional argument to take (or reject) arg settles it
+        const detail::ValueResult claimed{std::apply(
+            [arg](auto&... a) {
+                detail::ValueResult result{false};
+                // unused when there are no arguments at all
+                [[maybe_unused]] const auto offer = [arg, &result](
+                                                        auto& argument) {
+                    if (argument.positional_ && result && !*result) {
+                        result = argument.TryParseValue(arg);
+                    }
+                };
+                (offer(a), ...);
+                return result;
+            },
+            arg_values_)};
+        if (!claimed) {
+            return Fail(claimed.error(), current_);
+        }
+        if (*claimed) {
+            // keep the positional arguments together at the front of argv, in
+            // order, so that ArgvView can view them without copying. Nothing
+            // moves in the usual case of options first, then operands.
+            const auto first{args_.begin() + positionals_};
+            const auto current{args_.begin() + current_};
+            std::rotate(first, current, current + 1);
+            ++positionals_;
+        }
+        return {};
+    }
+
+    template <class A>
+    constexpr void BindArgv(A& argument) {
+        if constexpr (requires { argument.value.BindArgv(args_); }) {
+            argument.value.BindArgv(args_.first(positionals_));
+        }
+    }
+
     // since argc and argv should be valid for the lifetime of the main
     // function, storing this should be safe, as the lifetime of this object
     // should logically always be less than the main function.
     std::span<const char*> args_{};
     std::tuple<Args...> arg_values_{};
+    /// Index (in args_) of the token being parsed
+    std::size_t current_{0};
+    /// How many positional arguments have been moved to the front of args_
+    std::size_t positionals_{0};
+    /// The option whose values come next, if any
+    const detail::FlagName* seeking_{nullptr};
+    /// Index (in args_) of that option, for error messages
+    std::size_t seeking_token_{0};
 
     static constexpr std::string_view license_info_{
         "Copyright (C) 2025 Free Software Foundation, Inc.\nLicense GPLv3+: "
@@ -0,0 +1,158 @@
+///
+///  @file ArgumentStorage.hpp
+///  @brief allocation free containers for argument values
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_ARGUMENTSTORAGE_HPP_
+#define LIB_ARGUMENTSTORAGE_HPP_
+
+#include <array>
+#include <cstddef>
+#include <memory_resource>
+#include <ranges>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// Arguments that take many values keep them in std::vector by default. These
+/// are drop in replacements for when a heap allocation per process start is
+/// too much, e.g.
+///
+///     PositionalArguments<std::string_view, Converter, ArgvView>
+///     PositionalArguments<int, Converter, Inline<8>::Container>
+
+namespace coreutils {
+
+/// Up to Capacity values, stored inline. Going over capacity is a parse error.
+template <class T, std::size_t Capacity>
+class FixedVector final {
+ public:
+    constexpr bool push_back(T value) { return emplace_back(std::move(value)); }
+
+    /// Returns false, and adds nothing, when already full
+    template <class... Args>
+    constexpr bool emplace_back(Args&&... args) {
+        if (size_ == Capacity) {
+            return false;
+        }
+        items_[size_++] = T{std::forward<Args>(args)...};
+        return true;
+    }
+
+    constexpr std::size_t size() const { return size_; }
+    constexpr bool empty() const { return size_ == 0; }
+    constexpr const T& operator[](std::size_t i) const { return items_[i]; }
+    constexpr const T& front() const { return items_.front(); }
+    constexpr const T& back() const { return items_[size_ - 1]; }
+    constexpr const T* begin() const { return items_.data(); }
+    constexpr const T* end() const { return items_.data() + size_; }
+
+ private:
+    std::array<T, Capacity> items_{};
+    std::size_t size_{0};
+};
+
+template <std::size_t Capacity>
+struct Inline final {
+    template <class T>
+    using Container = FixedVector<T, Capacity>;
+};
+
+/// A std::pmr::vector whose first Bytes come out of an inline buffer. Unlike
+/// FixedVector there is no hard limit: past the buffer it goes to the heap.
+template <class T, std::size_t Bytes>
+class ArenaVector final {
+ public:
+    ArenaVector() = default;
+    ArenaVector(const ArenaVector&) = delete;
+    ArenaVector& operator=(const ArenaVector&) = delete;
+
+    void push_back(T value) { items_.push_back(std::move(value)); }
+
+    template <class... Args>
+    T& emplace_back(Args&&... args) {
+        return items_.emplace_back(std::forward<Args>(args)...);
+    }
+
+    std::size_t size() const { return items_.size(); }
+    bool empty() const { return items_.empty(); }
+    const T& operator[](std::size_t i) const { return items_[i]; }
+    const T& front() const { return items_.front(); }
+    const T& back() const { return items_.back(); }
+    auto begin() const { return items_.begin(); }
+    auto end() const { return items_.end(); }
+
+ private:
+    alignas(std::max_align_t) std::array<std::byte, Bytes> buffer_;
+    std::pmr::monotonic_buffer_resource arena_{buffer_.data(), buffer_.size()};
+    std::pmr::vector<T> items_{&arena_};
+};
+
+template <std::size_t Bytes>
+struct InArena final {
+    template <class T>
+    using Container = ArenaVector<T, Bytes>;
+};
+
+/// Zero copy positional arguments: the parser moves positional arguments to
+/// the front of argv as it goes (like GNU getopt), so afterwards they are one
+/// contiguous run of argv that this simply views. Only meaningful for
+/// std::string_view positionals, and only readable once parsing is done.
+template <class T>
+class ArgvView final {
+    static_assert(std::is_same_v<T, std::string_view>,
+                  "ArgvView can only hold the arguments themselves");
+
+    struct ToView final {
+        constexpr std::string_view operator()(const char* arg) const {
+            return arg;
+        }
+    };
+    using View = std::ranges::transform_view<std::span<const char* const>,
+                                             ToView>;
+
+ public:
+    /// The value is already in argv
+    constexpr void push_back(std::string_view) { ++size_; }
+    constexpr void emplace_back(std::string_view) { ++size_; }
+
+    /// Called by the parser once argv starts with the positional arguments
+    constexpr void BindArgv(std::span<const char* const> argv) {
+        view_ = View{argv.first(size_), ToView{}};
+    }
+
+    constexpr std::size_t size() const { return size_; }
+    constexpr bool empty() const { return size_ == 0; }
+    constexpr std::string_view operator[](std::size_t i) const {
+        return view_[i];
+    }
+    constexpr std::string_view front() const { return view_.front(); }
+    constexpr std::string_view back() const { return view_.back(); }
+    constexpr auto begin() const { return view_.begin(); }
+    constexpr auto end() const { return view_.end(); }
+
+ private:
+    std::size_t size_{0};
+    View view_{};
+};
+
+}  // namespace coreutils
+
+#endif  // LIB_ARGUMENTSTORAGE_HPP_
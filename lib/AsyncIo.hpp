@@ -0,0 +1,444 @@
+///
+///  @file AsyncIo.hpp
+///  @brief batched opens, stats, reads and writes, many in flight at once
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_ASYNCIO_HPP_
+#define LIB_ASYNCIO_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "DirectoryReader.hpp"
+#include "FileCopy.hpp"
+#include "FileStatus.hpp"
+#include "Parallel.hpp"
+#include "detail/AsyncIo.hpp"
+#include "detail/Output.hpp"
+#include "detail/Stats.hpp"
+
+namespace coreutils {
+
+enum class IoOp : std::uint8_t { OpenAt, Stat, Read, Write };
+
+/// One operation for an IoEngine to run, made by one of the functions below
+/// and filled in by IoEngine::Run
+struct IoRequest final {
+#if defined(_WIN32)
+    /// Windows has no directory descriptors, so paths are always relative
+    /// to the working directory there
+    static constexpr int working_directory{-100};
+#else
+    static constexpr int working_directory{AT_FDCWD};
+#endif
+
+    /// Opens path (relative to the directory dirfd) with flags, and
+    /// O_CLOEXEC. Files it creates get mode 0666, less the umask.
+    static IoRequest OpenAt(int dirfd, const char* path, int flags) {
+        return {.op = IoOp::OpenAt, .fd = dirfd, .path = path,
+                .flags = flags};
+    }
+
+    /// Looks up path (relative to the directory dirfd) without following
+    /// symlinks
+    static IoRequest Stat(int dirfd, const char* path, StatField fields) {
+        return {.op = IoOp::Stat, .fd = dirfd, .path = path,
+                .fields = fields};
+    }
+
+    /// One read into buffer, at offset or, if it is negative, at (and
+    /// moving) the file's offset
+    static IoRequest Read(int fd, std::span<char> buffer,
+                          std::int64_t offset = -1) {
+        return {.op = IoOp::Read, .fd = fd, .into = buffer, .offset = offset};
+    }
+
+    /// One write of data, at offset or, if it is negative, at (and moving)
+    /// the file's offset
+    static IoRequest Write(int fd, std::span<const char> data,
+                           std::int64_t offset = -1) {
+        return {.op = IoOp::Write, .fd = fd, .from = data, .offset = offset};
+    }
+
+    std::error_code error() const {
+        return result < 0 ? std::error_code{static_cast<int>(-result),
+                                            std::system_category()}
+                          : std::error_code{};
+    }
+
+    IoOp op;
+    /// The directory for OpenAt and Stat, the file for Read and Write
+    int fd;
+    /// Null terminated, and left alone until the request has run
+    const char* path{nullptr};
+    int flags{0};
+    StatField fields{StatField::None};
+    std::span<char> into{};
+    std::span<const char> from{};
+    std::int64_t offset{-1};
+
+    /// The new file descriptor for OpenAt, 0 for Stat, and how many bytes
+    /// moved for Read and Write. On failure, the negated errno.
+    std::int64_t result{0};
+    /// What Stat found
+    FileStatus status{};
+};
+
+namespace detail {
+
+/// A read or write of at most this much is never cut short by the kernel
+/// (Linux's MAX_RW_COUNT)
+inline constexpr std::size_t max_io_size{0x7ffff000};
+
+inline std::int64_t Outcome(
+    const std::expected<std::size_t, std::error_code>& done) {
+    return done ? static_cast<std::int64_t>(*done) : -done.error().value();
+}
+
+inline std::expected<std::size_t, std::error_code> WriteSomeAt(
+    int fd, std::span<const char> data, std::int64_t offset) {
+    while (true) {
+        const StatsTimer timer{StatsPhase::Io};
+#if defined(_WIN32)
+        if (::_lseeki64(fd, offset, SEEK_SET) < 0) {
+            return std::unexpected{
+                std::error_code{errno, std::system_category()}};
+        }
+        const int written{::_write(fd, data.data(),
+                                   static_cast<unsigned int>(data.size()))};
+#else
+        const ssize_t written{::pwrite(fd, data.data(), data.size(),
+                                       static_cast<off_t>(offset))};
+#endif
+        CountSyscall(StatsSyscall::Write, written);
+        if (written >= 0) {
+            return static_cast<std::size_t>(written);
+        } else if (errno != EINTR) {
+            return std::unexpected{
+                std::error_code{errno, std::system_category()}};
+        }
+    }
+}
+
+/// Runs request as a plain, blocking syscall
+inline void RunNow(IoRequest& request) {
+    switch (request.op) {
+        case IoOp::OpenAt: {
+#if defined(_WIN32)
+            const int fd{::_open(request.path, request.flags | _O_BINARY,
+                                 _S_IREAD | _S_IWRITE)};
+#else
+            const int fd{::openat(request.fd, request.path,
+                                  request.flags | O_CLOEXEC, 0666)};
+#endif
+            request.result = fd >= 0 ? fd : -errno;
+            break;
+        }
+        case IoOp::Stat: {
+            const StatsTimer timer{StatsPhase::Io};
+            CountSyscall(StatsSyscall::Stat);
+#if defined(_WIN32)
+            const StatResult status{StatPath(request.path, request.fields)};
+#else
+            const StatResult status{
+                StatAt(request.fd, request.path, request.fields)};
+#endif
+            request.result = status ? 0 : -status.error().value();
+            if (status) {
+                request.status = *status;
+            }
+            break;
+        }
+        case IoOp::Read: {
+            const std::span<char> into{request.into.first(
+                std::min(request.into.size(), max_io_size))};
+            request.result = Outcome(
+                request.offset < 0
+                    ? ReadSome(request.fd, into)
+                    : ReadSomeAt(request.fd, into,
+                                 static_cast<std::uint64_t>(request.offset)));
+            break;
+        }
+        case IoOp::Write: {
+            const std::span<const char> from{request.from.first(
+                std::min(request.from.size(), max_io_size))};
+            request.result = Outcome(
+                request.offset < 0
+                    ? WriteSome(request.fd, {from.data(), from.size()})
+                    : WriteSomeAt(request.fd, from, request.offset));
+            break;
+        }
+    }
+}
+
+}  // namespace detail
+
+/// Runs batches of opens, stats, reads and writes with many in flight at
+/// once, for work bound by syscall round trips rather than by bandwidth
+/// (e.g. looking up every entry of a directory on a network filesystem).
+///
+/// Built with COREUTILS_IO_URING on Linux, batches go through an io_uring,
+/// when the kernel allows one. Otherwise each request is a plain syscall,
+/// made by one of up to queue depth threads. Callers cannot tell which.
+///
+/// An engine belongs to the thread that made it.
+class IoEngine final {
+ public:
+    static constexpr std::size_t default_queue_depth{64};
+
+    explicit IoEngine(std::size_t queue_depth = default_queue_depth,
+                      std::size_t threads = DefaultConcurrency())
+        : queue_depth_{std::max<std::size_t>(queue_depth, 1)},
+          threads_{std::clamp<std::size_t>(threads, 1, queue_depth_)} {}
+
+    /// How many threads requests are spread over, when they are not going
+    /// through a ring
+    std::size_t threads() const { return threads_; }
+
+    /// Runs every one of requests, in no particular order, and fills in
+    /// their results. A request that fails does not stop the others.
+    void Run(std::span<IoRequest> requests) {
+#if defined(COREUTILS_IO_URING) && defined(__linux__)
+        if (Ring* const ring{GetRing()}) {
+            if (!RunOnRing(*ring, requests)) {
+                // it ran what was left without the ring, and batches from
+                // now on go the other way too
+                ring_.reset();
+            }
+            return;
+        }
+#endif
+        // small enough that a batch of a few hundred is still spread out,
+        // large enough that threads are not fighting over the counter
+        constexpr std::size_t grain{16};
+        ParallelFor(requests.size(), threads_, grain,
+                    [requests](std::size_t i) { detail::RunNow(requests[i]); });
+    }
+
+ private:
+    std::size_t queue_depth_;
+    std::size_t threads_;
+
+#if defined(COREUTILS_IO_URING) && defined(__linux__)
+    using Ring = detail::Ring;
+
+    /// Set up on first use, so that engines that end up with nothing to do
+    /// cost nothing
+    Ring* GetRing() {
+        if (!tried_ring_) {
+            tried_ring_ = true;
+            constexpr std::array<std::uint8_t, 4> ops{
+                IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ,
+                IORING_OP_WRITE};
+            ring_ = Ring::Create(
+                static_cast<unsigned>(std::min<std::size_t>(queue_depth_,
+                                                            4096)),
+                ops);
+            if (ring_) {
+                slots_.resize(std::min<std::size_t>(queue_depth_,
+                                                    ring_->capacity()));
+            }
+        }
+        return ring_.get();
+    }
+
+    /// Returns false if the ring broke, in which case every request it had
+    /// not taken has been run as a plain syscall instead, and the ones it had
+    /// taken were waited for (or, if even that failed, failed with it)
+    bool RunOnRing(Ring& ring, std::span<IoRequest> requests) {
+        const detail::StatsTimer timer{detail::StatsPhase::Io};
+        std::vector<std::size_t> free(slots_.size());
+        for (std::size_t i{0}; i < free.size(); ++i) {
+            free[i] = free.size() - 1 - i;
+        }
+
+        std::size_t next{0};
+        std::size_t in_flight{0};
+        while (next < requests.size() || in_flight > 0) {
+            for (; next < requests.size() && !free.empty(); ++next) {
+                const std::size_t slot{free.back()};
+                free.pop_back();
+                slots_[slot].request = next;
+                Prepare(ring.Prepare(), requests[next], slot);
+                ++in_flight;
+            }
+            // EAGAIN and EBUSY clear up as completions are reaped
+            const std::error_code error{ring.Submit(1)};
+            const auto finish = [this, requests, &free](std::uint64_t slot,
+                                                        std::int32_t res) {
+                Finish(requests[slots_[slot].request], slot, res);
+                free.push_back(slot);
+            };
+            in_flight -= ring.Reap(finish);
+            if (!error || error == std::errc::resource_unavailable_try_again ||
+                error == std::errc::device_or_resource_busy) {
+                continue;
+            }
+            // anything else means the ring itself is broken. What the kernel
+            // has not taken yet is run without it, but what it has taken may
+            // still be written into, so those have to come back first.
+            in_flight -= ring.Withdraw([this, requests,
+                                        &free](std::uint64_t slot) {
+                detail::RunNow(requests[slots_[slot].request]);
+                free.push_back(slot);
+            });
+            while (in_flight > 0) {
+                if (const std::error_code waited{ring.Submit(1)}; waited) {
+                    FailInFlight(requests, free, waited);
+                    break;
+                }
+                in_flight -= ring.Reap(finish);
+            }
+            for (; next < requests.size(); ++next) {
+                detail::RunNow(requests[next]);
+            }
+            return false;
+        }
+        return true;
+    }
+
+    /// For when a broken ring will not even say how the requests it took
+    /// went: every one of them failed with error
+    void FailInFlight(std::span<IoRequest> requests,
+                      std::span<const std::size_t> free,
+                      std::error_code error) {
+        std::vector<bool> idle(slots_.size(), false);
+        for (const std::size_t slot : free) {
+            idle[slot] = true;
+        }
+        for (std::size_t slot{0}; slot < slots_.size(); ++slot) {
+            if (!idle[slot]) {
+                requests[slots_[slot].request].result = -error.value();
+            }
+        }
+    }
+
+    void Prepare(io_uring_sqe& sqe, const IoRequest& request,
+                 std::size_t slot) {
+        sqe.user_data = slot;
+        sqe.fd = request.fd;
+        switch (request.op) {
+            case IoOp::OpenAt:
+                sqe.opcode = IORING_OP_OPENAT;
+                sqe.addr = reinterpret_cast<std::uintptr_t>(request.path);
+                sqe.len = 0666;
+                sqe.open_flags =
+                    static_cast<std::uint32_t>(request.flags | O_CLOEXEC);
+                break;
+            case IoOp::Stat:
+                sqe.opcode = IORING_OP_STATX;
+                sqe.addr = reinterpret_cast<std::uintptr_t>(request.path);
+                sqe.len = detail::StatxMask(request.fields);
+                sqe.off = reinterpret_cast<std::uintptr_t>(&slots_[slot].info);
+                sqe.statx_flags = detail::statx_flags;
+                break;
+            case IoOp::Read:
+                sqe.opcode = IORING_OP_READ;
+                sqe.addr =
+                    reinterpret_cast<std::uintptr_t>(request.into.data());
+                sqe.len = static_cast<std::uint32_t>(
+                    std::min(request.into.size(), detail::max_io_size));
+                sqe.off = static_cast<std::uint64_t>(request.offset);
+                break;
+            case IoOp::Write:
+                sqe.opcode = IORING_OP_WRITE;
+                sqe.addr =
+                    reinterpret_cast<std::uintptr_t>(request.from.data());
+                sqe.len = static_cast<std::uint32_t>(
+                    std::min(request.from.size(), detail::max_io_size));
+                sqe.off = static_cast<std::uint64_t>(request.offset);
+                break;
+        }
+    }
+
+    void Finish(IoRequest& request, std::size_t slot, std::int32_t res) {
+        request.result = res;
+        switch (request.op) {
+            case IoOp::OpenAt:
+                break;
+            case IoOp::Stat:
+                detail::CountSyscall(detail::StatsSyscall::Stat);
+                if (res == 0) {
+                    request.status = detail::FromStatx(slots_[slot].info);
+                }
+                break;
+            case IoOp::Read:
+                detail::CountSyscall(detail::StatsSyscall::Read, res);
+                break;
+            case IoOp::Write:
+                detail::CountSyscall(detail::StatsSyscall::Write, res);
+                break;
+        }
+    }
+
+    /// Where an operation in flight keeps what the kernel writes back
+    struct Slot final {
+        std::size_t request;
+        struct statx info;
+    };
+
+    bool tried_ring_{false};
+    std::unique_ptr<Ring> ring_{};
+    std::vector<Slot> slots_{};
+#endif
+};
+
+/// Looks up every entry of dir into results (which must be as long as
+/// entries), as StatAll does, with the lookups batched through engine
+inline void StatAll(IoEngine& engine, const DirectoryReader& dir,
+                    std::span<const DirectoryEntry> entries, StatField fields,
+                    std::span<StatResult> results) {
+#if defined(_WIN32)
+    StatAll(dir, entries, fields, results, engine.threads());
+#else
+    std::vector<IoRequest> requests{};
+    requests.reserve(entries.size());
+    for (const DirectoryEntry& entry : entries) {
+        requests.push_back(
+            IoRequest::Stat(dir.fd(), entry.name.data(), fields));
+    }
+    engine.Run(requests);
+    for (std::size_t i{0}; i < requests.size(); ++i) {
+        results[i] = requests[i].result < 0
+                         ? StatResult{std::unexpected{requests[i].error()}}
+                         : StatResult{requests[i].status};
+    }
+#endif
+}
+
+}  // namespace coreutils
+
+#endif  // LIB_ASYNCIO_HPP_
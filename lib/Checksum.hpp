@@ -0,0 +1,190 @@
+///
+///  @file Checksum.hpp
+///  @brief MD5, SHA-256 and BLAKE2b hashing of buffers and files
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_CHECKSUM_HPP_
+#define LIB_CHECKSUM_HPP_
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include "FileInput.hpp"
+#include "detail/Checksum.hpp"
+
+namespace coreutils {
+
+/// Every hash is fed with Update, any number of times, and gives its digest
+/// once, from Finish
+template <class Hash>
+concept Hasher = requires(Hash hash, std::span<const char> data) {
+    { Hash::digest_size } -> std::convertible_to<std::size_t>;
+    /// What the BSD style (--tag) lines call the hash
+    { Hash::tag } -> std::convertible_to<std::string_view>;
+    hash.Update(data);
+    {
+        hash.Finish()
+    } -> std::same_as<std::array<std::uint8_t, Hash::digest_size>>;
+};
+
+class Md5 final {
+ public:
+    static constexpr std::size_t digest_size{16};
+    static constexpr std::string_view tag{"MD5"};
+
+    void Update(std::span<const char> data) {
+        length_ += data.size();
+        buffer_.Feed(data, [this](const unsigned char* blocks,
+                                  std::size_t count) {
+            detail::Md5Blocks(state_, blocks, count);
+        });
+    }
+
+    std::array<std::uint8_t, digest_size> Finish() {
+        detail::PadBlocks<false>(
+            buffer_, length_,
+            [this](const unsigned char* blocks, std::size_t count) {
+                detail::Md5Blocks(state_, blocks, count);
+            });
+        std::array<std::uint8_t, digest_size> digest{};
+        for (std::size_t i{0}; i < state_.size(); ++i) {
+            detail::StoreLittle(state_[i], digest.data() + 4 * i);
+        }
+        return digest;
+    }
+
+ private:
+    std::array<std::uint32_t, 4> state_{0x67452301, 0xefcdab89, 0x98badcfe,
+                                        0x10325476};
+    detail::BlockBuffer<64> buffer_{};
+    std::uint64_t length_{0};
+};
+
+/// Uses the SHA extensions where the CPU has them (most x86 CPUs since
+/// 2017), which are several times faster than doing the rounds by hand
+class Sha256 final {
+ public:
+    static constexpr std::size_t digest_size{32};
+    static constexpr std::string_view tag{"SHA256"};
+
+    void Update(std::span<const char> data) {
+        length_ += data.size();
+        buffer_.Feed(data, [this](const unsigned char* blocks,
+                                  std::size_t count) {
+            kernel_(state_, blocks, count);
+        });
+    }
+
+    std::array<std::uint8_t, digest_size> Finish() {
+        detail::PadBlocks<true>(
+            buffer_, length_,
+            [this](const unsigned char* blocks, std::size_t count) {
+                kernel_(state_, blocks, count);
+            });
+        std::array<std::uint8_t, digest_size> digest{};
+        for (std::size_t i{0}; i < state_.size(); ++i) {
+            detail::StoreBig(state_[i], digest.data() + 4 * i);
+        }
+        return digest;
+    }
+
+ private:
+    detail::Sha256State state_{0x6a09e667, 0xbb67ae85, 0x3c6ef372,
+                               0xa54ff53a, 0x510e527f, 0x9b05688c,
+                               0x1f83d9ab, 0x5be0cd19};
+    detail::Sha256Kernel kernel_{detail::Sha256Blocks()};
+    detail::BlockBuffer<64> buffer_{};
+    std::uint64_t length_{0};
+};
+
+/// BLAKE2b-512, unkeyed, which is what b2sum computes by default
+class Blake2b final {
+ public:
+    static constexpr std::size_t digest_size{64};
+    static constexpr std::string_view tag{"BLAKE2b"};
+
+    Blake2b() {
+        state_.words = detail::blake2b_iv;
+        // the parameter block: digest length, no key, fanout and depth 1
+        state_.words[0] ^= 0x01010000 ^ digest_size;
+    }
+
+    void Update(std::span<const char> data) {
+        buffer_.Feed(data, [this](const unsigned char* blocks,
+                                  std::size_t count) {
+            detail::Blake2bBlocks(state_, blocks, count, false);
+        });
+    }
+
+    std::array<std::uint8_t, digest_size> Finish() {
+        std::fill(buffer_.bytes.begin() +
+                      static_cast<std::ptrdiff_t>(buffer_.fill),
+                  buffer_.bytes.end(), 0);
+        detail::Blake2bBlocks(state_, buffer_.bytes.data(), 1, true,
+                              buffer_.fill);
+        std::array<std::uint8_t, digest_size> digest{};
+        for (std::size_t i{0}; i < state_.words.size(); ++i) {
+            detail::StoreLittle(state_.words[i], digest.data() + 8 * i);
+        }
+        return digest;
+    }
+
+ private:
+    detail::Blake2bState state_{};
+    detail::BlockBuffer<128, true> buffer_{};
+};
+
+/// Lower case hexadecimal, as the *sum utilities print digests
+inline std::string ToHex(std::span<const std::uint8_t> digest) {
+    constexpr std::string_view digits{"0123456789abcdef"};
+    std::string hex(digest.size() * 2, '\0');
+    for (std::size_t i{0}; i < digest.size(); ++i) {
+        hex[2 * i] = digits[digest[i] >> 4];
+        hex[2 * i + 1] = digits[digest[i] & 0xf];
+    }
+    return hex;
+}
+
+/// Hashes everything left in fd, reading through buffer (which should be
+/// big enough that reads are not what the time goes to), and returns the
+/// digest in hexadecimal. It never maps fd, so that a file that shrinks
+/// while it is hashed gives a read error rather than SIGBUS.
+template <Hasher Hash>
+std::expected<std::string, std::error_code> HashFile(int fd,
+                                                     std::span<char> buffer) {
+    Hash hash{};
+    InputSource source{fd, InputSource::never_map};
+    if (const std::error_code error{source.ForEachChunk(
+            buffer, [&hash](std::span<const char> data) {
+                hash.Update(data);
+            })}) {
+        return std::unexpected{error};
+    }
+    return ToHex(hash.Finish());
+}
+
+}  // namespace coreutils
+
+#endif  // LIB_CHECKSUM_HPP_
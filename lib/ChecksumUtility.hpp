@@ -0,0 +1,509 @@
+///
+///  @file ChecksumUtility.hpp
+///  @brief the shared body of md5sum, sha256sum and b2sum
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_CHECKSUMUTILITY_HPP_
+#define LIB_CHECKSUMUTILITY_HPP_
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <expected>
+#include <format>
+#include <iostream>
+#include <optional>
+#include <print>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "ArgumentParser.hpp"
+#include "Checksum.hpp"
+#include "FileCopy.hpp"
+#include "FileInput.hpp"
+#include "Output.hpp"
+#include "Parallel.hpp"
+
+namespace coreutils {
+
+/// A file name and the digest it is supposed to have, from a line of a
+/// checksum list
+struct ChecksumLine final {
+    std::string name;
+    /// Lower case hexadecimal
+    std::string digest;
+};
+
+/// Names with backslashes or line breaks in them are written with those
+/// escaped, and the line they are on starts with a backslash, as GNU does
+inline bool NeedsEscape(std::string_view name) {
+    return name.find_first_of("\\\n\r") != std::string_view::npos;
+}
+
+inline std::string Escape(std::string_view name) {
+    std::string escaped{};
+    escaped.reserve(name.size());
+    for (const char c : name) {
+        switch (c) {
+            case '\\':
+                escaped.append("\\\\");
+                break;
+            case '\n':
+                escaped.append("\\n");
+                break;
+            case '\r':
+                escaped.append("\\r");
+                break;
+            default:
+                escaped.push_back(c);
+                break;
+        }
+    }
+    return escaped;
+}
+
+/// Parses a line as written by a *sum utility for tag, whether GNU style
+/// ("<digest>  <name>", or " *<name>" for binary mode) or BSD style
+/// ("<tag> (<name>) = <digest>"). Returns nothing if the line is neither.
+inline std::optional<ChecksumLine> ParseChecksumLine(std::string_view line,
+                                                     std::string_view tag,
+                                                     std::size_t digest_size) {
+    const bool escaped{line.starts_with('\\')};
+    if (escaped) {
+        line.remove_prefix(1);
+    }
+
+    std::string_view name{};
+    std::string_view digest{};
+    if (line.starts_with(tag) && line.substr(tag.size()).starts_with(" (")) {
+        const std::size_t end{line.rfind(") = ")};
+        if (end == std::string_view::npos || end < tag.size() + 2) {
+            return std::nullopt;
+        }
+        name = line.substr(tag.size() + 2, end - tag.size() - 2);
+        digest = line.substr(end + 4);
+    } else {
+        digest = line.substr(0, std::min(line.size(), 2 * digest_size));
+        const std::string_view rest{line.substr(digest.size())};
+        if (rest.size() < 3 || rest[0] != ' ' ||
+            (rest[1] != ' ' && rest[1] != '*')) {
+            return std::nullopt;
+        }
+        name = rest.substr(2);
+    }
+
+    if (digest.size() != 2 * digest_size || name.empty() ||
+        !std::ranges::all_of(digest, [](char c) {
+            return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') ||
+                   (c >= 'A' && c <= 'F');
+        })) {
+        return std::nullopt;
+    }
+
+    ChecksumLine parsed{.name = {}, .digest = std::string{digest}};
+    std::ranges::transform(parsed.digest, parsed.digest.begin(), [](char c) {
+        return c >= 'A' && c <= 'F' ? static_cast<char>(c - 'A' + 'a') : c;
+    });
+    if (!escaped) {
+        parsed.name = name;
+        return parsed;
+    }
+    for (std::size_t i{0}; i < name.size(); ++i) {
+        if (name[i] != '\\') {
+            parsed.name.push_back(name[i]);
+            continue;
+        } else if (++i == name.size()) {
+            return std::nullopt;
+        }
+        switch (name[i]) {
+            case '\\':
+                parsed.name.push_back('\\');
+                break;
+            case 'n':
+                parsed.name.push_back('\n');
+                break;
+            case 'r':
+                parsed.name.push_back('\r');
+                break;
+            default:
+                return std::nullopt;
+        }
+    }
+    return parsed;
+}
+
+namespace detail {
+
+/// Runs read on a file opened for reading, or on standard input for "-"
+template <class Read>
+auto WithInput(const std::string& path, Read&& read)
+    -> std::invoke_result_t<Read&, int> {
+    const std::expected<InputFile, std::error_code> input{
+        InputFile::Open(path.c_str())};
+    if (!input) {
+        return std::unexpected{input.error()};
+    }
+    return read(input->fd());
+}
+
+using Digest = std::expected<std::string, std::error_code>;
+
+template <Hasher Hash>
+Digest HashPath(const std::string& path) {
+    // every worker reads through a buffer of its own, kept for its next file
+    thread_local CopyBuffer buffer{};
+    return WithInput(path, [](int fd) {
+        return HashFile<Hash>(fd, buffer.span());
+    });
+}
+
+/// HashPath, except that standard input is left for the caller. It can only
+/// be read once, front to back, so it is hashed where the results are taken
+/// in order: all of it for the first "-", and nothing for any later one.
+template <Hasher Hash>
+std::optional<Digest> HashUnlessStdin(const std::string& path) {
+    if (path == "-") {
+        return std::nullopt;
+    }
+    return HashPath<Hash>(path);
+}
+
+inline std::expected<std::string, std::error_code> ReadWhole(
+    const std::string& path) {
+    return WithInput(
+        path, [](int fd) -> std::expected<std::string, std::error_code> {
+            std::string text{};
+            CopyBuffer buffer{};
+            InputSource source{fd, InputSource::never_map};
+            if (const std::error_code error{source.ForEachChunk(
+                    buffer.span(), [&text](std::span<const char> data) {
+                        text.append(data.data(), data.size());
+                    })}) {
+                return std::unexpected{error};
+            }
+            return text;
+        });
+}
+
+struct ChecksumOptions final {
+    std::string_view program;
+    bool binary;
+    bool tag;
+    bool quiet;
+    bool status;
+    bool warn;
+    bool strict;
+    std::size_t threads;
+};
+
+/// Errors go to (unbuffered) stderr, so what is before them on stdout is
+/// flushed first to keep the two in order on a terminal
+inline void ReportChecksumError(Output& out, std::string_view program,
+                                std::string_view message) {
+    out.Flush();
+    std::println(std::cerr, "{}: {}", program, message);
+}
+
+/// Prints the digest of every file, in order, while hashing them on up to
+/// threads threads at once. Returns the exit status.
+template <Hasher Hash>
+int PrintChecksums(const std::vector<std::string>& files,
+                   const ChecksumOptions& options, Output& out) {
+    int status{0};
+    ParallelOrdered(
+        files.size(), options.threads,
+        [&files](std::size_t i) { return HashUnlessStdin<Hash>(files[i]); },
+        [&](std::size_t i, std::optional<Digest> hashed) {
+            const std::string& file{files[i]};
+            const Digest digest{hashed ? std::move(*hashed)
+                                       : HashPath<Hash>(file)};
+            if (!digest) {
+                ReportChecksumError(
+                    out, options.program,
+                    std::format("{}: {}", file, digest.error().message()));
+                status = 1;
+                return;
+            }
+
+            const bool escape{NeedsEscape(file)};
+            const std::string name{escape ? Escape(file) : file};
+            if (escape) {
+                out.Put('\\');
+            }
+            if (options.tag) {
+                out.Write(Hash::tag).Write(" (").Write(name).Write(") = ");
+                out.Write(*digest);
+            } else {
+                out.Write(*digest).Put(' ').Put(options.binary ? '*' : ' ');
+                out.Write(name);
+            }
+            out.Put('\n');
+        });
+    return status;
+}
+
+/// "1 line is", "2 lines are"
+inline std::string Count(std::size_t count, std::string_view singular,
+                         std::string_view plural) {
+    return std::format("{} {}", count, count == 1 ? singular : plural);
+}
+
+/// Checks every file listed in list against its digest, hashing them on
+/// up to threads threads at once. Returns the exit status.
+template <Hasher Hash>
+int CheckChecksums(const std::string& list, const ChecksumOptions& options,
+                   Output& out) {
+    const std::string_view shown{list == "-" ? "'standard input'"
+                                             : std::string_view{list}};
+    const std::expected<std::string, std::error_code> text{ReadWhole(list)};
+    if (!text) {
+        ReportChecksumError(
+            out, options.program,
+            std::format("{}: {}", shown, text.error().message()));
+        return 1;
+    }
+
+    struct Entry final {
+        /// Nothing for lines that are not checksum lines
+        std::optional<ChecksumLine> line;
+        std::size_t number;
+    };
+    std::vector<Entry> entries{};
+    std::string_view rest{*text};
+    for (std::size_t number{1}; !rest.empty(); ++number) {
+        const std::size_t end{std::min(rest.find('\n'), rest.size())};
+        std::string_view line{rest.substr(0, end)};
+        rest.remove_prefix(std::min(end + 1, rest.size()));
+        if (line.ends_with('\r')) {
+            line.remove_suffix(1);
+        }
+        if (!line.starts_with('#')) {
+            entries.push_back(
+                {.line = ParseChecksumLine(line, Hash::tag,
+                                           Hash::digest_size),
+                 .number = number});
+        }
+    }
+
+    std::size_t malformed{0};
+    std::size_t unreadable{0};
+    std::size_t mismatched{0};
+    std::size_t checked{0};
+    ParallelOrdered(
+        entries.size(), options.threads,
+        [&entries](std::size_t i) -> std::optional<Digest> {
+            if (!entries[i].line) {
+                return std::nullopt;
+            }
+            return HashUnlessStdin<Hash>(entries[i].line->name);
+        },
+        [&](std::size_t i, std::optional<Digest> hashed) {
+            const Entry& entry{entries[i]};
+            if (!entry.line) {
+                ++malformed;
+                if (options.warn) {
+                    ReportChecksumError(
+                        out, options.program,
+                        std::format("{}: {}: improperly formatted {} "
+                                    "checksum line",
+                                    shown, entry.number, Hash::tag));
+                }
+                return;
+            }
+
+            ++checked;
+            const std::string& name{entry.line->name};
+            const Digest digest{hashed ? std::move(*hashed)
+                                       : HashPath<Hash>(name)};
+            // only line breaks are escaped here, as GNU does
+            const bool escape{name.find_first_of("\n\r") !=
+                              std::string::npos};
+            const auto result = [&](std::string_view what) {
+                if (options.status) {
+                    return;
+                }
+                if (escape) {
+                    out.Put('\\');
+                }
+                out.Write(escape ? Escape(name) : name).Write(": ");
+                out.Write(what).Put('\n');
+            };
+            if (!digest) {
+                ++unreadable;
+                ReportChecksumError(
+                    out, options.program,
+                    std::format("{}: {}", name, digest.error().message()));
+                result("FAILED open or read");
+            } else if (*digest != entry.line->digest) {
+                ++mismatched;
+                result("FAILED");
+            } else if (!options.quiet) {
+                result("OK");
+            }
+        });
+
+    if (checked == 0) {
+        ReportChecksumError(
+            out, options.program,
+            std::format("{}: no properly formatted checksum lines found",
+                        shown));
+        return 1;
+    }
+    if (!options.status) {
+        if (malformed > 0) {
+            ReportChecksumError(
+                out, options.program,
+                std::format("WARNING: {} improperly formatted",
+                            Count(malformed, "line is", "lines are")));
+        }
+        if (unreadable > 0) {
+            ReportChecksumError(
+                out, options.program,
+                std::format("WARNING: {} not be read",
+                            Count(unreadable, "listed file could",
+                                  "listed files could")));
+        }
+        if (mismatched > 0) {
+            ReportChecksumError(
+                out, options.program,
+                std::format("WARNING: {} did NOT match",
+                            Count(mismatched, "computed checksum",
+                                  "computed checksums")));
+        }
+    }
+    return mismatched > 0 || unreadable > 0 ||
+                   (options.strict && malformed > 0)
+               ? 1
+               : 0;
+}
+
+inline std::optional<std::size_t> ParseJobs(std::string_view arg) {
+    std::size_t jobs{};
+    const std::from_chars_result result{
+        std::from_chars(arg.data(), arg.data() + arg.size(), jobs)};
+    if (result.ec != std::errc{} || result.ptr != arg.data() + arg.size() ||
+        jobs == 0) {
+        return std::nullopt;
+    }
+    return jobs;
+}
+
+}  // namespace detail
+
+/// The whole of md5sum, sha256sum and b2sum, which differ only in their
+/// hash. Files are hashed several at a time, and printed (or checked) in
+/// the order they were given.
+template <Hasher Hash, IsProgramInfo Program>
+int ChecksumMain(int argc, const char** argv) {
+    constexpr auto identity = [](std::string_view arg) { return arg; };
+    using PosArgs =
+        PositionalArguments<std::string_view, identity, ArgvView>;
+    using Binary = BooleanArgument<"-b", "--binary">;
+    using Check = BooleanArgument<"-c", "--check">;
+    using Tag = BooleanArgument<"--tag">;
+    using Text = BooleanArgument<"-t", "--text">;
+    using Quiet = BooleanArgument<"--quiet">;
+    using Status = BooleanArgument<"--status">;
+    using Strict = BooleanArgument<"--strict">;
+    using Warn = BooleanArgument<"-w", "--warn">;
+    using Jobs =
+        SingleValueArgument<std::string_view, identity, "-j", "--jobs">;
+    ArgumentParser<Program, PosArgs, Binary, Check, Tag, Text, Quiet, Status,
+                   Strict, Warn, Jobs>
+        parser{argc, argv};
+    parser.ParseArgsOrExit();
+
+    detail::ChecksumOptions options{
+        .program = Program::name.PrintableView(),
+        .binary = parser.template get<Binary>().value &&
+                  !parser.template get<Text>().value,
+        .tag = parser.template get<Tag>().value,
+        .quiet = parser.template get<Quiet>().value,
+        .status = parser.template get<Status>().value,
+        .warn = parser.template get<Warn>().value,
+        .strict = parser.template get<Strict>().value,
+        // hashing one file is bound by the CPU or by the disk, and many at
+        // once keep both busy (and a network filesystem's pipeline full)
+        .threads = std::max<std::size_t>(DefaultConcurrency(), 4),
+    };
+    const bool check{parser.template get<Check>().value};
+    const auto usage_error = [&options](std::string_view message) {
+        std::println(std::cerr,
+                     "{}: {}\nTry '{} --help' for more information.",
+                     options.program, message, options.program);
+        return 1;
+    };
+    if (check && options.tag) {
+        return usage_error(
+            "the --tag option is meaningless when verifying checksums");
+    } else if (check && options.binary) {
+        return usage_error(
+            "the --binary and --text options are meaningless when verifying "
+            "checksums");
+    } else if (!check && (options.quiet || options.status || options.warn ||
+                          options.strict)) {
+        return usage_error(std::format(
+            "the {} option is meaningful only when verifying checksums",
+            options.quiet    ? "--quiet"
+            : options.status ? "--status"
+            : options.warn   ? "--warn"
+                             : "--strict"));
+    }
+    if (const std::string_view jobs{parser.template get<Jobs>().value};
+        !jobs.empty()) {
+        const std::optional<std::size_t> parsed{detail::ParseJobs(jobs)};
+        if (!parsed) {
+            std::println(std::cerr, "{}: invalid number of jobs: '{}'",
+                         options.program, jobs);
+            return 1;
+        }
+        options.threads = *parsed;
+    }
+
+    const auto& names{parser.template get<PosArgs>().value};
+    std::vector<std::string> files(names.begin(), names.end());
+    if (files.empty()) {
+        files.emplace_back("-");
+    }
+
+    Output out{};
+    int status{0};
+    if (check) {
+        for (const std::string& list : files) {
+            status = detail::CheckChecksums<Hash>(list, options, out) != 0
+                         ? 1
+                         : status;
+        }
+    } else {
+        status = detail::PrintChecksums<Hash>(files, options, out);
+    }
+    if (const std::error_code error{out.Flush()}; error) {
+        std::println(std::cerr, "{}: write error: {}", options.program,
+                     error.message());
+        return 1;
+    }
+    return status;
+}
+
+}  // namespace coreutils
+
+#endif  // LIB_CHECKSUMUTILITY_HPP_
@@ -0,0 +1,239 @@
+///
+///  @file DirectoryReader.hpp
+///  @brief allocation-light directory listing for coreutilspp
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_DIRECTORYREADER_HPP_
+#define LIB_DIRECTORYREADER_HPP_
+
+#include <cerrno>
+#include <concepts>
+#include <cstddef>
+#include <expected>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+#include "Arena.hpp"
+#include "detail/DirectoryReader.hpp"
+#include "detail/Stats.hpp"
+
+namespace coreutils {
+
+using detail::FileType;
+
+struct DirectoryEntry final {
+    std::string_view name;
+    FileType type;
+};
+
+/// An open directory. On POSIX systems this owns a directory file descriptor
+/// so that entries (and subdirectories) can be reached relative to it with
+/// the *at family of calls, instead of re-resolving full paths.
+///
+/// On Linux entries are pulled out of the kernel in large getdents64 batches,
+/// so listing a directory with millions of entries costs a few hundred
+/// syscalls and no per-entry heap allocations.
+class DirectoryReader final {
+ public:
+    /// How many bytes of directory entries to ask the kernel for at once
+    static constexpr std::size_t batch_size{128 * 1024};
+
+    /// path must be null terminated
+    static std::expected<DirectoryReader, std::error_code> Open(
+        const char* path) {
+#if defined(_WIN32)
+        std::error_code error{};
+        if (std::filesystem::is_directory(path, error)) {
+            return DirectoryReader{std::filesystem::path{path}};
+        }
+        return std::unexpected{
+            error ? error : std::make_error_code(std::errc::not_a_directory)};
+#else
+        return OpenAt(AT_FDCWD, path);
+#endif
+    }
+
+    /// Opens the directory name found inside of parent. name must be null
+    /// terminated (names stored by ReadAll are).
+    static std::expected<DirectoryReader, std::error_code> Open(
+        const DirectoryReader& parent, const char* name) {
+#if defined(_WIN32)
+        return Open((parent.path_ / name).string().c_str());
+#else
+        return OpenAt(parent.fd_, name);
+#endif
+    }
+
+    DirectoryReader(const DirectoryReader&) = delete;
+    DirectoryReader& operator=(const DirectoryReader&) = delete;
+
+#if defined(_WIN32)
+    DirectoryReader(DirectoryReader&&) = default;
+    DirectoryReader& operator=(DirectoryReader&&) = default;
+
+    const std::filesystem::path& path() const { return path_; }
+#else
+    DirectoryReader(DirectoryReader&& other) noexcept
+        : fd_{std::exchange(other.fd_, -1)} {}
+    DirectoryReader& operator=(DirectoryReader&& other) noexcept {
+        std::swap(fd_, other.fd_);
+        return *this;
+    }
+    ~DirectoryReader() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    /// The underlying directory file descriptor, for use with *at calls
+    int fd() const { return fd_; }
+#endif
+
+    /// Calls fn with every entry in the directory (including "." and "..")
+    /// in the order the filesystem returns them. The name inside of each
+    /// entry is only valid for the duration of the call. A directory can
+    /// only be walked once.
+    template <class Fn>
+        requires std::invocable<Fn&, const DirectoryEntry&>
+    std::error_code ForEach(Fn&& fn) {
+#if defined(__linux__)
+        const std::unique_ptr<std::byte[]> buffer{
+            std::make_unique_for_overwrite<std::byte[]>(batch_size)};
+        while (true) {
+            long read{0};
+            {
+                const detail::StatsTimer timer{detail::StatsPhase::Io};
+                read = ::syscall(SYS_getdents64, fd_, buffer.get(), batch_size);
+                detail::CountSyscall(detail::StatsSyscall::Directory);
+            }
+            if (read == 0) {
+                return {};
+            } else if (read < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return {errno, std::system_category()};
+            }
+
+            for (std::size_t offset{0};
+                 offset < static_cast<std::size_t>(read);) {
+                const detail::RawDirent record{buffer.get() + offset};
+                fn(DirectoryEntry{
+                    .name = record.Name(),
+                    .type = detail::FromDirentType(record.Type()),
+                });
+                offset += record.RecordLength();
+            }
+        }
+#elif defined(_WIN32)
+        std::error_code error{};
+        for (std::filesystem::directory_iterator it{path_, error}, end{};
+             !error && it != end; it.increment(error)) {
+            const std::string name{it->path().filename().string()};
+            fn(DirectoryEntry{
+                .name = name,
+                .type = detail::FromFilesystemType(
+                    it->symlink_status(error).type()),
+            });
+        }
+        return error;
+#else
+        const int duplicate{::dup(fd_)};
+        DIR* const dir{duplicate >= 0 ? ::fdopendir(duplicate) : nullptr};
+        if (!dir) {
+            const std::error_code error{errno, std::system_category()};
+            if (duplicate >= 0) {
+                ::close(duplicate);
+            }
+            return error;
+        }
+
+        std::error_code error{};
+        while (true) {
+            errno = 0;
+            const dirent* const entry{::readdir(dir)};
+            detail::CountSyscall(detail::StatsSyscall::Directory);
+            if (!entry) {
+                if (errno != 0) {
+                    error = {errno, std::system_category()};
+                }
+                break;
+            }
+            fn(DirectoryEntry{
+                .name = entry->d_name,
+                .type = detail::FromDirentType(entry->d_type),
+            });
+        }
+        ::closedir(dir);
+        return error;
+#endif
+    }
+
+    /// Appends every entry to out. Names are copied into arena, so they
+    /// outlive both the call and the reader.
+    std::error_code ReadAll(Arena& arena, std::vector<DirectoryEntry>& out) {
+        return ForEach([&arena, &out](const DirectoryEntry& entry) {
+            out.push_back({
+                .name = arena.Store(entry.name),
+                .type = entry.type,
+            });
+        });
+    }
+
+ private:
+#if defined(_WIN32)
+    explicit DirectoryReader(std::filesystem::path path)
+        : path_{std::move(path)} {}
+
+    std::filesystem::path path_;
+#else
+    explicit DirectoryReader(int fd) : fd_{fd} {}
+
+    static std::expected<DirectoryReader, std::error_code> OpenAt(
+        int parent, const char* name) {
+        const int fd{
+            ::openat(parent, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC)};
+        if (fd < 0) {
+            return std::unexpected{
+                std::error_code{errno, std::system_category()}};
+        }
+        return DirectoryReader{fd};
+    }
+
+    int fd_{-1};
+#endif
+};
+
+}  // namespace coreutils
+
+#endif  // LIB_DIRECTORYREADER_HPP_
@@ -0,0 +1,247 @@
+///
+///  @file Escapes.hpp
+///  @brief backslash escape decoding shared by echo and printf
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_ESCAPES_HPP_
+#define LIB_ESCAPES_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <format>
+#include <string>
+#include <string_view>
+
+namespace coreutils {
+
+/// The three slightly different escape languages of echo and printf
+enum class EscapeStyle : std::uint8_t {
+    /// echo -e: \0NNN and \NNN octal, and \xHH. Anything else (including a
+    /// \x with no digits) is left as it is.
+    Echo,
+    /// printf's FORMAT: \NNN octal, \xHH, \uHHHH, \UHHHHHHHH and \"
+    PrintfFormat,
+    /// printf's %b arguments: the same as FORMAT, but with echo's octal
+    PrintfArgument,
+};
+
+/// How a piece of escaped text ended
+enum class EscapeEnd : std::uint8_t {
+    Finished,
+    /// At a \c, which means no further output at all
+    Stopped,
+};
+
+/// The error is a message, e.g. "missing hexadecimal number in escape"
+using EscapeResult = std::expected<EscapeEnd, std::string>;
+
+namespace detail {
+
+enum class EscapeKind : std::uint8_t {
+    /// Backslash and all are kept
+    Unknown,
+    /// Stands for byte
+    Byte,
+    Octal,
+    Hex,
+    Unicode,
+    Stop,
+    /// \", which only printf knows
+    Quote,
+};
+
+struct EscapeEntry final {
+    EscapeKind kind;
+    char byte;
+};
+
+/// What follows a backslash, by the byte that does
+inline constexpr std::array<EscapeEntry, 256> escape_table{[]() {
+    std::array<EscapeEntry, 256> table{};
+    constexpr std::string_view letters{"\\abefnrtv"};
+    constexpr std::string_view bytes{"\\\a\b\x1b\f\n\r\t\v"};
+    for (std::size_t i{0}; i < letters.size(); ++i) {
+        table[static_cast<unsigned char>(letters[i])] = {EscapeKind::Byte,
+                                                         bytes[i]};
+    }
+    for (char digit{'0'}; digit <= '7'; ++digit) {
+        table[static_cast<unsigned char>(digit)] = {EscapeKind::Octal, 0};
+    }
+    table['x'] = {EscapeKind::Hex, 0};
+    table['u'] = {EscapeKind::Unicode, 0};
+    table['U'] = {EscapeKind::Unicode, 0};
+    table['c'] = {EscapeKind::Stop, 0};
+    table['"'] = {EscapeKind::Quote, '"'};
+    return table;
+}()};
+
+constexpr int HexDigit(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+/// Reads up to limit hex digits off the front of text
+constexpr std::size_t ReadHex(std::string_view& text, std::size_t limit,
+                              std::uint32_t& value) {
+    std::size_t digits{0};
+    for (; digits < limit && digits < text.size() &&
+           HexDigit(text[digits]) >= 0;
+         ++digits) {
+        value = value * 16 + static_cast<std::uint32_t>(HexDigit(text[digits]));
+    }
+    text.remove_prefix(digits);
+    return digits;
+}
+
+inline void AppendUtf8(std::uint32_t code, std::string& out) {
+    if (code < 0x80) {
+        out.push_back(static_cast<char>(code));
+    } else if (code < 0x800) {
+        out.push_back(static_cast<char>(0xc0 | (code >> 6)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+    } else if (code < 0x10000) {
+        out.push_back(static_cast<char>(0xe0 | (code >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+    } else {
+        out.push_back(static_cast<char>(0xf0 | (code >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3f)));
+        out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+    }
+}
+
+}  // namespace detail
+
+/// Decodes the one escape at the front of text (which starts with its
+/// backslash) onto out, and moves text past it. For callers that give
+/// other characters a meaning too, like the % of printf's FORMAT.
+inline EscapeResult AppendEscape(std::string_view& text, EscapeStyle style,
+                                 std::string& out) {
+    using detail::EscapeKind;
+    text.remove_prefix(1);
+    if (text.empty()) {
+        out.push_back('\\');
+        return EscapeEnd::Finished;
+    }
+
+    const char c{text.front()};
+    const detail::EscapeEntry entry{
+        detail::escape_table[static_cast<unsigned char>(c)]};
+    EscapeKind kind{entry.kind};
+    if ((kind == EscapeKind::Quote || kind == EscapeKind::Unicode) &&
+        style == EscapeStyle::Echo) {
+        kind = EscapeKind::Unknown;
+    }
+    switch (kind) {
+        case EscapeKind::Byte:
+        case EscapeKind::Quote:
+            out.push_back(entry.byte);
+            text.remove_prefix(1);
+            break;
+        case EscapeKind::Stop:
+            return EscapeEnd::Stopped;
+        case EscapeKind::Octal: {
+            // \0 leads up to three more digits, except in FORMAT, where it
+            // is the first of three
+            if (c == '0' && style != EscapeStyle::PrintfFormat) {
+                text.remove_prefix(1);
+            }
+            unsigned value{0};
+            std::size_t digits{0};
+            for (; digits < 3 && digits < text.size() &&
+                   text[digits] >= '0' && text[digits] <= '7';
+                 ++digits) {
+                value = value * 8 + static_cast<unsigned>(text[digits] - '0');
+            }
+            text.remove_prefix(digits);
+            out.push_back(static_cast<char>(value & 0xff));
+            break;
+        }
+        case EscapeKind::Hex: {
+            text.remove_prefix(1);
+            std::uint32_t value{0};
+            if (detail::ReadHex(text, 2, value) > 0) {
+                out.push_back(static_cast<char>(value));
+            } else if (style == EscapeStyle::Echo) {
+                out.append("\\x");
+            } else {
+                return std::unexpected{
+                    std::string{"missing hexadecimal number in escape"}};
+            }
+            break;
+        }
+        case EscapeKind::Unicode: {
+            text.remove_prefix(1);
+            const std::size_t length{c == 'u' ? 4u : 8u};
+            std::uint32_t code{0};
+            if (detail::ReadHex(text, length, code) != length) {
+                return std::unexpected{
+                    std::string{"missing hexadecimal number in escape"}};
+            }
+            // as in C, only $, @ and ` may be spelled this way below U+00A0,
+            // and surrogates never may
+            if ((code < 0xa0 && code != '$' && code != '@' && code != '`') ||
+                (code >= 0xd800 && code <= 0xdfff) || code > 0x10ffff) {
+                return std::unexpected{
+                    std::format("invalid universal character name \\{}{:0{}x}",
+                                c, code, length)};
+            }
+            detail::AppendUtf8(code, out);
+            break;
+        }
+        case EscapeKind::Unknown:
+            out.push_back('\\');
+            out.push_back(c);
+            text.remove_prefix(1);
+            break;
+    }
+    return EscapeEnd::Finished;
+}
+
+/// Appends text to out with its backslash escapes decoded. The runs between
+/// backslashes, which are usually nearly all of the text, are found with
+/// memchr (which libc vectorizes) and copied whole, and what follows each
+/// backslash is looked up in a table.
+inline EscapeResult AppendUnescaped(std::string_view text, EscapeStyle style,
+                                    std::string& out) {
+    while (true) {
+        const std::size_t backslash{text.find('\\')};
+        out.append(text.substr(0, backslash));
+        if (backslash == std::string_view::npos) {
+            return EscapeEnd::Finished;
+        }
+        text.remove_prefix(backslash);
+        if (const EscapeResult result{AppendEscape(text, style, out)};
+            !result || *result == EscapeEnd::Stopped) {
+            return result;
+        }
+    }
+}
+
+}  // namespace coreutils
+
+#endif  // LIB_ESCAPES_HPP_
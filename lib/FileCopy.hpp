@@ -0,0 +1,167 @@
+///
+///  @file FileCopy.hpp
+///  @brief copying between file descriptors, in the kernel where possible
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_FILECOPY_HPP_
+#define LIB_FILECOPY_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <memory>
+#include <new>
+#include <span>
+#include <system_error>
+
+#if !defined(_WIN32)
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "detail/FileCopy.hpp"
+
+namespace coreutils {
+
+using detail::CopyError;
+using detail::CopyResult;
+
+/// One read, for callers that look at the data on its way through. Returns
+/// how much was read, 0 at end of file.
+inline std::expected<std::size_t, std::error_code> ReadSome(
+    int fd, std::span<char> buffer) {
+    return detail::ReadSome(fd, buffer);
+}
+
+/// One read at offset, for callers that jump around a file (e.g. reading it
+/// backward from the end). Returns how much was read, 0 at end of file.
+inline std::expected<std::size_t, std::error_code> ReadSomeAt(
+    int fd, std::span<char> buffer, std::uint64_t offset) {
+    return detail::ReadSomeAt(fd, buffer, offset);
+}
+
+/// A page aligned buffer for copies that have to go through userspace. Being
+/// aligned (and a multiple of the page size) lets the kernel take its fast
+/// paths, e.g. for O_DIRECT files and pipes.
+class CopyBuffer final {
+ public:
+    static constexpr std::size_t default_size{128 * 1024};
+
+    explicit CopyBuffer(std::size_t size = default_size)
+        : size_{(std::max<std::size_t>(size, 1) + alignment - 1) / alignment *
+                alignment},
+          data_{static_cast<char*>(
+              ::operator new(size_, std::align_val_t{alignment}))} {}
+
+    std::span<char> span() const { return {data_.get(), size_}; }
+
+ private:
+    static constexpr std::size_t alignment{4096};
+
+    struct Deleter final {
+        void operator()(char* data) const {
+            ::operator delete(data, std::align_val_t{alignment});
+        }
+    };
+
+    std::size_t size_;
+    std::unique_ptr<char[], Deleter> data_;
+};
+
+/// Copies everything from in's current offset to its end into out, by the
+/// cheapest way the kernel offers for the pair:
+///
+/// - copy_file_range between regular files
+/// - splice out of a pipe
+/// - sendfile from a file into a pipe or socket (or anything else)
+///
+/// and through buffer otherwise, or when the kernel turns those down.
+inline CopyResult CopyAll(int in, int out, std::span<char> buffer) {
+#if defined(__linux__)
+    struct stat from {};
+    struct stat to {};
+    if (::fstat(in, &from) == 0 && ::fstat(out, &to) == 0 &&
+        // empty regular files might be e.g. /proc files, which can be read
+        // but not copied by the kernel
+        !(S_ISREG(from.st_mode) && from.st_size == 0)) {
+        const bool has_pages{S_ISREG(from.st_mode) || S_ISBLK(from.st_mode)};
+        using Path = detail::FastCopyResult (*)(int, int);
+        std::array<Path, 2> paths{};
+        if (S_ISREG(from.st_mode) && S_ISREG(to.st_mode)) {
+            paths[0] = detail::CopyFileRange;
+        } else if (S_ISFIFO(from.st_mode)) {
+            paths[0] = detail::Splice;
+        } else if (has_pages) {
+            paths[0] = detail::SendFile;
+            paths[1] = S_ISFIFO(to.st_mode) ? detail::Splice : nullptr;
+        }
+
+        for (const Path path : paths) {
+            if (!path) {
+                break;
+            }
+            const detail::FastCopyResult copied{path(in, out)};
+            if (!copied) {
+                return std::unexpected{copied.error()};
+            } else if (*copied) {
+                return {};
+            }
+        }
+    }
+#endif
+    return detail::CopyBuffered(in, out, buffer);
+}
+
+/// Copies all of in, a regular file, into out, an empty regular file (e.g.
+/// one just created, or truncated), both starting from offset 0. Tries, in
+/// order:
+///
+/// - a reflink, after which the two files share their extents until either
+///   is written to
+/// - copying only the parts of in that hold data, when it has holes, so that
+///   out has the same holes (and takes no more space)
+/// - CopyAll, i.e. copy_file_range and then a buffered copy
+inline CopyResult CopyRegularFile(int in, int out, std::span<char> buffer) {
+#if !defined(_WIN32)
+#if defined(__linux__)
+    if (detail::Reflink(in, out)) {
+        return {};
+    }
+#endif
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+    struct stat status {};
+    if (::fstat(in, &status) != 0) {
+        return std::unexpected{CopyError{
+            std::error_code{errno, std::system_category()}, false}};
+    }
+    // fewer blocks than the size takes up means holes (or compression, or
+    // inline data, which CopySparse copies just as well)
+    if (S_ISREG(status.st_mode) && status.st_blocks * 512 < status.st_size) {
+        return detail::CopySparse(in, out, status.st_size, buffer);
+    }
+#endif
+#endif
+    return CopyAll(in, out, buffer);
+}
+
+}  // namespace coreutils
+
+#endif  // LIB_FILECOPY_HPP_
@@ -0,0 +1,292 @@
+///
+///  @file FileInput.hpp
+///  @brief opening inputs, and reading them by mapping or by large reads
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_FILEINPUT_HPP_
+#define LIB_FILEINPUT_HPP_
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "FileCopy.hpp"
+#include "MappedFile.hpp"
+
+namespace coreutils {
+
+/// An input file, or standard input for "-". Closes what it opened.
+class InputFile final {
+ public:
+    static constexpr int standard_input{0};
+
+    /// path must be null terminated
+    static std::expected<InputFile, std::error_code> Open(const char* path) {
+        if (std::string_view{path} == "-") {
+            return InputFile{standard_input, false};
+        }
+#if defined(_WIN32)
+        const int fd{::_open(path, _O_RDONLY | _O_BINARY)};
+#else
+        const int fd{::open(path, O_RDONLY | O_CLOEXEC)};
+#endif
+        if (fd < 0) {
+            return std::unexpected{
+                std::error_code{errno, std::system_category()}};
+        }
+        return InputFile{fd, true};
+    }
+
+    InputFile(const InputFile&) = delete;
+    InputFile& operator=(const InputFile&) = delete;
+    InputFile(InputFile&& other) noexcept
+        : fd_{other.fd_}, owned_{std::exchange(other.owned_, false)} {}
+    InputFile& operator=(InputFile&& other) noexcept {
+        std::swap(fd_, other.fd_);
+        std::swap(owned_, other.owned_);
+        return *this;
+    }
+
+    ~InputFile() {
+        if (owned_) {
+#if defined(_WIN32)
+            ::_close(fd_);
+#else
+            ::close(fd_);
+#endif
+        }
+    }
+
+    int fd() const { return fd_; }
+
+ private:
+    InputFile(int fd, bool owned) : fd_{fd}, owned_{owned} {}
+
+    int fd_;
+    bool owned_;
+};
+
+/// What is known about an input before reading it
+struct InputShape final {
+    bool regular;
+    /// Bytes from the current offset to the end, for regular files
+    std::uint64_t remaining;
+};
+
+namespace detail {
+
+#if !defined(_WIN32)
+inline InputShape ShapeOf(const struct stat& info, off_t offset) {
+    if (!S_ISREG(info.st_mode)) {
+        return InputShape{};
+    }
+    return InputShape{
+        .regular = true,
+        .remaining = offset >= 0 && offset < info.st_size
+                         ? static_cast<std::uint64_t>(info.st_size - offset)
+                         : 0,
+    };
+}
+#endif
+
+}  // namespace detail
+
+/// Looks at an open input, from its current offset
+inline std::expected<InputShape, std::error_code> InspectInput(int fd) {
+#if defined(_WIN32)
+    (void)fd;
+    return InputShape{};
+#else
+    struct stat info {};
+    if (::fstat(fd, &info) != 0) {
+        return std::unexpected{std::error_code{errno, std::system_category()}};
+    }
+    return detail::ShapeOf(info, ::lseek(fd, 0, SEEK_CUR));
+#endif
+}
+
+/// Looks at a file without opening it. path must be null terminated.
+inline std::expected<InputShape, std::error_code> InspectInput(
+    const char* path) {
+#if defined(_WIN32)
+    (void)path;
+    return InputShape{};
+#else
+    struct stat info {};
+    if (::stat(path, &info) != 0) {
+        return std::unexpected{std::error_code{errno, std::system_category()}};
+    }
+    return detail::ShapeOf(info, 0);
+#endif
+}
+
+/// How an InputSource gets at its input
+enum class InputStrategy : std::uint8_t { Map, Read };
+
+/// Everything from an input's current offset to its end, got at whichever
+/// way is cheaper. Big regular files are mapped, which skips read's copy
+/// into a buffer and lets threads split the text between them. Everything
+/// else (pipes, terminals, small files, and files that cannot be mapped) is
+/// read through a large aligned buffer, since setting up and tearing down a
+/// mapping costs more than copying a few pages does.
+///
+/// Either way the kernel is told the input will be read front to back, so
+/// it reads ahead further than it otherwise would.
+class InputSource final {
+ public:
+    /// Below a few megabytes, mapping and unmapping cost more than reading
+    /// saves (see bench/input)
+    static constexpr std::size_t default_map_threshold{4 * 1024 * 1024};
+    /// For callers that must not be killed by SIGBUS when a file shrinks
+    /// under them, which a mapping is
+    static constexpr std::size_t never_map{
+        std::numeric_limits<std::size_t>::max()};
+
+    explicit InputSource(int fd,
+                         std::size_t map_threshold = default_map_threshold)
+        : fd_{fd} {
+        const std::expected<InputShape, std::error_code> shape{
+            InspectInput(fd)};
+        // if fd cannot be looked at, reading it will say why
+        if (!shape || !shape->regular) {
+            return;
+        }
+#if !defined(_WIN32)
+        const off_t offset{::lseek(fd, 0, SEEK_CUR)};
+#if defined(POSIX_FADV_SEQUENTIAL)
+        // just a hint, so failing is fine
+        ::posix_fadvise(fd, offset, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+        // empty regular files might be e.g. /proc files, whose size only
+        // reading will tell
+        if (offset < 0 || shape->remaining == 0 ||
+            shape->remaining < map_threshold ||
+            shape->remaining > std::numeric_limits<std::size_t>::max() -
+                                   static_cast<std::uint64_t>(offset)) {
+            return;
+        }
+        const auto start{static_cast<std::size_t>(offset)};
+        std::expected<MappedFile, std::error_code> mapped{
+            MappedFile::Map(fd, start + shape->remaining)};
+        // failing that (e.g. on a filesystem that cannot map files), it can
+        // still be read
+        if (mapped) {
+            mapped_.emplace(std::move(*mapped));
+            text_ = mapped_->span().subspan(start);
+            // leave fd where reading it all would have, for whoever uses it
+            // next (e.g. the rest of a shell script sharing its offset)
+            ::lseek(fd, 0, SEEK_END);
+        }
+#endif
+    }
+
+    InputStrategy strategy() const {
+        return mapped_ ? InputStrategy::Map : InputStrategy::Read;
+    }
+
+    /// The whole input, when it is mapped, for consumers that split it
+    /// between threads (see SplitChunks)
+    std::optional<std::span<const char>> mapped() const {
+        return mapped_ ? std::optional{text_} : std::nullopt;
+    }
+
+    /// Calls consume with each piece of the input in order: the whole
+    /// mapping at once, or each read into buffer (which the piece points
+    /// into, so it is only good until consume returns). On a read error,
+    /// everything before it has still been consumed.
+    template <class Consume>
+    std::error_code ForEachChunk(std::span<char> buffer, Consume&& consume) {
+        if (mapped_) {
+            if (!text_.empty()) {
+                consume(std::span<const char>{text_});
+            }
+            return {};
+        }
+        while (true) {
+            const std::expected<std::size_t, std::error_code> got{
+                ReadSome(fd_, buffer)};
+            if (!got) {
+                return got.error();
+            } else if (*got == 0) {
+                return {};
+            }
+            consume(std::span<const char>{buffer.first(*got)});
+        }
+    }
+
+ private:
+    int fd_;
+    std::optional<MappedFile> mapped_{};
+    std::span<const char> text_{};
+};
+
+/// Splits text into pieces for threads to work on, starting at multiples of
+/// size. align(text, start) moves each start forward to where a piece may
+/// begin (e.g. after the next newline, or past the rest of a character), and
+/// returns text.size() if there is nowhere left. Pieces may come out empty.
+template <class Align>
+std::vector<std::span<const char>> SplitChunks(std::span<const char> text,
+                                               std::size_t size,
+                                               Align&& align) {
+    size = std::max<std::size_t>(size, 1);
+    const std::size_t count{(text.size() + size - 1) / size};
+    std::vector<std::span<const char>> chunks{};
+    chunks.reserve(count);
+    std::size_t start{0};
+    for (std::size_t i{1}; i <= count; ++i) {
+        const std::size_t end{
+            i == count
+                ? text.size()
+                : std::clamp<std::size_t>(align(text, i * size), start,
+                                          text.size())};
+        chunks.push_back(text.subspan(start, end - start));
+        start = end;
+    }
+    return chunks;
+}
+
+/// Splits text into pieces of size bytes (the last may be shorter)
+inline std::vector<std::span<const char>> SplitChunks(
+    std::span<const char> text, std::size_t size) {
+    return SplitChunks(text, size,
+                       [](std::span<const char>, std::size_t start) {
+                           return start;
+                       });
+}
+
+}  // namespace coreutils
+
+#endif  // LIB_FILEINPUT_HPP_
@@ -0,0 +1,274 @@
+///
+///  @file FileStatus.hpp
+///  @brief file metadata lookups relative to an open directory
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_FILESTATUS_HPP_
+#define LIB_FILESTATUS_HPP_
+
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "DirectoryReader.hpp"
+#include "Parallel.hpp"
+#include "detail/FileStatus.hpp"
+#include "detail/Stats.hpp"
+
+namespace coreutils {
+
+/// Which parts of a FileStatus the caller is going to look at. The type is
+/// always filled in. On Linux only the requested fields are asked of statx,
+/// which lets network filesystems skip work (e.g. revalidating sizes).
+enum class StatField : std::uint8_t {
+    None = 0,
+    Permissions = 1 << 0,
+    Links = 1 << 1,
+    Owner = 1 << 2,
+    Size = 1 << 3,
+    Blocks = 1 << 4,
+    ModifyTime = 1 << 5,
+};
+
+constexpr StatField operator|(StatField lhs, StatField rhs) {
+    using Bits = std::underlying_type_t<StatField>;
+    return static_cast<StatField>(static_cast<Bits>(lhs) |
+                                  static_cast<Bits>(rhs));
+}
+
+constexpr StatField& operator|=(StatField& lhs, StatField rhs) {
+    return lhs = lhs | rhs;
+}
+
+/// Whether every field in wanted is in fields
+constexpr bool Has(StatField fields, StatField wanted) {
+    using Bits = std::underlying_type_t<StatField>;
+    return (static_cast<Bits>(fields) & static_cast<Bits>(wanted)) ==
+           static_cast<Bits>(wanted);
+}
+
+/// Fields that were not requested are left zeroed
+struct FileStatus final {
+    FileType type;
+    /// POSIX style permission bits (07777)
+    std::uint16_t permissions;
+    std::uint32_t uid;
+    std::uint32_t gid;
+    std::uint64_t links;
+    std::uint64_t size;
+    /// Allocated space, in 512 byte units
+    std::uint64_t blocks;
+    /// Last modification, in nanoseconds since the (unix) epoch
+    std::int64_t mtime;
+};
+
+using StatResult = std::expected<FileStatus, std::error_code>;
+
+namespace detail {
+
+#if defined(_WIN32)
+inline StatResult StatPath(const std::filesystem::path& path,
+                           StatField fields) {
+    namespace fs = std::filesystem;
+    std::error_code error{};
+    const fs::file_status status{fs::symlink_status(path, error)};
+    if (error) {
+        return std::unexpected{error};
+    }
+
+    FileStatus result{
+        .type = FromFilesystemType(status.type()),
+        .permissions = static_cast<std::uint16_t>(
+            static_cast<unsigned>(status.permissions()) & permission_mask),
+        .links = 1,
+    };
+    if (Has(fields, StatField::Size) || Has(fields, StatField::Blocks)) {
+        result.size = fs::is_regular_file(status)
+                          ? fs::file_size(path, error)
+                          : 0;
+        result.blocks = (result.size + 511) / 512;
+    }
+    if (Has(fields, StatField::ModifyTime)) {
+        // file_clock has its own epoch, so go through both clocks' "now"
+        const fs::file_time_type mtime{fs::last_write_time(path, error)};
+        const auto since_now{mtime - fs::file_time_type::clock::now()};
+        result.mtime =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                (std::chrono::system_clock::now() + since_now)
+                    .time_since_epoch())
+                .count();
+    }
+    if (error) {
+        return std::unexpected{error};
+    }
+    return result;
+}
+#else
+#if defined(__linux__)
+/// What to ask statx for, to fill in fields
+inline unsigned int StatxMask(StatField fields) {
+    unsigned int mask{STATX_TYPE};
+    mask |= Has(fields, StatField::Permissions) ? STATX_MODE : 0;
+    mask |= Has(fields, StatField::Links) ? STATX_NLINK : 0;
+    mask |= Has(fields, StatField::Owner) ? STATX_UID | STATX_GID : 0;
+    mask |= Has(fields, StatField::Size) ? STATX_SIZE : 0;
+    mask |= Has(fields, StatField::Blocks) ? STATX_BLOCKS : 0;
+    mask |= Has(fields, StatField::ModifyTime) ? STATX_MTIME : 0;
+    return mask;
+}
+
+/// Lookups never follow symlinks, nor trigger automounts
+inline constexpr int statx_flags{AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT};
+
+inline FileStatus FromStatx(const struct statx& info) {
+    return FileStatus{
+        .type = FromModeType(info.stx_mode),
+        .permissions =
+            static_cast<std::uint16_t>(info.stx_mode & permission_mask),
+        .uid = info.stx_uid,
+        .gid = info.stx_gid,
+        .links = info.stx_nlink,
+        .size = info.stx_size,
+        .blocks = info.stx_blocks,
+        .mtime = ToNanoseconds(info.stx_mtime.tv_sec, info.stx_mtime.tv_nsec),
+    };
+}
+#endif
+
+inline StatResult StatAt(int dirfd, const char* name, StatField fields) {
+#if defined(__linux__)
+    struct statx info {};
+    if (::statx(dirfd, name, statx_flags, StatxMask(fields), &info) != 0) {
+        return std::unexpected{std::error_code{errno, std::system_category()}};
+    }
+    return FromStatx(info);
+#else
+    struct stat info {};
+    if (::fstatat(dirfd, name, &info, AT_SYMLINK_NOFOLLOW) != 0) {
+        return std::unexpected{std::error_code{errno, std::system_category()}};
+    }
+#if defined(__APPLE__)
+    const timespec& mtime{info.st_mtimespec};
+#else
+    const timespec& mtime{info.st_mtim};
+#endif
+    return FileStatus{
+        .type = FromModeType(info.st_mode),
+        .permissions =
+            static_cast<std::uint16_t>(info.st_mode & permission_mask),
+        .uid = info.st_uid,
+        .gid = info.st_gid,
+        .links = static_cast<std::uint64_t>(info.st_nlink),
+        .size = static_cast<std::uint64_t>(info.st_size),
+        .blocks = static_cast<std::uint64_t>(info.st_blocks),
+        .mtime = ToNanoseconds(mtime.tv_sec, mtime.tv_nsec),
+    };
+#endif
+}
+#endif
+
+}  // namespace detail
+
+/// Looks up name inside of dir without following symlinks. name must be null
+/// terminated.
+inline StatResult StatAt(const DirectoryReader& dir, const char* name,
+                         StatField fields) {
+    const detail::StatsTimer timer{detail::StatsPhase::Io};
+    detail::CountSyscall(detail::StatsSyscall::Stat);
+#if defined(_WIN32)
+    return detail::StatPath(dir.path() / name, fields);
+#else
+    return detail::StatAt(dir.fd(), name, fields);
+#endif
+}
+
+/// Looks up path (relative to the working directory) without following
+/// symlinks. path must be null terminated.
+inline StatResult Stat(const char* path, StatField fields) {
+    const detail::StatsTimer timer{detail::StatsPhase::Io};
+    detail::CountSyscall(detail::StatsSyscall::Stat);
+#if defined(_WIN32)
+    return detail::StatPath(path, fields);
+#else
+    return detail::StatAt(AT_FDCWD, path, fields);
+#endif
+}
+
+/// Reads the target of the symlink name inside of dir. name must be null
+/// terminated.
+inline std::expected<std::string, std::error_code> ReadLinkAt(
+    const DirectoryReader& dir, const char* name) {
+#if defined(_WIN32)
+    std::error_code error{};
+    std::filesystem::path target{
+        std::filesystem::read_symlink(dir.path() / name, error)};
+    if (error) {
+        return std::unexpected{error};
+    }
+    return target.string();
+#else
+    std::string target(256, '\0');
+    while (true) {
+        const ssize_t length{
+            ::readlinkat(dir.fd(), name, target.data(), target.size())};
+        if (length < 0) {
+            return std::unexpected{
+                std::error_code{errno, std::system_category()}};
+        } else if (static_cast<std::size_t>(length) < target.size()) {
+            target.resize(static_cast<std::size_t>(length));
+            return target;
+        }
+        // possibly truncated
+        target.resize(target.size() * 2);
+    }
+#endif
+}
+
+/// Stats every entry of dir into results (which must be as long as entries).
+/// On local disks a stat is a microsecond or so, but on network and FUSE
+/// filesystems each one is a round trip, so a listing is latency bound
+/// unless many are in flight at once.
+inline void StatAll(const DirectoryReader& dir,
+                    std::span<const DirectoryEntry> entries, StatField fields,
+                    std::span<StatResult> results,
+                    std::size_t threads = DefaultConcurrency()) {
+    // small enough that a directory of a few hundred entries is still spread
+    // out, large enough that threads are not fighting over the counter
+    constexpr std::size_t grain{64};
+    ParallelFor(entries.size(), threads, grain,
+                [&dir, entries, fields, results](std::size_t i) {
+                    results[i] = StatAt(dir, entries[i].name.data(), fields);
+                });
+}
+
+}  // namespace coreutils
+
+#endif  // LIB_FILESTATUS_HPP_
@@ -0,0 +1,113 @@
+///
+///  @file InodeSet.hpp
+///  @brief a set of files by device and inode, for many threads at once
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_INODESET_HPP_
+#define LIB_INODESET_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace coreutils {
+
+/// Which files have been seen, by (device, inode), e.g. so that a file with
+/// several hard links is only counted once. Any number of threads can add to
+/// it at once: it is split into shards, each an open addressing table with a
+/// lock of its own, so threads only wait on each other when they happen to
+/// hit the same shard at the same moment.
+class InodeSet final {
+ public:
+    /// Adds the file, returning whether it was not in the set already
+    bool Insert(std::uint64_t device, std::uint64_t inode) {
+        const std::uint64_t hash{Hash(device, inode)};
+        // the top bits pick the shard, the bottom ones the slot within it
+        Shard& shard{shards_[hash >> (64 - shard_bits)]};
+        std::lock_guard lock{shard.mutex};
+        if (Slot& slot{Find(shard.slots, hash, device, inode)}; slot.used) {
+            return false;
+        }
+
+        // keep the load factor at or below one half
+        if (2 * (shard.size + 1) > shard.slots.size()) {
+            std::vector<Slot> grown(shard.slots.size() * 2);
+            for (const Slot& slot : shard.slots) {
+                if (slot.used) {
+                    Find(grown, Hash(slot.device, slot.inode), slot.device,
+                         slot.inode) = slot;
+                }
+            }
+            shard.slots = std::move(grown);
+        }
+        Find(shard.slots, hash, device, inode) = {
+            .device = device, .inode = inode, .used = true};
+        ++shard.size;
+        return true;
+    }
+
+ private:
+    static constexpr unsigned shard_bits{6};
+
+    struct Slot final {
+        std::uint64_t device;
+        std::uint64_t inode;
+        bool used;
+    };
+
+    /// On a cache line of its own, so that threads working on neighbouring
+    /// shards do not slow each other down
+    struct alignas(64) Shard final {
+        std::mutex mutex{};
+        std::vector<Slot> slots{std::vector<Slot>(16)};
+        std::size_t size{0};
+    };
+
+    static std::uint64_t Hash(std::uint64_t device, std::uint64_t inode) {
+        // inode numbers are often small and sequential, so mix them up well
+        // (the finalizer of MurmurHash3)
+        std::uint64_t hash{inode ^ (device * 0x9e3779b97f4a7c15u)};
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdu;
+        hash ^= hash >> 33;
+        hash *= 0xc4ceb9fe1a85ec53u;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    static Slot& Find(std::vector<Slot>& slots, std::uint64_t hash,
+                      std::uint64_t device, std::uint64_t inode) {
+        const std::size_t mask{slots.size() - 1};
+        for (std::size_t i{static_cast<std::size_t>(hash) & mask};;
+             i = (i + 1) & mask) {
+            if (!slots[i].used ||
+                (slots[i].device == device && slots[i].inode == inode)) {
+                return slots[i];
+            }
+        }
+    }
+
+    std::array<Shard, std::size_t{1} << shard_bits> shards_{};
+};
+
+}  // namespace coreutils
+
+#endif  // LIB_INODESET_HPP_
@@ -0,0 +1,281 @@
+///
+///  @file LineSeek.hpp
+///  @brief counting lines from either end of a file, for head and tail, and
+///  the rest of what the two share
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_LINESEEK_HPP_
+#define LIB_LINESEEK_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <expected>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#if defined(_WIN32)
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "FileCopy.hpp"
+#include "TextCount.hpp"
+
+namespace coreutils {
+
+/// A count of lines or bytes, as head and tail take them: b (512), K or
+/// KiB (1024), KB (1000), M or MiB, MB, and so on up to E, where K and M
+/// may also be k and m. Counts too big to hold are clamped, as they mean
+/// "everything" either way.
+inline std::optional<std::uint64_t> ParseCount(std::string_view arg) {
+    std::uint64_t count{0};
+    std::size_t i{0};
+    for (; i < arg.size() && arg[i] >= '0' && arg[i] <= '9'; ++i) {
+        const auto digit{static_cast<std::uint64_t>(arg[i] - '0')};
+        count = count > (std::numeric_limits<std::uint64_t>::max() - digit) / 10
+                    ? std::numeric_limits<std::uint64_t>::max()
+                    : count * 10 + digit;
+    }
+    const std::string_view suffix{arg.substr(i)};
+    if (i == 0) {
+        return std::nullopt;
+    } else if (suffix.empty()) {
+        return count;
+    } else if (suffix == "b") {
+        return count > std::numeric_limits<std::uint64_t>::max() / 512
+                   ? std::numeric_limits<std::uint64_t>::max()
+                   : count * 512;
+    }
+
+    constexpr std::string_view units{"KMGTPE"};
+    const std::size_t unit{units.find(suffix[0] == 'k'   ? 'K'
+                                      : suffix[0] == 'm' ? 'M'
+                                                         : suffix[0])};
+    const std::string_view rest{suffix.substr(1)};
+    if (unit == std::string_view::npos ||
+        !(rest.empty() || rest == "B" || rest == "iB")) {
+        return std::nullopt;
+    }
+    const std::uint64_t base{rest == "B" ? 1000u : 1024u};
+    for (std::size_t power{0}; power <= unit; ++power) {
+        count = count > std::numeric_limits<std::uint64_t>::max() / base
+                    ? std::numeric_limits<std::uint64_t>::max()
+                    : count * base;
+    }
+    return count;
+}
+
+/// GNU head and tail still take the old "-N" (and "-Nc"), so that is turned
+/// into "-n N" (or "-c N") before the arguments are parsed. count holds the
+/// number that the rewritten arguments point into.
+inline std::vector<const char*> RewriteObsolete(int argc, const char** argv,
+                                                std::string& count) {
+    std::vector<const char*> args(argv, argv + argc);
+    if (argc < 2) {
+        return args;
+    }
+    std::string_view first{argv[1]};
+    if (first.size() < 2 || first[0] != '-' || first[1] < '0' ||
+        first[1] > '9') {
+        return args;
+    }
+    const char unit{first.back()};
+    const bool bytes{unit == 'c'};
+    if (unit == 'c' || unit == 'l') {
+        first.remove_suffix(1);
+    }
+    if (!std::ranges::all_of(first.substr(1),
+                             [](char c) { return c >= '0' && c <= '9'; })) {
+        return args;
+    }
+    count = first.substr(1);
+    args[1] = count.c_str();
+    args.insert(args.begin() + 1, bytes ? "-c" : "-n");
+    return args;
+}
+
+/// Where the last count lines of text start, counted the same way as in the
+/// file overload below
+inline std::size_t FindLastLines(std::span<const char> text,
+                                 std::uint64_t count) {
+    if (count == 0 || text.empty()) {
+        return text.size();
+    }
+    const std::uint64_t wanted{count + (text.back() == '\n' ? 1 : 0)};
+    const NewlineSearch search{FindNewlineBackward(text, wanted)};
+    return search.found == wanted ? search.position + 1 : 0;
+}
+
+/// Where the last count lines of [begin, end) of fd (which must be seekable)
+/// start. Blocks are read backward from end until enough newlines turn up,
+/// so the cost depends on how much is wanted rather than on the size of the
+/// file. As tail counts them, a newline at end finishes the last line rather
+/// than starting another, and text after the last newline is a line too.
+inline std::expected<std::uint64_t, std::error_code> FindLastLines(
+    int fd, std::uint64_t begin, std::uint64_t end, std::uint64_t count,
+    std::span<char> buffer) {
+    if (count == 0) {
+        return end;
+    }
+    std::uint64_t wanted{count};
+    for (std::uint64_t block_end{end}; block_end > begin;) {
+        const std::size_t size{static_cast<std::size_t>(
+            std::min<std::uint64_t>(buffer.size(), block_end - begin))};
+        const std::uint64_t block_start{block_end - size};
+        std::size_t got{0};
+        while (got < size) {
+            const std::expected<std::size_t, std::error_code> read{
+                ReadSomeAt(fd, buffer.subspan(got, size - got),
+                           block_start + got)};
+            if (!read) {
+                return std::unexpected{read.error()};
+            } else if (*read == 0) {
+                // the file shrank under us
+                return std::unexpected{
+                    std::make_error_code(std::errc::io_error)};
+            }
+            got += *read;
+        }
+
+        const std::span<const char> block{buffer.first(size)};
+        if (block_end == end && block.back() == '\n') {
+            ++wanted;
+        }
+        const NewlineSearch search{FindNewlineBackward(block, wanted)};
+        if (search.found == wanted) {
+            return block_start + search.position + 1;
+        }
+        wanted -= search.found;
+        block_end = block_start;
+    }
+    return begin;
+}
+
+/// lseek, with 64 bit offsets everywhere
+inline std::int64_t Seek(int fd, std::int64_t offset, int whence) {
+#if defined(_WIN32)
+    return ::_lseeki64(fd, offset, whence);
+#else
+    return ::lseek(fd, static_cast<off_t>(offset), whence);
+#endif
+}
+
+/// A regular file's size and where fd is in it
+struct Seekable final {
+    std::uint64_t offset;
+    std::uint64_t size;
+};
+
+/// Nothing for anything but a regular file, which can only be read front
+/// to back
+inline std::optional<Seekable> InspectSeekable(int fd) {
+#if defined(_WIN32)
+    struct _stat64 status {};
+    if (::_fstat64(fd, &status) != 0 || (status.st_mode & _S_IFREG) == 0) {
+        return std::nullopt;
+    }
+#else
+    struct stat status {};
+    if (::fstat(fd, &status) != 0 || !S_ISREG(status.st_mode)) {
+        return std::nullopt;
+    }
+#endif
+    const std::int64_t offset{Seek(fd, 0, SEEK_CUR)};
+    // e.g. files in /proc claim to be empty, and have to be read to tell
+    if (offset < 0 || status.st_size == 0) {
+        return std::nullopt;
+    }
+    return Seekable{
+        .offset = static_cast<std::uint64_t>(offset),
+        .size = std::max(static_cast<std::uint64_t>(status.st_size),
+                         static_cast<std::uint64_t>(offset)),
+    };
+}
+
+/// A failed read, as opposed to a failed write
+inline CopyResult ReadError(std::error_code error) {
+    return std::unexpected{CopyError{error, false}};
+}
+
+/// The end of a stream: what was held back of it, and where in that its
+/// last count lines (or bytes) start
+struct StreamEnd final {
+    std::string text;
+    std::size_t start;
+};
+
+/// Reads a stream that can only be read front to back, holding on to only
+/// the chunks that its last count lines (or bytes) could still be in. The
+/// rest are handed to before(std::string_view) in order as soon as enough
+/// has come in after them.
+template <class Before>
+std::expected<StreamEnd, std::error_code> ReadStreamEnd(
+    int fd, std::uint64_t count, bool bytes, std::span<char> buffer,
+    Before&& before) {
+    struct Chunk final {
+        std::string text;
+        std::uint64_t newlines;
+    };
+    std::deque<Chunk> chunks{};
+    // in the chunks after the first one
+    std::uint64_t later{0};
+    while (true) {
+        const std::expected<std::size_t, std::error_code> got{
+            ReadSome(fd, buffer)};
+        if (!got) {
+            return std::unexpected{got.error()};
+        } else if (*got == 0) {
+            break;
+        }
+        const std::span<const char> text{buffer.first(*got)};
+        chunks.push_back({
+            .text = std::string{text.data(), text.size()},
+            .newlines = bytes ? text.size() : CountLines(text),
+        });
+        later += chunks.size() > 1 ? chunks.back().newlines : 0;
+        // lines need a newline to spare, for the one that may end the last
+        while (chunks.size() > 1 && (bytes ? later >= count : later > count)) {
+            before(std::string_view{chunks.front().text});
+            chunks.pop_front();
+            later -= chunks.front().newlines;
+        }
+    }
+
+    StreamEnd end{};
+    for (const Chunk& chunk : chunks) {
+        end.text.append(chunk.text);
+    }
+    end.start = bytes ? end.text.size() -
+                            std::min<std::uint64_t>(count, end.text.size())
+                      : FindLastLines(end.text, count);
+    return end;
+}
+
+}  // namespace coreutils
+
+#endif  // LIB_LINESEEK_HPP_
@@ -0,0 +1,39 @@
+///
+///  @file Main.hpp
+///  @brief entry point of a utility, standalone or in the multicall binary
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_MAIN_HPP_
+#define LIB_MAIN_HPP_
+
+/// Opens the definition of a utility's entry point, e.g.
+///
+///     COREUTILS_MAIN(ls) { ... }
+///
+/// On its own a utility is just main. The multicall build (see
+/// multicall/main.cpp) links every utility into one binary, so there each one
+/// is coreutils_main_<utility> instead, and gets picked by the name it was
+/// run as.
+#if defined(COREUTILS_MULTICALL)
+#define COREUTILS_MAIN(utility) \
+    int coreutils_main_##utility(int argc, const char** argv)
+#else
+#define COREUTILS_MAIN(utility) int main(int argc, const char** argv)
+#endif
+
+#endif  // LIB_MAIN_HPP_
@@ -0,0 +1,93 @@
+///
+///  @file MakeDirectory.hpp
+///  @brief creating directories relative to an open directory
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_MAKEDIRECTORY_HPP_
+#define LIB_MAKEDIRECTORY_HPP_
+
+#include <cerrno>
+#include <filesystem>
+#include <system_error>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+#include "DirectoryReader.hpp"
+
+namespace coreutils {
+
+/// Permission bits for directories that were not given a mode
+inline constexpr unsigned default_directory_mode{0777};
+
+/// The process' file mode creation mask (always 0 on Windows)
+inline unsigned CurrentUmask() {
+#if defined(_WIN32)
+    return 0;
+#else
+    // there is no way to read the mask without setting it
+    const mode_t mask{::umask(0)};
+    ::umask(mask);
+    return static_cast<unsigned>(mask);
+#endif
+}
+
+/// Creates the directory name inside of parent, with mode (less the umask).
+/// name must be null terminated. Fails with errc::file_exists if anything by
+/// that name is already there.
+inline std::error_code MakeDirectoryAt(const DirectoryReader& parent,
+                                       const char* name, unsigned mode) {
+#if defined(_WIN32)
+    (void)mode;
+    std::error_code error{};
+    if (!std::filesystem::create_directory(parent.path() / name, error) &&
+        !error) {
+        return std::make_error_code(std::errc::file_exists);
+    }
+    return error;
+#else
+    if (::mkdirat(parent.fd(), name, static_cast<mode_t>(mode)) != 0) {
+        return {errno, std::system_category()};
+    }
+    return {};
+#endif
+}
+
+/// Sets the permission bits (07777) of name inside of parent, following
+/// symlinks. name must be null terminated.
+inline std::error_code ChangeModeAt(const DirectoryReader& parent,
+                                    const char* name, unsigned mode) {
+#if defined(_WIN32)
+    std::error_code error{};
+    std::filesystem::permissions(parent.path() / name,
+                                 static_cast<std::filesystem::perms>(mode),
+                                 error);
+    return error;
+#else
+    if (::fchmodat(parent.fd(), name, static_cast<mode_t>(mode), 0) != 0) {
+        return {errno, std::system_category()};
+    }
+    return {};
+#endif
+}
+
+}  // namespace coreutils
+
+#endif  // LIB_MAKEDIRECTORY_HPP_
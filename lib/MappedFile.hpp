@@ -0,0 +1,105 @@
+///
+///  @file MappedFile.hpp
+///  @brief read only memory mappings of whole files
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_MAPPEDFILE_HPP_
+#define LIB_MAPPEDFILE_HPP_
+
+#include <cerrno>
+#include <cstddef>
+#include <expected>
+#include <span>
+#include <system_error>
+#include <utility>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#endif
+
+namespace coreutils {
+
+/// A private, read only view of the first size bytes of a file. Reading a
+/// big file through its mapping skips the copy into a buffer that read
+/// makes, and lets any number of threads look at any part of it at once.
+///
+/// The file must not shrink while it is mapped: touching a page past its new
+/// end raises SIGBUS.
+class MappedFile final {
+ public:
+    static std::expected<MappedFile, std::error_code> Map(int fd,
+                                                          std::size_t size) {
+#if defined(_WIN32)
+        (void)fd;
+        (void)size;
+        return std::unexpected{
+            std::make_error_code(std::errc::operation_not_supported)};
+#else
+        if (size == 0) {
+            return MappedFile{nullptr, 0};
+        }
+        void* data{::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0)};
+        if (data == MAP_FAILED) {
+            return std::unexpected{
+                std::error_code{errno, std::system_category()}};
+        }
+        // readers walk through it front to back (each thread its own part), so
+        // ask for aggressive readahead. Just a hint, so failing is fine.
+        ::madvise(data, size, MADV_SEQUENTIAL);
+#if defined(MADV_HUGEPAGE)
+        // where the filesystem can back it with huge pages, a big mapping
+        // then takes a fraction of the page faults and TLB entries
+        if (size >= huge_page_size) {
+            ::madvise(data, size, MADV_HUGEPAGE);
+        }
+#endif
+        return MappedFile{static_cast<const char*>(data), size};
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept
+        : data_{std::exchange(other.data_, nullptr)},
+          size_{std::exchange(other.size_, 0)} {}
+    MappedFile& operator=(MappedFile&&) = delete;
+
+    ~MappedFile() {
+#if !defined(_WIN32)
+        if (data_) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+#endif
+    }
+
+    std::span<const char> span() const { return {data_, size_}; }
+
+ private:
+    /// The smallest on the platforms that have them (x86-64 and arm64)
+    static constexpr std::size_t huge_page_size{2 * 1024 * 1024};
+
+    MappedFile(const char* data, std::size_t size)
+        : data_{data}, size_{size} {}
+
+    const char* data_;
+    std::size_t size_;
+};
+
+}  // namespace coreutils
+
+#endif  // LIB_MAPPEDFILE_HPP_
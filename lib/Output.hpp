@@ -0,0 +1,188 @@
+///
+///  @file Output.hpp
+///  @brief buffered, format free writer for standard output
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_OUTPUT_HPP_
+#define LIB_OUTPUT_HPP_
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <expected>
+#include <format>
+#include <limits>
+#include <memory>
+#include <string_view>
+#include <system_error>
+
+#include "detail/Output.hpp"
+
+namespace coreutils {
+
+/// A single unbuffered write, for callers that manage their own buffer (and
+/// partial writes). Returns how much of data the kernel took.
+inline std::expected<std::size_t, std::error_code> WriteSome(
+    int fd, std::string_view data) {
+    return detail::WriteSome(fd, data);
+}
+
+/// Integers that should be written as numbers (unlike char and bool)
+template <class T>
+concept Number = std::integral<T> && !std::same_as<T, char> &&
+                 !std::same_as<T, bool>;
+
+/// Collects output in a fixed size buffer and hands it to the kernel in as
+/// few write calls as possible. Unlike stdio there is no locking, and plain
+/// strings and numbers never go through the format machinery. Like stdio,
+/// output is flushed at every newline when writing to a terminal, so that
+/// interactive use still sees lines as they are produced.
+///
+/// The first failed write is remembered (see error()) and everything after it
+/// is dropped, so callers only need to check once, when they Flush at the end.
+class Output final {
+ public:
+    static constexpr int standard_output{1};
+    static constexpr std::size_t default_capacity{64 * 1024};
+
+    explicit Output(int fd = standard_output,
+                    std::size_t capacity = default_capacity)
+        : fd_{fd},
+          capacity_{std::max<std::size_t>(capacity, 1)},
+          buffer_{std::make_unique_for_overwrite<char[]>(capacity_)},
+          line_buffered_{detail::IsTerminal(fd)} {}
+
+    Output(const Output&) = delete;
+    Output& operator=(const Output&) = delete;
+
+    /// Flushes whatever is left. Call Flush first to find out if it worked.
+    ~Output() { Flush(); }
+
+    Output& Write(std::string_view data) {
+        if (data.size() <= capacity_ - size_) {
+            std::memcpy(buffer_.get() + size_, data.data(), data.size());
+            size_ += data.size();
+        } else if (data.size() < capacity_) {
+            Flush();
+            std::memcpy(buffer_.get(), data.data(), data.size());
+            size_ = data.size();
+        } else {
+            // would not fit even in an empty buffer, so skip the copy
+            if (!error_) {
+                Fail(detail::WriteAll(fd_, {buffer_.get(), size_}, data));
+            }
+            size_ = 0;
+        }
+        if (line_buffered_ && data.find('\n') != std::string_view::npos) {
+            Flush();
+        }
+        return *this;
+    }
+
+    Output& Put(char c) {
+        if (size_ == capacity_) {
+            Flush();
+        }
+        buffer_[size_++] = c;
+        if (line_buffered_ && c == '\n') {
+            Flush();
+        }
+        return *this;
+    }
+
+    /// Puts count copies of c, e.g. to pad a column
+    Output& Fill(char c, std::size_t count) {
+        while (count > 0) {
+            if (size_ == capacity_) {
+                Flush();
+            }
+            const std::size_t chunk{std::min(count, capacity_ - size_)};
+            std::memset(buffer_.get() + size_, c, chunk);
+            size_ += chunk;
+            count -= chunk;
+        }
+        return *this;
+    }
+
+    template <Number T>
+    Output& Write(T value) {
+        // every digit plus a sign
+        std::array<char, std::numeric_limits<T>::digits10 + 2> digits{};
+        const std::to_chars_result result{
+            std::to_chars(digits.data(), digits.data() + digits.size(), value)};
+        return Write(std::string_view{digits.data(), result.ptr});
+    }
+
+    /// For everything else. Formats straight into the buffer when the result
+    /// fits.
+    template <class... Args>
+    Output& Format(std::format_string<const Args&...> format,
+                   const Args&... args) {
+        if (size_ == capacity_) {
+            Flush();
+        }
+        const std::size_t available{capacity_ - size_};
+        const auto result{
+            std::format_to_n(buffer_.get() + size_,
+                             static_cast<std::ptrdiff_t>(available), format,
+                             args...)};
+        const std::size_t length{static_cast<std::size_t>(result.size)};
+        if (length > available) {
+            return Write(std::format(format, args...));
+        }
+        const std::string_view formatted{buffer_.get() + size_, length};
+        size_ += length;
+        if (line_buffered_ && formatted.find('\n') != std::string_view::npos) {
+            Flush();
+        }
+        return *this;
+    }
+
+    /// Hands everything buffered to the kernel. Returns the first error any
+    /// write has run into so far.
+    std::error_code Flush() {
+        if (size_ > 0 && !error_) {
+            Fail(detail::WriteAll(fd_, {buffer_.get(), size_}));
+        }
+        size_ = 0;
+        return error_;
+    }
+
+    std::error_code error() const { return error_; }
+
+ private:
+    void Fail(std::error_code error) {
+        if (!error_) {
+            error_ = error;
+        }
+    }
+
+    int fd_;
+    std::size_t capacity_;
+    std::unique_ptr<char[]> buffer_;
+    std::size_t size_{0};
+    bool line_buffered_;
+    std::error_code error_{};
+};
+
+}  // namespace coreutils
+
+#endif  // LIB_OUTPUT_HPP_
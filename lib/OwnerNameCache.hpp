@@ -0,0 +1,181 @@
+///
+///  @file OwnerNameCache.hpp
+///  @brief memoized uid/gid to user/group name lookups
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_OWNERNAMECACHE_HPP_
+#define LIB_OWNERNAMECACHE_HPP_
+
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <grp.h>
+#include <pwd.h>
+#include <unistd.h>
+#endif
+
+#include "Arena.hpp"
+
+namespace coreutils {
+
+/// Every uncached lookup can mean parsing /etc/passwd (or asking NSS, which
+/// may mean asking LDAP), while a directory typically has a handful of
+/// distinct owners. So names are looked up once and kept in a small open
+/// addressing table. Ids without a name are shown as numbers, as GNU does.
+class OwnerNameCache final {
+ public:
+    std::string_view User(std::uint32_t uid) {
+        return Lookup(users_, uid, [this](std::uint32_t id) {
+            return LookupUser(id);
+        });
+    }
+
+    std::string_view Group(std::uint32_t gid) {
+        return Lookup(groups_, gid, [this](std::uint32_t id) {
+            return LookupGroup(id);
+        });
+    }
+
+ private:
+    struct Slot final {
+        std::uint32_t id;
+        bool used;
+        std::string_view name;
+    };
+
+    struct Table final {
+        std::vector<Slot> slots{std::vector<Slot>(16)};
+        std::size_t size{0};
+    };
+
+    static std::size_t Hash(std::uint32_t id) {
+        // Fibonacci hashing: ids tend to be small and sequential
+        return static_cast<std::size_t>(
+            (static_cast<std::uint64_t>(id) * 0x9e3779b97f4a7c15u) >> 32);
+    }
+
+    static Slot& Find(std::vector<Slot>& slots, std::uint32_t id) {
+        const std::size_t mask{slots.size() - 1};
+        for (std::size_t i{Hash(id) & mask};; i = (i + 1) & mask) {
+            if (!slots[i].used || slots[i].id == id) {
+                return slots[i];
+            }
+        }
+    }
+
+    template <class Resolve>
+    std::string_view Lookup(Table& table, std::uint32_t id,
+                            Resolve&& resolve) {
+        if (Slot& slot{Find(table.slots, id)}; slot.used) {
+            return slot.name;
+        }
+
+        // keep the load factor at or below one half
+        if (2 * (table.size + 1) > table.slots.size()) {
+            std::vector<Slot> grown(table.slots.size() * 2);
+            for (const Slot& slot : table.slots) {
+                if (slot.used) {
+                    Find(grown, slot.id) = slot;
+                }
+            }
+            table.slots = std::move(grown);
+        }
+
+        const std::optional<std::string_view> resolved{resolve(id)};
+        const std::string_view name{resolved ? *resolved : Number(id)};
+        Find(table.slots, id) = {.id = id, .used = true, .name = name};
+        ++table.size;
+        return name;
+    }
+
+    std::string_view Number(std::uint32_t id) {
+        std::array<char, 16> digits{};
+        const std::to_chars_result result{
+            std::to_chars(digits.data(), digits.data() + digits.size(), id)};
+        return names_.Store({digits.data(), result.ptr});
+    }
+
+#if defined(_WIN32)
+    std::optional<std::string_view> LookupUser(std::uint32_t) {
+        return std::nullopt;
+    }
+    std::optional<std::string_view> LookupGroup(std::uint32_t) {
+        return std::nullopt;
+    }
+#else
+    /// Calls the reentrant getpw/getgr function get, growing the scratch
+    /// buffer until the entry fits
+    template <class Entry, class Get>
+    std::optional<std::string_view> LookupWith(std::uint32_t id, Get get,
+                                               char* Entry::*field) {
+        Entry entry{};
+        Entry* found{nullptr};
+        while (true) {
+            const int error{
+                get(id, &entry, scratch_.data(), scratch_.size(), &found)};
+            if (error == ERANGE) {
+                scratch_.resize(scratch_.size() * 2);
+                continue;
+            } else if (error != 0 || !found) {
+                return std::nullopt;
+            }
+            return names_.Store(entry.*field);
+        }
+    }
+
+    std::optional<std::string_view> LookupUser(std::uint32_t uid) {
+        return LookupWith<passwd>(
+            uid,
+            [](std::uint32_t id, passwd* entry, char* buffer,
+               std::size_t size, passwd** found) {
+                return ::getpwuid_r(static_cast<uid_t>(id), entry, buffer,
+                                    size, found);
+            },
+            &passwd::pw_name);
+    }
+
+    std::optional<std::string_view> LookupGroup(std::uint32_t gid) {
+        return LookupWith<group>(
+            gid,
+            [](std::uint32_t id, group* entry, char* buffer,
+               std::size_t size, group** found) {
+                return ::getgrgid_r(static_cast<gid_t>(id), entry, buffer,
+                                    size, found);
+            },
+            &group::gr_name);
+    }
+
+    std::vector<char> scratch_{std::vector<char>(1024)};
+#endif
+
+    Table users_{};
+    Table groups_{};
+    Arena names_{4096};
+};
+
+}  // namespace coreutils
+
+#endif  // LIB_OWNERNAMECACHE_HPP_
@@ -0,0 +1,141 @@
+///
+///  @file Parallel.hpp
+///  @brief minimal data parallel helpers shared by the coreutils
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_PARALLEL_HPP_
+#define LIB_PARALLEL_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "detail/Stats.hpp"
+
+namespace coreutils {
+
+/// How many threads to use when the user did not say
+inline std::size_t DefaultConcurrency() {
+    return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+/// Calls fn(i) for every i in [0, count) using up to threads threads, the
+/// calling thread included. Threads claim grain indices at a time, so slow
+/// items (e.g. a stat that has to go over the network) do not hold up the
+/// rest of a statically assigned slice. Does nothing in parallel unless
+/// there are at least two grains of work.
+template <class Fn>
+    requires std::invocable<Fn&, std::size_t>
+void ParallelFor(std::size_t count, std::size_t threads, std::size_t grain,
+                 Fn&& fn) {
+    grain = std::max<std::size_t>(grain, 1);
+    threads = std::min(threads, count / grain);
+    if (threads <= 1) {
+        for (std::size_t i{0}; i < count; ++i) {
+            fn(i);
+        }
+        detail::CountWork(count);
+        return;
+    }
+
+    std::atomic<std::size_t> next{0};
+    const auto work = [&next, &fn, count, grain]() {
+        for (std::size_t start{next.fetch_add(grain)}; start < count;
+             start = next.fetch_add(grain)) {
+            for (std::size_t i{start}; i < std::min(start + grain, count);
+                 ++i) {
+                fn(i);
+            }
+            detail::CountWork(std::min(grain, count - start));
+        }
+    };
+
+    std::vector<std::jthread> workers{};
+    workers.reserve(threads - 1);
+    for (std::size_t i{1}; i < threads; ++i) {
+        workers.emplace_back(work);
+    }
+    work();
+}
+
+/// Calls produce(i) for every i in [0, count) on up to threads other
+/// threads, and hands the results to consume(i, result) on the calling
+/// thread in order of i, each as soon as it and every one before it is
+/// ready. For utilities whose output has to follow their operands while the
+/// work for each operand is independent (e.g. hashing one file per
+/// operand). Results wait in memory until consumed, so they should be small.
+template <class Produce, class Consume>
+    requires std::invocable<Produce&, std::size_t>
+void ParallelOrdered(std::size_t count, std::size_t threads,
+                     Produce&& produce, Consume&& consume) {
+    using Result = std::invoke_result_t<Produce&, std::size_t>;
+    threads = std::min(threads, count);
+    if (threads <= 1) {
+        for (std::size_t i{0}; i < count; ++i) {
+            consume(i, produce(i));
+        }
+        detail::CountWork(count);
+        return;
+    }
+
+    std::vector<std::optional<Result>> results(count);
+    std::mutex mutex{};
+    std::condition_variable ready{};
+    std::atomic<std::size_t> next{0};
+    const auto work = [&]() {
+        for (std::size_t i{next.fetch_add(1)}; i < count;
+             i = next.fetch_add(1)) {
+            Result result{produce(i)};
+            detail::CountWork();
+            {
+                std::lock_guard lock{mutex};
+                results[i].emplace(std::move(result));
+            }
+            ready.notify_one();
+        }
+    };
+
+    std::vector<std::jthread> workers{};
+    workers.reserve(threads);
+    for (std::size_t i{0}; i < threads; ++i) {
+        workers.emplace_back(work);
+    }
+    for (std::size_t i{0}; i < count; ++i) {
+        std::optional<Result> result{};
+        {
+            std::unique_lock lock{mutex};
+            ready.wait(lock,
+                       [&results, i]() { return results[i].has_value(); });
+            result = std::move(results[i]);
+            results[i].reset();
+        }
+        consume(i, std::move(*result));
+    }
+}
+
+}  // namespace coreutils
+
+#endif  // LIB_PARALLEL_HPP_
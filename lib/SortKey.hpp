@@ -0,0 +1,351 @@
+///
+///  @file SortKey.hpp
+///  @brief sort keys, and the order they put lines in
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_SORTKEY_HPP_
+#define LIB_SORTKEY_HPP_
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "detail/SortKey.hpp"
+#include "detail/StringSort.hpp"
+
+namespace coreutils {
+
+/// Ordering options, either given on their own (and then the defaults for
+/// every key) or attached to one key
+struct SortFlags final {
+    /// -b, which for a key given with -k only applies to the end it is
+    /// attached to
+    bool skip_blanks;
+    /// -n
+    bool numeric;
+    /// -r
+    bool reverse;
+
+    constexpr bool any() const { return skip_blanks || numeric || reverse; }
+};
+
+/// One -k POS1[,POS2], with fields and characters counted from zero
+struct SortKey final {
+    static constexpr std::size_t to_end{
+        std::numeric_limits<std::size_t>::max()};
+
+    std::size_t start_field;
+    std::size_t start_char;
+    /// to_end for a key that runs to the end of the line
+    std::size_t end_field{to_end};
+    /// How many characters of end_field the key takes, all of them if 0
+    std::size_t end_char;
+    bool skip_start_blanks;
+    bool skip_end_blanks;
+    bool numeric;
+    bool reverse;
+};
+
+enum class SortKeyError : std::uint8_t {
+    BadNumber,
+    ZeroField,
+    ZeroCharacter,
+    UnsupportedOption,
+    StrayCharacter,
+};
+
+constexpr std::string_view Describe(SortKeyError error) {
+    switch (error) {
+        case SortKeyError::BadNumber:
+            return "invalid number";
+        case SortKeyError::ZeroField:
+            return "field number is zero";
+        case SortKeyError::ZeroCharacter:
+            return "character offset is zero";
+        case SortKeyError::UnsupportedOption:
+            return "unsupported ordering option";
+        case SortKeyError::StrayCharacter:
+            return "stray character in field spec";
+    }
+    return "invalid field specification";
+}
+
+/// Parses the argument of -k. Keys with no ordering options of their own
+/// take on defaults, as GNU's do.
+constexpr std::expected<SortKey, SortKeyError> ParseSortKey(
+    std::string_view spec, const SortFlags& defaults) {
+    const auto count = [&spec]() -> std::expected<std::size_t, SortKeyError> {
+        std::size_t value{0};
+        const auto [end, error]{
+            std::from_chars(spec.data(), spec.data() + spec.size(), value)};
+        if (error != std::errc{}) {
+            return std::unexpected{SortKeyError::BadNumber};
+        }
+        spec.remove_prefix(static_cast<std::size_t>(end - spec.data()));
+        return value;
+    };
+    // the letters after a position, returning whether there were any
+    const auto options = [&spec](SortKey& key, bool& skip_blanks)
+        -> std::expected<bool, SortKeyError> {
+        bool any{false};
+        for (; !spec.empty() && spec.front() != ','; spec.remove_prefix(1)) {
+            switch (spec.front()) {
+                case 'b':
+                    skip_blanks = true;
+                    break;
+                case 'n':
+                    key.numeric = true;
+                    break;
+                case 'r':
+                    key.reverse = true;
+                    break;
+                case 'd':
+                case 'f':
+                case 'g':
+                case 'h':
+                case 'i':
+                case 'M':
+                case 'R':
+                case 'V':
+                    return std::unexpected{SortKeyError::UnsupportedOption};
+                default:
+                    return std::unexpected{SortKeyError::StrayCharacter};
+            }
+            any = true;
+        }
+        return any;
+    };
+
+    SortKey key{};
+    const std::expected<std::size_t, SortKeyError> start_field{count()};
+    if (!start_field) {
+        return std::unexpected{start_field.error()};
+    } else if (*start_field == 0) {
+        return std::unexpected{SortKeyError::ZeroField};
+    }
+    key.start_field = *start_field - 1;
+    if (spec.starts_with('.')) {
+        spec.remove_prefix(1);
+        const std::expected<std::size_t, SortKeyError> start_char{count()};
+        if (!start_char) {
+            return std::unexpected{start_char.error()};
+        } else if (*start_char == 0) {
+            return std::unexpected{SortKeyError::ZeroCharacter};
+        }
+        key.start_char = *start_char - 1;
+    }
+    const std::expected<bool, SortKeyError> start_options{
+        options(key, key.skip_start_blanks)};
+    if (!start_options) {
+        return std::unexpected{start_options.error()};
+    }
+
+    bool end_options{false};
+    if (spec.starts_with(',')) {
+        spec.remove_prefix(1);
+        const std::expected<std::size_t, SortKeyError> end_field{count()};
+        if (!end_field) {
+            return std::unexpected{end_field.error()};
+        } else if (*end_field == 0) {
+            return std::unexpected{SortKeyError::ZeroField};
+        }
+        key.end_field = *end_field - 1;
+        if (spec.starts_with('.')) {
+            spec.remove_prefix(1);
+            const std::expected<std::size_t, SortKeyError> end_char{count()};
+            if (!end_char) {
+                return std::unexpected{end_char.error()};
+            }
+            key.end_char = *end_char;
+        }
+        const std::expected<bool, SortKeyError> parsed{
+            options(key, key.skip_end_blanks)};
+        if (!parsed) {
+            return std::unexpected{parsed.error()};
+        }
+        end_options = *parsed;
+    }
+    if (!spec.empty()) {
+        return std::unexpected{SortKeyError::StrayCharacter};
+    }
+
+    if (!*start_options && !end_options) {
+        key.skip_start_blanks = key.skip_end_blanks = defaults.skip_blanks;
+        key.numeric = defaults.numeric;
+        key.reverse = defaults.reverse;
+    }
+    return key;
+}
+
+/// A line to be sorted, pointing into whatever block of input holds it. The
+/// first key's position is worked out once, up front, along with its first
+/// 8 bytes (as in SortRecord), or for a numeric key as much of its value as
+/// fits in 64 bits, which settle most comparisons on their own.
+struct SortLine final {
+    std::uint64_t prefix;
+    const char* data;
+    std::uint32_t size;
+    std::uint32_t key_begin;
+    std::uint32_t key_end;
+
+    constexpr std::string_view view() const { return {data, size}; }
+    constexpr std::string_view key() const {
+        return {data + key_begin, key_end - key_begin};
+    }
+};
+
+/// The order sort puts lines in: by each key in turn, then (unless only
+/// unique lines are wanted) by the whole line, bytewise
+class LineOrder final {
+ public:
+    /// Lines longer than this cannot be sorted
+    static constexpr std::size_t max_line{
+        std::numeric_limits<std::uint32_t>::max()};
+
+    /// With no keys, the whole line is the key
+    LineOrder(std::vector<SortKey> keys, const SortFlags& defaults,
+              std::optional<char> tab, bool unique)
+        : keys_{std::move(keys)},
+          tab_{tab},
+          reverse_{defaults.reverse},
+          unique_{unique} {
+        if (keys_.empty()) {
+            keys_.push_back({
+                .skip_start_blanks = defaults.skip_blanks,
+                .skip_end_blanks = defaults.skip_blanks,
+                .numeric = defaults.numeric,
+                .reverse = defaults.reverse,
+            });
+        }
+    }
+
+    /// Whether lines are simply compared bytewise, which is what
+    /// MultikeyQuicksort does (only faster)
+    bool bytewise() const {
+        const SortKey& key{keys_.front()};
+        return keys_.size() == 1 && key.start_field == 0 &&
+               key.start_char == 0 && key.end_field == SortKey::to_end &&
+               !key.skip_start_blanks && !key.numeric && !key.reverse &&
+               !reverse_;
+    }
+
+    /// line must be at most max_line long
+    SortLine Make(const char* data, std::size_t size) const {
+        const std::string_view key{Extract(keys_.front(), {data, size})};
+        SortLine line{
+            .data = data,
+            .size = static_cast<std::uint32_t>(size),
+            .key_begin = static_cast<std::uint32_t>(key.data() - data),
+            .key_end = static_cast<std::uint32_t>(key.data() + key.size() -
+                                                  data),
+        };
+        line.prefix = keys_.front().numeric
+                          ? detail::NumberPrefix(key)
+                          : detail::LoadChunk(key.data(), key.size(), 0);
+        return line;
+    }
+
+    /// Negative, zero or positive as lhs goes before, with or after rhs
+    int Compare(const SortLine& lhs, const SortLine& rhs) const {
+        const SortKey& first{keys_.front()};
+        int diff{0};
+        if (lhs.prefix != rhs.prefix) {
+            diff = lhs.prefix < rhs.prefix ? -1 : 1;
+        } else if (first.numeric) {
+            diff = detail::CompareNumbers(lhs.key(), rhs.key());
+        } else {
+            diff = detail::CompareBytes(lhs.key(), rhs.key());
+        }
+        if (diff != 0) {
+            return first.reverse ? -diff : diff;
+        }
+
+        for (std::size_t i{1}; i < keys_.size(); ++i) {
+            const SortKey& key{keys_[i]};
+            const std::string_view left{Extract(key, lhs.view())};
+            const std::string_view right{Extract(key, rhs.view())};
+            diff = key.numeric ? detail::CompareNumbers(left, right)
+                               : detail::CompareBytes(left, right);
+            if (diff != 0) {
+                return key.reverse ? -diff : diff;
+            }
+        }
+
+        if (unique_) {
+            return 0;
+        }
+        diff = detail::CompareBytes(lhs.view(), rhs.view());
+        return reverse_ ? -diff : diff;
+    }
+
+ private:
+    /// The part of line that key covers, as GNU's begfield and limfield
+    /// find it
+    std::string_view Extract(const SortKey& key, std::string_view line) const {
+        const char* const end{line.data() + line.size()};
+
+        const char* begin{
+            detail::SkipFields(line.data(), end, key.start_field, tab_)};
+        if (key.skip_start_blanks) {
+            begin = detail::SkipBlanks(begin, end);
+        }
+        begin = begin + std::min<std::size_t>(key.start_char,
+                                              static_cast<std::size_t>(
+                                                  end - begin));
+
+        const char* limit{end};
+        if (key.end_field != SortKey::to_end) {
+            // a character count of 0 means all of the field, i.e. up to
+            // where the next one starts
+            limit = detail::SkipFields(
+                line.data(), end, key.end_field + (key.end_char == 0 ? 1 : 0),
+                tab_, key.end_char != 0);
+            if (key.end_char != 0) {
+                // the characters are counted within the field, so a short
+                // one does not lend the key any of the next
+                const char* const field_end{
+                    detail::SkipFields(limit, end, 1, tab_, false)};
+                if (key.skip_end_blanks) {
+                    limit = detail::SkipBlanks(limit, field_end);
+                }
+                limit = limit + std::min<std::size_t>(
+                                    key.end_char,
+                                    static_cast<std::size_t>(field_end -
+                                                             limit));
+            }
+        }
+        return {begin, static_cast<std::size_t>(std::max(begin, limit) -
+                                                begin)};
+    }
+
+    std::vector<SortKey> keys_;
+    std::optional<char> tab_;
+    bool reverse_;
+    bool unique_;
+};
+
+}  // namespace coreutils
+
+#endif  // LIB_SORTKEY_HPP_
@@ -0,0 +1,215 @@
+///
+///  @file Stats.hpp
+///  @brief --stats: a JSON report of where a utility spent its time
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_STATS_HPP_
+#define LIB_STATS_HPP_
+
+#include <cstddef>
+#include <span>
+#include <string_view>
+
+#if defined(COREUTILS_STATS)
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <iterator>
+#include <print>
+#include <string>
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+#endif
+
+#include "detail/Stats.hpp"
+
+namespace coreutils {
+
+#if defined(COREUTILS_STATS)
+
+namespace detail {
+
+struct StatsRequest final {
+    std::string program;
+    /// Empty for stderr
+    std::string path;
+    bool enabled;
+};
+
+inline StatsRequest stats_request{};
+
+/// Peak resident set size in KiB, or 0 where there is no way to ask
+inline std::uint64_t PeakRss() {
+#if defined(_WIN32)
+    return 0;
+#else
+    rusage usage{};
+    if (::getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#if defined(__APPLE__)
+    // in bytes here, rather than KiB
+    return static_cast<std::uint64_t>(usage.ru_maxrss) / 1024;
+#else
+    return static_cast<std::uint64_t>(usage.ru_maxrss);
+#endif
+#endif
+}
+
+/// One line of JSON, e.g.
+///
+///     {"utility":"wc","wall_ns":1200345,"phases_ns":{"parse":2100,...},
+///      "syscalls":{"read":18,...},"bytes":{"read":1048576,...},
+///      "peak_rss_kib":3712,"threads":[{"work":0,...}]}
+///
+/// The phases are the main thread's: io and output are the time it spent
+/// blocked in the shared I/O layer, and compute is the rest of wall. Other
+/// threads only show up under threads, since their time overlaps. There is
+/// one entry there per thread that was running at once, each adding up the
+/// threads that ran in its place one after the other.
+inline std::string FormatStats() {
+    const auto load = [](const std::atomic<std::uint64_t>& counter) {
+        return counter.load(std::memory_order_relaxed);
+    };
+    const auto phase = [&load](const StatsSlot& slot, StatsPhase which) {
+        return load(slot.nanoseconds[static_cast<std::size_t>(which)]);
+    };
+
+    const std::uint64_t wall{static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            StatsRegistry::Clock::now() - stats_registry.start())
+            .count())};
+    std::array<std::uint64_t, stats_phases> main{};
+    std::array<std::uint64_t, stats_syscalls> syscalls{};
+    std::uint64_t bytes_read{0};
+    std::uint64_t bytes_written{0};
+    std::string threads{};
+    stats_registry.ForEach([&](const StatsSlot& slot) {
+        if (threads.empty()) {
+            for (std::size_t i{0}; i < stats_phases; ++i) {
+                main[i] = load(slot.nanoseconds[i]);
+            }
+        }
+        for (std::size_t i{0}; i < stats_syscalls; ++i) {
+            syscalls[i] += load(slot.syscalls[i]);
+        }
+        bytes_read += load(slot.bytes_read);
+        bytes_written += load(slot.bytes_written);
+        std::format_to(std::back_inserter(threads),
+                       "{}{{\"work\":{},\"io_ns\":{},\"output_ns\":{}}}",
+                       threads.empty() ? "" : ",", load(slot.work),
+                       phase(slot, StatsPhase::Io),
+                       phase(slot, StatsPhase::Output));
+    });
+
+    const std::uint64_t timed{main[0] + main[1] + main[2]};
+    return std::format(
+        "{{\"utility\":\"{}\",\"wall_ns\":{},"
+        "\"phases_ns\":{{\"parse\":{},\"io\":{},\"compute\":{},"
+        "\"output\":{}}},"
+        "\"syscalls\":{{\"read\":{},\"write\":{},\"copy\":{},"
+        "\"directory\":{},\"stat\":{}}},"
+        "\"bytes\":{{\"read\":{},\"written\":{}}},"
+        "\"peak_rss_kib\":{},\"threads\":[{}]}}",
+        stats_request.program, wall, main[0], main[1],
+        wall - std::min(wall, timed), main[2], syscalls[0], syscalls[1],
+        syscalls[2], syscalls[3], syscalls[4], bytes_read, bytes_written,
+        PeakRss(), threads);
+}
+
+/// Runs at exit, after main has returned (and so after its Outputs have
+/// flushed) or after std::exit
+inline void ReportStats() {
+    const std::string report{FormatStats()};
+    const StatsRequest& request{stats_request};
+    // appended to, so that every utility in a pipeline can share one file
+    std::FILE* const file{request.path.empty()
+                              ? stderr
+                              : std::fopen(request.path.c_str(), "a")};
+    if (!file) {
+        std::println(stderr, "{}: cannot write stats to '{}': {}",
+                     request.program, request.path, std::strerror(errno));
+        return;
+    }
+    std::println(file, "{}", report);
+    if (file != stderr) {
+        std::fclose(file);
+    }
+}
+
+}  // namespace detail
+
+/// Reports on the process once it exits, to path, or to stderr if path is
+/// empty. Called by ArgumentParser for --stats.
+inline void EnableStats(std::string_view program, std::string_view path = {}) {
+    detail::StatsRequest& request{detail::stats_request};
+    request.program = program;
+    request.path = path;
+    if (!request.enabled) {
+        request.enabled = true;
+        std::atexit(detail::ReportStats);
+    }
+}
+
+/// COREUTILSPP_STATS=path reports to path, for when the command line cannot
+/// be changed (e.g. a utility run by a script)
+inline void EnableStatsFromEnvironment(std::string_view program) {
+    if (const char* const path{std::getenv("COREUTILSPP_STATS")};
+        path && *path != '\0') {
+        EnableStats(program, path);
+    }
+}
+
+/// For utilities that read their own command line, since any of it may be
+/// text (echo, printf): turns stats on from the environment, or for a
+/// leading --stats. Returns how many arguments that took, 0 or 1.
+inline std::size_t EnableStatsFromCommandLine(
+    std::string_view program, std::span<const char* const> args) {
+    EnableStatsFromEnvironment(program);
+    if (!args.empty() && std::string_view{args.front()} == "--stats") {
+        EnableStats(program);
+        return 1;
+    }
+    return 0;
+}
+
+#else
+
+constexpr void EnableStatsFromEnvironment(std::string_view) {}
+
+/// Without COREUTILS_STATS, --stats is just text
+constexpr std::size_t EnableStatsFromCommandLine(
+    std::string_view, std::span<const char* const>) {
+    return 0;
+}
+
+#endif
+
+}  // namespace coreutils
+
+#endif  // LIB_STATS_HPP_
@@ -0,0 +1,64 @@
+///
+///  @file StringSort.hpp
+///  @brief cache friendly bytewise sorting of large numbers of strings
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_STRINGSORT_HPP_
+#define LIB_STRINGSORT_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+#include "detail/StringSort.hpp"
+
+namespace coreutils {
+
+/// A string to be sorted, along with where it came from. The first 8 bytes
+/// of the string are packed next to the pointer, so most comparisons are
+/// settled without ever chasing it.
+struct SortRecord final {
+    static SortRecord Make(std::string_view str, std::uint32_t index) {
+        return {
+            .prefix = detail::LoadChunk(str.data(), str.size(), 0),
+            .data = str.data(),
+            .size = static_cast<std::uint32_t>(str.size()),
+            .index = index,
+        };
+    }
+
+    constexpr std::string_view view() const { return {data, size}; }
+
+    std::uint64_t prefix;
+    const char* data;
+    std::uint32_t size;
+    /// Position of the string in whatever the caller is sorting
+    std::uint32_t index;
+};
+
+/// Sorts records by their strings, bytewise (i.e. the C locale's order).
+/// Not stable. The prefix of each record is used as scratch space, so it is
+/// meaningless afterwards.
+inline void SortStrings(std::span<SortRecord> records) {
+    detail::MultikeyQuicksort(records.data(), records.size(), 0);
+}
+
+}  // namespace coreutils
+
+#endif  // LIB_STRINGSORT_HPP_
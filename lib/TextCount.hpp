@@ -0,0 +1,271 @@
+///
+///  @file TextCount.hpp
+///  @brief line, word and character counting over blocks of text
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_TEXTCOUNT_HPP_
+#define LIB_TEXTCOUNT_HPP_
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cwchar>
+#include <cwctype>
+#include <span>
+
+#include "detail/TextCount.hpp"
+
+namespace coreutils {
+
+/// Counts for one contiguous piece of text. Pieces counted separately (e.g.
+/// the chunks of a big file, counted on different threads) are put back
+/// together with Join, which is where a word that straddles two pieces is
+/// counted only once.
+struct TextCounts final {
+    std::uint64_t bytes;
+    std::uint64_t lines;
+    std::uint64_t words;
+    std::uint64_t characters;
+    /// Whether any byte is a space or part of a word. Others (e.g. control
+    /// characters) neither start nor end words.
+    bool has_word_or_space;
+    /// Whether the first space or word byte is part of a word
+    bool starts_in_word;
+    /// Whether the last space or word byte is part of a word
+    bool ends_in_word;
+    /// Whether every byte is ASCII, in which case the counts are the same in
+    /// every locale
+    bool ascii;
+};
+
+/// Counts text as the C locale sees it: every byte is a character, and words
+/// are made of printable bytes and separated by white space
+inline TextCounts CountText(std::span<const char> text) {
+    TextCounts counts{.bytes = text.size(),
+                      .characters = text.size(),
+                      .ascii = true};
+
+    using detail::block_size;
+    std::uint64_t after_space{1};
+    std::uint64_t high{0};
+    const auto count = [&counts, &after_space, &high](const char* block,
+                                                      std::uint64_t valid) {
+        const detail::BlockMasks masks{detail::Classify(block)};
+        const std::uint64_t spaces{masks.spaces & valid};
+        const std::uint64_t graphic{masks.graphic & valid};
+        if (!counts.has_word_or_space && (spaces | graphic) != 0) {
+            counts.has_word_or_space = true;
+            counts.starts_in_word =
+                (graphic >> std::countr_zero(spaces | graphic)) & 1;
+        }
+        counts.lines += static_cast<std::uint64_t>(
+            std::popcount(masks.newlines & valid));
+        counts.words += static_cast<std::uint64_t>(
+            std::popcount(detail::WordStarts(spaces, graphic, after_space)));
+        high |= masks.high & valid;
+    };
+
+    const char* data{text.data()};
+    const std::size_t whole{text.size() - text.size() % block_size};
+    for (std::size_t i{0}; i < whole; i += block_size) {
+        count(data + i, ~std::uint64_t{0});
+    }
+    if (const std::size_t rest{text.size() - whole}; rest != 0) {
+        std::array<char, block_size> block{};
+        std::memcpy(block.data(), data + whole, rest);
+        count(block.data(), (std::uint64_t{1} << rest) - 1);
+    }
+
+    counts.ends_in_word = counts.has_word_or_space && after_space == 0;
+    counts.ascii = high == 0;
+    return counts;
+}
+
+/// Counts text as the current locale sees it, which for single byte locales
+/// is what CountText does, only slower. Sequences that are not characters
+/// are skipped over, as is a character cut short by the end of text.
+inline TextCounts CountMultibyteText(std::span<const char> text) {
+    TextCounts counts{.bytes = text.size(), .ascii = true};
+    bool in_word{false};
+    const auto mark = [&counts, &in_word](bool word) {
+        if (!counts.has_word_or_space) {
+            counts.has_word_or_space = true;
+            counts.starts_in_word = word;
+        }
+        counts.words += word && !in_word ? 1 : 0;
+        in_word = word;
+    };
+
+    std::mbstate_t state{};
+    for (std::size_t i{0}; i < text.size();) {
+        const auto byte{static_cast<unsigned char>(text[i])};
+        if (byte < 0x80) {
+            ++counts.characters;
+            ++i;
+            counts.lines += byte == '\n' ? 1 : 0;
+            if (byte == ' ' || (byte >= '\t' && byte <= '\r')) {
+                mark(false);
+            } else if (byte > ' ' && byte < 0x7f) {
+                mark(true);
+            }
+            continue;
+        }
+
+        counts.ascii = false;
+        wchar_t c{};
+        const std::size_t length{
+            std::mbrtowc(&c, text.data() + i, text.size() - i, &state)};
+        if (length == static_cast<std::size_t>(-1) ||
+            length == static_cast<std::size_t>(-2)) {
+            state = {};
+            ++i;
+            continue;
+        }
+        ++counts.characters;
+        i += length;
+        if (detail::IsWideSpace(c)) {
+            mark(false);
+        } else if (std::iswprint(static_cast<std::wint_t>(c))) {
+            mark(true);
+        }
+    }
+    counts.ends_in_word = in_word;
+    return counts;
+}
+
+/// Counts for first immediately followed by second
+constexpr TextCounts Join(const TextCounts& first, const TextCounts& second) {
+    return {
+        .bytes = first.bytes + second.bytes,
+        .lines = first.lines + second.lines,
+        .words = first.words + second.words -
+                 (first.ends_in_word && second.starts_in_word ? 1 : 0),
+        .characters = first.characters + second.characters,
+        .has_word_or_space =
+            first.has_word_or_space || second.has_word_or_space,
+        .starts_in_word = first.has_word_or_space ? first.starts_in_word
+                                                  : second.starts_in_word,
+        .ends_in_word = second.has_word_or_space ? second.ends_in_word
+                                                 : first.ends_in_word,
+        .ascii = first.ascii && second.ascii,
+    };
+}
+
+/// Just the newlines, which needs a fraction of the work of CountText
+inline std::uint64_t CountLines(std::span<const char> text) {
+    return detail::CountNewlines(text.data(), text.size());
+}
+
+/// Where a search for newlines stopped: at the newline asked for, or, when
+/// there were fewer than that, at the end of the text (having found the
+/// rest)
+struct NewlineSearch final {
+    /// Of the newline asked for, or the end of the text searched (its size
+    /// going forward, 0 going backward) when it was not there
+    std::size_t position;
+    std::uint64_t found;
+};
+
+/// Finds the count'th newline (counting from 1) from the front of text, a
+/// block at a time, so long lines cost little more than a memchr
+inline NewlineSearch FindNewline(std::span<const char> text,
+                                 std::uint64_t count) {
+    std::uint64_t found{0};
+    std::size_t i{0};
+    for (; count > found && i + detail::block_size <= text.size();
+         i += detail::block_size) {
+        std::uint64_t mask{detail::NewlineMask(text.data() + i)};
+        const auto here{static_cast<std::uint64_t>(std::popcount(mask))};
+        if (found + here < count) {
+            found += here;
+            continue;
+        }
+        // drop the newlines before the one that is wanted
+        for (std::uint64_t skip{count - found - 1}; skip > 0; --skip) {
+            mask &= mask - 1;
+        }
+        return {
+            .position = i + static_cast<std::size_t>(std::countr_zero(mask)),
+            .found = count,
+        };
+    }
+    for (; count > found && i < text.size(); ++i) {
+        if (text[i] == '\n' && ++found == count) {
+            return {.position = i, .found = found};
+        }
+    }
+    return {.position = text.size(), .found = found};
+}
+
+/// Finds the count'th newline (counting from 1) from the back of text, for
+/// the utilities that start from the end of a file
+inline NewlineSearch FindNewlineBackward(std::span<const char> text,
+                                         std::uint64_t count) {
+    std::uint64_t found{0};
+    std::size_t end{text.size()};
+    for (; count > found && end >= detail::block_size;
+         end -= detail::block_size) {
+        std::uint64_t mask{
+            detail::NewlineMask(text.data() + end - detail::block_size)};
+        const auto here{static_cast<std::uint64_t>(std::popcount(mask))};
+        if (found + here < count) {
+            found += here;
+            continue;
+        }
+        for (std::uint64_t skip{count - found - 1}; skip > 0; --skip) {
+            mask &= ~(std::uint64_t{1} << (63 - std::countl_zero(mask)));
+        }
+        return {.position = end - detail::block_size + 63 -
+                            static_cast<std::size_t>(std::countl_zero(mask)),
+                .found = count};
+    }
+    for (; count > found && end > 0; --end) {
+        if (text[end - 1] == '\n' && ++found == count) {
+            return {.position = end - 1, .found = found};
+        }
+    }
+    return {.position = 0, .found = found};
+}
+
+/// How much of text can be counted without cutting a UTF-8 character in
+/// two, i.e. all of it unless it ends partway through one
+constexpr std::size_t Utf8Boundary(std::span<const char> text) {
+    // a character is at most 4 bytes, so only the last 3 can start one that
+    // does not fit
+    for (std::size_t back{1}; back <= std::min<std::size_t>(3, text.size());
+         ++back) {
+        const auto byte{static_cast<unsigned char>(text[text.size() - back])};
+        if ((byte & 0xc0) == 0x80) {
+            continue;
+        }
+        const int length{byte >= 0xf0   ? 4
+                         : byte >= 0xe0 ? 3
+                         : byte >= 0xc0 ? 2
+                                        : 1};
+        return static_cast<std::size_t>(length) > back ? text.size() - back
+                                                      : text.size();
+    }
+    return text.size();
+}
+
+}  // namespace coreutils
+
+#endif  // LIB_TEXTCOUNT_HPP_
@@ -0,0 +1,137 @@
+///
+///  @file Translate.hpp
+///  @brief translating, deleting and squeezing bytes in bulk, for tr
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_TRANSLATE_HPP_
+#define LIB_TRANSLATE_HPP_
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "detail/Translate.hpp"
+
+namespace coreutils {
+
+/// What every byte becomes. Starts out mapping every byte to itself.
+class ByteMap final {
+ public:
+    ByteMap() {
+        for (std::size_t i{0}; i < map_.size(); ++i) {
+            map_[i] = static_cast<unsigned char>(i);
+        }
+    }
+
+    void Set(unsigned char from, unsigned char to) {
+        map_[from] = to;
+        flips_[from >> 4][from & 0x0f] = from ^ to;
+        if (from != to) {
+            changed_ |= static_cast<std::uint16_t>(1u << (from >> 4));
+        }
+    }
+
+    unsigned char operator[](unsigned char byte) const { return map_[byte]; }
+
+    /// Maps every byte of data in place. On x86 this is a byte shuffle per
+    /// 16 bytes for every row of 16 bytes (by high nibble) that the map
+    /// changes, rather than a load and a store per byte. Maps that change
+    /// most rows (e.g. tr -c) are faster looked up a byte at a time.
+    void Apply(std::span<char> data) const {
+        auto* const bytes{reinterpret_cast<unsigned char*>(data.data())};
+        std::size_t done{0};
+#if defined(COREUTILS_SSSE3)
+        constexpr int most_rows{5};
+        if (std::popcount(changed_) <= most_rows && detail::UseSsse3()) {
+            done = detail::TranslateSsse3(bytes, data.size(), flips_,
+                                          changed_);
+        }
+#endif
+        detail::TranslatePortable(bytes + done, data.size() - done, map_);
+    }
+
+ private:
+    std::array<unsigned char, 256> map_{};
+    /// map_ xor the identity, by high nibble
+    detail::ByteRows flips_{};
+    /// Rows of flips_ that are not all zeros
+    std::uint16_t changed_{0};
+};
+
+/// A set of bytes
+class ByteSet final {
+ public:
+    void Add(unsigned char byte) {
+        members_[byte] = true;
+        auto& row{byte < 0x80 ? bitmap_.below : bitmap_.above};
+        row[byte & 0x0f] |= static_cast<unsigned char>(1u << ((byte >> 4) & 7));
+    }
+
+    bool Contains(unsigned char byte) const { return members_[byte]; }
+
+    /// Removes the members of data in place, and returns how many bytes are
+    /// left
+    std::size_t Delete(std::span<char> data) const {
+        auto* const bytes{reinterpret_cast<unsigned char*>(data.data())};
+        std::size_t done{0};
+        std::size_t kept{0};
+#if defined(COREUTILS_SSSE3)
+        if (detail::UseSsse3()) {
+            done = detail::DeleteSsse3(bytes, data.size(), bitmap_, kept);
+        }
+#endif
+        for (; done < data.size(); ++done) {
+            bytes[kept] = bytes[done];
+            kept += members_[bytes[done]] ? 0 : 1;
+        }
+        return kept;
+    }
+
+    /// Replaces every run of a repeated member in data with one of it, in
+    /// place, and returns how many bytes are left. last is the byte that
+    /// came before data (so runs carry across pieces of a stream), or -1 if
+    /// there was none, and is updated for the next piece.
+    std::size_t Squeeze(std::span<char> data, int& last) const {
+        auto* const bytes{reinterpret_cast<unsigned char*>(data.data())};
+        std::size_t done{0};
+        std::size_t kept{0};
+#if defined(COREUTILS_SSSE3)
+        if (detail::UseSsse3()) {
+            done = detail::SqueezeSsse3(bytes, data.size(), bitmap_, last,
+                                        kept);
+        }
+#endif
+        for (; done < data.size(); ++done) {
+            const unsigned char byte{bytes[done]};
+            bytes[kept] = byte;
+            kept += byte == last && members_[byte] ? 0 : 1;
+            last = byte;
+        }
+        return kept;
+    }
+
+ private:
+    std::array<bool, 256> members_{};
+    detail::ByteBitmap bitmap_{};
+};
+
+}  // namespace coreutils
+
+#endif  // LIB_TRANSLATE_HPP_
@@ -0,0 +1,189 @@
+///
+///  @file WorkStealingPool.hpp
+///  @brief thread pool for recursive, irregular workloads (e.g. tree walks)
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_WORKSTEALINGPOOL_HPP_
+#define LIB_WORKSTEALINGPOOL_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "detail/Stats.hpp"
+
+namespace coreutils {
+
+/// Every worker owns a deque of tasks. Tasks submitted from inside a task go
+/// onto the submitting worker's own deque, which it works through newest
+/// first (so a tree walk stays depth first and cache warm), while idle
+/// workers steal the oldest tasks from the other end of someone else's deque
+/// (which, in a tree walk, are the biggest untouched subtrees).
+class WorkStealingPool final {
+ public:
+    using Task = std::function<void()>;
+
+    explicit WorkStealingPool(std::size_t threads) {
+        threads = std::max<std::size_t>(threads, 1);
+        queues_.reserve(threads);
+        for (std::size_t i{0}; i < threads; ++i) {
+            queues_.push_back(std::make_unique<Queue>());
+        }
+        workers_.reserve(threads);
+        for (std::size_t i{0}; i < threads; ++i) {
+            workers_.emplace_back([this, i]() { Work(i); });
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    /// Finishes every outstanding task before tearing the workers down
+    ~WorkStealingPool() {
+        Wait();
+        {
+            std::lock_guard lock{sleep_mutex_};
+            stopping_ = true;
+        }
+        wake_.notify_all();
+    }
+
+    std::size_t size() const { return queues_.size(); }
+
+    void Submit(Task task) {
+        pending_.fetch_add(1);
+        queued_.fetch_add(1);
+        const std::size_t index{current_pool_ == this
+                                    ? current_index_
+                                    : next_queue_.fetch_add(1) % size()};
+        {
+            Queue& queue{*queues_[index]};
+            std::lock_guard lock{queue.mutex};
+            queue.tasks.push_back(std::move(task));
+        }
+        if (sleepers_.load() > 0) {
+            // taking the lock orders this against a worker that is between
+            // checking for work and going to sleep
+            { std::lock_guard lock{sleep_mutex_}; }
+            wake_.notify_one();
+        }
+    }
+
+    /// Blocks until every submitted task, and every task those submitted,
+    /// has run. Must not be called from inside a task.
+    void Wait() {
+        std::unique_lock lock{done_mutex_};
+        done_.wait(lock, [this]() { return pending_.load() == 0; });
+    }
+
+ private:
+    struct Queue final {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::optional<Task> PopOwn(std::size_t index) {
+        Queue& queue{*queues_[index]};
+        std::lock_guard lock{queue.mutex};
+        if (queue.tasks.empty()) {
+            return std::nullopt;
+        }
+        Task task{std::move(queue.tasks.back())};
+        queue.tasks.pop_back();
+        return task;
+    }
+
+    std::optional<Task> Steal(std::size_t thief) {
+        for (std::size_t offset{1}; offset < size(); ++offset) {
+            Queue& queue{*queues_[(thief + offset) % size()]};
+            std::lock_guard lock{queue.mutex};
+            if (!queue.tasks.empty()) {
+                Task task{std::move(queue.tasks.front())};
+                queue.tasks.pop_front();
+                return task;
+            }
+        }
+        return std::nullopt;
+    }
+
+    void Work(std::size_t index) {
+        current_pool_ = this;
+        current_index_ = index;
+        while (true) {
+            std::optional<Task> task{PopOwn(index)};
+            if (!task) {
+                task = Steal(index);
+            }
+
+            if (task) {
+                queued_.fetch_sub(1);
+                (*task)();
+                detail::CountWork();
+                if (pending_.fetch_sub(1) == 1) {
+                    { std::lock_guard lock{done_mutex_}; }
+                    done_.notify_all();
+                }
+                continue;
+            }
+
+            std::unique_lock lock{sleep_mutex_};
+            sleepers_.fetch_add(1);
+            wake_.wait(lock,
+                       [this]() { return queued_.load() > 0 || stopping_; });
+            sleepers_.fetch_sub(1);
+            if (stopping_ && queued_.load() == 0) {
+                return;
+            }
+        }
+    }
+
+    static inline thread_local WorkStealingPool* current_pool_{nullptr};
+    static inline thread_local std::size_t current_index_{0};
+
+    std::vector<std::unique_ptr<Queue>> queues_{};
+    /// Submitted but not yet finished
+    std::atomic<std::size_t> pending_{0};
+    /// Sitting in some deque
+    std::atomic<std::size_t> queued_{0};
+    std::atomic<std::size_t> next_queue_{0};
+
+    std::mutex sleep_mutex_{};
+    std::condition_variable wake_{};
+    std::atomic<std::size_t> sleepers_{0};
+    bool stopping_{false};
+
+    std::mutex done_mutex_{};
+    std::condition_variable done_{};
+
+    // declared last so the workers are joined before anything they touch is
+    // destroyed
+    std::vector<std::jthread> workers_{};
+};
+
+}  // namespace coreutils
+
+#endif  // LIB_WORKSTEALINGPOOL_HPP_
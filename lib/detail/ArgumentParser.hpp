@@ -23,13 +23,14 @@
 
 #include <algorithm>
 #include <array>
+#include <bit>
 #include <concepts>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
-#include <format>
+#include <expected>
 #include <functional>
-#include <stdexcept>
+#include <span>
 #include <string_view>
 #include <type_traits>
 #include <vector>
@@ -71,8 +72,39 @@ enum struct NArgs : std::uint8_t {
     None,  // e.g. --verbose
     One,   // e.g. --directory foo/bar
     Many,  // e.g. --names bob sally mary ...
+    Each,  // e.g. -k 2,2 -k 1,1
 };
 
+/// What went wrong with a command line. Kept to a byte so that a failed parse
+/// costs nothing until (and unless) the message is actually printed.
+enum class ParseErrorKind : std::uint8_t {
+    DuplicateOption,  // e.g. -v -v, for an option that takes no values
+    MissingValues,    // e.g. --names --verbose
+    MissingValue,     // e.g. a trailing --directory
+    TooManyValues,    // more values than a fixed capacity container holds
+    UnexpectedValue,  // e.g. --verbose=yes, for an option that takes none
+    UnknownOption,    // e.g. --colour=auto, when there is no --colour
+};
+
+using ParseResult = std::expected<void, ParseErrorKind>;
+/// Whether the token was consumed as a value, if it was valid at all
+using ValueResult = std::expected<bool, ParseErrorKind>;
+
+/// Adds value to container, which may be full (see FixedVector)
+template <class Container, class T>
+constexpr bool Append(Container& container, T&& value) {
+    if constexpr (requires {
+                      {
+                          container.emplace_back(std::forward<T>(value))
+                      } -> std::same_as<bool>;
+                  }) {
+        return container.emplace_back(std::forward<T>(value));
+    } else {
+        container.emplace_back(std::forward<T>(value));
+        return true;
+    }
+}
+
 template <ComptimeString PrimaryName, ComptimeString... Aliases>
 struct ArgumentBase {
     static_assert(PrimaryName.PrintableView().starts_with("-"),
@@ -84,6 +116,11 @@ struct ArgumentBase {
     static inline constexpr std::string_view help_view_{
         PrimaryName.PrintableView()};
 
+    static inline constexpr bool positional_{false};
+
+    /// Whether the next value on the command line belongs to this argument
+    constexpr bool seeking() const { return state_ == ParseState::Seeking; }
+
  protected:
     ParseState state_{ParseState::Start};
 };
@@ -94,11 +131,18 @@ struct ArgumentBase<""> {
 
     static inline constexpr std::string_view help_view_{};
 
+    static inline constexpr bool positional_{true};
+
+    constexpr bool seeking() const { return state_ == ParseState::Seeking; }
+
  protected:
     ParseState state_{ParseState::Start};
 };
 
-template <class ParseType, NArgs N, auto Converter, ComptimeString... Names>
+/// Container holds the values of arguments that take many (and is unused
+/// otherwise), e.g. std::vector
+template <class ParseType, NArgs N, auto Converter,
+          template <class> class Container, ComptimeString... Names>
     requires std::regular_invocable<decltype(Converter), std::string_view>
 struct Argument final {
     static_assert(false, "Use a specialized version of this struct");
@@ -106,121 +150,126 @@ struct Argument final {
 
 /// Specialization to specify an argument that can receive one or more
 /// args
-template <class T, auto Converter, ComptimeString... Names>
+template <class T, auto Converter, template <class> class Container,
+          ComptimeString... Names>
     requires std::regular_invocable<decltype(Converter), std::string_view>
-struct Argument<T, NArgs::Many, Converter, Names...> : ArgumentBase<Names...> {
+struct Argument<T, NArgs::Many, Converter, Container, Names...>
+    : ArgumentBase<Names...> {
     static_assert(!std::is_same_v<void, T>,
                   "Flag arguments cannot be of type void");
 
-    constexpr void TryParseValue(std::string_view arg) {
+    static inline constexpr NArgs nargs_{NArgs::Many};
+
+    /// Returns whether arg was consumed as one of this argument's values
+    constexpr ValueResult TryParseValue(std::string_view arg) {
         switch (ArgumentBase<Names...>::state_) {
             case ParseState::Start:
             case ParseState::End:
                 // ignore
-                break;
+                return false;
             case ParseState::Seeking:
-                value.emplace_back(std::invoke(Converter, arg));
-                break;
+                if (!Append(value, std::invoke(Converter, arg))) {
+                    return std::unexpected{ParseErrorKind::TooManyValues};
+                }
+                return true;
         }
+        return false;
     }
-    constexpr void TryParseFlag(std::string_view arg) {
-        bool is_this{std::ranges::any_of(
-            ArgumentBase<Names...>::names_,
-            [arg](std::string_view name) { return name == arg; })};
-
+    /// Called with arg being one of this argument's names
+    constexpr ParseResult ParseFlag(std::string_view _) {
         switch (ArgumentBase<Names...>::state_) {
             case ParseState::Start:
-                if (is_this) {
-                    ArgumentBase<Names...>::state_ = ParseState::Seeking;
-                }
+                ArgumentBase<Names...>::state_ = ParseState::Seeking;
                 break;
             case ParseState::Seeking:
-                if (is_this) {
-                    throw std::runtime_error{
-                        std::format("ERROR! Duplicate option: {}", arg)};
-                } else if (!value.size()) {
-                    throw std::runtime_error{std::format(
-                        "ERROR! Do not specify {} and supply no arguments",
-                        arg)};
-                } else {
-                    ArgumentBase<Names...>::state_ = ParseState::End;
-                }
-                break;
             case ParseState::End:
-                if (is_this) {
-                    throw std::runtime_error{
-                        std::format("ERROR! Duplicate option: {}", arg)};
-                }
-                break;
+                return std::unexpected{ParseErrorKind::DuplicateOption};
         }
+        return {};
+    }
+    /// Called when some other flag comes along while this one is seeking,
+    /// which ends its list of values
+    constexpr ParseResult ParseOtherFlag(std::string_view _) {
+        if (!value.size()) {
+            return std::unexpected{ParseErrorKind::MissingValues};
+        }
+        ArgumentBase<Names...>::state_ = ParseState::End;
+        return {};
     }
 
-    // TODO(SEP): maybe take a template-template parameter to not force vector?
-    std::vector<T> value{};
+    Container<T> value{};
 };
 
-template <class T, auto Converter>
+template <class T, auto Converter, template <class> class Container>
     requires std::regular_invocable<decltype(Converter), std::string_view>
-struct Argument<T, NArgs::Many, Converter, ""> : ArgumentBase<""> {
+struct Argument<T, NArgs::Many, Converter, Container, "">
+    : ArgumentBase<""> {
     static_assert(!std::is_same_v<void, T>,
                   "Positional arguments cannot be of type void");
 
-    constexpr void TryParseValue(std::string_view arg) {
+    static inline constexpr NArgs nargs_{NArgs::Many};
+
+    /// Positional arguments take whatever values no option claimed, wherever
+    /// they appear relative to the flags
+    constexpr ValueResult TryParseValue(std::string_view arg) {
         switch (this->state_) {
             case ParseState::Start:
                 ArgumentBase<"">::state_ = ParseState::Seeking;
                 // NOTE: fallthrough
             case ParseState::Seeking:
-                value.emplace_back(std::invoke(Converter, arg));
-                break;
+                if (!Append(value, std::invoke(Converter, arg))) {
+                    return std::unexpected{ParseErrorKind::TooManyValues};
+                }
+                return true;
             case ParseState::End:
                 break;
         }
+        return false;
     }
-    constexpr void TryParseFlag(std::string_view _) {
-        ArgumentBase<"">::state_ = ParseState::End;
-    }
+    constexpr ParseResult ParseFlag(std::string_view _) { return {}; }
+    constexpr ParseResult ParseOtherFlag(std::string_view _) { return {}; }
 
-    // TODO(SEP): maybe take a template-template parameter to not force vector?
-    std::vector<T> value{};
+    Container<T> value{};
 };
 
-template <class T, auto Converter, ComptimeString... Names>
-struct Argument<T, NArgs::None, Converter, Names...> : ArgumentBase<Names...> {
+template <class T, auto Converter, template <class> class Container,
+          ComptimeString... Names>
+struct Argument<T, NArgs::None, Converter, Container, Names...>
+    : ArgumentBase<Names...> {
     static_assert(std::is_same_v<void, T>,
                   "A flag returning no values cannot have a non-void type");
 
-    constexpr void TryParseValue(std::string_view _) {}
-    constexpr void TryParseFlag(std::string_view arg) {
-        bool is_this{std::ranges::any_of(
-            ArgumentBase<Names...>::names_,
-            [arg](std::string_view name) { return name == arg; })};
-
-        if (is_this) {
-            switch (this->state_) {
-                case ParseState::Start:
-                    value = true;
-                    this->state_ = ParseState::End;
-                    break;
-                case ParseState::Seeking:
-                case ParseState::End:
-                    throw std::runtime_error{
-                        std::format("ERROR! Duplicate option: {}", arg)};
-                    break;
-            }
+    static inline constexpr NArgs nargs_{NArgs::None};
+
+    constexpr ValueResult TryParseValue(std::string_view _) { return false; }
+    constexpr ParseResult ParseFlag(std::string_view _) {
+        switch (this->state_) {
+            case ParseState::Start:
+                value = true;
+                this->state_ = ParseState::End;
+                break;
+            case ParseState::Seeking:
+            case ParseState::End:
+                return std::unexpected{ParseErrorKind::DuplicateOption};
         }
+        return {};
     }
+    constexpr ParseResult ParseOtherFlag(std::string_view _) { return {}; }
 
     bool value{};
 };
 
-template <class T, auto Converter, ComptimeString... Names>
+template <class T, auto Converter, template <class> class Container,
+          ComptimeString... Names>
     requires std::regular_invocable<decltype(Converter), std::string_view>
-struct Argument<T, NArgs::One, Converter, Names...> : ArgumentBase<Names...> {
+struct Argument<T, NArgs::One, Converter, Container, Names...>
+    : ArgumentBase<Names...> {
     static_assert(!std::is_same_v<void, T>,
                   "Flag argument cannot be of type void");
 
-    constexpr void TryParseValue(std::string_view arg) {
+    static inline constexpr NArgs nargs_{NArgs::One};
+
+    constexpr ValueResult TryParseValue(std::string_view arg) {
         switch (this->state_) {
             case ParseState::Start:
             case ParseState::End:
@@ -228,32 +277,224 @@ struct Argument<T, NArgs::One, Converter, Names...> : ArgumentBase<Names...> {
             case ParseState::Seeking:
                 value = std::invoke(Converter, arg);
                 ArgumentBase<Names...>::state_ = ParseState::End;
-                break;
+                return true;
         }
+        return false;
     }
-    constexpr void TryParseFlag(std::string_view arg) {
-        bool is_this{std::ranges::any_of(
-            ArgumentBase<Names...>::names_,
-            [arg](std::string_view name) { return name == arg; })};
-
+    constexpr ParseResult ParseFlag(std::string_view _) {
         switch (ArgumentBase<Names...>::state_) {
             case ParseState::Start:
-                if (is_this) {
-                    this->state_ = ParseState::Seeking;
-                }
+                this->state_ = ParseState::Seeking;
                 break;
             case ParseState::Seeking:
             case ParseState::End:
-                if (is_this) {
-                    throw std::runtime_error{std::format(
-                        "ERROR: unexpected repeated flag: {}", arg)};
-                }
-                break;
+                return std::unexpected{ParseErrorKind::DuplicateOption};
         }
+        return {};
     }
+    /// Never called: while seeking, the very next token is the value, even
+    /// if it starts with a - (e.g. a negative number)
+    constexpr ParseResult ParseOtherFlag(std::string_view _) { return {}; }
 
     T value{};
 };
+
+/// Specialization for an option that takes one value every time it is
+/// given, and can be given any number of times
+template <class T, auto Converter, template <class> class Container,
+          ComptimeString... Names>
+    requires std::regular_invocable<decltype(Converter), std::string_view>
+struct Argument<T, NArgs::Each, Converter, Container, Names...>
+    : ArgumentBase<Names...> {
+    static_assert(!std::is_same_v<void, T>,
+                  "Flag argument cannot be of type void");
+
+    static inline constexpr NArgs nargs_{NArgs::Each};
+
+    constexpr ValueResult TryParseValue(std::string_view arg) {
+        if (this->state_ != ParseState::Seeking) {
+            return false;
+        }
+        if (!Append(value, std::invoke(Converter, arg))) {
+            return std::unexpected{ParseErrorKind::TooManyValues};
+        }
+        // ready for the next time the option is given
+        this->state_ = ParseState::Start;
+        return true;
+    }
+    constexpr ParseResult ParseFlag(std::string_view _) {
+        this->state_ = ParseState::Seeking;
+        return {};
+    }
+    /// Never called, as with NArgs::One
+    constexpr ParseResult ParseOtherFlag(std::string_view _) { return {}; }
+
+    Container<T> value{};
+};
+
+/// An option name, and which of the parser's arguments it belongs to
+struct FlagName final {
+    std::string_view name{};
+    std::size_t index{0};
+};
+
+/// Every option name of every argument, in order
+template <class... Args>
+consteval auto CollectFlagNames() {
+    std::array<FlagName, (Args::names_.size() + ... + 0)> names{};
+    std::size_t next{0};
+    std::size_t index{0};
+    // unused when there are no arguments at all
+    [[maybe_unused]] const auto add = [&names, &next,
+                                       &index](const auto& argument_names) {
+        for (const std::string_view name : argument_names) {
+            names[next++] = {.name = name, .index = index};
+        }
+        ++index;
+    };
+    (add(Args::names_), ...);
+    return names;
+}
+
+template <std::size_t Count>
+consteval bool HasDistinctNames(const std::array<FlagName, Count>& names) {
+    for (std::size_t i{0}; i < Count; ++i) {
+        for (std::size_t j{i + 1}; j < Count; ++j) {
+            if (names[i].name == names[j].name) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/// FNV-1a
+constexpr std::uint64_t HashFlag(std::string_view name) {
+    std::uint64_t hash{0xcbf29ce484222325};
+    for (const char c : name) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+/// The splitmix64 finalizer, over a name's hash moved by displacement, so
+/// that every displacement scatters the names differently
+constexpr std::uint64_t MixFlag(std::uint64_t hash,
+                                std::uint32_t displacement) {
+    hash ^= displacement * 0x9e3779b97f4a7c15;
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111eb;
+    return hash ^ (hash >> 31);
+}
+
+/// A perfect hash table over a fixed set of option names, built at compile
+/// time: every name gets a slot of its own, so a lookup is one hash and one
+/// string comparison, no matter how many options there are.
+///
+/// A single seed that separates every name stops turning up once there are
+/// more than a few dozen names (the chance of no collisions at all falls off
+/// with the square of the count), so this hashes and displaces instead. Names
+/// are split into buckets of about two by their hash, and each bucket gets a
+/// displacement of its own that moves its names into free slots, which with
+/// four slots per name takes a try or two per bucket.
+template <std::size_t Count>
+class FlagTable final {
+ public:
+    static constexpr std::size_t size{std::bit_ceil(4 * Count + 1)};
+    static constexpr std::size_t buckets{std::bit_ceil(Count / 2 + 1)};
+
+    consteval explicit FlagTable(const std::array<FlagName, Count>& names) {
+        // no displacement can ever separate two equal names (the parser
+        // reports those with a static_assert of its own)
+        if (!HasDistinctNames(names)) {
+            return;
+        }
+
+        // names grouped by bucket: those of bucket b are members[starts[b]]
+        // up to members[starts[b + 1]]
+        std::array<std::uint64_t, Count> hashes{};
+        std::array<std::size_t, buckets + 1> starts{};
+        for (std::size_t i{0}; i < Count; ++i) {
+            hashes[i] = HashFlag(names[i].name);
+            ++starts[Bucket(hashes[i]) + 1];
+        }
+        for (std::size_t b{0}; b < buckets; ++b) {
+            starts[b + 1] += starts[b];
+        }
+        std::array<std::size_t, Count> members{};
+        std::array<std::size_t, buckets> filled{};
+        for (std::size_t i{0}; i < Count; ++i) {
+            const std::size_t bucket{Bucket(hashes[i])};
+            members[starts[bucket] + filled[bucket]++] = i;
+        }
+
+        // the fullest buckets are the hardest to place, so they go first,
+        // while the table is still empty
+        std::array<std::size_t, buckets> order{};
+        for (std::size_t b{0}; b < buckets; ++b) {
+            order[b] = b;
+        }
+        std::ranges::sort(order, [&filled](std::size_t a, std::size_t b) {
+            return filled[a] > filled[b];
+        });
+        for (const std::size_t bucket : order) {
+            const std::span<const std::size_t> group{
+                members.data() + starts[bucket], filled[bucket]};
+            while (!TryPlace(names, hashes, group, bucket)) {
+                ++displacements_[bucket];
+            }
+        }
+    }
+
+    /// Which argument name belongs to, if any, along with its spelling (which
+    /// unlike name, outlives the parse)
+    constexpr const FlagName* Find(std::string_view name) const {
+        const std::uint64_t hash{HashFlag(name)};
+        const FlagName& slot{slots_[Slot(hash, displacements_[Bucket(hash)])]};
+        return !slot.name.empty() && slot.name == name ? &slot : nullptr;
+    }
+
+ private:
+    /// Multiply-shift, as FNV-1a leaves names that differ only in their last
+    /// character (-a, -b, ...) differing in few of the middle bits
+    static constexpr std::size_t Bucket(std::uint64_t hash) {
+        return static_cast<std::size_t>((hash * 0x9e3779b97f4a7c15) >> 32) &
+               (buckets - 1);
+    }
+
+    static constexpr std::size_t Slot(std::uint64_t hash,
+                                      std::uint32_t displacement) {
+        return static_cast<std::size_t>(MixFlag(hash, displacement)) &
+               (size - 1);
+    }
+
+    /// Puts every name of group (the names in bucket) into a free slot
+    /// under the bucket's current displacement, or none of them if any
+    /// collide
+    consteval bool TryPlace(const std::array<FlagName, Count>& names,
+                            const std::array<std::uint64_t, Count>& hashes,
+                            std::span<const std::size_t> group,
+                            std::size_t bucket) {
+        for (std::size_t placed{0}; placed < group.size(); ++placed) {
+            const std::size_t i{group[placed]};
+            FlagName& slot{slots_[Slot(hashes[i], displacements_[bucket])]};
+            if (!slot.name.empty()) {
+                for (std::size_t j{0}; j < placed; ++j) {
+                    slots_[Slot(hashes[group[j]], displacements_[bucket])] =
+                        {};
+                }
+                return false;
+            }
+            slot = names[i];
+        }
+        return true;
+    }
+
+    std::array<FlagName, size> slots_{};
+    std::array<std::uint32_t, buckets> displacements_{};
+};
+
 }  // namespace coreutils::detail
 
 #endif  // LIB_DETAIL_ARGUMENTPARSER_HPP_
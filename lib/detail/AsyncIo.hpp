@@ -0,0 +1,239 @@
+///
+///  @file AsyncIo.hpp
+///  @brief the io_uring rings behind coreutilspp batched I/O
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_DETAIL_ASYNCIO_HPP_
+#define LIB_DETAIL_ASYNCIO_HPP_
+
+#if defined(COREUTILS_IO_URING) && defined(__linux__)
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <system_error>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace coreutils::detail {
+
+/// A submission queue and a completion queue, shared with the kernel. Only
+/// the thread that made it may use it. Built on the raw syscalls, so that
+/// nothing beyond the kernel headers is needed.
+class Ring final {
+ public:
+    /// Null when the kernel has no io_uring, it is turned off (e.g. by
+    /// seccomp, or the kernel.io_uring_disabled sysctl), or it cannot do
+    /// every one of ops. entries is rounded up to a power of two, and
+    /// clamped to what the kernel allows.
+    static std::unique_ptr<Ring> Create(unsigned entries,
+                                        std::span<const std::uint8_t> ops) {
+        io_uring_params params{};
+        params.flags = IORING_SETUP_CLAMP;
+        const long fd{::syscall(__NR_io_uring_setup, entries, &params)};
+        if (fd < 0) {
+            return nullptr;
+        }
+        std::unique_ptr<Ring> ring{new Ring{static_cast<int>(fd)}};
+        if (!ring->Map(params) || !ring->Supports(ops)) {
+            return nullptr;
+        }
+        return ring;
+    }
+
+    Ring(const Ring&) = delete;
+    Ring& operator=(const Ring&) = delete;
+
+    ~Ring() {
+        if (sqes_ != MAP_FAILED) {
+            ::munmap(sqes_, sqes_size_);
+        }
+        if (cq_ != MAP_FAILED && cq_ != sq_) {
+            ::munmap(cq_, cq_size_);
+        }
+        if (sq_ != MAP_FAILED) {
+            ::munmap(sq_, sq_size_);
+        }
+        ::close(fd_);
+    }
+
+    /// How many submissions fit at once. The completion queue is twice as
+    /// big, so it cannot overflow while no more than this are in flight.
+    unsigned capacity() const { return sq_entries_; }
+
+    /// The next submission, zeroed, to be filled in and then handed over by
+    /// Submit. There must be fewer than capacity() in flight.
+    io_uring_sqe& Prepare() {
+        io_uring_sqe& sqe{sqes_[tail_ & sq_mask_]};
+        ++tail_;
+        sqe = {};
+        return sqe;
+    }
+
+    /// Hands everything prepared to the kernel, and waits until at least
+    /// wait operations have completed. EAGAIN and EBUSY mean the kernel is
+    /// out of room until completions are reaped.
+    std::error_code Submit(unsigned wait) {
+        std::atomic_ref{*sq_tail_}.store(tail_, std::memory_order_release);
+        while (true) {
+            const unsigned pending{
+                tail_ -
+                std::atomic_ref{*sq_head_}.load(std::memory_order_acquire)};
+            if (::syscall(__NR_io_uring_enter, fd_, pending, wait,
+                          wait > 0 ? IORING_ENTER_GETEVENTS : 0u, nullptr,
+                          0) >= 0) {
+                return {};
+            } else if (errno != EINTR) {
+                return std::error_code{errno, std::system_category()};
+            }
+        }
+    }
+
+    /// Takes back every prepared submission the kernel has not taken yet,
+    /// calling withdrawn(user_data) for each. Returns how many there were.
+    template <class Withdrawn>
+    std::size_t Withdraw(Withdrawn&& withdrawn) {
+        const unsigned head{
+            std::atomic_ref{*sq_head_}.load(std::memory_order_acquire)};
+        const std::size_t count{tail_ - head};
+        for (; tail_ != head; --tail_) {
+            withdrawn(sqes_[(tail_ - 1) & sq_mask_].user_data);
+        }
+        std::atomic_ref{*sq_tail_}.store(tail_, std::memory_order_release);
+        return count;
+    }
+
+    /// Calls done(user_data, res) for every operation completed so far,
+    /// where res is what the syscall would have returned, or a negated
+    /// errno. Returns how many there were.
+    template <class Done>
+    std::size_t Reap(Done&& done) {
+        unsigned head{
+            std::atomic_ref{*cq_head_}.load(std::memory_order_relaxed)};
+        const unsigned tail{
+            std::atomic_ref{*cq_tail_}.load(std::memory_order_acquire)};
+        const std::size_t count{tail - head};
+        for (; head != tail; ++head) {
+            const io_uring_cqe& cqe{cqes_[head & cq_mask_]};
+            done(cqe.user_data, cqe.res);
+        }
+        std::atomic_ref{*cq_head_}.store(head, std::memory_order_release);
+        return count;
+    }
+
+ private:
+    explicit Ring(int fd) : fd_{fd} {}
+
+    template <class T>
+    T* At(void* base, std::uint32_t offset) {
+        return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+    }
+
+    bool Map(const io_uring_params& params) {
+        sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_size_ =
+            params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single{(params.features & IORING_FEAT_SINGLE_MMAP) != 0};
+        if (single) {
+            sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+        }
+        sq_ = ::mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+        if (sq_ == MAP_FAILED) {
+            return false;
+        }
+        cq_ = single ? sq_
+                     : ::mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_POPULATE, fd_,
+                              IORING_OFF_CQ_RING);
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(
+            ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES));
+        if (cq_ == MAP_FAILED || sqes_ == MAP_FAILED) {
+            return false;
+        }
+
+        sq_entries_ = params.sq_entries;
+        sq_head_ = At<unsigned>(sq_, params.sq_off.head);
+        sq_tail_ = At<unsigned>(sq_, params.sq_off.tail);
+        sq_mask_ = *At<unsigned>(sq_, params.sq_off.ring_mask);
+        cq_head_ = At<unsigned>(cq_, params.cq_off.head);
+        cq_tail_ = At<unsigned>(cq_, params.cq_off.tail);
+        cq_mask_ = *At<unsigned>(cq_, params.cq_off.ring_mask);
+        cqes_ = At<io_uring_cqe>(cq_, params.cq_off.cqes);
+        tail_ = *sq_tail_;
+        // submission i always lives in slot i, so the indirection array
+        // is filled in once
+        unsigned* const array{At<unsigned>(sq_, params.sq_off.array)};
+        for (unsigned i{0}; i < sq_entries_; ++i) {
+            array[i] = i;
+        }
+        return true;
+    }
+
+    /// Whether the kernel can do every one of ops (it learned them one
+    /// release at a time)
+    bool Supports(std::span<const std::uint8_t> ops) {
+        constexpr std::size_t probed{256};
+        const std::unique_ptr<std::byte[]> storage{new std::byte[
+            sizeof(io_uring_probe) + probed * sizeof(io_uring_probe_op)]()};
+        auto* const probe{reinterpret_cast<io_uring_probe*>(storage.get())};
+        if (::syscall(__NR_io_uring_register, fd_, IORING_REGISTER_PROBE,
+                      probe, probed) < 0) {
+            return false;
+        }
+        return std::ranges::all_of(ops, [probe](std::uint8_t op) {
+            return op < probe->ops_len &&
+                   (probe->ops[op].flags & IO_URING_OP_SUPPORTED) != 0;
+        });
+    }
+
+    int fd_;
+    void* sq_{MAP_FAILED};
+    void* cq_{MAP_FAILED};
+    io_uring_sqe* sqes_{static_cast<io_uring_sqe*>(MAP_FAILED)};
+    std::size_t sq_size_{0};
+    std::size_t cq_size_{0};
+    std::size_t sqes_size_{0};
+
+    unsigned sq_entries_{0};
+    unsigned* sq_head_{nullptr};
+    unsigned* sq_tail_{nullptr};
+    unsigned sq_mask_{0};
+    unsigned* cq_head_{nullptr};
+    unsigned* cq_tail_{nullptr};
+    unsigned cq_mask_{0};
+    io_uring_cqe* cqes_{nullptr};
+    /// Where the next submission goes, ahead of the kernel's view of the
+    /// tail until Submit
+    unsigned tail_{0};
+};
+
+}  // namespace coreutils::detail
+
+#endif
+
+#endif  // LIB_DETAIL_ASYNCIO_HPP_
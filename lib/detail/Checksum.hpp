@@ -0,0 +1,480 @@
+///
+///  @file Checksum.hpp
+///  @brief block functions of the MD5, SHA-256 and BLAKE2b hashes
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_DETAIL_CHECKSUM_HPP_
+#define LIB_DETAIL_CHECKSUM_HPP_
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <utility>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define COREUTILS_SHA_NI 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace coreutils::detail {
+
+template <class Word>
+constexpr Word LoadLittle(const unsigned char* bytes) {
+    Word word{0};
+    for (std::size_t i{0}; i < sizeof(Word); ++i) {
+        word |= static_cast<Word>(bytes[i]) << (8 * i);
+    }
+    return word;
+}
+
+template <class Word>
+constexpr Word LoadBig(const unsigned char* bytes) {
+    Word word{0};
+    for (std::size_t i{0}; i < sizeof(Word); ++i) {
+        word = static_cast<Word>(word << 8) | bytes[i];
+    }
+    return word;
+}
+
+template <class Word>
+constexpr void StoreLittle(Word word, unsigned char* bytes) {
+    for (std::size_t i{0}; i < sizeof(Word); ++i) {
+        bytes[i] = static_cast<unsigned char>(word >> (8 * i));
+    }
+}
+
+template <class Word>
+constexpr void StoreBig(Word word, unsigned char* bytes) {
+    for (std::size_t i{0}; i < sizeof(Word); ++i) {
+        bytes[i] =
+            static_cast<unsigned char>(word >> (8 * (sizeof(Word) - 1 - i)));
+    }
+}
+
+/// Gathers input into whole blocks for a block function, called as
+/// compress(blocks, count). Whole blocks in the input are handed over
+/// where they are, without a copy. When hold_last is set, the last block
+/// is held back even when it is whole, for hashes (like BLAKE2b) that
+/// treat the final block differently.
+template <std::size_t BlockSize, bool HoldLast = false>
+struct BlockBuffer final {
+    template <class Compress>
+    void Feed(std::span<const char> input, Compress&& compress) {
+        const auto* data{reinterpret_cast<const unsigned char*>(input.data())};
+        std::size_t size{input.size()};
+        if (fill > 0 || (HoldLast && size <= BlockSize)) {
+            const std::size_t taken{std::min(size, BlockSize - fill)};
+            std::memcpy(bytes.data() + fill, data, taken);
+            fill += taken;
+            data += taken;
+            size -= taken;
+            if (fill < BlockSize || (HoldLast && size == 0)) {
+                return;
+            }
+            compress(bytes.data(), 1);
+            fill = 0;
+        }
+
+        std::size_t blocks{size / BlockSize};
+        if (HoldLast && blocks > 0 && size % BlockSize == 0) {
+            --blocks;
+        }
+        if (blocks > 0) {
+            compress(data, blocks);
+            data += blocks * BlockSize;
+            size -= blocks * BlockSize;
+        }
+        std::memcpy(bytes.data(), data, size);
+        fill = size;
+    }
+
+    std::array<unsigned char, BlockSize> bytes{};
+    std::size_t fill{0};
+};
+
+/// Merkle-Damgard padding, as in MD5 and SHA-2: a one bit, zeros, and the
+/// length in bits in the last 8 bytes of the last block
+template <bool BigEndian, class Compress>
+void PadBlocks(BlockBuffer<64>& buffer, std::uint64_t length,
+               Compress&& compress) {
+    buffer.bytes[buffer.fill++] = 0x80;
+    if (buffer.fill > 56) {
+        std::fill(buffer.bytes.begin() +
+                      static_cast<std::ptrdiff_t>(buffer.fill),
+                  buffer.bytes.end(), 0);
+        compress(buffer.bytes.data(), 1);
+        buffer.fill = 0;
+    }
+    std::fill(buffer.bytes.begin() + static_cast<std::ptrdiff_t>(buffer.fill),
+              buffer.bytes.begin() + 56, 0);
+    if constexpr (BigEndian) {
+        StoreBig(length * 8, buffer.bytes.data() + 56);
+    } else {
+        StoreLittle(length * 8, buffer.bytes.data() + 56);
+    }
+    compress(buffer.bytes.data(), 1);
+    buffer.fill = 0;
+}
+
+// -----------------------------------------------------------------------------
+// MD5 (RFC 1321)
+// -----------------------------------------------------------------------------
+
+inline constexpr std::array<std::uint32_t, 64> md5_sines{
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a,
+    0xa8304613, 0xfd469501, 0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
+    0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821, 0xf61e2562, 0xc040b340,
+    0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8,
+    0x676f02d9, 0x8d2a4c8a, 0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,
+    0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70, 0x289b7ec6, 0xeaa127fa,
+    0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92,
+    0xffeff47d, 0x85845dd1, 0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
+    0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
+};
+
+/// Step I of 64. Steps are written out at compile time (see Md5Blocks), so
+/// that the state stays in registers and every choice below is made by the
+/// compiler.
+template <std::size_t I>
+inline void Md5Step(std::uint32_t& a, std::uint32_t b, std::uint32_t c,
+                    std::uint32_t d,
+                    const std::array<std::uint32_t, 16>& words) {
+    constexpr std::array<int, 16> shifts{
+        7, 12, 17, 22, 5, 9, 14, 20, 4, 11, 16, 23, 6, 10, 15, 21,
+    };
+    std::uint32_t mixed{};
+    std::size_t word{};
+    if constexpr (I < 16) {
+        mixed = d ^ (b & (c ^ d));
+        word = I;
+    } else if constexpr (I < 32) {
+        mixed = c ^ (d & (b ^ c));
+        word = (5 * I + 1) % 16;
+    } else if constexpr (I < 48) {
+        mixed = b ^ c ^ d;
+        word = (3 * I + 5) % 16;
+    } else {
+        mixed = c ^ (b | ~d);
+        word = (7 * I) % 16;
+    }
+    a = b + std::rotl(a + mixed + md5_sines[I] + words[word],
+                      shifts[(I / 16) * 4 + I % 4]);
+}
+
+/// Four steps at a time, as each one updates the next of a, d, c and b
+template <std::size_t... Groups>
+inline void Md5Steps(std::uint32_t& a, std::uint32_t& b, std::uint32_t& c,
+                     std::uint32_t& d,
+                     const std::array<std::uint32_t, 16>& words,
+                     std::index_sequence<Groups...>) {
+    ((Md5Step<4 * Groups>(a, b, c, d, words),
+      Md5Step<4 * Groups + 1>(d, a, b, c, words),
+      Md5Step<4 * Groups + 2>(c, d, a, b, words),
+      Md5Step<4 * Groups + 3>(b, c, d, a, words)),
+     ...);
+}
+
+inline void Md5Blocks(std::array<std::uint32_t, 4>& state,
+                      const unsigned char* data, std::size_t blocks) {
+    for (; blocks > 0; --blocks, data += 64) {
+        std::array<std::uint32_t, 16> words{};
+        for (std::size_t i{0}; i < words.size(); ++i) {
+            words[i] = LoadLittle<std::uint32_t>(data + 4 * i);
+        }
+
+        std::uint32_t a{state[0]};
+        std::uint32_t b{state[1]};
+        std::uint32_t c{state[2]};
+        std::uint32_t d{state[3]};
+        Md5Steps(a, b, c, d, words, std::make_index_sequence<16>{});
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// SHA-256 (FIPS 180-4)
+// -----------------------------------------------------------------------------
+
+alignas(16) inline constexpr std::array<std::uint32_t, 64> sha256_rounds{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+using Sha256State = std::array<std::uint32_t, 8>;
+
+inline void Sha256BlocksPortable(Sha256State& state, const unsigned char* data,
+                                 std::size_t blocks) {
+    for (; blocks > 0; --blocks, data += 64) {
+        std::array<std::uint32_t, 64> schedule{};
+        for (std::size_t i{0}; i < 16; ++i) {
+            schedule[i] = LoadBig<std::uint32_t>(data + 4 * i);
+        }
+        for (std::size_t i{16}; i < 64; ++i) {
+            const std::uint32_t early{schedule[i - 15]};
+            const std::uint32_t late{schedule[i - 2]};
+            schedule[i] = schedule[i - 16] + schedule[i - 7] +
+                          (std::rotr(early, 7) ^ std::rotr(early, 18) ^
+                           (early >> 3)) +
+                          (std::rotr(late, 17) ^ std::rotr(late, 19) ^
+                           (late >> 10));
+        }
+
+        Sha256State working{state};
+        auto& [a, b, c, d, e, f, g, h] = working;
+        for (std::size_t i{0}; i < 64; ++i) {
+            const std::uint32_t first{
+                h + (std::rotr(e, 6) ^ std::rotr(e, 11) ^ std::rotr(e, 25)) +
+                (g ^ (e & (f ^ g))) + sha256_rounds[i] + schedule[i]};
+            const std::uint32_t second{
+                (std::rotr(a, 2) ^ std::rotr(a, 13) ^ std::rotr(a, 22)) +
+                ((a & b) | (c & (a | b)))};
+            h = g;
+            g = f;
+            f = e;
+            e = d + first;
+            d = c;
+            c = b;
+            b = a;
+            a = first + second;
+        }
+        for (std::size_t i{0}; i < state.size(); ++i) {
+            state[i] += working[i];
+        }
+    }
+}
+
+#if defined(COREUTILS_SHA_NI)
+
+#define COREUTILS_SHA_NI_TARGET __attribute__((target("sha,sse4.1")))
+
+/// Four rounds, and the part of the message schedule that can overlap with
+/// them. The schedule lives in messages[0..3], four words each, and Group
+/// counts groups of four rounds.
+template <std::size_t Group>
+COREUTILS_SHA_NI_TARGET inline void Sha256RoundsShaNi(
+    __m128i& abef, __m128i& cdgh, __m128i (&messages)[4]) {
+    __m128i& current{messages[Group % 4]};
+    __m128i input{_mm_add_epi32(
+        current, _mm_load_si128(reinterpret_cast<const __m128i*>(
+                     sha256_rounds.data() + 4 * Group)))};
+    cdgh = _mm_sha256rnds2_epu32(cdgh, abef, input);
+    if constexpr (Group >= 3 && Group < 15) {
+        __m128i& next{messages[(Group + 1) % 4]};
+        next = _mm_add_epi32(
+            next, _mm_alignr_epi8(current, messages[(Group + 3) % 4], 4));
+        next = _mm_sha256msg2_epu32(next, current);
+    }
+    input = _mm_shuffle_epi32(input, 0x0e);
+    abef = _mm_sha256rnds2_epu32(abef, cdgh, input);
+    if constexpr (Group >= 1 && Group < 13) {
+        __m128i& previous{messages[(Group + 3) % 4]};
+        previous = _mm_sha256msg1_epu32(previous, current);
+    }
+}
+
+template <std::size_t... Groups>
+COREUTILS_SHA_NI_TARGET inline void Sha256BlockShaNi(
+    __m128i& abef, __m128i& cdgh, __m128i (&messages)[4],
+    std::index_sequence<Groups...>) {
+    (Sha256RoundsShaNi<Groups>(abef, cdgh, messages), ...);
+}
+
+/// With the SHA extensions, which do two rounds per instruction. The state
+/// is kept the way those instructions want it, as ABEF and CDGH.
+COREUTILS_SHA_NI_TARGET inline void Sha256BlocksShaNi(
+    Sha256State& state, const unsigned char* data, std::size_t blocks) {
+    const __m128i byte_swap{
+        _mm_set_epi64x(0x0c0d0e0f08090a0bll, 0x0405060700010203ll)};
+    const __m128i cdab{_mm_shuffle_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(state.data())),
+        0xb1)};
+    const __m128i efgh{_mm_shuffle_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(state.data() + 4)),
+        0x1b)};
+    __m128i abef{_mm_alignr_epi8(cdab, efgh, 8)};
+    __m128i cdgh{_mm_blend_epi16(efgh, cdab, 0xf0)};
+
+    for (; blocks > 0; --blocks, data += 64) {
+        const __m128i saved_abef{abef};
+        const __m128i saved_cdgh{cdgh};
+        // a plain array, as std::array would drop __m128i's alignment
+        __m128i messages[4];
+        for (std::size_t i{0}; i < 4; ++i) {
+            messages[i] = _mm_shuffle_epi8(
+                _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(data + 16 * i)),
+                byte_swap);
+        }
+        Sha256BlockShaNi(abef, cdgh, messages, std::make_index_sequence<16>{});
+        abef = _mm_add_epi32(abef, saved_abef);
+        cdgh = _mm_add_epi32(cdgh, saved_cdgh);
+    }
+
+    const __m128i feba{_mm_shuffle_epi32(abef, 0x1b)};
+    const __m128i dchg{_mm_shuffle_epi32(cdgh, 0xb1)};
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state.data()),
+                     _mm_blend_epi16(feba, dchg, 0xf0));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state.data() + 4),
+                     _mm_alignr_epi8(dchg, feba, 8));
+}
+
+#undef COREUTILS_SHA_NI_TARGET
+
+inline bool HasShaExtensions() {
+    unsigned int a{};
+    unsigned int b{};
+    unsigned int c{};
+    unsigned int d{};
+    if (!__get_cpuid(1, &a, &b, &c, &d) || (c & bit_SSE4_1) == 0) {
+        return false;
+    }
+    // leaf 7, EBX bit 29
+    return __get_cpuid_count(7, 0, &a, &b, &c, &d) && (b & (1u << 29)) != 0;
+}
+
+#endif
+
+using Sha256Kernel = void (*)(Sha256State&, const unsigned char*,
+                              std::size_t);
+
+/// The fastest block function this CPU has, picked the first time it is
+/// asked for
+inline Sha256Kernel Sha256Blocks() {
+#if defined(COREUTILS_SHA_NI)
+    static const Sha256Kernel kernel{
+        HasShaExtensions() ? &Sha256BlocksShaNi : &Sha256BlocksPortable};
+    return kernel;
+#else
+    return &Sha256BlocksPortable;
+#endif
+}
+
+// -----------------------------------------------------------------------------
+// BLAKE2b (RFC 7693)
+// -----------------------------------------------------------------------------
+
+inline constexpr std::array<std::uint64_t, 8> blake2b_iv{
+    0x6a09e667f3bcc908, 0xbb67ae8584caa73b, 0x3c6ef372fe94f82b,
+    0xa54ff53a5f1d36f1, 0x510e527fade682d1, 0x9b05688c2b3e6c1f,
+    0x1f83d9abfb41bd6b, 0x5be0cd19137e2179,
+};
+
+struct Blake2bState final {
+    std::array<std::uint64_t, 8> words;
+    /// Bytes hashed so far, as a 128 bit counter
+    std::uint64_t low;
+    std::uint64_t high;
+};
+
+inline constexpr std::array<std::array<std::uint8_t, 16>, 10> blake2b_sigma{{
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+    {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3},
+    {11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4},
+    {7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8},
+    {9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13},
+    {2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9},
+    {12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11},
+    {13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10},
+    {6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5},
+    {10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0},
+}};
+
+template <std::size_t A, std::size_t B, std::size_t C, std::size_t D>
+inline void Blake2bMix(std::array<std::uint64_t, 16>& v, std::uint64_t x,
+                       std::uint64_t y) {
+    v[A] += v[B] + x;
+    v[D] = std::rotr(v[D] ^ v[A], 32);
+    v[C] += v[D];
+    v[B] = std::rotr(v[B] ^ v[C], 24);
+    v[A] += v[B] + y;
+    v[D] = std::rotr(v[D] ^ v[A], 16);
+    v[C] += v[D];
+    v[B] = std::rotr(v[B] ^ v[C], 63);
+}
+
+/// Rounds are written out at compile time, so that which message word goes
+/// where is settled by the compiler and v stays in registers
+template <std::size_t... Rounds>
+inline void Blake2bRounds(std::array<std::uint64_t, 16>& v,
+                          const std::array<std::uint64_t, 16>& m,
+                          std::index_sequence<Rounds...>) {
+    const auto round = [&v, &m]<std::size_t Round>() {
+        constexpr std::array<std::uint8_t, 16> s{blake2b_sigma[Round % 10]};
+        Blake2bMix<0, 4, 8, 12>(v, m[s[0]], m[s[1]]);
+        Blake2bMix<1, 5, 9, 13>(v, m[s[2]], m[s[3]]);
+        Blake2bMix<2, 6, 10, 14>(v, m[s[4]], m[s[5]]);
+        Blake2bMix<3, 7, 11, 15>(v, m[s[6]], m[s[7]]);
+        Blake2bMix<0, 5, 10, 15>(v, m[s[8]], m[s[9]]);
+        Blake2bMix<1, 6, 11, 12>(v, m[s[10]], m[s[11]]);
+        Blake2bMix<2, 7, 8, 13>(v, m[s[12]], m[s[13]]);
+        Blake2bMix<3, 4, 9, 14>(v, m[s[14]], m[s[15]]);
+    };
+    (round.template operator()<Rounds>(), ...);
+}
+
+/// Compresses blocks whole blocks. When last is set, the final one of them
+/// is the end of the message, holding last_size bytes (the rest being zero).
+inline void Blake2bBlocks(Blake2bState& state, const unsigned char* data,
+                          std::size_t blocks, bool last,
+                          std::size_t last_size = 128) {
+    for (std::size_t block{0}; block < blocks; ++block, data += 128) {
+        const bool final_block{last && block + 1 == blocks};
+        const std::uint64_t size{final_block ? last_size : 128};
+        state.low += size;
+        state.high += state.low < size ? 1 : 0;
+
+        std::array<std::uint64_t, 16> message{};
+        for (std::size_t i{0}; i < message.size(); ++i) {
+            message[i] = LoadLittle<std::uint64_t>(data + 8 * i);
+        }
+        std::array<std::uint64_t, 16> v{};
+        std::copy(state.words.begin(), state.words.end(), v.begin());
+        std::copy(blake2b_iv.begin(), blake2b_iv.end(), v.begin() + 8);
+        v[12] ^= state.low;
+        v[13] ^= state.high;
+        v[14] ^= final_block ? ~std::uint64_t{0} : 0;
+
+        Blake2bRounds(v, message, std::make_index_sequence<12>{});
+        for (std::size_t i{0}; i < state.words.size(); ++i) {
+            state.words[i] ^= v[i] ^ v[i + 8];
+        }
+    }
+}
+
+}  // namespace coreutils::detail
+
+#endif  // LIB_DETAIL_CHECKSUM_HPP_
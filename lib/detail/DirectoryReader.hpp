@@ -0,0 +1,128 @@
+///
+///  @file DirectoryReader.hpp
+///  @brief implementation details for the coreutilspp directory reader
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_DETAIL_DIRECTORYREADER_HPP_
+#define LIB_DETAIL_DIRECTORYREADER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <string_view>
+
+#if !defined(_WIN32)
+#include <dirent.h>
+#endif
+
+namespace coreutils::detail {
+
+/// What kind of file a directory entry is, as far as the directory itself
+/// knows. Unknown means the filesystem did not say, and a stat is needed.
+enum class FileType : std::uint8_t {
+    Unknown,
+    Fifo,
+    CharDevice,
+    Directory,
+    BlockDevice,
+    Regular,
+    Symlink,
+    Socket,
+};
+
+#if !defined(_WIN32)
+constexpr FileType FromDirentType(unsigned char type) {
+    switch (type) {
+        case DT_FIFO:
+            return FileType::Fifo;
+        case DT_CHR:
+            return FileType::CharDevice;
+        case DT_DIR:
+            return FileType::Directory;
+        case DT_BLK:
+            return FileType::BlockDevice;
+        case DT_REG:
+            return FileType::Regular;
+        case DT_LNK:
+            return FileType::Symlink;
+        case DT_SOCK:
+            return FileType::Socket;
+        default:
+            return FileType::Unknown;
+    }
+}
+#endif
+
+inline FileType FromFilesystemType(std::filesystem::file_type type) {
+    using std::filesystem::file_type;
+    switch (type) {
+        case file_type::fifo:
+            return FileType::Fifo;
+        case file_type::character:
+            return FileType::CharDevice;
+        case file_type::directory:
+            return FileType::Directory;
+        case file_type::block:
+            return FileType::BlockDevice;
+        case file_type::regular:
+            return FileType::Regular;
+        case file_type::symlink:
+            return FileType::Symlink;
+        case file_type::socket:
+            return FileType::Socket;
+        default:
+            return FileType::Unknown;
+    }
+}
+
+#if defined(__linux__)
+/// The kernel's struct linux_dirent64 ends in a flexible array member, which
+/// C++ does not have, so records are decoded field by field instead:
+///
+///     u64 d_ino; s64 d_off; u16 d_reclen; u8 d_type; char d_name[];
+///
+struct RawDirent final {
+    static constexpr std::size_t reclen_offset{16};
+    static constexpr std::size_t type_offset{18};
+    static constexpr std::size_t name_offset{19};
+
+    explicit RawDirent(const std::byte* record) : record_{record} {}
+
+    std::uint16_t RecordLength() const {
+        std::uint16_t length{};
+        std::memcpy(&length, record_ + reclen_offset, sizeof(length));
+        return length;
+    }
+
+    unsigned char Type() const {
+        return static_cast<unsigned char>(record_[type_offset]);
+    }
+
+    std::string_view Name() const {
+        return reinterpret_cast<const char*>(record_ + name_offset);
+    }
+
+ private:
+    const std::byte* record_;
+};
+#endif
+
+}  // namespace coreutils::detail
+
+#endif  // LIB_DETAIL_DIRECTORYREADER_HPP_
@@ -0,0 +1,302 @@
+///
+///  @file FileCopy.hpp
+///  @brief the kernel copy paths behind CopyAll, and the fallback
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_DETAIL_FILECOPY_HPP_
+#define LIB_DETAIL_FILECOPY_HPP_
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <span>
+#include <string_view>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#endif
+
+#include "Output.hpp"
+#include "Stats.hpp"
+
+namespace coreutils::detail {
+
+struct CopyError final {
+    std::error_code error;
+    /// Whether writing, rather than reading, is what failed
+    bool writing;
+};
+
+using CopyResult = std::expected<void, CopyError>;
+
+/// One read call, retried if interrupted. 0 means end of file.
+inline std::expected<std::size_t, std::error_code> ReadSome(
+    int fd, std::span<char> buffer) {
+    while (true) {
+        const StatsTimer timer{StatsPhase::Io};
+#if defined(_WIN32)
+        const int got{::_read(fd, buffer.data(),
+                              static_cast<unsigned int>(buffer.size()))};
+#else
+        const ssize_t got{::read(fd, buffer.data(), buffer.size())};
+#endif
+        CountSyscall(StatsSyscall::Read, got);
+        if (got >= 0) {
+            return static_cast<std::size_t>(got);
+        } else if (errno != EINTR) {
+            return std::unexpected{
+                std::error_code{errno, std::system_category()}};
+        }
+    }
+}
+
+/// One positioned read, retried if interrupted, leaving the file offset
+/// alone (except on Windows, which has no pread). 0 means end of file.
+inline std::expected<std::size_t, std::error_code> ReadSomeAt(
+    int fd, std::span<char> buffer, std::uint64_t offset) {
+    while (true) {
+        const StatsTimer timer{StatsPhase::Io};
+#if defined(_WIN32)
+        if (::_lseeki64(fd, static_cast<__int64>(offset), SEEK_SET) < 0) {
+            return std::unexpected{
+                std::error_code{errno, std::system_category()}};
+        }
+        const int got{::_read(fd, buffer.data(),
+                              static_cast<unsigned int>(buffer.size()))};
+#else
+        const ssize_t got{::pread(fd, buffer.data(), buffer.size(),
+                                  static_cast<off_t>(offset))};
+#endif
+        CountSyscall(StatsSyscall::Read, got);
+        if (got >= 0) {
+            return static_cast<std::size_t>(got);
+        } else if (errno != EINTR) {
+            return std::unexpected{
+                std::error_code{errno, std::system_category()}};
+        }
+    }
+}
+
+/// Reads from in and writes to out through buffer until the end of in
+inline CopyResult CopyBuffered(int in, int out, std::span<char> buffer) {
+    while (true) {
+        const std::expected<std::size_t, std::error_code> got{
+            ReadSome(in, buffer)};
+        if (!got) {
+            return std::unexpected{CopyError{got.error(), false}};
+        } else if (*got == 0) {
+            return {};
+        }
+        if (const std::error_code error{
+                WriteAll(out, {buffer.data(), *got})};
+            error) {
+            return std::unexpected{CopyError{error, true}};
+        }
+    }
+}
+
+#if defined(__linux__)
+
+/// Done (true), or turned down by the kernel for this pair of files (false)
+using FastCopyResult = std::expected<bool, CopyError>;
+
+/// Most the copy syscalls move in one call (see sendfile(2))
+inline constexpr std::size_t max_transfer{0x7ffff000};
+
+/// Whether errno, from a copy syscall, means these files cannot be copied
+/// that way, rather than that the copy failed
+inline bool Unsupported(int error) {
+    return error == EINVAL || error == ENOSYS || error == EXDEV ||
+           error == EOPNOTSUPP || error == EBADF;
+}
+
+/// The kernel does not say which side of a copy failed, but these can only
+/// come from the destination
+inline bool FromWriting(int error) {
+    return error == EPIPE || error == ENOSPC || error == EDQUOT ||
+           error == EFBIG;
+}
+
+/// Calls transfer until the end of the input. All of the copy syscalls move
+/// the file offsets they were given null for, so when one is turned down
+/// partway through, the next way of copying carries on where it left off.
+template <class Transfer>
+FastCopyResult KernelCopy(Transfer transfer) {
+    for (bool first{true};; first = false) {
+        const StatsTimer timer{StatsPhase::Io};
+        const ssize_t moved{transfer(max_transfer)};
+        CountSyscall(StatsSyscall::Copy, moved);
+        if (moved > 0) {
+            continue;
+        } else if (moved == 0) {
+            // some files (e.g. in /proc) claim to be empty but are not, so
+            // an empty first answer is double checked by reading
+            return !first;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (Unsupported(errno)) {
+            return false;
+        }
+        return std::unexpected{CopyError{
+            std::error_code{errno, std::system_category()},
+            FromWriting(errno)}};
+    }
+}
+
+/// Between regular files. Filesystems that can will share the extents
+/// instead (e.g. btrfs, XFS), and NFS and SMB copy on the server.
+inline FastCopyResult CopyFileRange(int in, int out) {
+    return KernelCopy([in, out](std::size_t count) {
+        return ::copy_file_range(in, nullptr, out, nullptr, count, 0);
+    });
+}
+
+/// From a file (anything with a page cache) to a pipe or socket
+inline FastCopyResult SendFile(int in, int out) {
+    return KernelCopy([in, out](std::size_t count) {
+        return ::sendfile(out, in, nullptr, count);
+    });
+}
+
+/// When either end is a pipe
+inline FastCopyResult Splice(int in, int out) {
+    return KernelCopy([in, out](std::size_t count) {
+        return ::splice(in, nullptr, out, nullptr, count,
+                        SPLICE_F_MOVE | SPLICE_F_MORE);
+    });
+}
+
+/// Makes out share in's extents, which copies no data at all, on
+/// filesystems that can (e.g. btrfs, XFS)
+inline bool Reflink(int in, int out) { return ::ioctl(out, FICLONE, in) == 0; }
+
+#endif
+
+#if !defined(_WIN32)
+
+/// Copies length bytes from offset in in to the same offset in out. Leaves
+/// the file offsets alone.
+inline CopyResult CopyRange(int in, int out, off_t offset, off_t length,
+                            std::span<char> buffer) {
+#if defined(__linux__)
+    off_t out_offset{offset};
+    while (length > 0) {
+        const StatsTimer timer{StatsPhase::Io};
+        const ssize_t moved{::copy_file_range(
+            in, &offset, out, &out_offset,
+            std::min(static_cast<std::size_t>(length), max_transfer), 0)};
+        CountSyscall(StatsSyscall::Copy, moved);
+        if (moved > 0) {
+            length -= moved;
+            continue;
+        } else if (moved < 0 && errno == EINTR) {
+            continue;
+        } else if (moved < 0 && !Unsupported(errno)) {
+            return std::unexpected{CopyError{
+                std::error_code{errno, std::system_category()},
+                FromWriting(errno)}};
+        }
+        // turned down, or the file shrank: the buffered copy below takes
+        // over from here, and finds out which
+        break;
+    }
+#endif
+    while (length > 0) {
+        const StatsTimer timer{StatsPhase::Io};
+        const ssize_t got{::pread(
+            in, buffer.data(),
+            std::min(static_cast<std::size_t>(length), buffer.size()),
+            offset)};
+        CountSyscall(StatsSyscall::Read, got);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        } else if (got < 0) {
+            return std::unexpected{CopyError{
+                std::error_code{errno, std::system_category()}, false}};
+        } else if (got == 0) {
+            return {};
+        }
+        for (ssize_t written{0}; written < got;) {
+            const ssize_t put{::pwrite(out, buffer.data() + written,
+                                       static_cast<std::size_t>(got - written),
+                                       offset + written)};
+            CountSyscall(StatsSyscall::Write, put);
+            if (put < 0 && errno == EINTR) {
+                continue;
+            } else if (put < 0) {
+                return std::unexpected{CopyError{
+                    std::error_code{errno, std::system_category()}, true}};
+            }
+            written += put;
+        }
+        offset += got;
+        length -= got;
+    }
+    return {};
+}
+
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+/// Copies only the parts of in (the first size bytes of it) that hold data,
+/// so that out has holes wherever in does
+inline CopyResult CopySparse(int in, int out, off_t size,
+                             std::span<char> buffer) {
+    for (off_t offset{0}; offset < size;) {
+        const off_t data{::lseek(in, offset, SEEK_DATA)};
+        if (data < 0 && errno == ENXIO) {
+            // nothing but a hole from here to the end
+            break;
+        }
+        const off_t hole{data < 0 ? -1 : ::lseek(in, data, SEEK_HOLE)};
+        if (hole < 0) {
+            return std::unexpected{CopyError{
+                std::error_code{errno, std::system_category()}, false}};
+        }
+        const off_t end{std::min(hole, size)};
+        if (const CopyResult copied{CopyRange(in, out, data, end - data,
+                                              buffer)};
+            !copied) {
+            return copied;
+        }
+        offset = end;
+    }
+    // a hole at the end only exists by way of the file's size
+    if (::ftruncate(out, size) != 0) {
+        return std::unexpected{CopyError{
+            std::error_code{errno, std::system_category()}, true}};
+    }
+    return {};
+}
+#endif
+
+#endif
+
+}  // namespace coreutils::detail
+
+#endif  // LIB_DETAIL_FILECOPY_HPP_
@@ -0,0 +1,67 @@
+///
+///  @file FileStatus.hpp
+///  @brief platform specific halves of the coreutilspp metadata lookups
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_DETAIL_FILESTATUS_HPP_
+#define LIB_DETAIL_FILESTATUS_HPP_
+
+#include <cstdint>
+
+#if !defined(_WIN32)
+#include <sys/stat.h>
+#endif
+
+#include "DirectoryReader.hpp"
+
+namespace coreutils::detail {
+
+/// Permission bits, including set-user-ID, set-group-ID and sticky
+inline constexpr std::uint16_t permission_mask{07777};
+
+#if !defined(_WIN32)
+constexpr FileType FromModeType(unsigned mode) {
+    switch (mode & S_IFMT) {
+        case S_IFIFO:
+            return FileType::Fifo;
+        case S_IFCHR:
+            return FileType::CharDevice;
+        case S_IFDIR:
+            return FileType::Directory;
+        case S_IFBLK:
+            return FileType::BlockDevice;
+        case S_IFREG:
+            return FileType::Regular;
+        case S_IFLNK:
+            return FileType::Symlink;
+        case S_IFSOCK:
+            return FileType::Socket;
+        default:
+            return FileType::Unknown;
+    }
+}
+
+constexpr std::int64_t ToNanoseconds(std::int64_t seconds,
+                                     std::int64_t nanoseconds) {
+    return seconds * 1'000'000'000 + nanoseconds;
+}
+#endif
+
+}  // namespace coreutils::detail
+
+#endif  // LIB_DETAIL_FILESTATUS_HPP_
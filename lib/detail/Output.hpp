@@ -0,0 +1,117 @@
+///
+///  @file Output.hpp
+///  @brief platform specific halves of the coreutilspp output writer
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_DETAIL_OUTPUT_HPP_
+#define LIB_DETAIL_OUTPUT_HPP_
+
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <expected>
+#include <string_view>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include "Stats.hpp"
+
+namespace coreutils::detail {
+
+inline bool IsTerminal(int fd) {
+#if defined(_WIN32)
+    return ::_isatty(fd) != 0;
+#else
+    return ::isatty(fd) != 0;
+#endif
+}
+
+/// One write call, retried if interrupted before writing anything
+inline std::expected<std::size_t, std::error_code> WriteSome(
+    int fd, std::string_view data) {
+    while (true) {
+        const StatsTimer timer{StatsPhase::Output};
+#if defined(_WIN32)
+        const int written{
+            ::_write(fd, data.data(), static_cast<unsigned int>(data.size()))};
+#else
+        const ssize_t written{::write(fd, data.data(), data.size())};
+#endif
+        CountSyscall(StatsSyscall::Write, written);
+        if (written >= 0) {
+            return static_cast<std::size_t>(written);
+        } else if (errno != EINTR) {
+            return std::unexpected{
+                std::error_code{errno, std::system_category()}};
+        }
+    }
+}
+
+/// Writes first and then second, as a single writev where possible, so that
+/// a full buffer and an oversized string after it cost one syscall
+inline std::error_code WriteAll(int fd, std::string_view first,
+                                std::string_view second = {}) {
+#if !defined(_WIN32)
+    while (!first.empty()) {
+        std::array<iovec, 2> chunks{{
+            {const_cast<char*>(first.data()), first.size()},
+            {const_cast<char*>(second.data()), second.size()},
+        }};
+        const StatsTimer timer{StatsPhase::Output};
+        const ssize_t written{
+            ::writev(fd, chunks.data(), second.empty() ? 1 : 2)};
+        CountSyscall(StatsSyscall::Write, written);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return std::error_code{errno, std::system_category()};
+        }
+
+        const std::size_t done{static_cast<std::size_t>(written)};
+        if (done >= first.size()) {
+            second.remove_prefix(done - first.size());
+            first = second;
+            second = {};
+        } else {
+            first.remove_prefix(done);
+        }
+    }
+#endif
+    for (std::string_view data : {first, second}) {
+        while (!data.empty()) {
+            const std::expected<std::size_t, std::error_code> written{
+                WriteSome(fd, data)};
+            if (!written) {
+                return written.error();
+            }
+            data.remove_prefix(*written);
+        }
+    }
+    return {};
+}
+
+}  // namespace coreutils::detail
+
+#endif  // LIB_DETAIL_OUTPUT_HPP_
@@ -0,0 +1,182 @@
+///
+///  @file SortKey.hpp
+///  @brief field splitting and key comparisons behind the coreutilspp sort
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_DETAIL_SORTKEY_HPP_
+#define LIB_DETAIL_SORTKEY_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string_view>
+
+namespace coreutils::detail {
+
+/// What separates fields when no -t is given, as in the C locale
+constexpr bool IsBlank(char c) { return c == ' ' || c == '\t'; }
+
+constexpr const char* SkipBlanks(const char* begin, const char* end) {
+    while (begin < end && IsBlank(*begin)) {
+        ++begin;
+    }
+    return begin;
+}
+
+/// Moves past count fields. Without a tab, a field is a run of blanks
+/// followed by a run of anything else, so it includes the blanks before it.
+constexpr const char* SkipFields(const char* begin, const char* end,
+                                 std::size_t count, std::optional<char> tab,
+                                 bool past_last_tab = true) {
+    for (; begin < end && count > 0; --count) {
+        if (tab) {
+            begin = std::find(begin, end, *tab);
+            if (begin < end && (count > 1 || past_last_tab)) {
+                ++begin;
+            }
+        } else {
+            begin = SkipBlanks(begin, end);
+            while (begin < end && !IsBlank(*begin)) {
+                ++begin;
+            }
+        }
+    }
+    return begin;
+}
+
+/// Sign and digits of a number as -n reads it: optional blanks, an optional
+/// minus sign, digits, and optionally a decimal point and more digits.
+/// Anything else ends the number, and no digits at all reads as zero.
+struct Number final {
+    bool negative;
+    /// Without leading zeroes
+    std::string_view integer;
+    /// Without trailing zeroes
+    std::string_view fraction;
+};
+
+constexpr bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+constexpr Number ReadNumber(std::string_view text) {
+    const char* begin{SkipBlanks(text.data(), text.data() + text.size())};
+    const char* const end{text.data() + text.size()};
+    Number number{};
+    if (begin < end && *begin == '-') {
+        number.negative = true;
+        ++begin;
+    }
+    while (begin < end && *begin == '0') {
+        ++begin;
+    }
+    const char* digits{begin};
+    while (begin < end && IsDigit(*begin)) {
+        ++begin;
+    }
+    number.integer = {digits, static_cast<std::size_t>(begin - digits)};
+    if (begin < end && *begin == '.') {
+        digits = ++begin;
+        const char* significant{begin};
+        for (; begin < end && IsDigit(*begin); ++begin) {
+            significant = *begin == '0' ? significant : begin + 1;
+        }
+        number.fraction = {digits,
+                           static_cast<std::size_t>(significant - digits)};
+    }
+    if (number.integer.empty() && number.fraction.empty()) {
+        // -0 is 0
+        number.negative = false;
+    }
+    return number;
+}
+
+/// Packs as much of a number as fits into 64 bits, such that packed numbers
+/// compare (as unsigned integers) in the same order as the numbers, or equal
+/// when 64 bits are not enough to tell them apart. From the top: the sign (2
+/// bits, negative, zero or positive), how many integer digits there are (6
+/// bits), and the first 14 digits, 4 bits each. For negative numbers
+/// everything after the sign is flipped, as bigger means smaller there.
+constexpr std::uint64_t NumberPrefix(std::string_view text) {
+    const Number number{ReadNumber(text)};
+    if (number.integer.empty() && number.fraction.empty()) {
+        return std::uint64_t{1} << 62;
+    }
+
+    constexpr std::size_t max_length{63};
+    constexpr std::size_t max_digits{14};
+    std::uint64_t packed{0};
+    if (number.integer.size() < max_length) {
+        std::size_t packed_digits{0};
+        for (const std::string_view part : {number.integer, number.fraction}) {
+            for (std::size_t i{0};
+                 i < part.size() && packed_digits < max_digits;
+                 ++i, ++packed_digits) {
+                packed = packed << 4 |
+                         static_cast<std::uint64_t>(part[i] - '0');
+            }
+        }
+        packed <<= 4 * (max_digits - packed_digits);
+        packed |= static_cast<std::uint64_t>(number.integer.size()) << 56;
+    } else {
+        packed = std::uint64_t{max_length} << 56;
+    }
+
+    constexpr std::uint64_t magnitude_mask{(std::uint64_t{1} << 62) - 1};
+    return number.negative ? ~packed & magnitude_mask
+                           : std::uint64_t{2} << 62 | packed;
+}
+
+/// Like GNU's strnumcmp, so numbers of any length compare exactly
+constexpr int CompareNumbers(std::string_view lhs, std::string_view rhs) {
+    const Number left{ReadNumber(lhs)};
+    const Number right{ReadNumber(rhs)};
+    if (left.negative != right.negative) {
+        return left.negative ? -1 : 1;
+    }
+
+    int magnitude{0};
+    if (left.integer.size() != right.integer.size()) {
+        magnitude = left.integer.size() < right.integer.size() ? -1 : 1;
+    } else if (const int integer{left.integer.compare(right.integer)};
+               integer != 0) {
+        magnitude = integer;
+    } else {
+        // trailing zeroes are gone, so the longer fraction is bigger if all
+        // else is equal
+        magnitude = left.fraction.compare(right.fraction);
+    }
+    magnitude = magnitude < 0 ? -1 : magnitude > 0 ? 1 : 0;
+    return left.negative ? -magnitude : magnitude;
+}
+
+/// Bytewise, as in the C locale
+inline int CompareBytes(std::string_view lhs, std::string_view rhs) {
+    const std::size_t common{std::min(lhs.size(), rhs.size())};
+    if (const int diff{common == 0 ? 0
+                                   : std::memcmp(lhs.data(), rhs.data(),
+                                                 common)};
+        diff != 0) {
+        return diff < 0 ? -1 : 1;
+    }
+    return lhs.size() < rhs.size() ? -1 : lhs.size() > rhs.size() ? 1 : 0;
+}
+
+}  // namespace coreutils::detail
+
+#endif  // LIB_DETAIL_SORTKEY_HPP_
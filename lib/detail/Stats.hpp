@@ -0,0 +1,189 @@
+///
+///  @file Stats.hpp
+///  @brief counters behind --stats, kept by the shared I/O layer
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_DETAIL_STATS_HPP_
+#define LIB_DETAIL_STATS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(COREUTILS_STATS)
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <vector>
+#endif
+
+namespace coreutils::detail {
+
+/// The phases that are timed directly. Compute is whatever is left over.
+enum class StatsPhase : std::uint8_t { Parse, Io, Output };
+
+/// What a syscall made by the shared I/O layer was for
+enum class StatsSyscall : std::uint8_t { Read, Write, Copy, Directory, Stat };
+
+#if defined(COREUTILS_STATS)
+
+inline constexpr std::size_t stats_phases{3};
+inline constexpr std::size_t stats_syscalls{5};
+
+/// Only ever written by the thread it belongs to, and on a cache line of its
+/// own, so counting costs no more than the clock reads around it. The
+/// counters are atomic only so the report can read them from another thread.
+struct alignas(64) StatsSlot final {
+    std::array<std::atomic<std::uint64_t>, stats_phases> nanoseconds{};
+    std::array<std::atomic<std::uint64_t>, stats_syscalls> syscalls{};
+    std::atomic<std::uint64_t> bytes_read{0};
+    std::atomic<std::uint64_t> bytes_written{0};
+    /// Items of parallel work (e.g. stats, files, tasks) this thread ran
+    std::atomic<std::uint64_t> work{0};
+};
+
+inline void Add(std::atomic<std::uint64_t>& counter, std::uint64_t amount) {
+    // no other thread writes it, so there is no need for a locked add
+    counter.store(counter.load(std::memory_order_relaxed) + amount,
+                  std::memory_order_relaxed);
+}
+
+class StatsRegistry final {
+ public:
+    using Clock = std::chrono::steady_clock;
+
+    /// Constructed during static initialization, so on the main thread,
+    /// which therefore always owns the first slot
+    StatsRegistry() { Local(); }
+
+    StatsSlot& Local() {
+        static thread_local Lease lease{*this};
+        return *lease.slot;
+    }
+
+    /// Calls fn with every thread's slot, the main thread's first
+    template <class Fn>
+    void ForEach(Fn&& fn) {
+        std::lock_guard lock{mutex_};
+        for (const StatsSlot& slot : slots_) {
+            fn(slot);
+        }
+    }
+
+    Clock::time_point start() const { return start_; }
+
+ private:
+    /// A thread's hold on its slot, which goes back to the registry when
+    /// the thread exits
+    struct Lease final {
+        explicit Lease(StatsRegistry& owner) : registry{&owner} {
+            std::lock_guard lock{owner.mutex_};
+            if (owner.free_.empty()) {
+                slot = &owner.slots_.emplace_back();
+            } else {
+                slot = owner.free_.back();
+                owner.free_.pop_back();
+            }
+        }
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        ~Lease() {
+            std::lock_guard lock{registry->mutex_};
+            registry->free_.push_back(slot);
+        }
+
+        StatsRegistry* registry;
+        StatsSlot* slot{nullptr};
+    };
+
+    Clock::time_point start_{Clock::now()};
+    std::mutex mutex_{};
+    /// Slots outlive their threads, so that a finished worker's counts
+    /// still make it into the report. The parallel helpers start fresh
+    /// threads for every call, so a new thread carries on in the slot of
+    /// one that has finished: there are only ever as many slots as there
+    /// were threads at once.
+    std::deque<StatsSlot> slots_{};
+    std::vector<StatsSlot*> free_{};
+};
+
+inline StatsRegistry stats_registry{};
+
+/// Adds the time until the end of the enclosing scope to phase
+class StatsTimer final {
+ public:
+    explicit StatsTimer(StatsPhase phase)
+        : phase_{phase}, start_{StatsRegistry::Clock::now()} {}
+
+    StatsTimer(const StatsTimer&) = delete;
+    StatsTimer& operator=(const StatsTimer&) = delete;
+
+    ~StatsTimer() {
+        const auto elapsed{StatsRegistry::Clock::now() - start_};
+        Add(stats_registry.Local()
+                .nanoseconds[static_cast<std::size_t>(phase_)],
+            static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                    .count()));
+    }
+
+ private:
+    StatsPhase phase_;
+    StatsRegistry::Clock::time_point start_;
+};
+
+/// Counts one syscall, which moved bytes (read and written, for a copy)
+inline void CountSyscall(StatsSyscall kind, std::int64_t bytes = 0) {
+    StatsSlot& slot{stats_registry.Local()};
+    Add(slot.syscalls[static_cast<std::size_t>(kind)], 1);
+    if (bytes <= 0) {
+        return;
+    }
+    if (kind == StatsSyscall::Read || kind == StatsSyscall::Copy) {
+        Add(slot.bytes_read, static_cast<std::uint64_t>(bytes));
+    }
+    if (kind == StatsSyscall::Write || kind == StatsSyscall::Copy) {
+        Add(slot.bytes_written, static_cast<std::uint64_t>(bytes));
+    }
+}
+
+inline void CountWork(std::uint64_t items = 1) {
+    Add(stats_registry.Local().work, items);
+}
+
+#else
+
+// Without COREUTILS_STATS every call site below compiles away
+
+class [[maybe_unused]] StatsTimer final {
+ public:
+    explicit constexpr StatsTimer(StatsPhase) {}
+};
+
+constexpr void CountSyscall(StatsSyscall, std::int64_t = 0) {}
+
+constexpr void CountWork(std::uint64_t = 1) {}
+
+#endif
+
+}  // namespace coreutils::detail
+
+#endif  // LIB_DETAIL_STATS_HPP_
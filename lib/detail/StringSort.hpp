@@ -0,0 +1,157 @@
+///
+///  @file StringSort.hpp
+///  @brief implementation details for the coreutilspp string sort
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_DETAIL_STRINGSORT_HPP_
+#define LIB_DETAIL_STRINGSORT_HPP_
+
+#include <algorithm>
+#include <bit>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+namespace coreutils::detail {
+
+/// Strings are compared 8 bytes at a time, as big endian integers, so one
+/// integer comparison does the work of up to 8 character comparisons.
+inline constexpr std::size_t chunk_size{sizeof(std::uint64_t)};
+
+/// Loads the 8 bytes of data starting at offset as a big endian integer,
+/// padding with zeroes past the end of the string.
+inline std::uint64_t LoadChunk(const char* data, std::size_t size,
+                               std::size_t offset) {
+    std::uint64_t chunk{0};
+    if (offset < size) {
+        std::memcpy(&chunk, data + offset,
+                    std::min(chunk_size, size - offset));
+        if constexpr (std::endian::native == std::endian::little) {
+            chunk = std::byteswap(chunk);
+        }
+    }
+    return chunk;
+}
+
+/// One "character" of the multikey quicksort. Zero padding alone cannot tell
+/// "a" from "a\0", so how many of the 8 bytes are real breaks the tie (a
+/// string that ends sooner sorts first, as with std::string_view).
+struct ChunkKey final {
+    std::uint64_t chunk;
+    std::uint8_t length;
+
+    constexpr auto operator<=>(const ChunkKey&) const = default;
+
+    /// Whether strings with this key continue past it
+    constexpr bool Continues() const { return length == chunk_size; }
+};
+
+/// Records being partitioned at some depth always have that depth's chunk
+/// cached in their prefix, so partitioning only ever touches the packed
+/// records and never the strings they point to.
+template <class Record>
+ChunkKey KeyAt(const Record& record, std::size_t depth) {
+    const std::size_t offset{depth * chunk_size};
+    const std::size_t remaining{record.size > offset ? record.size - offset
+                                                     : 0};
+    return {
+        .chunk = record.prefix,
+        .length = static_cast<std::uint8_t>(std::min(remaining, chunk_size)),
+    };
+}
+
+template <class Record>
+bool LessFrom(const Record& lhs, const Record& rhs, std::size_t depth) {
+    ChunkKey left{KeyAt(lhs, depth)};
+    ChunkKey right{KeyAt(rhs, depth)};
+    while (left == right && left.Continues()) {
+        ++depth;
+        left = {LoadChunk(lhs.data, lhs.size, depth * chunk_size),
+                KeyAt(lhs, depth).length};
+        right = {LoadChunk(rhs.data, rhs.size, depth * chunk_size),
+                 KeyAt(rhs, depth).length};
+    }
+    return left < right;
+}
+
+/// Below this many records, partitioning costs more than it saves
+inline constexpr std::size_t insertion_sort_threshold{16};
+
+template <class Record>
+void InsertionSort(Record* records, std::size_t count, std::size_t depth) {
+    for (std::size_t i{1}; i < count; ++i) {
+        for (std::size_t j{i};
+             j > 0 && LessFrom(records[j], records[j - 1], depth); --j) {
+            std::swap(records[j], records[j - 1]);
+        }
+    }
+}
+
+template <class Record>
+ChunkKey MedianOfThree(const Record* records, std::size_t count,
+                       std::size_t depth) {
+    const ChunkKey a{KeyAt(records[0], depth)};
+    const ChunkKey b{KeyAt(records[count / 2], depth)};
+    const ChunkKey c{KeyAt(records[count - 1], depth)};
+    return std::max(std::min(a, b), std::min(std::max(a, b), c));
+}
+
+/// Bentley & Sedgewick's multikey quicksort: three way partition on the key
+/// at depth, then only the "equal" partition moves on to the next key. Each
+/// chunk of each string is therefore looked at about log(n) times, rather
+/// than every comparison re-reading the shared prefix from the start.
+template <class Record>
+void MultikeyQuicksort(Record* records, std::size_t count, std::size_t depth) {
+    while (count > insertion_sort_threshold) {
+        const ChunkKey pivot{MedianOfThree(records, count, depth)};
+
+        std::size_t less{0};
+        std::size_t greater{count};
+        for (std::size_t i{0}; i < greater;) {
+            const ChunkKey key{KeyAt(records[i], depth)};
+            if (key < pivot) {
+                std::swap(records[less++], records[i++]);
+            } else if (pivot < key) {
+                std::swap(records[i], records[--greater]);
+            } else {
+                ++i;
+            }
+        }
+
+        MultikeyQuicksort(records, less, depth);
+        MultikeyQuicksort(records + greater, count - greater, depth);
+        if (!pivot.Continues()) {
+            return;
+        }
+        // loop rather than recurse on what is usually the largest partition
+        records += less;
+        count = greater - less;
+        ++depth;
+        for (std::size_t i{0}; i < count; ++i) {
+            records[i].prefix = LoadChunk(records[i].data, records[i].size,
+                                          depth * chunk_size);
+        }
+    }
+    InsertionSort(records, count, depth);
+}
+
+}  // namespace coreutils::detail
+
+#endif  // LIB_DETAIL_STRINGSORT_HPP_
@@ -0,0 +1,266 @@
+///
+///  @file TextCount.hpp
+///  @brief per instruction set kernels behind the coreutilspp text counters
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_DETAIL_TEXTCOUNT_HPP_
+#define LIB_DETAIL_TEXTCOUNT_HPP_
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cwctype>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace coreutils::detail {
+
+/// Text is looked at 64 bytes at a time, one bit per byte
+inline constexpr std::size_t block_size{64};
+
+/// What each byte of a block is, one bit per byte. Spaces are what isspace
+/// is true for in the C locale, and graphic bytes are printable ASCII other
+/// than the space. Bytes that are neither (control characters, and anything
+/// that is not ASCII) are what single byte locales consider unprintable.
+struct BlockMasks final {
+    std::uint64_t newlines;
+    std::uint64_t spaces;
+    std::uint64_t graphic;
+    /// Bytes that are not ASCII
+    std::uint64_t high;
+};
+
+#if defined(__AVX2__)
+
+inline std::uint64_t Mask(__m256i low, __m256i high) {
+    return static_cast<std::uint32_t>(_mm256_movemask_epi8(low)) |
+           static_cast<std::uint64_t>(
+               static_cast<std::uint32_t>(_mm256_movemask_epi8(high)))
+               << 32;
+}
+
+/// Bytes in [first, first + count)
+inline __m256i InRange(__m256i bytes, char first, char count) {
+    const __m256i shifted{_mm256_sub_epi8(bytes, _mm256_set1_epi8(first))};
+    const __m256i last{_mm256_set1_epi8(static_cast<char>(count - 1))};
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, last), shifted);
+}
+
+inline BlockMasks Classify(const char* block) {
+    const auto newlines = [](__m256i bytes) {
+        return _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n'));
+    };
+    const auto spaces = [](__m256i bytes) {
+        // \t \n \v \f \r
+        return _mm256_or_si256(
+            InRange(bytes, '\t', 5),
+            _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')));
+    };
+    const auto graphic = [](__m256i bytes) {
+        return InRange(bytes, '!', '~' - '!' + 1);
+    };
+
+    const __m256i low{
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block))};
+    const __m256i high{
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32))};
+    return {
+        .newlines = Mask(newlines(low), newlines(high)),
+        .spaces = Mask(spaces(low), spaces(high)),
+        .graphic = Mask(graphic(low), graphic(high)),
+        .high = Mask(low, high),
+    };
+}
+
+#elif defined(__SSE2__)
+
+inline std::uint64_t Mask(__m128i a, __m128i b, __m128i c, __m128i d) {
+    const auto bits = [](__m128i bytes) {
+        return static_cast<std::uint64_t>(
+            static_cast<std::uint16_t>(_mm_movemask_epi8(bytes)));
+    };
+    return bits(a) | bits(b) << 16 | bits(c) << 32 | bits(d) << 48;
+}
+
+/// Bytes in [first, first + count)
+inline __m128i InRange(__m128i bytes, char first, char count) {
+    const __m128i shifted{_mm_sub_epi8(bytes, _mm_set1_epi8(first))};
+    const __m128i last{_mm_set1_epi8(static_cast<char>(count - 1))};
+    return _mm_cmpeq_epi8(_mm_min_epu8(shifted, last), shifted);
+}
+
+inline BlockMasks Classify(const char* block) {
+    const auto newlines = [](__m128i bytes) {
+        return _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n'));
+    };
+    const auto spaces = [](__m128i bytes) {
+        // \t \n \v \f \r
+        return _mm_or_si128(InRange(bytes, '\t', 5),
+                            _mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')));
+    };
+    const auto graphic = [](__m128i bytes) {
+        return InRange(bytes, '!', '~' - '!' + 1);
+    };
+
+    const auto load = [block](std::size_t i) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(block) + i);
+    };
+    const __m128i a{load(0)};
+    const __m128i b{load(1)};
+    const __m128i c{load(2)};
+    const __m128i d{load(3)};
+    return {
+        .newlines = Mask(newlines(a), newlines(b), newlines(c), newlines(d)),
+        .spaces = Mask(spaces(a), spaces(b), spaces(c), spaces(d)),
+        .graphic = Mask(graphic(a), graphic(b), graphic(c), graphic(d)),
+        .high = Mask(a, b, c, d),
+    };
+}
+
+#else
+
+inline BlockMasks Classify(const char* block) {
+    BlockMasks masks{};
+    for (std::size_t i{0}; i < block_size; ++i) {
+        const auto byte{static_cast<unsigned char>(block[i])};
+        const std::uint64_t bit{std::uint64_t{1} << i};
+        masks.newlines |= byte == '\n' ? bit : 0;
+        masks.spaces |= byte == ' ' || (byte >= '\t' && byte <= '\r') ? bit : 0;
+        masks.graphic |= byte >= '!' && byte <= '~' ? bit : 0;
+        masks.high |= byte >= 0x80 ? bit : 0;
+    }
+    return masks;
+}
+
+#endif
+
+/// Just the newlines of a block, one bit per byte
+inline std::uint64_t NewlineMask(const char* block) {
+#if defined(__AVX2__)
+    const __m256i newline{_mm256_set1_epi8('\n')};
+    const auto load = [block](std::size_t i) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block) + i);
+    };
+    return Mask(_mm256_cmpeq_epi8(load(0), newline),
+                _mm256_cmpeq_epi8(load(1), newline));
+#elif defined(__SSE2__)
+    const __m128i newline{_mm_set1_epi8('\n')};
+    const auto match = [block, newline](std::size_t i) {
+        return _mm_cmpeq_epi8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(block) + i),
+            newline);
+    };
+    return Mask(match(0), match(1), match(2), match(3));
+#else
+    std::uint64_t mask{0};
+    for (std::size_t i{0}; i < block_size; ++i) {
+        mask |= block[i] == '\n' ? std::uint64_t{1} << i : 0;
+    }
+    return mask;
+#endif
+}
+
+/// Of the bytes in a block, the first ones of the words. Bytes that are
+/// neither spaces nor graphic do not end a word, nor start one, so a word
+/// starts at a graphic byte when the closest space or graphic byte before it
+/// is a space. after_space says whether that is true of the last one before
+/// the block (and is updated for the next one).
+constexpr std::uint64_t WordStarts(std::uint64_t spaces, std::uint64_t graphic,
+                                   std::uint64_t& after_space) {
+    const std::uint64_t neither{~(spaces | graphic)};
+    // every run of neither that directly follows a space is carried through
+    // by the addition, landing on whatever comes after the run
+    const std::uint64_t follows_space{(spaces << 1) | after_space};
+    const std::uint64_t landed{(follows_space & ~neither) |
+                               ((neither + (follows_space & neither)) &
+                                ~neither)};
+    if (const std::uint64_t either{spaces | graphic}; either != 0) {
+        after_space = (spaces >> (63 - std::countl_zero(either))) & 1;
+    }
+    return landed & graphic;
+}
+
+/// White space for word counting in multibyte locales, which like GNU
+/// includes the no-break spaces that iswspace leaves out
+inline bool IsWideSpace(wchar_t c) {
+    return std::iswspace(static_cast<std::wint_t>(c)) || c == L'\u00a0' ||
+           c == L'\u2007' || c == L'\u202f' || c == L'\u2060';
+}
+
+/// Newlines in [data, data + size)
+inline std::uint64_t CountNewlines(const char* data, std::size_t size) {
+    std::uint64_t count{0};
+    std::size_t i{0};
+#if defined(__AVX2__)
+    // every matching byte subtracts one (i.e. adds 0xff) from its lane, so
+    // lanes are summed into 64 bit totals before any of them can wrap
+    const __m256i newline{_mm256_set1_epi8('\n')};
+    while (i + 32 <= size) {
+        __m256i lanes{_mm256_setzero_si256()};
+        for (std::size_t round{0}; round < 255 && i + 32 <= size;
+             ++round, i += 32) {
+            const __m256i bytes{
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i))};
+            lanes = _mm256_sub_epi8(lanes, _mm256_cmpeq_epi8(bytes, newline));
+        }
+        const __m256i sums{_mm256_sad_epu8(lanes, _mm256_setzero_si256())};
+        std::array<std::uint64_t, 4> parts{};
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(parts.data()), sums);
+        count += parts[0] + parts[1] + parts[2] + parts[3];
+    }
+#elif defined(__SSE2__)
+    const __m128i newline{_mm_set1_epi8('\n')};
+    while (i + 16 <= size) {
+        __m128i lanes{_mm_setzero_si128()};
+        for (std::size_t round{0}; round < 255 && i + 16 <= size;
+             ++round, i += 16) {
+            const __m128i bytes{
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i))};
+            lanes = _mm_sub_epi8(lanes, _mm_cmpeq_epi8(bytes, newline));
+        }
+        const __m128i sums{_mm_sad_epu8(lanes, _mm_setzero_si128())};
+        std::array<std::uint64_t, 2> parts{};
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(parts.data()), sums);
+        count += parts[0] + parts[1];
+    }
+#else
+    // eight bytes at a time: a byte of the xor is zero only for a newline,
+    // and only then is its high bit left clear by the add
+    constexpr std::uint64_t low_bits{0x7f7f7f7f7f7f7f7fu};
+    for (; i + 8 <= size; i += 8) {
+        std::uint64_t word{};
+        std::memcpy(&word, data + i, sizeof(word));
+        word ^= 0x0a0a0a0a0a0a0a0au;
+        const std::uint64_t nonzero{((word & low_bits) + low_bits) | word};
+        count +=
+            static_cast<std::uint64_t>(std::popcount(~nonzero & ~low_bits));
+    }
+#endif
+    for (; i < size; ++i) {
+        count += data[i] == '\n';
+    }
+    return count;
+}
+
+}  // namespace coreutils::detail
+
+#endif  // LIB_DETAIL_TEXTCOUNT_HPP_
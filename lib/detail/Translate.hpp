@@ -0,0 +1,233 @@
+///
+///  @file Translate.hpp
+///  @brief table lookup and compaction kernels behind tr
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#ifndef LIB_DETAIL_TRANSLATE_HPP_
+#define LIB_DETAIL_TRANSLATE_HPP_
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define COREUTILS_SSSE3 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace coreutils::detail {
+
+/// A 256 entry table of bytes, cut by high nibble into 16 rows of 16, which
+/// is the shape a byte shuffle can look up
+using ByteRows = std::array<std::array<unsigned char, 16>, 16>;
+
+/// A set of bytes as two 128 bit maps: row[low nibble] has bit (high nibble
+/// mod 8) set for members, in the first map for high nibbles below 8 and in
+/// the second for the rest. Membership of 16 bytes is then two shuffles,
+/// whatever the set holds.
+struct ByteBitmap final {
+    alignas(16) std::array<unsigned char, 16> below;
+    alignas(16) std::array<unsigned char, 16> above;
+};
+
+/// For every mask of kept bytes in an 8 byte group, the shuffle that packs
+/// them to the front
+inline constexpr std::array<std::array<unsigned char, 8>, 256> pack_shuffles{
+    []() {
+        std::array<std::array<unsigned char, 8>, 256> shuffles{};
+        for (std::size_t mask{0}; mask < shuffles.size(); ++mask) {
+            std::size_t kept{0};
+            for (unsigned char i{0}; i < 8; ++i) {
+                if ((mask >> i) & 1) {
+                    shuffles[mask][kept++] = i;
+                }
+            }
+        }
+        return shuffles;
+    }()};
+
+inline std::size_t TranslatePortable(
+    unsigned char* data, std::size_t size,
+    const std::array<unsigned char, 256>& map) {
+    for (std::size_t i{0}; i < size; ++i) {
+        data[i] = map[data[i]];
+    }
+    return size;
+}
+
+#if defined(COREUTILS_SSSE3)
+
+#define COREUTILS_SSSE3_TARGET __attribute__((target("ssse3")))
+
+inline bool HasSsse3() {
+    unsigned int a{};
+    unsigned int b{};
+    unsigned int c{};
+    unsigned int d{};
+    return __get_cpuid(1, &a, &b, &c, &d) && (c & bit_SSSE3) != 0;
+}
+
+/// Whether to use the kernels below, asked of the CPU once
+inline bool UseSsse3() {
+    static const bool ssse3{HasSsse3()};
+    return ssse3;
+}
+
+/// The high and low nibbles of every byte of x
+struct Nibbles final {
+    __m128i high;
+    __m128i low;
+};
+
+COREUTILS_SSSE3_TARGET inline Nibbles Split(__m128i x) {
+    const __m128i nibble{_mm_set1_epi8(0x0f)};
+    return {_mm_and_si128(_mm_srli_epi16(x, 4), nibble),
+            _mm_and_si128(x, nibble)};
+}
+
+/// 0xff for the bytes of x that are in the set, 0 for the rest
+COREUTILS_SSSE3_TARGET inline __m128i Members(const Nibbles& x,
+                                              const ByteBitmap& set) {
+    const __m128i bits{_mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8,
+                                     16, 32, 64, -128)};
+    const __m128i below{_mm_shuffle_epi8(
+        _mm_load_si128(reinterpret_cast<const __m128i*>(set.below.data())),
+        x.low)};
+    const __m128i above{_mm_shuffle_epi8(
+        _mm_load_si128(reinterpret_cast<const __m128i*>(set.above.data())),
+        x.low)};
+    const __m128i row{_mm_or_si128(
+        _mm_andnot_si128(_mm_cmpgt_epi8(x.high, _mm_set1_epi8(7)), below),
+        _mm_and_si128(_mm_cmpgt_epi8(x.high, _mm_set1_epi8(7)), above))};
+    const __m128i bit{_mm_shuffle_epi8(bits, x.high)};
+    return _mm_cmpeq_epi8(_mm_and_si128(row, bit), bit);
+}
+
+/// Rows holds the xor of every byte with what it becomes, and only the rows
+/// in changed have anything but zeros, so a sparse map (e.g. a-z to A-Z,
+/// which touches two rows) costs a few instructions per 16 bytes
+COREUTILS_SSSE3_TARGET inline std::size_t TranslateSsse3(
+    unsigned char* data, std::size_t size, const ByteRows& rows,
+    std::uint16_t changed) {
+    std::size_t i{0};
+    for (; i + 16 <= size; i += 16) {
+        auto* const at{reinterpret_cast<__m128i*>(data + i)};
+        const __m128i x{_mm_loadu_si128(at)};
+        const Nibbles nibbles{Split(x)};
+        __m128i flips{_mm_setzero_si128()};
+        for (std::uint16_t left{changed}; left != 0; left &= left - 1) {
+            const int row{std::countr_zero(left)};
+            const __m128i in_row{_mm_cmpeq_epi8(
+                nibbles.high, _mm_set1_epi8(static_cast<char>(row)))};
+            const __m128i flip{_mm_shuffle_epi8(
+                _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(rows[row].data())),
+                nibbles.low)};
+            flips = _mm_or_si128(flips, _mm_and_si128(in_row, flip));
+        }
+        _mm_storeu_si128(at, _mm_xor_si128(x, flips));
+    }
+    return i;
+}
+
+/// Packs the bytes of x whose bit in keep is set to the front of out, eight
+/// at a time. Writes up to 16 bytes however few are kept, so out must have
+/// that much room, though it may overlap x's source.
+COREUTILS_SSSE3_TARGET inline unsigned char* Pack(__m128i x,
+                                                  std::uint32_t keep,
+                                                  unsigned char* out) {
+    if (keep == 0xffff) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), x);
+        return out + 16;
+    }
+    const std::uint32_t low{keep & 0xff};
+    const std::uint32_t high{keep >> 8};
+    const __m128i low_shuffle{_mm_loadl_epi64(
+        reinterpret_cast<const __m128i*>(pack_shuffles[low].data()))};
+    const __m128i high_shuffle{_mm_add_epi8(
+        _mm_loadl_epi64(
+            reinterpret_cast<const __m128i*>(pack_shuffles[high].data())),
+        _mm_set1_epi8(8))};
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out),
+                     _mm_shuffle_epi8(x, low_shuffle));
+    out += std::popcount(low);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out),
+                     _mm_shuffle_epi8(x, high_shuffle));
+    return out + std::popcount(high);
+}
+
+/// Deletes the members of set from whole blocks of 16 at the front of data.
+/// Returns how much of data was looked at, and sets kept to how much of it
+/// is left.
+COREUTILS_SSSE3_TARGET inline std::size_t DeleteSsse3(unsigned char* data,
+                                                      std::size_t size,
+                                                      const ByteBitmap& set,
+                                                      std::size_t& kept) {
+    unsigned char* out{data};
+    std::size_t i{0};
+    for (; i + 16 <= size; i += 16) {
+        const __m128i x{
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i))};
+        const auto keep{static_cast<std::uint32_t>(
+            _mm_movemask_epi8(Members(Split(x), set)) ^ 0xffff)};
+        out = Pack(x, keep, out);
+    }
+    kept = static_cast<std::size_t>(out - data);
+    return i;
+}
+
+/// Drops every member of set that repeats the byte before it, from whole
+/// blocks of 16 at the front of data. last is the byte before data, or -1,
+/// and is updated. Returns the same as DeleteSsse3.
+COREUTILS_SSSE3_TARGET inline std::size_t SqueezeSsse3(unsigned char* data,
+                                                       std::size_t size,
+                                                       const ByteBitmap& set,
+                                                       int& last,
+                                                       std::size_t& kept) {
+    unsigned char* out{data};
+    std::size_t i{0};
+    if (size >= 16) {
+        // a byte that cannot repeat the first one, when there is no last
+        __m128i previous{_mm_set1_epi8(static_cast<char>(
+            last >= 0 ? last : static_cast<unsigned char>(~data[0])))};
+        for (; i + 16 <= size; i += 16) {
+            const __m128i x{
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i))};
+            const __m128i before{_mm_alignr_epi8(x, previous, 15)};
+            const __m128i repeats{_mm_and_si128(_mm_cmpeq_epi8(x, before),
+                                                Members(Split(x), set))};
+            out = Pack(x,
+                       static_cast<std::uint32_t>(
+                           _mm_movemask_epi8(repeats) ^ 0xffff),
+                       out);
+            previous = x;
+        }
+        // data itself may have been packed over by now
+        last = _mm_extract_epi16(previous, 7) >> 8;
+    }
+    kept = static_cast<std::size_t>(out - data);
+    return i;
+}
+
+#endif
+
+}  // namespace coreutils::detail
+
+#endif  // LIB_DETAIL_TRANSLATE_HPP_
@@ -0,0 +1,99 @@
+///
+///  @file main.cpp
+///  @brief Every utility in one binary, picked by the name it is run as
+///
+///  Copyright (C) 2025  Sebastian Pineda (spineda.wpi.alum@gmail.com)
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///  You should have received a copy of the GNU General Public License along
+///  with this program. If not, see <https://www.gnu.org/licenses/>
+///
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iostream>
+#include <print>
+#include <span>
+#include <string_view>
+
+// utilities.inc is generated by build.zig: one COREUTILS_UTILITY(name) line
+// for every utility in the CoreUtils struct
+#define COREUTILS_UTILITY(utility) \
+    int coreutils_main_##utility(int argc, const char** argv);
+#include "utilities.inc"
+#undef COREUTILS_UTILITY
+
+namespace {
+
+struct Utility final {
+    std::string_view name;
+    int (*main)(int argc, const char** argv);
+};
+
+constexpr std::array utilities{
+#define COREUTILS_UTILITY(utility) \
+    Utility{.name = #utility, .main = &coreutils_main_##utility},
+#include "utilities.inc"
+#undef COREUTILS_UTILITY
+};
+
+/// e.g. ls for /usr/bin/ls, or ls.exe on Windows
+constexpr std::string_view Basename(std::string_view path) {
+    if (const std::size_t slash{path.find_last_of("/\\")};
+        slash != std::string_view::npos) {
+        path.remove_prefix(slash + 1);
+    }
+    if (path.ends_with(".exe")) {
+        path.remove_suffix(4);
+    }
+    return path;
+}
+
+const Utility* Find(std::string_view name) {
+    const auto* const found{std::ranges::find(utilities, name, &Utility::name)};
+    return found == utilities.end() ? nullptr : found;
+}
+
+int Usage(std::string_view program) {
+    std::println(std::cerr, "Usage: {} UTILITY [ARGUMENT]...", program);
+    std::print(std::cerr, "Utilities:");
+    for (const Utility& utility : utilities) {
+        std::print(std::cerr, " {}", utility.name);
+    }
+    std::println(std::cerr, "");
+    return 1;
+}
+
+}  // namespace
+
+/// Run as a symlink named after a utility (e.g. ls -> coreutilspp), or as
+/// coreutilspp UTILITY [ARGUMENT]...
+int main(int argc, const char** argv) {
+    const std::span<const char*> args{argv, static_cast<std::size_t>(argc)};
+    const std::string_view program{args.empty() ? "coreutilspp"
+                                                : Basename(args.front())};
+    if (const Utility* const utility{Find(program)}) {
+        return utility->main(argc, argv);
+    }
+
+    if (args.size() < 2) {
+        return Usage(program);
+    }
+    const Utility* const utility{Find(args[1])};
+    if (!utility) {
+        std::println(std::cerr, "{}: unknown utility '{}'", program, args[1]);
+        return Usage(program);
+    }
+    // the utility sees its own name as argv[0]
+    return utility->main(argc - 1, argv + 1);
+}
@@ -1,6 +1,13 @@
 #include <ArgumentParser.hpp>
+#include <algorithm>
 #include <array>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 namespace {
 // -----------------------------------------------------------------------------
@@ -20,9 +27,7 @@ bool test_boolean_flag() {
         std::array<const char*, argc> argv{"Program", "--verbose"};
 
         ArgumentParser<Info, Verbose> parser{argc, argv.data()};
-        try {
-            parser.ParseArgsOrExit();
-        } catch (...) {
+        if (!parser.TryParseArgs()) {
             return false;
         }
 
@@ -35,9 +40,7 @@ bool test_boolean_flag() {
         std::array<const char*, argc> argv{"Program"};
 
         ArgumentParser<Info, Verbose> parser{argc, argv.data()};
-        try {
-            parser.ParseArgsOrExit();
-        } catch (...) {
+        if (!parser.TryParseArgs()) {
             return false;
         }
 
@@ -45,6 +48,274 @@ bool test_boolean_flag() {
     }
 }
 
+// -----------------------------------------------------------------------------
+// Test: Positionals Around Flags
+// Description: Positional values are collected wherever they appear relative
+// to flags, and values claimed by an option do not leak into them.
+// -----------------------------------------------------------------------------
+bool test_positionals_around_flags() {
+    using namespace coreutils;
+    using Info = ProgramInfo<"test", "0.0.1", "test", "test">;
+    using PosArgs =
+        PositionalArguments<std::string_view, [](std::string_view v) {
+            return v;
+        }>;
+    using Force = BooleanArgument<"-f", "--force">;
+    using Mode = SingleValueArgument<std::string_view,
+                                     [](std::string_view v) { return v; },
+                                     "-m", "--mode">;
+
+    constexpr int argc = 7;
+    std::array<const char*, argc> argv{"Program", "a",  "-f", "b",
+                                       "-m",      "755", "c"};
+
+    ArgumentParser<Info, PosArgs, Force, Mode> parser{argc, argv.data()};
+    if (!parser.TryParseArgs()) {
+        return false;
+    }
+
+    const std::vector<std::string_view> expected{"a", "b", "c"};
+    return parser.get<PosArgs>().value == expected &&
+           parser.get<Force>().value && parser.get<Mode>().value == "755";
+}
+
+// -----------------------------------------------------------------------------
+// Test: Long Option With Inline Value
+// Description: --name=value behaves exactly like --name value.
+// -----------------------------------------------------------------------------
+bool test_inline_value() {
+    using namespace coreutils;
+    using Info = ProgramInfo<"test", "0.0.1", "test", "test">;
+    using Sort = SingleValueArgument<std::string_view,
+                                     [](std::string_view v) { return v; },
+                                     "--sort">;
+
+    constexpr int argc = 2;
+    std::array<const char*, argc> argv{"Program", "--sort=size"};
+
+    ArgumentParser<Info, Sort> parser{argc, argv.data()};
+    if (!parser.TryParseArgs()) {
+        return false;
+    }
+
+    return parser.get<Sort>().value == "size";
+}
+
+// -----------------------------------------------------------------------------
+// Test: Inline Value Without An Option For It
+// Description: --name=value is an error, rather than an operand named value,
+// when --name takes no value or is not an option at all.
+// -----------------------------------------------------------------------------
+bool test_inline_value_errors() {
+    using namespace coreutils;
+    using Info = ProgramInfo<"test", "0.0.1", "test", "test">;
+    constexpr auto identity = [](std::string_view v) { return v; };
+    using PosArgs = PositionalArguments<std::string_view, identity>;
+    using All = BooleanArgument<"-a", "--all">;
+    using Parser = ArgumentParser<Info, PosArgs, All>;
+
+    const auto parse = [](std::span<const char*> argv) {
+        Parser parser{static_cast<int>(argv.size()), argv.data()};
+        const Parser::Result result{parser.TryParseArgs()};
+        return std::pair{result ? ParseError{} : result.error(),
+                         parser.get<PosArgs>().value.size()};
+    };
+    const auto is = [](std::pair<ParseError, std::size_t> parsed,
+                       ParseErrorKind kind, std::uint32_t index) {
+        return parsed.first.kind == kind && parsed.first.index == index &&
+               parsed.second == 0;
+    };
+
+    std::array<const char*, 2> known{"Program", "--all=x"};
+    std::array<const char*, 2> unknown{"Program", "--foo=bar"};
+    return is(parse(known), ParseErrorKind::UnexpectedValue, 1) &&
+           is(parse(unknown), ParseErrorKind::UnknownOption, 1);
+}
+
+// -----------------------------------------------------------------------------
+// Test: Repeated Option
+// Description: An option that takes one value can be given again and again
+// (-k1 -k 2,2), and positionals after it are not taken as more values.
+// -----------------------------------------------------------------------------
+bool test_repeated_value() {
+    using namespace coreutils;
+    using Info = ProgramInfo<"test", "0.0.1", "test", "test">;
+    constexpr auto identity = [](std::string_view v) { return v; };
+    using PosArgs = PositionalArguments<std::string_view, identity>;
+    using Key = RepeatedValueArgument<std::string_view, identity, "-k">;
+
+    constexpr int argc = 5;
+    std::array<const char*, argc> argv{"Program", "-k1", "-k", "2,2",
+                                       "file"};
+
+    ArgumentParser<Info, PosArgs, Key> parser{argc, argv.data()};
+    if (!parser.TryParseArgs()) {
+        return false;
+    }
+
+    const std::vector<std::string_view>& keys{parser.get<Key>().value};
+    const std::vector<std::string_view>& files{parser.get<PosArgs>().value};
+    return keys.size() == 2 && keys[0] == "1" && keys[1] == "2,2" &&
+           files.size() == 1 && files[0] == "file";
+}
+
+// -----------------------------------------------------------------------------
+// Test: Bundled Short Flags
+// Description: -fv is -f -v, a value may be attached (-m755), an option's
+// value may start with a dash, and -- ends the options.
+// -----------------------------------------------------------------------------
+bool test_bundled_short_flags() {
+    using namespace coreutils;
+    using Info = ProgramInfo<"test", "0.0.1", "test", "test">;
+    using PosArgs =
+        PositionalArguments<std::string_view, [](std::string_view v) {
+            return v;
+        }>;
+    using Force = BooleanArgument<"-f", "--force">;
+    using Verbose = BooleanArgument<"-v", "--verbose">;
+    using Mode = SingleValueArgument<std::string_view,
+                                     [](std::string_view v) { return v; },
+                                     "-m", "--mode">;
+    using Offset = SingleValueArgument<std::string_view,
+                                       [](std::string_view v) { return v; },
+                                       "-n">;
+
+    constexpr int argc = 8;
+    std::array<const char*, argc> argv{"Program", "-fvm755", "-n", "-5",
+                                       "a",       "--",      "-v", "-"};
+
+    ArgumentParser<Info, PosArgs, Force, Verbose, Mode, Offset> parser{
+        argc, argv.data()};
+    if (!parser.TryParseArgs()) {
+        return false;
+    }
+
+    const std::vector<std::string_view> expected{"a", "-v", "-"};
+    return parser.get<Force>().value && parser.get<Verbose>().value &&
+           parser.get<Mode>().value == "755" &&
+           parser.get<Offset>().value == "-5" &&
+           parser.get<PosArgs>().value == expected;
+}
+
+// -----------------------------------------------------------------------------
+// Test: Pluggable Containers
+// Description: Values land in the chosen container. ArgvView sees the
+// positionals in order even when flags are interleaved with them.
+// -----------------------------------------------------------------------------
+bool test_value_containers() {
+    using namespace coreutils;
+    using Info = ProgramInfo<"test", "0.0.1", "test", "test">;
+    constexpr auto identity = [](std::string_view v) { return v; };
+    using PosArgs = PositionalArguments<std::string_view, identity, ArgvView>;
+    using Force = BooleanArgument<"-f">;
+    using Names =
+        MultiValueArgumentIn<Inline<4>::Container, std::string_view, identity,
+                             "--names">;
+    using Tags = MultiValueArgumentIn<InArena<256>::Container,
+                                      std::string_view, identity, "--tags">;
+
+    constexpr int argc = 11;
+    std::array<const char*, argc> argv{
+        "Program", "a", "--names", "x", "y", "-f", "b", "--tags", "t", "--",
+        "c"};
+
+    ArgumentParser<Info, PosArgs, Force, Names, Tags> parser{argc,
+                                                             argv.data()};
+    if (!parser.TryParseArgs()) {
+        return false;
+    }
+
+    const std::vector<std::string_view> positionals{
+        parser.get<PosArgs>().value.begin(), parser.get<PosArgs>().value.end()};
+    const std::vector<std::string_view> expected{"a", "b", "c"};
+    const auto& names{parser.get<Names>().value};
+    const auto& tags{parser.get<Tags>().value};
+    return positionals == expected && names.size() == 2 &&
+           names[0] == "x" && names[1] == "y" && tags.size() == 1 &&
+           tags.front() == "t";
+}
+
+// -----------------------------------------------------------------------------
+// Test: Parse Errors
+// Description: Bad command lines come back as an error kind plus the argv
+// index of the token at fault, rather than as an exception.
+// -----------------------------------------------------------------------------
+bool test_parse_errors() {
+    using namespace coreutils;
+    using Info = ProgramInfo<"test", "0.0.1", "test", "test">;
+    constexpr auto identity = [](std::string_view v) { return v; };
+    using PosArgs = PositionalArguments<std::string_view, identity,
+                                        Inline<1>::Container>;
+    using Verbose = BooleanArgument<"-v">;
+    using Names = MultiValueArgument<std::string_view, identity, "--names">;
+    using Mode = SingleValueArgument<std::string_view, identity, "-m">;
+    using Parser = ArgumentParser<Info, PosArgs, Verbose, Names, Mode>;
+
+    const auto parse = [](std::span<const char*> argv) {
+        Parser parser{static_cast<int>(argv.size()), argv.data()};
+        const Parser::Result result{parser.TryParseArgs()};
+        return result ? ParseError{} : result.error();
+    };
+    const auto is = [](ParseError error, ParseErrorKind kind,
+                       std::uint32_t index) {
+        return error.kind == kind && error.index == index;
+    };
+
+    std::array<const char*, 4> duplicate{"Program", "a", "-v", "-vv"};
+    std::array<const char*, 4> no_names{"Program", "--names", "-v", "a"};
+    std::array<const char*, 3> no_mode{"Program", "-v", "-m"};
+    std::array<const char*, 4> too_many{"Program", "-v", "a", "b"};
+    return is(parse(duplicate), ParseErrorKind::DuplicateOption, 3) &&
+           is(parse(no_names), ParseErrorKind::MissingValues, 1) &&
+           is(parse(no_mode), ParseErrorKind::MissingValue, 2) &&
+           is(parse(too_many), ParseErrorKind::TooManyValues, 3);
+}
+
+// -----------------------------------------------------------------------------
+// Test: Many Option Names
+// Description: The compile time option table still gives every name a slot
+// of its own when there are hundreds of them (where a single hash seed that
+// separates them all practically never turns up).
+// -----------------------------------------------------------------------------
+constexpr std::size_t many_names{300};
+
+/// "--o000" through "--o299", back to back
+constexpr std::array<char, many_names * 6> many_names_text{[] {
+    std::array<char, many_names * 6> text{};
+    for (std::size_t i{0}; i < many_names; ++i) {
+        const std::array<char, 6> name{'-',
+                                       '-',
+                                       'o',
+                                       static_cast<char>('0' + i / 100),
+                                       static_cast<char>('0' + i / 10 % 10),
+                                       static_cast<char>('0' + i % 10)};
+        std::ranges::copy(name, text.begin() + 6 * i);
+    }
+    return text;
+}()};
+
+consteval std::array<coreutils::detail::FlagName, many_names> ManyNames() {
+    std::array<coreutils::detail::FlagName, many_names> names{};
+    for (std::size_t i{0}; i < many_names; ++i) {
+        names[i] = {.name = {many_names_text.data() + 6 * i, 6}, .index = i};
+    }
+    return names;
+}
+
+bool test_many_option_names() {
+    using coreutils::detail::FlagName;
+    static constexpr coreutils::detail::FlagTable<many_names> table{
+        ManyNames()};
+    for (std::size_t i{0}; i < many_names; ++i) {
+        const std::string_view name{many_names_text.data() + 6 * i, 6};
+        const FlagName* const found{table.Find(name)};
+        if (!found || found->index != i || found->name != name) {
+            return false;
+        }
+    }
+    return !table.Find("--o300") && !table.Find("--o") && !table.Find("");
+}
+
 /*
 // -----------------------------------------------------------------------------
 // Test 2: Typed Options (String & Integer)
@@ -145,7 +416,12 @@ bool test_negative_numbers() {
 }
 */
 
-std::array<std::function<bool()>, 1> tests{test_boolean_flag};
+std::array<std::function<bool()>, 9> tests{
+    test_boolean_flag,        test_positionals_around_flags,
+    test_inline_value,        test_inline_value_errors,
+    test_repeated_value,      test_bundled_short_flags,
+    test_value_containers,    test_parse_errors,
+    test_many_option_names};
 }  // namespace
 
 extern "C" {
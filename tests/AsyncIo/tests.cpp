@@ -0,0 +1,332 @@
+#include <AsyncIo.hpp>
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#endif
+
+namespace {
+#if !defined(_WIN32)
+/// A fresh directory under the temporary directory, removed along with the
+/// files made in it once the test is done with it
+class TempDirectory final {
+ public:
+    TempDirectory() {
+        std::string path{
+            (std::filesystem::temp_directory_path() / "asyncio-XXXXXX")
+                .string()};
+        if (::mkdtemp(path.data())) {
+            path_ = path;
+            fd_ = ::open(path_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        }
+    }
+
+    TempDirectory(const TempDirectory&) = delete;
+    TempDirectory& operator=(const TempDirectory&) = delete;
+
+    ~TempDirectory() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+        std::error_code ignored{};
+        std::filesystem::remove_all(path_, ignored);
+    }
+
+    int fd() const { return fd_; }
+
+ private:
+    std::string path_{};
+    int fd_{-1};
+};
+
+/// Opens name in dir through engine, returning the descriptor or -1
+int open_file(coreutils::IoEngine& engine, const TempDirectory& dir,
+              const char* name, int flags) {
+    std::array requests{coreutils::IoRequest::OpenAt(dir.fd(), name, flags)};
+    engine.Run(requests);
+    return requests[0].result >= 0 ? static_cast<int>(requests[0].result)
+                                   : -1;
+}
+
+// -----------------------------------------------------------------------------
+// Test 1: Open And Stat
+// Description: Opens create files and hand back their descriptors, stats fill
+// in the fields asked for, and either fails with its negated errno without
+// stopping the rest of the batch.
+// -----------------------------------------------------------------------------
+bool test_open_and_stat() {
+    const TempDirectory dir{};
+    coreutils::IoEngine engine{4, 2};
+    std::array opens{
+        coreutils::IoRequest::OpenAt(dir.fd(), "made", O_CREAT | O_WRONLY),
+        coreutils::IoRequest::OpenAt(dir.fd(), "missing", O_RDONLY),
+    };
+    engine.Run(opens);
+    if (dir.fd() < 0 || opens[0].result < 0 || opens[1].result != -ENOENT ||
+        opens[1].error() != std::errc::no_such_file_or_directory) {
+        return false;
+    }
+    const int fd{static_cast<int>(opens[0].result)};
+    const bool written{::write(fd, "hello", 5) == 5};
+    ::close(fd);
+
+    std::array stats{
+        coreutils::IoRequest::Stat(dir.fd(), "made",
+                                   coreutils::StatField::Size),
+        coreutils::IoRequest::Stat(dir.fd(), ".", coreutils::StatField::None),
+        coreutils::IoRequest::Stat(dir.fd(), "missing",
+                                   coreutils::StatField::Size),
+    };
+    engine.Run(stats);
+    return written && stats[0].result == 0 &&
+           stats[0].status.type == coreutils::FileType::Regular &&
+           stats[0].status.size == 5 && stats[1].result == 0 &&
+           stats[1].status.type == coreutils::FileType::Directory &&
+           stats[2].result == -ENOENT;
+}
+
+// -----------------------------------------------------------------------------
+// Test 2: Positional Reads And Writes
+// Description: A batch many times the queue depth of writes at offsets, then
+// one of reads at offsets, each land where they were asked to, and leave the
+// file's own offset alone.
+// -----------------------------------------------------------------------------
+bool test_positional() {
+    const TempDirectory dir{};
+    coreutils::IoEngine engine{4, 3};
+    const int fd{open_file(engine, dir, "data", O_CREAT | O_RDWR)};
+    if (fd < 0) {
+        return false;
+    }
+
+    constexpr std::size_t count{200};
+    std::string text{};
+    for (std::size_t i{0}; i < count; ++i) {
+        text.push_back(static_cast<char>('a' + i % 26));
+    }
+    std::vector<coreutils::IoRequest> writes{};
+    for (std::size_t i{0}; i < count; ++i) {
+        writes.push_back(coreutils::IoRequest::Write(
+            fd, std::span<const char>{text}.subspan(i, 1),
+            static_cast<std::int64_t>(i)));
+    }
+    engine.Run(writes);
+
+    std::string back(count, '\0');
+    std::vector<coreutils::IoRequest> reads{};
+    for (std::size_t i{0}; i < count; i += 10) {
+        reads.push_back(coreutils::IoRequest::Read(
+            fd, std::span<char>{back}.subspan(i, 10),
+            static_cast<std::int64_t>(i)));
+    }
+    engine.Run(reads);
+
+    bool result{::lseek(fd, 0, SEEK_CUR) == 0 && back == text};
+    for (const coreutils::IoRequest& write : writes) {
+        result = result && write.result == 1;
+    }
+    for (const coreutils::IoRequest& read : reads) {
+        result = result && read.result == 10;
+    }
+    ::close(fd);
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// Test 3: File Offset
+// Description: Reads and writes without an offset go through the file's own
+// offset and move it, like read and write do.
+// -----------------------------------------------------------------------------
+bool test_file_offset() {
+    const TempDirectory dir{};
+    coreutils::IoEngine engine{};
+    const int fd{open_file(engine, dir, "data", O_CREAT | O_RDWR)};
+    if (fd < 0) {
+        return false;
+    }
+
+    bool result{true};
+    for (const std::string_view piece : {"abc", "defg"}) {
+        std::array write{coreutils::IoRequest::Write(fd, piece)};
+        engine.Run(write);
+        result = result && write[0].result ==
+                               static_cast<std::int64_t>(piece.size());
+    }
+    result = result && ::lseek(fd, 1, SEEK_SET) == 1;
+
+    std::array<char, 16> buffer{};
+    std::array read{coreutils::IoRequest::Read(fd, buffer)};
+    engine.Run(read);
+    result = result && read[0].result == 6 &&
+             std::string_view{buffer.data(), 6} == "bcdefg" &&
+             ::lseek(fd, 0, SEEK_CUR) == 7;
+    ::close(fd);
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// Test 4: Failed Reads And Writes
+// Description: Reads and writes on descriptors that cannot do them report
+// the negated errno, and the requests around them still run.
+// -----------------------------------------------------------------------------
+bool test_failures() {
+    const TempDirectory dir{};
+    coreutils::IoEngine engine{2, 2};
+    const int fd{open_file(engine, dir, "data", O_CREAT | O_RDONLY)};
+    if (fd < 0) {
+        return false;
+    }
+
+    std::array<char, 4> buffer{};
+    std::array requests{
+        coreutils::IoRequest::Read(-1, buffer, 0),
+        coreutils::IoRequest::Write(fd, std::string_view{"x"}, 0),
+        coreutils::IoRequest::Read(fd, buffer, 0),
+        coreutils::IoRequest::Write(-1, std::string_view{"x"}),
+    };
+    engine.Run(requests);
+    ::close(fd);
+    return requests[0].result == -EBADF &&
+           requests[0].error() == std::errc::bad_file_descriptor &&
+           requests[1].result == -EBADF && requests[2].result == 0 &&
+           requests[3].result == -EBADF;
+}
+
+#if defined(__linux__)
+/// From now on, every io_uring_enter in this process that hands the kernel
+/// anything but none or exactly allowed submissions fails with ENOMEM
+bool FailSubmissionsExcept(unsigned allowed) {
+    // the low half of to_submit, which is all of it
+    constexpr std::uint32_t to_submit{
+        offsetof(seccomp_data, args[1]) +
+        (std::endian::native == std::endian::big ? 4u : 0u)};
+    std::array filter{
+        sock_filter BPF_STMT(BPF_LD | BPF_W | BPF_ABS,
+                             offsetof(seccomp_data, nr)),
+        sock_filter BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, __NR_io_uring_enter,
+                             0, 4),
+        sock_filter BPF_STMT(BPF_LD | BPF_W | BPF_ABS, to_submit),
+        sock_filter BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0, 2, 0),
+        sock_filter BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, allowed, 1, 0),
+        sock_filter BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ERRNO | ENOMEM),
+        sock_filter BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW),
+    };
+    const sock_fprog program{.len = static_cast<unsigned short>(filter.size()),
+                             .filter = filter.data()};
+    return ::prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) == 0 &&
+           ::prctl(PR_SET_SECCOMP, SECCOMP_MODE_FILTER, &program) == 0;
+}
+
+/// The body of test_submit_failure, in a process of its own
+bool run_with_failing_submits(const TempDirectory& dir) {
+    constexpr std::size_t depth{4};
+    constexpr std::size_t count{40};
+    std::string text(count, '\0');
+    for (std::size_t i{0}; i < count; ++i) {
+        text[i] = static_cast<char>('a' + i % 26);
+    }
+    const int fd{::openat(dir.fd(), "data", O_CREAT | O_RDWR, 0600)};
+    std::array<int, 2> pipe{-1, -1};
+    if (fd < 0 ||
+        ::write(fd, text.data(), count) != static_cast<ssize_t>(count) ||
+        ::pipe(pipe.data()) != 0) {
+        return false;
+    }
+    if (!FailSubmissionsExcept(depth)) {
+        // no seccomp, so there is nothing to test with
+        return true;
+    }
+
+    // the read from the pipe is taken by the kernel in the first submission,
+    // and cannot finish until well after the second one fails
+    std::array<char, 1> from_pipe{};
+    std::string back(count, '\0');
+    std::vector<coreutils::IoRequest> requests{
+        coreutils::IoRequest::Read(pipe[0], from_pipe)};
+    for (std::size_t i{0}; i < count; ++i) {
+        requests.push_back(coreutils::IoRequest::Read(
+            fd, std::span<char>{back}.subspan(i, 1),
+            static_cast<std::int64_t>(i)));
+    }
+    std::thread writer{[&pipe] {
+        std::this_thread::sleep_for(std::chrono::milliseconds{100});
+        return ::write(pipe[1], "!", 1);
+    }};
+    coreutils::IoEngine engine{depth, 2};
+    engine.Run(requests);
+    writer.join();
+    ::close(pipe[1]);
+
+    bool result{requests[0].result == 1 && from_pipe[0] == '!' &&
+                back == text};
+    for (std::size_t i{1}; i < requests.size(); ++i) {
+        result = result && requests[i].result == 1;
+    }
+    // and the engine carries on without the ring
+    engine.Run(requests);
+    return result && requests[1].result == 1 && requests[0].result == 0;
+}
+
+// -----------------------------------------------------------------------------
+// Test 5: Submission Failing Mid-Batch
+// Description: When io_uring_enter starts failing after the kernel has taken
+// part of a batch, the requests it took still finish through the ring, and
+// the rest are run without it, rather than the process aborting.
+// -----------------------------------------------------------------------------
+bool test_submit_failure() {
+    const TempDirectory dir{};
+    const pid_t child{::fork()};
+    if (child == 0) {
+        ::_exit(run_with_failing_submits(dir) ? 0 : 1);
+    }
+    int status{0};
+    return child > 0 && ::waitpid(child, &status, 0) == child &&
+           WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+std::array<std::function<bool()>, 5> tests{test_open_and_stat,
+                                           test_positional, test_file_offset,
+                                           test_failures, test_submit_failure};
+#else
+std::array<std::function<bool()>, 4> tests{
+    test_open_and_stat, test_positional, test_file_offset, test_failures};
+#endif
+#else
+// requests are run against descriptors made with POSIX calls above
+std::array<std::function<bool()>, 0> tests{};
+#endif
+}  // namespace
+
+extern "C" {
+bool test_asyncio() {
+    bool result{true};
+    for (const auto& test : tests) {
+        result = result && test();
+    }
+
+    return result;
+}
+}
@@ -0,0 +1,221 @@
+#include <Checksum.hpp>
+#include <ChecksumUtility.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <format>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+namespace {
+template <class Hash>
+std::string hex_digest(std::string_view text) {
+    Hash hash{};
+    hash.Update(text);
+    return coreutils::ToHex(hash.Finish());
+}
+
+/// Text whose length crosses block boundaries, to be fed in pieces
+std::string long_text(std::size_t size) {
+    std::string text(size, '\0');
+    for (std::size_t i{0}; i < size; ++i) {
+        text[i] = static_cast<char>((i * 131) % 251);
+    }
+    return text;
+}
+
+/// Every split of text into two pieces hashes the same as the whole
+template <class Hash>
+bool same_when_split(std::string_view text) {
+    const std::string whole{hex_digest<Hash>(text)};
+    for (std::size_t split{0}; split <= text.size(); ++split) {
+        Hash hash{};
+        hash.Update(text.substr(0, split));
+        hash.Update(text.substr(split));
+        if (coreutils::ToHex(hash.Finish()) != whole) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Test 1: Known Digests
+// Description: The digests of "" and "abc" are the ones the RFCs and FIPS
+// 180-4 give.
+// -----------------------------------------------------------------------------
+bool test_known_digests() {
+    return hex_digest<coreutils::Md5>("") ==
+               "d41d8cd98f00b204e9800998ecf8427e" &&
+           hex_digest<coreutils::Md5>("abc") ==
+               "900150983cd24fb0d6963f7d28e17f72" &&
+           hex_digest<coreutils::Sha256>("") ==
+               "e3b0c44298fc1c149afbf4c8996fb924"
+               "27ae41e4649b934ca495991b7852b855" &&
+           hex_digest<coreutils::Sha256>("abc") ==
+               "ba7816bf8f01cfea414140de5dae2223"
+               "b00361a396177a9cb410ff61f20015ad" &&
+           hex_digest<coreutils::Sha256>(
+               "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq") ==
+               "248d6a61d20638b8e5c026930c3e6039"
+               "a33ce45964ff2167f6ecedd419db06c1" &&
+           hex_digest<coreutils::Blake2b>("abc") ==
+               "ba80a53f981c4d0d6a2797b69f12f6e9"
+               "4c212f14685ac4b74b12bb6fdbffa2d1"
+               "7d87c5392aab792dc252d5de4533cc95"
+               "18d38aa8dbf1925ab92386edd4009923";
+}
+
+// -----------------------------------------------------------------------------
+// Test 2: Split Input
+// Description: Feeding a hash in two pieces gives the same digest as feeding
+// it all at once, wherever the split falls (including on block boundaries,
+// which BLAKE2b treats specially at the end of the input).
+// -----------------------------------------------------------------------------
+bool test_split_input() {
+    const std::string text{long_text(300)};
+    return same_when_split<coreutils::Md5>(text) &&
+           same_when_split<coreutils::Sha256>(text) &&
+           same_when_split<coreutils::Blake2b>(text) &&
+           same_when_split<coreutils::Blake2b>(long_text(256));
+}
+
+// -----------------------------------------------------------------------------
+// Test 3: Checksum Lines
+// Description: Lines in either style parse, escaped names are unescaped, and
+// lines with a digest of the wrong length or a bad escape are rejected.
+// -----------------------------------------------------------------------------
+bool test_checksum_lines() {
+    const std::string digest(32, 'a');
+    const auto parse = [](std::string_view line) {
+        return coreutils::ParseChecksumLine(line, "MD5", 16);
+    };
+    const std::optional<coreutils::ChecksumLine> plain{
+        parse(digest + "  name with spaces")};
+    const std::optional<coreutils::ChecksumLine> binary{
+        parse(std::string(32, 'A') + " *file")};
+    const std::optional<coreutils::ChecksumLine> tagged{
+        parse("MD5 (a) = b) = " + digest)};
+    const std::optional<coreutils::ChecksumLine> escaped{
+        parse("\\" + digest + "  a\\\\b\\nc")};
+    return plain && plain->name == "name with spaces" &&
+           plain->digest == digest && binary && binary->name == "file" &&
+           binary->digest == digest && tagged && tagged->name == "a) = b" &&
+           escaped && escaped->name == "a\\b\nc" &&
+           !parse(digest.substr(1) + "  short") &&
+           !parse("\\" + digest + "  bad\\q") && !parse(digest + " x") &&
+           coreutils::Escape("a\\b\nc") == "a\\\\b\\nc";
+}
+
+#if !defined(_WIN32)
+/// Everything in file, from its start
+std::string read_back(std::FILE* file) {
+    std::string text{};
+    std::array<char, 4096> buffer{};
+    std::rewind(file);
+    for (std::size_t got{0};
+         (got = std::fread(buffer.data(), 1, buffer.size(), file)) > 0;) {
+        text.append(buffer.data(), got);
+    }
+    return text;
+}
+
+/// What md5sum (or md5sum -c) prints for operands while standard input is a
+/// file holding text, or nothing if it fails
+std::string run_on_stdin(std::string_view text, bool check,
+                         const std::vector<std::string>& operands) {
+    std::FILE* const input{std::tmpfile()};
+    std::FILE* const output{std::tmpfile()};
+    if (!input || !output ||
+        std::fwrite(text.data(), 1, text.size(), input) != text.size() ||
+        std::fflush(input) != 0) {
+        return "";
+    }
+    std::rewind(input);
+    const int saved{::dup(0)};
+    ::dup2(::fileno(input), 0);
+    int status{0};
+    {
+        coreutils::Output out{::fileno(output)};
+        const coreutils::detail::ChecksumOptions options{
+            .program = "md5sum", .threads = 4};
+        if (check) {
+            for (const std::string& list : operands) {
+                status |= coreutils::detail::CheckChecksums<coreutils::Md5>(
+                    list, options, out);
+            }
+        } else {
+            status = coreutils::detail::PrintChecksums<coreutils::Md5>(
+                operands, options, out);
+        }
+    }
+    ::dup2(saved, 0);
+    ::close(saved);
+    std::string printed{status == 0 ? read_back(output) : ""};
+    std::fclose(input);
+    std::fclose(output);
+    return printed;
+}
+
+// -----------------------------------------------------------------------------
+// Test 4: Standard Input More Than Once
+// Description: The first "-" hashes all of standard input and any later one
+// hashes nothing, as GNU does, however many threads there are, both when
+// printing digests and when checking a list that names "-".
+// -----------------------------------------------------------------------------
+bool test_repeated_stdin() {
+    const std::string text{long_text(1 << 20)};
+    const std::string all{hex_digest<coreutils::Md5>(text)};
+    const std::string none{hex_digest<coreutils::Md5>("")};
+
+    const std::string list{std::format("{}  -\n{}  -\n", all, none)};
+    std::string list_path{
+        (std::filesystem::temp_directory_path() / "checksum-XXXXXX")
+            .string()};
+    const int listed{::mkstemp(list_path.data())};
+    if (listed < 0) {
+        return false;
+    }
+    const bool written{::write(listed, list.data(), list.size()) ==
+                       static_cast<ssize_t>(list.size())};
+    ::close(listed);
+    const std::string checked{
+        written ? run_on_stdin(text, true, {list_path}) : ""};
+    ::unlink(list_path.c_str());
+
+    return run_on_stdin(text, false, {"-", "-", "-"}) ==
+               std::format("{}  -\n{}  -\n{}  -\n", all, none, none) &&
+           checked == "-: OK\n-: OK\n";
+}
+
+std::array<std::function<bool()>, 4> tests{
+    test_known_digests, test_split_input, test_checksum_lines,
+    test_repeated_stdin};
+#else
+// standard input is swapped out with POSIX calls
+std::array<std::function<bool()>, 3> tests{
+    test_known_digests, test_split_input, test_checksum_lines};
+#endif
+}  // namespace
+
+extern "C" {
+bool test_checksum() {
+    bool result{true};
+    for (const auto& test : tests) {
+        result = result && test();
+    }
+
+    return result;
+}
+}
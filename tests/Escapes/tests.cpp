@@ -0,0 +1,88 @@
+#include <Escapes.hpp>
+#include <array>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace {
+/// Decodes text, returning nothing on errors
+std::string unescape(std::string_view text, coreutils::EscapeStyle style,
+                     coreutils::EscapeEnd expected_end) {
+    std::string out{};
+    const coreutils::EscapeResult result{
+        coreutils::AppendUnescaped(text, style, out)};
+    return result && *result == expected_end ? out : "<error>";
+}
+
+// -----------------------------------------------------------------------------
+// Test 1: Echo Escapes
+// Description: echo -e knows \0NNN and \NNN octal and \xHH, stops at \c, and
+// keeps whatever else follows a backslash as it is.
+// -----------------------------------------------------------------------------
+bool test_echo_escapes() {
+    using coreutils::EscapeEnd;
+    using coreutils::EscapeStyle;
+    return unescape("a\\tb\\\\", EscapeStyle::Echo, EscapeEnd::Finished) ==
+               "a\tb\\" &&
+           unescape("\\0101\\101\\08", EscapeStyle::Echo,
+                    EscapeEnd::Finished) == std::string{"AA\0" "8", 4} &&
+           unescape("\\x41\\x\\u00e9\\\"\\", EscapeStyle::Echo,
+                    EscapeEnd::Finished) == "A\\x\\u00e9\\\"\\" &&
+           unescape("one\\ctwo", EscapeStyle::Echo, EscapeEnd::Stopped) ==
+               "one";
+}
+
+// -----------------------------------------------------------------------------
+// Test 2: Printf Escapes
+// Description: printf's FORMAT reads at most three octal digits including a
+// leading zero, while %b arguments read three after it. Both decode
+// universal character names to UTF-8, and reject a \x without digits.
+// -----------------------------------------------------------------------------
+bool test_printf_escapes() {
+    using coreutils::EscapeEnd;
+    using coreutils::EscapeStyle;
+    return unescape("\\0101", EscapeStyle::PrintfFormat,
+                    EscapeEnd::Finished) == "\b1" &&
+           unescape("\\0101", EscapeStyle::PrintfArgument,
+                    EscapeEnd::Finished) == "A" &&
+           unescape("\\u00e9\\U0001F600\\\"", EscapeStyle::PrintfFormat,
+                    EscapeEnd::Finished) == "\xc3\xa9\xf0\x9f\x98\x80\"" &&
+           unescape("\\xZ", EscapeStyle::PrintfFormat, EscapeEnd::Finished) ==
+               "<error>" &&
+           unescape("\\ud800", EscapeStyle::PrintfArgument,
+                    EscapeEnd::Finished) == "<error>";
+}
+
+// -----------------------------------------------------------------------------
+// Test 3: One Escape
+// Description: printf's FORMAT is decoded one escape at a time, around its
+// conversions. Each escape is taken whole, so \\ is one backslash and \%
+// is kept as it is, and whatever comes after is left for the caller.
+// -----------------------------------------------------------------------------
+bool test_one_escape() {
+    const auto decode{[](std::string_view text, std::string_view decoded,
+                         std::string_view rest) {
+        std::string out{};
+        const coreutils::EscapeResult result{coreutils::AppendEscape(
+            text, coreutils::EscapeStyle::PrintfFormat, out)};
+        return result && out == decoded && text == rest;
+    }};
+    return decode("\\\\b", "\\", "b") && decode("\\bc", "\b", "c") &&
+           decode("\\%d", "\\%", "d") && decode("\\0101%d", "\b", "1%d") &&
+           decode("\\x41\\n", "A", "\\n") && decode("\\", "\\", "");
+}
+
+std::array<std::function<bool()>, 3> tests{
+    test_echo_escapes, test_printf_escapes, test_one_escape};
+}  // namespace
+
+extern "C" {
+bool test_escapes() {
+    bool result{true};
+    for (const auto& test : tests) {
+        result = result && test();
+    }
+
+    return result;
+}
+}
@@ -0,0 +1,215 @@
+#include <FileInput.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+/// Lines of every length from 0 up, so splits land everywhere in them
+std::string lines_text(std::size_t lines) {
+    std::string text{};
+    for (std::size_t i{0}; i < lines; ++i) {
+        text.append(i % 37, 'x');
+        text.push_back('\n');
+    }
+    return text;
+}
+
+/// An anonymous file holding text, which goes away when it is closed
+std::unique_ptr<std::FILE, int (*)(std::FILE*)> temp_file(
+    std::string_view text) {
+    std::unique_ptr<std::FILE, int (*)(std::FILE*)> file{std::tmpfile(),
+                                                         &std::fclose};
+    if (file) {
+        std::fwrite(text.data(), 1, text.size(), file.get());
+        std::fflush(file.get());
+        std::rewind(file.get());
+    }
+    return file;
+}
+
+/// Everything source gives, read a few bytes at a time when it reads
+std::string read_all(coreutils::InputSource& source) {
+    std::array<char, 100> buffer{};
+    std::string text{};
+    const std::error_code error{
+        source.ForEachChunk(buffer, [&text](std::span<const char> data) {
+            text.append(data.data(), data.size());
+        })};
+    return error ? "<error>" : text;
+}
+
+// -----------------------------------------------------------------------------
+// Test 1: Whole Text
+// Description: The pieces of a split follow on from one another and cover the
+// whole text, for every piece size, including ones bigger than the text.
+// -----------------------------------------------------------------------------
+bool test_whole_text() {
+    const std::string text{lines_text(50)};
+    for (std::size_t size{1}; size <= text.size() + 1; ++size) {
+        const std::vector<std::span<const char>> chunks{
+            coreutils::SplitChunks(text, size)};
+        const char* next{text.data()};
+        for (const std::span<const char> chunk : chunks) {
+            if (chunk.data() != next || chunk.size() > size) {
+                return false;
+            }
+            next += chunk.size();
+        }
+        if (next != text.data() + text.size()) {
+            return false;
+        }
+    }
+    return coreutils::SplitChunks(std::span<const char>{}, 16).empty();
+}
+
+// -----------------------------------------------------------------------------
+// Test 2: Line Aligned
+// Description: When starts are moved past the next newline, every piece but
+// the last ends with one, and the pieces still cover the whole text.
+// -----------------------------------------------------------------------------
+bool test_line_aligned() {
+    const std::string text{lines_text(200)};
+    const auto after_newline = [](std::span<const char> all,
+                                  std::size_t start) {
+        while (start < all.size() && all[start - 1] != '\n') {
+            ++start;
+        }
+        return start;
+    };
+    for (std::size_t size{1}; size < 300; size += 13) {
+        const std::vector<std::span<const char>> chunks{
+            coreutils::SplitChunks(text, size, after_newline)};
+        std::string joined{};
+        for (std::size_t i{0}; i < chunks.size(); ++i) {
+            if (i + 1 < chunks.size() && !chunks[i].empty() &&
+                chunks[i].back() != '\n') {
+                return false;
+            }
+            joined.append(chunks[i].data(), chunks[i].size());
+        }
+        if (joined != text) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#if !defined(_WIN32)
+// -----------------------------------------------------------------------------
+// Test 3: Map Threshold
+// Description: A regular file is mapped from the threshold up and read below
+// it, and never mapped with never_map. Either way it comes out the same.
+// -----------------------------------------------------------------------------
+bool test_map_threshold() {
+    const std::string text{lines_text(200)};
+    const auto file{temp_file(text)};
+    if (!file) {
+        return false;
+    }
+    const int fd{::fileno(file.get())};
+    for (const std::size_t threshold :
+         {std::size_t{1}, text.size(), text.size() + 1,
+          coreutils::InputSource::never_map}) {
+        ::lseek(fd, 0, SEEK_SET);
+        coreutils::InputSource source{fd, threshold};
+        const bool mapped{threshold <= text.size()};
+        if ((source.strategy() == coreutils::InputStrategy::Map) != mapped ||
+            source.mapped().has_value() != mapped ||
+            read_all(source) != text) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Test 4: Current Offset
+// Description: Only what is left after the file's offset is given, mapped or
+// read, and a mapped file is left at its end as reading it would leave it.
+// -----------------------------------------------------------------------------
+bool test_current_offset() {
+    const std::string text{lines_text(200)};
+    const auto file{temp_file(text)};
+    if (!file) {
+        return false;
+    }
+    const int fd{::fileno(file.get())};
+    const std::string_view rest{std::string_view{text}.substr(1000)};
+
+    ::lseek(fd, 1000, SEEK_SET);
+    coreutils::InputSource mapped{fd, 1};
+    const std::optional<std::span<const char>> view{mapped.mapped()};
+    if (!view || std::string_view{view->data(), view->size()} != rest ||
+        ::lseek(fd, 0, SEEK_CUR) != static_cast<off_t>(text.size()) ||
+        read_all(mapped) != rest) {
+        return false;
+    }
+
+    ::lseek(fd, 1000, SEEK_SET);
+    coreutils::InputSource read{fd, coreutils::InputSource::never_map};
+    return read_all(read) == rest &&
+           ::lseek(fd, 0, SEEK_CUR) == static_cast<off_t>(text.size());
+}
+
+// -----------------------------------------------------------------------------
+// Test 5: Empty Files
+// Description: Files that say they are empty are read, never mapped, since
+// some (like those in /proc) only tell how big they are by being read.
+// -----------------------------------------------------------------------------
+bool test_empty_files() {
+    const auto empty{temp_file("")};
+    if (!empty) {
+        return false;
+    }
+    coreutils::InputSource nothing{::fileno(empty.get()), 0};
+    if (nothing.strategy() != coreutils::InputStrategy::Read ||
+        !read_all(nothing).empty()) {
+        return false;
+    }
+
+    const int fd{::open("/proc/self/stat", O_RDONLY)};
+    if (fd < 0) {
+        // not on Linux
+        return true;
+    }
+    coreutils::InputSource proc{fd, 0};
+    const bool read{proc.strategy() == coreutils::InputStrategy::Read &&
+                    !read_all(proc).empty()};
+    ::close(fd);
+    return read;
+}
+#endif
+
+#if defined(_WIN32)
+std::array<std::function<bool()>, 2> tests{test_whole_text,
+                                           test_line_aligned};
+#else
+std::array<std::function<bool()>, 5> tests{
+    test_whole_text, test_line_aligned, test_map_threshold,
+    test_current_offset, test_empty_files};
+#endif
+}  // namespace
+
+extern "C" {
+bool test_fileinput() {
+    bool result{true};
+    for (const auto& test : tests) {
+        result = result && test();
+    }
+
+    return result;
+}
+}
@@ -0,0 +1,74 @@
+#include <InodeSet.hpp>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace {
+// -----------------------------------------------------------------------------
+// Test 1: Duplicates
+// Description: Only the first insert of a file succeeds, and files are told
+// apart by device as well as by inode.
+// -----------------------------------------------------------------------------
+bool test_duplicates() {
+    coreutils::InodeSet set{};
+    // enough files for every shard to grow a few times
+    for (std::uint64_t inode{0}; inode < 10000; ++inode) {
+        if (!set.Insert(1, inode) || set.Insert(1, inode)) {
+            return false;
+        }
+    }
+    for (std::uint64_t inode{0}; inode < 10000; ++inode) {
+        if (set.Insert(1, inode) || !set.Insert(2, inode)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Test 2: Concurrent Inserts
+// Description: When several threads insert overlapping files at once, each
+// file is reported as new exactly once.
+// -----------------------------------------------------------------------------
+bool test_concurrent_inserts() {
+    constexpr std::size_t threads{4};
+    constexpr std::uint64_t files{20000};
+    coreutils::InodeSet set{};
+    std::atomic<std::uint64_t> inserted{0};
+    {
+        std::vector<std::jthread> workers{};
+        for (std::size_t t{0}; t < threads; ++t) {
+            workers.emplace_back([&set, &inserted, t]() {
+                // every thread covers half of the files, starting a quarter
+                // further along than the last, so that between them every
+                // file is covered twice
+                for (std::uint64_t i{0}; i < files / 2; ++i) {
+                    const std::uint64_t inode{(i + t * files / 4) % files};
+                    if (set.Insert(7, inode)) {
+                        inserted.fetch_add(1);
+                    }
+                }
+            });
+        }
+    }
+    return inserted.load() == files;
+}
+
+std::array<std::function<bool()>, 2> tests{test_duplicates,
+                                           test_concurrent_inserts};
+}  // namespace
+
+extern "C" {
+bool test_inodeset() {
+    bool result{true};
+    for (const auto& test : tests) {
+        result = result && test();
+    }
+
+    return result;
+}
+}
@@ -0,0 +1,97 @@
+#include <SortKey.hpp>
+#include <array>
+#include <expected>
+#include <functional>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace {
+/// The part of line that the key given as spec (as to -k) covers
+std::string_view key_of(std::string_view spec, std::string_view line,
+                        std::optional<char> tab = std::nullopt) {
+    const coreutils::SortFlags defaults{};
+    const std::expected<coreutils::SortKey, coreutils::SortKeyError> key{
+        coreutils::ParseSortKey(spec, defaults)};
+    if (!key) {
+        return "<invalid>";
+    }
+    const coreutils::LineOrder order{{*key}, defaults, tab, false};
+    return order.Make(line.data(), line.size()).key();
+}
+
+// -----------------------------------------------------------------------------
+// Test 1: Parse Keys
+// Description: Fields and characters come out counted from zero, options
+// attach to the end they follow, and bad specs are rejected with the reason.
+// -----------------------------------------------------------------------------
+bool test_parse_keys() {
+    const coreutils::SortFlags defaults{.skip_blanks = false,
+                                        .numeric = true,
+                                        .reverse = false};
+    const auto parse = [&defaults](std::string_view spec) {
+        return coreutils::ParseSortKey(spec, defaults);
+    };
+    const auto fails = [&parse](std::string_view spec,
+                                coreutils::SortKeyError error) {
+        const auto key{parse(spec)};
+        return !key && key.error() == error;
+    };
+
+    const auto whole{parse("2")};
+    const auto span{parse("2.3,4.5b")};
+    return whole && whole->start_field == 1 && whole->start_char == 0 &&
+           whole->end_field == coreutils::SortKey::to_end &&
+           whole->numeric && span && span->start_field == 1 &&
+           span->start_char == 2 && span->end_field == 3 &&
+           span->end_char == 5 && !span->skip_start_blanks &&
+           span->skip_end_blanks && !span->numeric &&
+           fails("0", coreutils::SortKeyError::ZeroField) &&
+           fails("1.0", coreutils::SortKeyError::ZeroCharacter) &&
+           fails("1,x", coreutils::SortKeyError::BadNumber) &&
+           fails("1M", coreutils::SortKeyError::UnsupportedOption) &&
+           fails("1,2q", coreutils::SortKeyError::StrayCharacter);
+}
+
+// -----------------------------------------------------------------------------
+// Test 2: Key Positions
+// Description: Keys start and end where GNU's begfield and limfield put
+// them, with and without -t, including fields that are missing altogether.
+// -----------------------------------------------------------------------------
+bool test_key_positions() {
+    return key_of("2", "ab cd ef") == " cd ef" &&
+           key_of("2,2", "ab cd ef") == " cd" &&
+           key_of("2b,2", "ab   cd ef") == "cd" &&
+           key_of("1.2,1.4", "abcdef ghi") == "bcd" &&
+           key_of("2,2", "ab:cd:ef", ':') == "cd" &&
+           key_of("2.2", "ab:cd:ef", ':') == "d:ef" &&
+           key_of("3", "ab", ':').empty() && key_of("2,1", "ab cd").empty();
+}
+
+// -----------------------------------------------------------------------------
+// Test 3: Short End Field
+// Description: A character offset past the end of the key's last field stops
+// at the end of that field, rather than running on into the next one.
+// -----------------------------------------------------------------------------
+bool test_short_end_field() {
+    return key_of("1,1.5", "ab cdefg") == "ab" &&
+           key_of("1,1.5", "ab:cdefg", ':') == "ab" &&
+           key_of("2,2.3b", "x   ab cd") == "   ab" &&
+           key_of("2,2.3", "x   ab cd") == "   " &&
+           key_of("1,1.2", "abcdef ghi") == "ab";
+}
+
+std::array<std::function<bool()>, 3> tests{
+    test_parse_keys, test_key_positions, test_short_end_field};
+}  // namespace
+
+extern "C" {
+bool test_sortkey() {
+    bool result{true};
+    for (const auto& test : tests) {
+        result = result && test();
+    }
+
+    return result;
+}
+}
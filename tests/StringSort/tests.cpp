@@ -0,0 +1,77 @@
+#include <StringSort.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+bool matches_std_sort(std::vector<std::string> strings) {
+    std::vector<coreutils::SortRecord> records{};
+    for (std::size_t i{0}; i < strings.size(); ++i) {
+        records.push_back(coreutils::SortRecord::Make(
+            strings[i], static_cast<std::uint32_t>(i)));
+    }
+    coreutils::SortStrings(records);
+
+    std::vector<std::string> expected{strings};
+    std::ranges::sort(expected);
+    return std::ranges::equal(
+        records, expected, std::ranges::equal_to{},
+        [](const coreutils::SortRecord& record) { return record.view(); },
+        [](const std::string& str) { return std::string_view{str}; });
+}
+
+// -----------------------------------------------------------------------------
+// Test 1: Small Input
+// Description: A handful of names sorts bytewise, uppercase first.
+// -----------------------------------------------------------------------------
+bool test_small_input() {
+    return matches_std_sort({"b", "a", "C", "", "ab", "a"});
+}
+
+// -----------------------------------------------------------------------------
+// Test 2: Shared Prefixes
+// Description: Names that only differ after their first 8 bytes (spool
+// directories) still sort correctly once partitioning goes past the cached
+// prefix.
+// -----------------------------------------------------------------------------
+bool test_shared_prefixes() {
+    std::vector<std::string> names{};
+    for (std::uint32_t i{0}; i < 5000; ++i) {
+        names.push_back("spool-job-" + std::to_string((i * 7919) % 5003));
+    }
+    return matches_std_sort(names);
+}
+
+// -----------------------------------------------------------------------------
+// Test 3: Embedded Nulls
+// Description: Zero padding must not make "a" and "a\0" compare equal.
+// -----------------------------------------------------------------------------
+bool test_embedded_nulls() {
+    using namespace std::string_literals;
+    std::vector<std::string> strings{};
+    for (std::size_t i{0}; i < 64; ++i) {
+        strings.push_back(std::string(i % 11, '\0') + "a"s);
+        strings.push_back("abcdefgh"s + std::string(i % 5, '\0'));
+        strings.push_back("abcdefg\0"s + std::to_string(i));
+    }
+    return matches_std_sort(strings);
+}
+
+std::array<std::function<bool()>, 3> tests{
+    test_small_input, test_shared_prefixes, test_embedded_nulls};
+}  // namespace
+
+extern "C" {
+bool test_stringsort() {
+    bool result{true};
+    for (const auto& test : tests) {
+        result = result && test();
+    }
+
+    return result;
+}
+}
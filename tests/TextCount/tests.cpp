@@ -0,0 +1,157 @@
+#include <TextCount.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+/// Byte at a time, the way GNU wc counts in the C locale
+coreutils::TextCounts reference_count(std::string_view text) {
+    coreutils::TextCounts counts{.bytes = text.size(),
+                                 .characters = text.size()};
+    bool in_word{false};
+    for (const char c : text) {
+        counts.lines += c == '\n' ? 1 : 0;
+        if (c == ' ' || (c >= '\t' && c <= '\r')) {
+            in_word = false;
+        } else if (c > ' ' && c < 0x7f) {
+            counts.words += in_word ? 0 : 1;
+            in_word = true;
+        }
+    }
+    return counts;
+}
+
+bool same_counts(const coreutils::TextCounts& lhs,
+                 const coreutils::TextCounts& rhs) {
+    return lhs.bytes == rhs.bytes && lhs.lines == rhs.lines &&
+           lhs.words == rhs.words && lhs.characters == rhs.characters;
+}
+
+/// Text where words, white space and unprintable bytes all come in runs of
+/// every length, including ones that cross 64 byte blocks
+std::string mixed_text(std::size_t size, std::uint32_t seed) {
+    constexpr std::string_view alphabet{"ab \t\n\x01\x7f\xc3\xa9\r\v"};
+    std::string text{};
+    std::uint32_t state{seed};
+    while (text.size() < size) {
+        state = state * 1664525u + 1013904223u;
+        const char c{alphabet[(state >> 8) % alphabet.size()]};
+        text.append(((state >> 20) % 70) + 1, c);
+    }
+    text.resize(size);
+    return text;
+}
+
+// -----------------------------------------------------------------------------
+// Test 1: Whole Text
+// Description: Block at a time counting agrees with byte at a time counting,
+// for every length up to a few blocks.
+// -----------------------------------------------------------------------------
+bool test_whole_text() {
+    for (std::size_t size{0}; size < 300; ++size) {
+        const std::string text{
+            mixed_text(size, static_cast<std::uint32_t>(size))};
+        if (!same_counts(coreutils::CountText(text), reference_count(text)) ||
+            coreutils::CountLines(text) != reference_count(text).lines) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Test 2: Split Text
+// Description: Counting two pieces separately and joining them gives the same
+// counts as counting the whole, wherever the split falls (inside a word, or
+// between a word and the control characters that follow it).
+// -----------------------------------------------------------------------------
+bool test_split_text() {
+    const std::string text{mixed_text(1000, 7)};
+    const coreutils::TextCounts whole{reference_count(text)};
+    const std::span<const char> all{text};
+    for (std::size_t split{0}; split <= text.size(); ++split) {
+        const coreutils::TextCounts joined{
+            coreutils::Join(coreutils::CountText(all.first(split)),
+                            coreutils::CountText(all.subspan(split)))};
+        if (!same_counts(joined, whole)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Test 3: Unprintable Middle
+// Description: A piece holding nothing but unprintable bytes neither ends the
+// word before it nor starts one.
+// -----------------------------------------------------------------------------
+bool test_unprintable_middle() {
+    using coreutils::CountText;
+    using coreutils::Join;
+    const coreutils::TextCounts joined{
+        Join(Join(CountText(std::string_view{"one tw"}),
+                  CountText(std::string_view{"\x01\x02"})),
+             CountText(std::string_view{"o three"}))};
+    return joined.words == 3;
+}
+
+// -----------------------------------------------------------------------------
+// Test 4: Newline Search
+// Description: Searching a block at a time from either end finds the same
+// newline as looking at one byte at a time, and says how many there were
+// when there are not enough.
+// -----------------------------------------------------------------------------
+bool test_newline_search() {
+    for (std::size_t size{0}; size < 300; size += 7) {
+        const std::string text{
+            mixed_text(size, static_cast<std::uint32_t>(size) + 1)};
+        std::vector<std::size_t> newlines{};
+        for (std::size_t i{0}; i < text.size(); ++i) {
+            if (text[i] == '\n') {
+                newlines.push_back(i);
+            }
+        }
+        for (std::uint64_t count{1}; count <= newlines.size() + 1; ++count) {
+            const coreutils::NewlineSearch forward{
+                coreutils::FindNewline(text, count)};
+            const coreutils::NewlineSearch backward{
+                coreutils::FindNewlineBackward(text, count)};
+            if (count > newlines.size()) {
+                if (forward.found != newlines.size() ||
+                    forward.position != text.size() ||
+                    backward.found != newlines.size() ||
+                    backward.position != 0) {
+                    return false;
+                }
+            } else if (forward.found != count ||
+                       forward.position != newlines[count - 1] ||
+                       backward.found != count ||
+                       backward.position !=
+                           newlines[newlines.size() - count]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+std::array<std::function<bool()>, 4> tests{test_whole_text, test_split_text,
+                                           test_unprintable_middle,
+                                           test_newline_search};
+}  // namespace
+
+extern "C" {
+bool test_textcount() {
+    bool result{true};
+    for (const auto& test : tests) {
+        result = result && test();
+    }
+
+    return result;
+}
+}
@@ -0,0 +1,144 @@
+#include <Translate.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace {
+/// Every byte value, in runs of every length, so that runs cross the 16
+/// byte blocks the kernels work in
+std::string mixed_bytes(std::size_t size, std::uint32_t seed) {
+    std::string text{};
+    std::uint32_t state{seed};
+    while (text.size() < size) {
+        state = state * 1664525u + 1013904223u;
+        text.append(((state >> 24) % 4) + 1, static_cast<char>(state >> 8));
+    }
+    text.resize(size);
+    return text;
+}
+
+/// Squeezing one byte at a time
+std::string reference_squeeze(std::string_view text,
+                              const coreutils::ByteSet& set, int& last) {
+    std::string squeezed{};
+    for (const char c : text) {
+        const auto byte{static_cast<unsigned char>(c)};
+        if (byte != last || !set.Contains(byte)) {
+            squeezed.push_back(c);
+        }
+        last = byte;
+    }
+    return squeezed;
+}
+
+// -----------------------------------------------------------------------------
+// Test 1: Bulk Translate
+// Description: Mapping in bulk agrees with looking every byte up, both for
+// maps that touch a couple of rows and for ones that touch every row.
+// -----------------------------------------------------------------------------
+bool test_bulk_translate() {
+    coreutils::ByteMap upper{};
+    for (unsigned char c{'a'}; c <= 'z'; ++c) {
+        upper.Set(c, static_cast<unsigned char>(c - 'a' + 'A'));
+    }
+    coreutils::ByteMap scramble{};
+    for (std::size_t i{0}; i < 256; ++i) {
+        scramble.Set(static_cast<unsigned char>(i),
+                     static_cast<unsigned char>(i * 167 + 13));
+    }
+    for (const coreutils::ByteMap* map : {&upper, &scramble}) {
+        for (std::size_t size{0}; size < 100; ++size) {
+            const std::string text{
+                mixed_bytes(size, static_cast<std::uint32_t>(size))};
+            std::string mapped{text};
+            map->Apply(mapped);
+            for (std::size_t i{0}; i < size; ++i) {
+                if (static_cast<unsigned char>(mapped[i]) !=
+                    (*map)[static_cast<unsigned char>(text[i])]) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Test 2: Delete
+// Description: Deleting in bulk keeps exactly the bytes that are not in the
+// set, in order, for sets in one row, in every row, and empty.
+// -----------------------------------------------------------------------------
+bool test_delete() {
+    coreutils::ByteSet newline{};
+    newline.Add('\n');
+    coreutils::ByteSet odd{};
+    for (std::size_t i{1}; i < 256; i += 2) {
+        odd.Add(static_cast<unsigned char>(i));
+    }
+    const coreutils::ByteSet none{};
+    for (const coreutils::ByteSet* set :
+         std::array<const coreutils::ByteSet*, 3>{&newline, &odd, &none}) {
+        for (std::size_t size{0}; size < 100; ++size) {
+            const std::string text{
+                mixed_bytes(size, static_cast<std::uint32_t>(size) + 3)};
+            std::string expected{};
+            for (const char c : text) {
+                if (!set->Contains(static_cast<unsigned char>(c))) {
+                    expected.push_back(c);
+                }
+            }
+            std::string deleted{text};
+            deleted.resize(set->Delete(deleted));
+            if (deleted != expected) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Test 3: Squeeze
+// Description: Squeezing in bulk agrees with squeezing a byte at a time,
+// including runs that carry over from one piece of a stream to the next.
+// -----------------------------------------------------------------------------
+bool test_squeeze() {
+    coreutils::ByteSet set{};
+    for (std::size_t i{0}; i < 256; i += 3) {
+        set.Add(static_cast<unsigned char>(i));
+    }
+    const std::string text{mixed_bytes(1000, 11)};
+    for (std::size_t split{0}; split <= 64; ++split) {
+        int reference_last{-1};
+        const std::string expected{
+            reference_squeeze(text, set, reference_last)};
+
+        int last{-1};
+        std::string first{text.substr(0, split)};
+        std::string rest{text.substr(split)};
+        first.resize(set.Squeeze(first, last));
+        rest.resize(set.Squeeze(rest, last));
+        if (first + rest != expected || last != reference_last) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::array<std::function<bool()>, 3> tests{test_bulk_translate, test_delete,
+                                           test_squeeze};
+}  // namespace
+
+extern "C" {
+bool test_translate() {
+    bool result{true};
+    for (const auto& test : tests) {
+        result = result && test();
+    }
+
+    return result;
+}
+}
@@ -1,7 +1,52 @@
 const std = @import("std");
 
 extern "c" fn test_argparser() bool;
+extern "c" fn test_stringsort() bool;
+extern "c" fn test_textcount() bool;
+extern "c" fn test_inodeset() bool;
+extern "c" fn test_checksum() bool;
+extern "c" fn test_translate() bool;
+extern "c" fn test_escapes() bool;
+extern "c" fn test_fileinput() bool;
+extern "c" fn test_asyncio() bool;
+extern "c" fn test_sortkey() bool;
 
 test test_argparser {
     try std.testing.expect(test_argparser());
 }
+
+test test_stringsort {
+    try std.testing.expect(test_stringsort());
+}
+
+test test_textcount {
+    try std.testing.expect(test_textcount());
+}
+
+test test_inodeset {
+    try std.testing.expect(test_inodeset());
+}
+
+test test_checksum {
+    try std.testing.expect(test_checksum());
+}
+
+test test_translate {
+    try std.testing.expect(test_translate());
+}
+
+test test_escapes {
+    try std.testing.expect(test_escapes());
+}
+
+test test_fileinput {
+    try std.testing.expect(test_fileinput());
+}
+
+test test_asyncio {
+    try std.testing.expect(test_asyncio());
+}
+
+test test_sortkey {
+    try std.testing.expect(test_sortkey());
+}